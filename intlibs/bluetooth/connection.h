@@ -39,6 +39,17 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 
 class HttpConnection;
 
+//A native datagram buffer, used by readFromMulti() and writeToMulti().
+struct DatagramBuffer {
+	void* data;
+	//For reads, the size of the buffer. For writes, the number of bytes to send.
+	int size;
+	//For reads, set to the number of bytes received.
+	int length;
+	//For reads, set to the source address. For writes, the destination address.
+	MAConnAddr addr;
+};
+
 class Closable {
 public:
 	//Thread-safe. Will cause all active operations to return with CONNERR_CANCELED.
@@ -74,6 +85,16 @@ public:
 
 	virtual int writeTo(const void* src, int len, const MAConnAddr& dst) GCCATTRIB(noreturn);
 
+	//Reads 1 to <count> datagrams. Blocks until at least one is available.
+	//Returns the number of datagrams read or CONNERR code.
+	//The default implementation reads one datagram using readFrom().
+	virtual int readFromMulti(DatagramBuffer* bufs, int count);
+
+	//Writes up to <count> datagrams.
+	//Returns the number of datagrams written or CONNERR code.
+	//The default implementation calls writeTo() for each datagram.
+	virtual int writeToMulti(const DatagramBuffer* bufs, int count);
+
 	//Writes the remote connection's address to \a addr.
 	//Will fail if connect() has not completed.
 	virtual int getAddr(MAConnAddr& addr) = 0;
@@ -232,14 +232,15 @@ void HashMapBase::dispose(BasePair&) {
 HashMapBase::TIteratorC::TIteratorC(const BasePair* pos, const BasePair* end)
 : mPos(pos), mEnd(end)
 {
-	if(mPos != NULL) if(mPos->value == NULL)
+	if(mPos != mEnd) if(mPos->value == NULL)
 		proceed();
 }
 
 void HashMapBase::TIteratorC::proceed() {
 	while(mPos != mEnd) {
 		mPos++;
-		if(mPos->value != NULL)
+		//mEnd is past the last pair.
+		if(mPos != mEnd && mPos->value != NULL)
 			break;
 	}
 }
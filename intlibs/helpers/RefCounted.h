@@ -22,6 +22,7 @@ class RefCounted {
 public:
 	// Initializes the reference counter to initialValue (default 1).
 	RefCounted(int initialValue=1) : mCount(initialValue) { }
+	virtual ~RefCounted() { }
 	
 	// Increases the reference counter by one.
 	void addRef() { 
@@ -0,0 +1,60 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#ifndef ATOMIC_H
+#define ATOMIC_H
+
+// Minimal atomic operations on longs. All of them are full memory barriers.
+
+#if defined (WIN32) || defined(_WIN32_WCE)
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+// Sets *p to newValue if it equals oldValue. Returns true if it did.
+static inline bool atomicCompareAndSwap(volatile long* p, long oldValue, long newValue) {
+	return InterlockedCompareExchange(p, newValue, oldValue) == oldValue;
+}
+
+// Returns the new value.
+static inline long atomicIncrement(volatile long* p) {
+	return InterlockedIncrement(p);
+}
+
+static inline void atomicMemoryBarrier() {
+	MemoryBarrier();
+}
+
+#elif defined(__GNUC__)
+
+static inline bool atomicCompareAndSwap(volatile long* p, long oldValue, long newValue) {
+	return __sync_bool_compare_and_swap(p, oldValue, newValue);
+}
+
+static inline long atomicIncrement(volatile long* p) {
+	return __sync_add_and_fetch(p, 1);
+}
+
+static inline void atomicMemoryBarrier() {
+	__sync_synchronize();
+}
+
+#else
+#error Unsupported platform!
+#endif
+
+#endif	//ATOMIC_H
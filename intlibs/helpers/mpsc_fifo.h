@@ -0,0 +1,142 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#ifndef _MPSC_FIFO_H_
+#define _MPSC_FIFO_H_
+
+#include <helpers/atomic.h>
+
+//A bounded FIFO queue for any number of producer threads and one consumer thread.
+//
+//put() never blocks and never takes a lock; if the queue is full, the item is dropped.
+//Each slot carries a sequence number that tells whether it is free or holds a
+//published item, so producers only contend on the tail index.
+//
+//putCoalesced() may instead overwrite the most recently published item, if the
+//consumer hasn't taken it yet. That, and get(), briefly lock the one slot involved,
+//so that the consumer never reads a half-overwritten item.
+//
+//size must be a power of two.
+template<class T, int size> class MpscFifo {
+public:
+	enum PutResult {
+		DROPPED, PUT, COALESCED
+	};
+
+	MpscFifo() : mHead(0), mTail(0) {
+		for(int i=0; i<size; i++) {
+			mSlots[i].seq = i;
+			mSlots[i].lock = 0;
+		}
+	}
+
+	//Any thread.
+	//Fails if fewer than \a reserve slots would remain free afterwards.
+	//Returns true if the item was put, false if it was dropped.
+	bool put(const T& t, int reserve = 0) {
+		while(true) {
+			long pos = mTail;
+			Slot& s(mSlots[pos & MASK]);
+			long diff = s.seq - pos;
+			if(diff == 0) {
+				if(pos - mHead >= size - reserve)
+					return false;
+				if(atomicCompareAndSwap(&mTail, pos, pos + 1)) {
+					s.data = t;
+					atomicMemoryBarrier();
+					s.seq = pos + 1;
+					return true;
+				}
+			} else if(diff < 0) {
+				return false;	//full
+			}
+			//else another producer got there first; try again.
+		}
+	}
+
+	//Any thread.
+	//If the last published item is still in the queue and match(queuedItem, t) returns true,
+	//the queued item is replaced by \a t. Otherwise, works like put().
+	template<class Match> PutResult putCoalesced(const T& t, Match match, int reserve = 0) {
+		long pos = mTail;
+		if(pos != mHead) {
+			Slot& s(mSlots[(pos - 1) & MASK]);
+			lockSlot(s);
+			//seq == pos: published, and not yet taken by the consumer.
+			//mTail == pos: no other producer has claimed a later slot.
+			bool replace = s.seq == pos && mTail == pos && match(s.data, t);
+			if(replace)
+				s.data = t;
+			unlockSlot(s);
+			if(replace)
+				return COALESCED;
+		}
+		return put(t, reserve) ? PUT : DROPPED;
+	}
+
+	//Consumer thread only.
+	//Returns false if the queue is empty.
+	bool get(T& t) {
+		long pos = mHead;
+		Slot& s(mSlots[pos & MASK]);
+		if(s.seq != pos + 1)
+			return false;
+		lockSlot(s);
+		t = s.data;
+		s.seq = pos + size;
+		unlockSlot(s);
+		mHead = pos + 1;
+		return true;
+	}
+
+	//Any thread. The result may be out of date by the time it is returned,
+	//but it is exact from the consumer's point of view if there are no producers.
+	int count() const {
+		return (int)(mTail - mHead);
+	}
+
+	//Consumer thread only.
+	void clear() {
+		T t;
+		while(get(t)) {}
+	}
+
+private:
+	enum { MASK = size - 1 };
+
+	//fails to compile if size isn't a power of two.
+	typedef char SizeIsAPowerOfTwo[(size & (size - 1)) == 0 ? 1 : -1];
+
+	struct Slot {
+		volatile long seq;
+		volatile long lock;
+		T data;
+	};
+
+	static void lockSlot(Slot& s) {
+		while(!atomicCompareAndSwap(&s.lock, 0, 1)) {}
+	}
+	static void unlockSlot(Slot& s) {
+		atomicMemoryBarrier();
+		s.lock = 0;
+	}
+
+	Slot mSlots[size];
+	volatile long mHead, mTail;
+};
+
+#endif	//_MPSC_FIFO_H_
@@ -0,0 +1,62 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#ifndef _RCU_H_
+#define _RCU_H_
+
+#include <helpers/atomic.h>
+
+#if !defined(WIN32) && !defined(_WIN32_WCE)
+#include <sched.h>
+#endif
+
+//Read-copy-update for one reader thread, such as an audio callback.
+//
+//The reader brackets each use of the shared data with readBegin() and
+//readEnd(), which never block. A writer replaces the data, publishes the
+//new version, then calls synchronize(). When that returns, the reader is
+//no longer using the old version, which may then be freed.
+//Writers must be serialised by the caller.
+class Rcu {
+public:
+	Rcu() : mEpoch(0) {}
+
+	//Reader thread. The epoch is odd while the reader is inside.
+	void readBegin() { atomicIncrement(&mEpoch); }
+	void readEnd() { atomicIncrement(&mEpoch); }
+
+	//Writer thread. Waits until the reader has left the section it was in,
+	//if any, when the new version was published.
+	void synchronize() {
+		atomicMemoryBarrier();
+		long epoch = mEpoch;
+		if(epoch & 1) {
+			while(mEpoch == epoch) {
+#if defined(WIN32) || defined(_WIN32_WCE)
+				Sleep(0);
+#else
+				sched_yield();
+#endif
+			}
+		}
+	}
+
+private:
+	volatile long mEpoch;
+};
+
+#endif	//_RCU_H_
@@ -19,6 +19,7 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 #define LOGGING_ENABLED
 
 #include "net.h"
+#include "resolver.h"
 #include "helpers/log.h"
 #include "helpers/cpp_defs.h"
 #include "helpers/helpers.h"
@@ -102,6 +103,22 @@ int Connection::writeTo(const void* src, int len, const MAConnAddr& dst) {
 	BIG_PHAT_ERROR(ERR_CONN_WRITETO);
 }
 
+int Connection::readFromMulti(DatagramBuffer* bufs, int count) {
+	int res;
+	TLTZ_PASS(res = readFrom(bufs[0].data, bufs[0].size, bufs[0].addr));
+	bufs[0].length = res;
+	return 1;
+}
+
+int Connection::writeToMulti(const DatagramBuffer* bufs, int count) {
+	for(int i=0; i<count; i++) {
+		int res = writeTo(bufs[i].data, bufs[i].size, bufs[i].addr);
+		if(res < 0)
+			return i > 0 ? i : res;
+	}
+	return count;
+}
+
 //******************************************************************************
 // TcpConnection helpers
 //******************************************************************************
@@ -151,6 +168,11 @@ MoSyncSocket MASocketCreate(const char* address, int& result, uint& inetAddr) {
 #endif
 #endif
 
+	// Resolve first, so that a failed lookup doesn't leak a socket.
+	result = Resolver::resolve(address, inetAddr);
+	if(result <= 0)
+		return INVALID_SOCKET;
+
 	MoSyncSocket mySocket;
 	// Create socket
 	mySocket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
@@ -161,22 +183,6 @@ MoSyncSocket MASocketCreate(const char* address, int& result, uint& inetAddr) {
 		return INVALID_SOCKET;
 	}
 
-	inetAddr = inet_addr(address);
-	if(inetAddr == INADDR_NONE) {
-		hostent *hostEnt;
-		if((hostEnt = gethostbyname(address)) == NULL) {
-			LOG("MASocketOpen: DNS resolve failed. %d\n", SOCKET_ERRNO);
-			result = CONNERR_DNS;
-			return INVALID_SOCKET;
-		}
-		inetAddr = (uint)*((uint*)hostEnt->h_addr_list[0]);
-		if(inetAddr == INADDR_NONE) {
-			LOG("MASocketOpen: Could not parse the resolved ip address. %d\n", SOCKET_ERRNO);
-			result = CONNERR_URL;
-			return INVALID_SOCKET;
-		}
-	}
-
 	// Make sure Nagle's algorithm is disabled
 	int v;
 	socklen_t len = sizeof(v);
@@ -271,21 +277,8 @@ int UdpConnection::connect() {
 	if(mHostname.empty())
 		return openServer();
 
-	// parse address
-	mInetAddr = inet_addr(mHostname.c_str());
-	if(mInetAddr == INADDR_NONE) {
-		hostent *hostEnt;
-		// DNS lookup
-		if((hostEnt = gethostbyname(mHostname.c_str())) == NULL) {
-			LOG("MASocketOpen: DNS resolve failed. %d\n", SOCKET_ERRNO);
-			return CONNERR_DNS;
-		}
-		mInetAddr = (uint)*((uint*)hostEnt->h_addr_list[0]);
-		if(mInetAddr == INADDR_NONE) {
-			LOG("MASocketOpen: Could not parse the resolved ip address. %d\n", SOCKET_ERRNO);
-			return CONNERR_URL;
-		}
-	}
+	// parse address, or look it up
+	TLTZ_PASS(Resolver::resolve(mHostname.c_str(), mInetAddr));
 
 	// connect
 	return MASocketConnect(mSock, mInetAddr, mPort);
@@ -430,6 +423,71 @@ int UdpConnection::writeTo(const void* src, int len, const MAConnAddr& dst) {
 	}
 }
 
+#ifdef LINUX
+int UdpConnection::readFromMulti(DatagramBuffer* bufs, int count) {
+	DEBUG_ASSERT(count > 0 && count <= CONN_MAX_DATAGRAMS);
+	mmsghdr msgs[CONN_MAX_DATAGRAMS];
+	iovec iovs[CONN_MAX_DATAGRAMS];
+	sockaddr_in froms[CONN_MAX_DATAGRAMS];
+	memset(msgs, 0, sizeof(mmsghdr) * count);
+	for(int i=0; i<count; i++) {
+		iovs[i].iov_base = bufs[i].data;
+		iovs[i].iov_len = bufs[i].size;
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_name = &froms[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+	}
+
+	//block until the first datagram arrives, then take whatever else is queued.
+	int res = recvmmsg(mSock, msgs, count, MSG_WAITFORONE, NULL);
+	if(SOCKET_ERROR == res) {
+		LOG("UdpConnection::readFromMulti: recvmmsg failed. error code: %i\n", SOCKET_ERRNO);
+		return CONNERR_GENERIC;
+	} else if(res == 0) {
+		return CONNERR_CLOSED;
+	}
+	for(int i=0; i<res; i++) {
+		bufs[i].length = msgs[i].msg_len;
+		parse_sockaddr(bufs[i].addr, (sockaddr*)&froms[i], msgs[i].msg_hdr.msg_namelen);
+	}
+	return res;
+}
+
+int UdpConnection::writeToMulti(const DatagramBuffer* bufs, int count) {
+	DEBUG_ASSERT(count > 0 && count <= CONN_MAX_DATAGRAMS);
+	mmsghdr msgs[CONN_MAX_DATAGRAMS];
+	iovec iovs[CONN_MAX_DATAGRAMS];
+	sockaddr_in tos[CONN_MAX_DATAGRAMS];
+	memset(msgs, 0, sizeof(mmsghdr) * count);
+	for(int i=0; i<count; i++) {
+		const MAConnAddr& dst(bufs[i].addr);
+		DEBUG_ASSERT(dst.family == CONN_FAMILY_INET4);
+		tos[i].sin_family = AF_INET;
+		tos[i].sin_port = htons(dst.inet4.port);
+		tos[i].sin_addr.s_addr = htonl(dst.inet4.addr);
+		iovs[i].iov_base = bufs[i].data;
+		iovs[i].iov_len = bufs[i].size;
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_name = &tos[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+	}
+
+	//sendmmsg() may stop early, for example when the socket buffer is full.
+	int sent = 0;
+	while(sent < count) {
+		int res = sendmmsg(mSock, msgs + sent, count - sent, 0);
+		if(SOCKET_ERROR == res) {
+			LOG("UdpConnection::writeToMulti: sendmmsg failed. error code: %i\n", SOCKET_ERRNO);
+			return sent > 0 ? sent : CONNERR_GENERIC;
+		}
+		sent += res;
+	}
+	return sent;
+}
+#endif	//LINUX
+
 int InetConnection::write(const void* src, int len) {
 	int bytesSent = send(mSock, (const char*) src, len, 0);
 	if(bytesSent != len || SOCKET_ERROR == bytesSent) {
@@ -102,6 +102,11 @@ public:
 	virtual int read(void* dst, int max);
 	virtual int readFrom(void* dst, int max, MAConnAddr& src);
 	virtual int writeTo(const void* src, int len, const MAConnAddr& dst);
+#ifdef LINUX
+	//Uses recvmmsg() and sendmmsg(), one system call per batch.
+	virtual int readFromMulti(DatagramBuffer* bufs, int count);
+	virtual int writeToMulti(const DatagramBuffer* bufs, int count);
+#endif
 
 private:
 	int openServer();
@@ -0,0 +1,351 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#define CONFIG_H	//hack
+#define LOGGING_ENABLED
+
+#include "net.h"
+#include "resolver.h"
+#include "helpers/log.h"
+#include "helpers/cpp_defs.h"
+#include "helpers/helpers.h"
+#include "helpers/CriticalSection.h"
+
+#ifndef SYMBIAN
+
+#if !defined(WIN32) && !defined(_WIN32_WCE)
+#include <pthread.h>
+#include <time.h>
+#include <sys/time.h>
+#endif
+
+using namespace MoSyncError;
+
+//******************************************************************************
+// Helpers
+//******************************************************************************
+
+// Milliseconds since some unspecified point in time. Never goes backwards.
+static u64 monotonicMillis() {
+#if defined(WIN32) || defined(_WIN32_WCE)
+	// wraps after 49 days, but the differences we compute are far smaller.
+	return GetTickCount();
+#elif defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#else
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (u64)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+#endif
+}
+
+// A one-shot signal carrying the result of a lookup. Threads that want
+// the result of a lookup that is already in progress wait on it.
+// Reference counted; the counter is protected by the cache's lock.
+class LookupDone {
+public:
+	LookupDone() : inetAddr(INADDR_NONE), result(CONNERR_DNS), refs(1), mSet(false) {
+#if defined(WIN32) || defined(_WIN32_WCE)
+		mEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+		DEBUG_ASSERT(mEvent != NULL);
+#else
+		pthread_mutex_init(&mMutex, NULL);
+		pthread_cond_init(&mCond, NULL);
+#endif
+	}
+	~LookupDone() {
+#if defined(WIN32) || defined(_WIN32_WCE)
+		CloseHandle(mEvent);
+#else
+		pthread_cond_destroy(&mCond);
+		pthread_mutex_destroy(&mMutex);
+#endif
+	}
+	void set() {
+#if defined(WIN32) || defined(_WIN32_WCE)
+		mSet = true;
+		SetEvent(mEvent);
+#else
+		pthread_mutex_lock(&mMutex);
+		mSet = true;
+		pthread_cond_broadcast(&mCond);
+		pthread_mutex_unlock(&mMutex);
+#endif
+	}
+	void wait() {
+#if defined(WIN32) || defined(_WIN32_WCE)
+		WaitForSingleObject(mEvent, INFINITE);
+#else
+		pthread_mutex_lock(&mMutex);
+		while(!mSet)
+			pthread_cond_wait(&mCond, &mMutex);
+		pthread_mutex_unlock(&mMutex);
+#endif
+	}
+
+	uint inetAddr;
+	int result;
+	int refs;
+private:
+	bool mSet;
+#if defined(WIN32) || defined(_WIN32_WCE)
+	HANDLE mEvent;
+#else
+	pthread_mutex_t mMutex;
+	pthread_cond_t mCond;
+#endif
+};
+
+//******************************************************************************
+// Default backend
+//******************************************************************************
+
+// getaddrinfo() is thread-safe. gethostbyname() may return a static buffer,
+// so on Windows the calls, and the copy of the result, are serialized.
+class HostentBackend : public ResolverBackend {
+public:
+#if defined(WIN32) || defined(_WIN32_WCE)
+	HostentBackend() {
+		InitializeCriticalSection(&mCS);
+	}
+
+	int lookup(const char* hostname, uint& inetAddr, int& ttl) {
+		CriticalSectionHandler csh(&mCS);
+		hostent *hostEnt;
+		if((hostEnt = gethostbyname(hostname)) == NULL) {
+			LOG("Resolver: DNS resolve failed. %d\n", SOCKET_ERRNO);
+			return CONNERR_DNS;
+		}
+		inetAddr = (uint)*((uint*)hostEnt->h_addr_list[0]);
+		if(inetAddr == INADDR_NONE) {
+			LOG("Resolver: Could not parse the resolved ip address. %d\n", SOCKET_ERRNO);
+			return CONNERR_URL;
+		}
+		return 1;
+	}
+private:
+	CRITICAL_SECTION mCS;
+#else
+	int lookup(const char* hostname, uint& inetAddr, int& ttl) {
+		addrinfo hints;
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_INET;
+		hints.ai_socktype = SOCK_STREAM;
+		addrinfo* res;
+		int err = getaddrinfo(hostname, NULL, &hints, &res);
+		if(err != 0 || res == NULL) {
+			LOG("Resolver: DNS resolve failed. %d(%s)\n", err, gai_strerror(err));
+			return CONNERR_DNS;
+		}
+		inetAddr = ((sockaddr_in*)res->ai_addr)->sin_addr.s_addr;
+		freeaddrinfo(res);
+		if(inetAddr == INADDR_NONE) {
+			LOG("Resolver: Could not parse the resolved ip address.\n");
+			return CONNERR_URL;
+		}
+		return 1;
+	}
+#endif
+};
+
+//******************************************************************************
+// Cache
+//******************************************************************************
+
+struct DnsEntry {
+	uint inetAddr;
+	int result;	// >0 or CONNERR code.
+	u64 expires;
+	LookupDone* pending;	// non-NULL while a lookup is in progress.
+};
+
+typedef hash_map<std::string, DnsEntry> DnsMap;
+typedef DnsMap::iterator DnsItr;
+
+class DnsCache {
+public:
+	DnsCache() : mBackend(&mDefaultBackend) {
+		InitializeCriticalSection(&mCS);
+		memset(&mStats, 0, sizeof(mStats));
+	}
+
+	int resolve(const char* hostname, uint& inetAddr);
+	void flush();
+	void setBackend(ResolverBackend* backend);
+	void getStats(Resolver::Stats& stats);
+
+private:
+	CRITICAL_SECTION mCS;
+	DnsMap mMap;
+	HostentBackend mDefaultBackend;
+	ResolverBackend* mBackend;
+	Resolver::Stats mStats;
+
+	int waitFor(LookupDone* done, uint& inetAddr);
+	void release(LookupDone* done);
+	void purge(u64 now);
+};
+
+static DnsCache sCache;
+
+int DnsCache::resolve(const char* hostname, uint& inetAddr) {
+	const std::string key(hostname);
+	ResolverBackend* backend;
+	LookupDone* done;
+	{
+		CriticalSectionHandler csh(&mCS);
+		u64 now = monotonicMillis();
+		DnsItr itr = mMap.find(key);
+		if(itr != mMap.end()) {
+			DnsEntry& e(itr->second);
+			if(e.pending) {
+				mStats.joinedLookups++;
+				return waitFor(e.pending, inetAddr);
+			}
+			if(e.expires > now) {
+				if(e.result > 0) {
+					mStats.hits++;
+					inetAddr = e.inetAddr;
+				} else {
+					mStats.negativeHits++;
+				}
+				return e.result;
+			}
+		} else {
+			if(mMap.size() >= RESOLVER_MAX_ENTRIES)
+				purge(now);
+			itr = mMap.insert(DnsMap::value_type(key, DnsEntry())).first;
+		}
+		mStats.misses++;
+
+		// claim the lookup. others asking for this host will wait for us.
+		DnsEntry& e(itr->second);
+		e.result = CONNERR_DNS;
+		e.expires = 0;
+		e.pending = done = new LookupDone;
+		backend = mBackend;
+	}
+
+	// the lookup itself runs unlocked, so that other hosts can be resolved meanwhile.
+	uint addr = INADDR_NONE;
+	int ttl = RESOLVER_DEFAULT_TTL;
+	int result = backend->lookup(hostname, addr, ttl);
+
+	{
+		CriticalSectionHandler csh(&mCS);
+		DnsEntry& e(mMap[key]);
+		DEBUG_ASSERT(e.pending == done);
+		if(result > 0) {
+			ttl = MIN(MAX(ttl, 0), RESOLVER_MAX_TTL);
+		} else {
+			ttl = RESOLVER_NEGATIVE_TTL;
+		}
+		e.inetAddr = addr;
+		e.result = result;
+		e.expires = monotonicMillis() + (u64)ttl * 1000;
+		e.pending = NULL;
+		done->inetAddr = addr;
+		done->result = result;
+		done->set();
+		release(done);
+	}
+	if(result > 0)
+		inetAddr = addr;
+	return result;
+}
+
+// Called with mCS held. Returns with mCS held.
+int DnsCache::waitFor(LookupDone* done, uint& inetAddr) {
+	done->refs++;
+	LeaveCriticalSection(&mCS);
+	done->wait();
+	EnterCriticalSection(&mCS);
+
+	int result = done->result;
+	if(result > 0)
+		inetAddr = done->inetAddr;
+	release(done);
+	return result;
+}
+
+// Called with mCS held.
+void DnsCache::release(LookupDone* done) {
+	done->refs--;
+	if(done->refs == 0)
+		delete done;
+}
+
+// Called with mCS held.
+// Removes expired entries. If that doesn't free up anything,
+// removes every entry that isn't being looked up.
+void DnsCache::purge(u64 now) {
+	for(int pass=0; pass<2; pass++) {
+		DnsItr itr = mMap.begin();
+		while(itr != mMap.end()) {
+			const DnsEntry& e(itr->second);
+			if(e.pending == NULL && (pass == 1 || e.expires <= now))
+				mMap.erase(itr++);
+			else
+				++itr;
+		}
+		if(mMap.size() < RESOLVER_MAX_ENTRIES)
+			return;
+	}
+}
+
+void DnsCache::flush() {
+	CriticalSectionHandler csh(&mCS);
+	purge(~(u64)0);
+}
+
+void DnsCache::setBackend(ResolverBackend* backend) {
+	CriticalSectionHandler csh(&mCS);
+	mBackend = backend ? backend : &mDefaultBackend;
+	purge(~(u64)0);
+}
+
+void DnsCache::getStats(Resolver::Stats& stats) {
+	CriticalSectionHandler csh(&mCS);
+	stats = mStats;
+}
+
+//******************************************************************************
+// Resolver
+//******************************************************************************
+
+int Resolver::resolve(const char* hostname, uint& inetAddr) {
+	inetAddr = inet_addr(hostname);
+	if(inetAddr != INADDR_NONE)
+		return 1;
+	return sCache.resolve(hostname, inetAddr);
+}
+
+void Resolver::flush() {
+	sCache.flush();
+}
+
+void Resolver::setBackend(ResolverBackend* backend) {
+	sCache.setBackend(backend);
+}
+
+void Resolver::getStats(Stats& stats) {
+	sCache.getStats(stats);
+}
+
+#endif	//SYMBIAN
@@ -0,0 +1,72 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include "helpers/types.h"
+
+//***************************************************************************
+// Host name resolution with an in-memory cache.
+//
+// Results are kept for the record's time-to-live, capped at RESOLVER_MAX_TTL.
+// Failed lookups are kept for RESOLVER_NEGATIVE_TTL, so that a bad host name
+// doesn't cause a new lookup on every connection attempt.
+// If several threads ask for the same uncached host at the same time,
+// only one of them performs the lookup; the others wait for its result.
+//***************************************************************************
+
+// All times are in seconds.
+#define RESOLVER_DEFAULT_TTL 60
+#define RESOLVER_MAX_TTL 300
+#define RESOLVER_NEGATIVE_TTL 10
+#define RESOLVER_MAX_ENTRIES 256
+
+// Performs the actual lookups. The default backend uses getaddrinfo(), or
+// gethostbyname() on Windows, which don't report TTLs. Tests may install a stub backend.
+class ResolverBackend {
+public:
+	// Stores the address, in network byte order, in \a inetAddr.
+	// If the backend knows the time-to-live of the record, it stores it in \a ttl.
+	// Otherwise, \a ttl is left unchanged.
+	// Returns >0 or CONNERR code.
+	virtual int lookup(const char* hostname, uint& inetAddr, int& ttl) = 0;
+
+	virtual ~ResolverBackend() {}
+};
+
+namespace Resolver {
+	// Stores the address of \a hostname, in network byte order, in \a inetAddr.
+	// Numeric addresses are parsed without touching the cache.
+	// Blocks if a lookup is needed. Thread-safe.
+	// Returns >0 or CONNERR code.
+	int resolve(const char* hostname, uint& inetAddr);
+
+	// Removes every entry that isn't currently being looked up.
+	void flush();
+
+	// Installs a new backend and flushes the cache.
+	// Pass NULL to restore the default. Does not take ownership.
+	void setBackend(ResolverBackend* backend);
+
+	struct Stats {
+		int hits, misses, negativeHits, joinedLookups;
+	};
+	void getStats(Stats& stats);
+}
+
+#endif	//RESOLVER_H
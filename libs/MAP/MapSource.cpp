@@ -25,12 +25,10 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 namespace MAP
 {
 	//=========================================================================
-	class MapSourceImageDownloader :
-		#ifdef StoreCompressedTilesInCache
-		public Downloader
-		#else
-		public ImageDownloader
-		#endif
+	//
+	// Downloads the encoded tile image. MapSource decodes it.
+	//
+	class MapSourceImageDownloader : public Downloader
 	//=========================================================================
 	{
 	public:
@@ -55,11 +53,7 @@ namespace MAP
 			//
 			mUrl = url;
 		
-			#ifdef StoreCompressedTilesInCache
 			return Downloader::beginDownloading( url, placeholder );
-			#else
-			return ImageDownloader::beginDownloading( url, placeholder );
-			#endif
 		}
 
 		#ifdef StoreCompressedTilesInCache
@@ -185,6 +179,25 @@ namespace MAP
 		virtual	~MapSourceQueue( ) { }
 	};
 
+	//=========================================================================
+	//
+	// A tile image that is being decoded in the background
+	//
+	class MapSourceDecode
+	//=========================================================================
+	{
+	public:
+		MAHandle mImage;
+		IMapSourceListener* mListener;
+		MapTileCoordinate mTileXY;
+	};
+
+	//=========================================================================
+	class MapSourceDecodes : public Vector<MapSourceDecode>
+	//=========================================================================
+	{
+	};
+
 	//-------------------------------------------------------------------------
 	//
 	// Creates a new map source
@@ -192,10 +205,12 @@ namespace MAP
 	MapSource::MapSource( ) :
 	//-------------------------------------------------------------------------
 		mQueue( NULL ),
+		mDecodes( NULL ),
 		mTileCount( 0 )
 	{
 		mDownloaders = new MapSourceImageDownloader*[MapSourceDownloaders];
 		mQueue = newobject( MapSourceQueue, new MapSourceQueue( ) );
+		mDecodes = newobject( MapSourceDecodes, new MapSourceDecodes( ) );
 		for (int i = 0; i < MapSourceDownloaders; i++)
 			mDownloaders[i] = NULL;
 	}
@@ -207,6 +222,20 @@ namespace MAP
 		mQueue->clear( );
 		deleteobject( mQueue );
 		//
+		// Drop tiles that are being decoded
+		//
+		if ( mDecodes->size( ) > 0 )
+		{
+			Environment::getEnvironment( ).removeCustomEventListener( this );
+			for ( int i = 0; i < mDecodes->size( ); i++ )
+			{
+				MAHandle image = (*mDecodes)[i].mImage;
+				maCancelImageDecode( image );
+				maDestroyPlaceholder( image );
+			}
+		}
+		deleteobject( mDecodes );
+		//
 		// Drop and delete downloader pool
 		//
 		for ( int i = 0; i < MapSourceDownloaders; i++ )
@@ -231,7 +260,7 @@ namespace MAP
 	void MapSource::requestTile( IMapSourceListener* listener, MapTileCoordinate tileXY )
 	//-------------------------------------------------------------------------
 	{
-		if ( !isInQueue( tileXY ) && !isInDownloaders( tileXY ) )
+		if ( !isInQueue( tileXY ) && !isInDownloaders( tileXY ) && !isDecoding( tileXY ) )
 		{
 			QueueEntry entry = QueueEntry( listener, false, tileXY );
 			mQueue->push( entry );
@@ -294,6 +323,22 @@ namespace MAP
 		return false;
 	}
 
+	//-------------------------------------------------------------------------
+	//
+	// Is tile image being decoded?
+	//
+	bool MapSource::isDecoding( MapTileCoordinate tileXY )
+	//-------------------------------------------------------------------------
+	{
+		for ( int i = 0; i < mDecodes->size( ); i++ )
+		{
+			MapTileCoordinate itemTileXY = (*mDecodes)[i].mTileXY;
+			if ( itemTileXY.getX( ) == tileXY.getX( ) && itemTileXY.getY( ) == tileXY.getY( ) && itemTileXY.getMagnification( ) == tileXY.getMagnification( ) )
+				return true;
+		}
+		return false;
+	}
+
 	//-------------------------------------------------------------------------
 	//
 	// disconnects and removes downloader from list of downloaders
@@ -338,19 +383,49 @@ namespace MAP
 	{
 		MapSourceImageDownloader* dlr = (MapSourceImageDownloader*)downloader;
 
-		mTileCount++;
 		MapTileCoordinate tileXY = dlr->mTileXY;
 
-		LonLat ll = tileCenterToLonLat( getTileSize( ), tileXY, 0, 0 );
-
 		#ifdef StoreCompressedTilesInCache 
+		mTileCount++;
+		LonLat ll = tileCenterToLonLat( getTileSize( ), tileXY, 0, 0 );
 		DebugPrintf("PNG size: %d\n", dlr->getContentLength( ) );
 		MapTile* tile = newobject( MapTile, new MapTile( this, tileXY.getX( ), tileXY.getY( ), tileXY.getMagnification( ), ll, data, dlr->getContentLength( ) ) );
+		onTileReceived( dlr->mListener, tile );
 		#else
-		MapTile* tile = newobject( MapTile, new MapTile( this, tileXY.getX( ), tileXY.getY( ), tileXY.getMagnification( ), ll, data ) );
-		#endif // StoreCompressedTilesInCache
+		//
+		// Decode in the background if possible. The data is copied,
+		// so it can be released right away.
+		//
+		MAHandle image = maCreatePlaceholder( );
+		int size = maGetDataSize( data );
+		int res = maCreateImageFromDataAsync( image, data, 0, size );
+		bool async = ( res == RES_OK );
+		if ( async )
+		{
+			if ( mDecodes->size( ) == 0 )
+				Environment::getEnvironment( ).addCustomEventListener( this );
+			MapSourceDecode decode;
+			decode.mImage = image;
+			decode.mListener = dlr->mListener;
+			decode.mTileXY = tileXY;
+			mDecodes->add( decode );
+		}
+		else
+		{
+			res = maCreateImageFromData( image, data, 0, size );
+		}
+		maDestroyPlaceholder( data );
 
-		onTileReceived( dlr->mListener, tile );
+		if ( res != RES_OK )
+		{
+			maDestroyPlaceholder( image );
+			onError( dlr->mListener, CONNERR_DOWNLOADER_OTHER - res );
+		}
+		else if ( !async )
+		{
+			tileDecoded( dlr->mListener, tileXY, image );
+		}
+		#endif // StoreCompressedTilesInCache
 		//
 		// Terminate clientdata lifespan
 		//
@@ -364,6 +439,48 @@ namespace MAP
 		dequeueIfIdleSlot( /*dlr*/NULL );
 	}
 
+	//-------------------------------------------------------------------------
+	void MapSource::customEvent( const MAEvent& event )
+	//-------------------------------------------------------------------------
+	{
+		if ( event.type != EVENT_TYPE_IMAGE_DECODED )
+			return;
+
+		for ( int i = 0; i < mDecodes->size( ); i++ )
+		{
+			if ( (*mDecodes)[i].mImage != event.imagePlaceholder )
+				continue;
+
+			MapSourceDecode decode = (*mDecodes)[i];
+			mDecodes->remove( i );
+			if ( mDecodes->size( ) == 0 )
+				Environment::getEnvironment( ).removeCustomEventListener( this );
+
+			if ( event.imageDecodeResult == RES_OK )
+			{
+				tileDecoded( decode.mListener, decode.mTileXY, decode.mImage );
+			}
+			else
+			{
+				maDestroyPlaceholder( decode.mImage );
+				onError( decode.mListener, CONNERR_DOWNLOADER_OTHER - event.imageDecodeResult );
+			}
+			return;
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	void MapSource::tileDecoded( IMapSourceListener* listener, MapTileCoordinate tileXY, MAHandle image )
+	//-------------------------------------------------------------------------
+	{
+		#ifndef StoreCompressedTilesInCache
+		mTileCount++;
+		LonLat ll = tileCenterToLonLat( getTileSize( ), tileXY, 0, 0 );
+		MapTile* tile = newobject( MapTile, new MapTile( this, tileXY.getX( ), tileXY.getY( ), tileXY.getMagnification( ), ll, image ) );
+		onTileReceived( listener, tile );
+		#endif
+	}
+
 	//-------------------------------------------------------------------------
 	void MapSource::downloadCancelled( Downloader* downloader )
 	//-------------------------------------------------------------------------
@@ -26,6 +26,7 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 
 #include <maapi.h>
 #include <MAUtil/Downloader.h>
+#include <MAUtil/Environment.h>
 
 #include "MapTile.h"
 #include "Queue.h"
@@ -42,6 +43,7 @@ namespace MAP
 	class MapTile;
 	class MapSourceImageDownloader;
 	class MapSourceQueue;
+	class MapSourceDecodes;
 	class MapSource;
 
 	//=========================================================================
@@ -64,8 +66,11 @@ namespace MAP
 	 * 
 	 * A map source is a provider of map tiles.
 	 * Behavior is modeled after OpenStreetMap tile server.
+	 *
+	 * Tile images are decoded in the background with maCreateImageFromDataAsync,
+	 * where the runtime supports it, so that receiving a tile doesn't stall drawing.
 	 */
-	class MapSource : public DownloadListener
+	class MapSource : public DownloadListener, public CustomEventListener
 	//=========================================================================
 	{
 	public:
@@ -127,6 +132,10 @@ namespace MAP
 		void						finishedDownloading( Downloader* downloader, MAHandle data );
 		void						downloadCancelled(Downloader* downloader);
 		void						error(Downloader* downloader, int code);
+		//
+		// CustomEventListener override, receives decoded tile images
+		//
+		void						customEvent( const MAEvent& event );
 
 	private:
 		//
@@ -143,6 +152,11 @@ namespace MAP
 		//
 		bool						isInQueue( MapTileCoordinate tileXY );
 		bool						isInDownloaders( MapTileCoordinate tileXY );
+		bool						isDecoding( MapTileCoordinate tileXY );
+		//
+		// Creates the tile for a downloaded image
+		//
+		void						tileDecoded( IMapSourceListener* listener, MapTileCoordinate tileXY, MAHandle image );
 		//
 		//
 		//
@@ -156,6 +170,7 @@ namespace MAP
 		void						onError( IMapSourceListener* listener, int code );
 
 		MapSourceQueue*				mQueue;
+		MapSourceDecodes*			mDecodes;
 		MapSourceImageDownloader**	mDownloaders;
 		int							mTileCount;
 	};
@@ -36,6 +36,7 @@ namespace MAUI {
 		defaultFont = NULL;
 		defaultSkin = NULL;
 		overlay = NULL;
+		damageCount = 0;
 		singletonPtr = this;
 		//clipStackPtr = -1;
 		Environment::getEnvironment().addFocusListener(this);
@@ -185,6 +186,7 @@ namespace MAUI {
 		//printf("doing repaint!");
 		
 		Gfx_beginRendering();
+		damageCount = 0;
 		
 		//clearClipRect();
 		Gfx_clearClipRect();
@@ -211,7 +213,44 @@ namespace MAUI {
 		}
 
 		//maUpdateScreen();
-		Gfx_updateScreen();
+		if(damageCount > 0)
+			Gfx_updateScreenRects(damageRects, damageCount);
+		else
+			Gfx_updateScreen();
+	}
+
+	void Engine::addDamage(const MARect& rect) {
+		if(rect.width <= 0 || rect.height <= 0)
+			return;
+		// children are drawn inside their parents, which are damaged first.
+		for(int i = 0; i < damageCount; i++) {
+			const MARect& d = damageRects[i];
+			if(rect.left >= d.left && rect.top >= d.top &&
+				rect.left + rect.width <= d.left + d.width &&
+				rect.top + rect.height <= d.top + d.height)
+			{
+				return;
+			}
+		}
+		if(damageCount < MAX_DAMAGE_RECTS) {
+			damageRects[damageCount++] = rect;
+			return;
+		}
+		// too many; use one rect around all of them.
+		int left = rect.left, top = rect.top;
+		int right = rect.left + rect.width, bottom = rect.top + rect.height;
+		for(int i = 0; i < damageCount; i++) {
+			const MARect& d = damageRects[i];
+			if(d.left < left) left = d.left;
+			if(d.top < top) top = d.top;
+			if(d.left + d.width > right) right = d.left + d.width;
+			if(d.top + d.height > bottom) bottom = d.top + d.height;
+		}
+		damageRects[0].left = left;
+		damageRects[0].top = top;
+		damageRects[0].width = right - left;
+		damageRects[0].height = bottom - top;
+		damageCount = 1;
 	}
 	
 	void Engine::idle() {
@@ -41,7 +41,8 @@ namespace MAUI {
 	class Engine : public IdleListener, public FocusListener {
 	public:
 		enum {
-			MAX_WIDGET_DEPTH = 16
+			MAX_WIDGET_DEPTH = 16,
+			MAX_DAMAGE_RECTS = 16
 		};
 
 		/** Sets the widget that is main to the application, constituting the root of the UI tree **/
@@ -78,6 +79,12 @@ namespace MAUI {
 
 		/** Actually performs repainting **/ 
 		void repaint();
+
+		/** Widgets call this function when they draw themselves during repaint().
+		 * \a rect is in screen coordinates. Only the damaged parts of the screen
+		 * are updated at the end of repaint().
+		 **/
+		void addDamage(const MARect& rect);
 		
 		/** Returns a reference to the single instance of this class, using lazy
 		  * initialization.
@@ -106,6 +113,9 @@ namespace MAUI {
 
 		bool characterInputActive;
 
+		MARect damageRects[MAX_DAMAGE_RECTS];
+		int damageCount;
+
 	private:
 		Engine();
 	};
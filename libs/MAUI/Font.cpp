@@ -346,11 +346,52 @@ namespace MAUI {
 		delete []rebuiltFont;
 	} */
 
+#define GLYPH_BATCH_SIZE 64
+
+	/**
+	* Collects glyphs and draws them with one Gfx_drawImageRegions() call
+	* per GLYPH_BATCH_SIZE glyphs.
+	*/
+	class GlyphBatch {
+	public:
+		GlyphBatch(MAHandle image) : mImage(image), mCount(0) {}
+		~GlyphBatch() {
+			flush();
+		}
+
+		void add(const CharDescriptor& c, int x, int y) {
+			if(c.width == 0 || c.height == 0)
+				return;
+			MARect& src = mSrcs[mCount];
+			src.left = c.x;
+			src.top = c.y;
+			src.width = c.width;
+			src.height = c.height;
+			mDsts[mCount].x = x + c.xOffset;
+			mDsts[mCount].y = y + c.yOffset;
+			mCount++;
+			if(mCount == GLYPH_BATCH_SIZE)
+				flush();
+		}
+
+		void flush() {
+			if(mCount > 0)
+				Gfx_drawImageRegions(mImage, mSrcs, mDsts, mCount, TRANS_NONE);
+			mCount = 0;
+		}
+
+	private:
+		MAHandle mImage;
+		int mCount;
+		MARect mSrcs[GLYPH_BATCH_SIZE];
+		MAPoint2d mDsts[GLYPH_BATCH_SIZE];
+	};
+
 	void Font::drawString(const char* strS, int x, int y) {
 		if(!mFontImage) return;
 		const unsigned char* str = (const unsigned char*)strS;
-		MARect srcRect = {0, 0, 0, 0};
 		MAPoint2d cursor = {x,y};
+		GlyphBatch batch(mFontImage);
 
 		CharDescriptor *chars = mCharset->chars;
 		while(*str) {
@@ -362,16 +403,7 @@ namespace MAUI {
 				continue;
 			}
 
-			srcRect.left = chars[*str].x;
-			srcRect.top = chars[*str].y;
-			srcRect.width = chars[*str].width;
-			srcRect.height = chars[*str].height;
-
-			MAPoint2d destPoint = {cursor.x + chars[*str].xOffset,
-				cursor.y + chars[*str].yOffset};
-
-			//maDrawImageRegion(this->mFontImage, &srcRect, &destPoint, 0);
-			Gfx_drawImageRegion(this->mFontImage, &srcRect, &destPoint, 0);
+			batch.add(chars[*str], cursor.x, cursor.y);
 
 			cursor.x += chars[*str].xAdvance;
 			str++;
@@ -426,8 +458,8 @@ namespace MAUI {
 		if(!mFontImage) return;
 		const unsigned char* str = (const unsigned char*)strS;
 		calcLineBreaks(strS, x, y, bound);
-		MARect srcRect = {0, 0, 0, 0};
 		MAPoint2d cursor = {x, y};
+		GlyphBatch batch(mFontImage);
 		CharDescriptor *chars = mCharset->chars;
 		while(str[i]) {
 			if(lineBreaks[j] == i) {
@@ -440,16 +472,7 @@ namespace MAUI {
 				}
 			}
 
-			srcRect.left = chars[str[i]].x;
-			srcRect.top = chars[str[i]].y;
-			srcRect.width = chars[str[i]].width;
-			srcRect.height = chars[str[i]].height;
-
-			MAPoint2d destPoint = {cursor.x + chars[str[i]].xOffset,
-				cursor.y + chars[str[i]].yOffset};
-
-			//maDrawImageRegion(this->mFontImage, &srcRect, &destPoint, 0);
-			Gfx_drawImageRegion(this->mFontImage, &srcRect, &destPoint, 0);
+			batch.add(chars[str[i]], cursor.x, cursor.y);
 
 			cursor.x += chars[str[i]].xAdvance;
 			i++;
@@ -26,6 +26,17 @@ namespace MAUI {
 		MAExtent size = maGetImageSize(image);
 		int imgWidth = EXTENT_X(size);
 		int imgHeight = EXTENT_Y(size);
+
+		if(alphaMode == AM_WRITEALPHA) {
+			MARect rect = {0, 0, imgWidth, imgHeight};
+			MAPoint2d center = {origo.x, origo.y};
+			MAHandle lastDrawTarget = maSetDrawTarget(image);
+			int res = maFillRadialGradient(&rect, &center, radius, origoColor, circleColor);
+			maSetDrawTarget(lastDrawTarget);
+			if(res != IOCTL_UNAVAILABLE)
+				return;
+		}
+
 		int *tempSurface = new int[imgWidth*imgHeight];
 		if(!tempSurface) {
 			maPanic(0, "ImageGenerators::circularGradient, OH NO! NO MEMORY!!!!!!!!!!!!!!!!!!!!!!!!");
@@ -82,6 +93,7 @@ namespace MAUI {
 		}
 		
 		maSetDrawTarget(lastDrawTarget);
+		delete []tempSurface;
 	}
 
 	void ImageGenerators::linearGradient(MAHandle image, Point start, Point end, int startColor,
@@ -92,6 +104,17 @@ namespace MAUI {
 		int imgWidth = EXTENT_X(size);
 		int imgHeight = EXTENT_Y(size);
 
+		if(alphaMode == AM_WRITEALPHA) {
+			MARect rect = {0, 0, imgWidth, imgHeight};
+			MAPoint2d startPoint = {start.x, start.y};
+			MAPoint2d endPoint = {end.x, end.y};
+			MAHandle lastDrawTarget = maSetDrawTarget(image);
+			int res = maFillLinearGradient(&rect, &startPoint, &endPoint, startColor, endColor);
+			maSetDrawTarget(lastDrawTarget);
+			if(res != IOCTL_UNAVAILABLE)
+				return;
+		}
+
 		int gradVecX, gradVecY, 
 			gradOrthoVecX, gradOrthoVecY;
 
@@ -32,6 +32,9 @@ namespace MAUI {
 
 /** 
 * \brief Utility generating linear and circular gradients
+*
+* With AM_WRITEALPHA, the gradients are drawn by maFillLinearGradient() and
+* maFillRadialGradient() where the runtime has them.
 */
 
 class ImageGenerators {
@@ -166,33 +166,15 @@ namespace MAUI {
 		return maGetImageSize(placeholderStart + scale);
 	}
 
-	Scaler::Scaler(MAHandle image, const MARect *srcRect, double minScale, double maxScale, int levels, eScaleType scaleType) :
-	levels(levels)
-	{
-		int imageWidth = 0;
-		int imageHeight = 0;
-
-		// default dimensions in case of null user rect
-		if(!srcRect) {
-			MAExtent imageDims = maGetImageSize(image);
-			imageWidth = EXTENT_X(imageDims);
-			imageHeight = EXTENT_Y(imageDims);
-
-			MARect tempRect;
-			tempRect.left = tempRect.top = 0;
-			tempRect.width = imageWidth;
-			tempRect.height = imageHeight;
-			srcRect = &tempRect;
-		}
-
-		// user rect not null here - update the new dimensions
-		imageWidth  = srcRect->width;
-		imageHeight = srcRect->height;
+	// reads the pixels of srcRect, with an extra column and row for bilinear scaling.
+	static int* readImageData(MAHandle image, const MARect *srcRect, Scaler::eScaleType scaleType) {
+		int imageWidth = srcRect->width;
+		int imageHeight = srcRect->height;
 
 		int *imageData = new int[(imageWidth+1)*(imageHeight+1)];
 		maGetImageData(image, imageData, srcRect, imageWidth+1);
 
-		if(scaleType == ST_BILINEAR) {
+		if(scaleType != Scaler::ST_NEAREST_NEIGHBOUR) {
 			for(int i = 0; i < imageWidth; i++) {
 				imageData[i+(imageWidth+1)*(imageHeight)] = 
 					imageData[i+(imageWidth+1)*(imageHeight-1)];
@@ -202,6 +184,36 @@ namespace MAUI {
 					imageData[(imageWidth-1)+(imageWidth+1)*(i)];
 			}
 		}
+		return imageData;
+	}
+
+	static int scaleFilter(Scaler::eScaleType scaleType) {
+		switch(scaleType) {
+			case Scaler::ST_BILINEAR: return IMAGE_SCALE_BILINEAR;
+			case Scaler::ST_BOX: return IMAGE_SCALE_BOX;
+			default: return IMAGE_SCALE_NEAREST;
+		}
+	}
+
+	Scaler::Scaler(MAHandle image, const MARect *srcRect, double minScale, double maxScale, int levels, eScaleType scaleType) :
+	levels(levels)
+	{
+		// default dimensions in case of null user rect
+		MARect tempRect;
+		if(!srcRect) {
+			MAExtent imageDims = maGetImageSize(image);
+			tempRect.left = tempRect.top = 0;
+			tempRect.width = EXTENT_X(imageDims);
+			tempRect.height = EXTENT_Y(imageDims);
+			srcRect = &tempRect;
+		}
+
+		int imageWidth  = srcRect->width;
+		int imageHeight = srcRect->height;
+
+		// only read if the runtime can't scale.
+		int *imageData = NULL;
+		bool native = true;
 
 		int scaleDelta = (int)(((maxScale - minScale)*65536.0)/(double)levels);
 		int scale = (int)(minScale*65536.0);
@@ -213,26 +225,39 @@ namespace MAUI {
 		for(int i = 0; i < levels; i++) {
 			int scaledImageWidth = ((imageWidth*scale)>>16);
 			int scaledImageHeight = ((imageHeight*scale)>>16);		
-			int *scaledImageData = new int[scaledImageWidth*scaledImageHeight];
-			switch(scaleType) {
-				case ST_BILINEAR: 
-					bilinearScale(scaledImageData, scaledImageWidth, scaledImageHeight, scaledImageWidth, imageData, imageWidth, imageHeight, imageWidth+1);
-					break;
-				case ST_NEAREST_NEIGHBOUR:
-					nearestNeighbour(scaledImageData, scaledImageWidth, scaledImageHeight, scaledImageWidth, imageData, imageWidth, imageHeight, imageWidth+1);
-					break;
-			}
 
-			maCreateImageRaw(p, scaledImageData, EXTENT(scaledImageWidth, scaledImageHeight), 1);
+			bool scaled = false;
+			if(native && scaledImageWidth > 0 && scaledImageHeight > 0) {
+				native = maCreateScaledImage(p, image, srcRect, scaledImageWidth, scaledImageHeight,
+					scaleFilter(scaleType)) != IOCTL_UNAVAILABLE;
+				scaled = native;
+			}
 
-			// clean up
-			delete scaledImageData;
+			if(!scaled) {
+				if(!imageData)
+					imageData = readImageData(image, srcRect, scaleType);
+				int *scaledImageData = new int[scaledImageWidth*scaledImageHeight];
+				switch(scaleType) {
+					case ST_BILINEAR: 
+					case ST_BOX:
+						bilinearScale(scaledImageData, scaledImageWidth, scaledImageHeight, scaledImageWidth, imageData, imageWidth, imageHeight, imageWidth+1);
+						break;
+					case ST_NEAREST_NEIGHBOUR:
+						nearestNeighbour(scaledImageData, scaledImageWidth, scaledImageHeight, scaledImageWidth, imageData, imageWidth, imageHeight, imageWidth+1);
+						break;
+				}
+
+				maCreateImageRaw(p, scaledImageData, EXTENT(scaledImageWidth, scaledImageHeight), 1);
+
+				// clean up
+				delete[] scaledImageData;
+			}
 
 			// prepare for next iteration
 			scale += scaleDelta;
 			p = maCreatePlaceholder();
 		}
-		delete imageData;
+		delete[] imageData;
 	}
 
 	void Scaler::draw(int x, int y, int level) {
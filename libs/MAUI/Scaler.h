@@ -36,11 +36,19 @@ namespace MAUI {
 
 		enum eScaleType {
 			ST_NEAREST_NEIGHBOUR,
-			ST_BILINEAR
+			ST_BILINEAR,
+			/**
+			* Averages the pixels that each scaled pixel covers. Best for
+			* shrinking. On runtimes that can't scale images natively,
+			* it is the same as ST_BILINEAR.
+			*/
+			ST_BOX
 		};
 
 		// be aware that you need placeholderStart to placeholderStart+levels amount of placeholders ordered
 		// after each other.
+		// The levels are scaled by the runtime with maCreateScaledImage() where
+		// it is available, and pixel by pixel otherwise.
 		Scaler(MAHandle image, const MARect *srcRect, double minScale, double maxScale,
 			int levels, eScaleType scaleType);
 		MAExtent getSize(int scale);
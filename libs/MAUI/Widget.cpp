@@ -154,6 +154,7 @@ namespace MAUI {
 		{
 			if(isDirty() || forceDraw) 
 			{
+				Engine::getSingleton().addDamage(Gfx_getClipRect());
 				if(shouldDrawBackground) 
 				{
 					drawBackground();
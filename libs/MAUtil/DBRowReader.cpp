@@ -0,0 +1,145 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#include <ma.h>
+#include <mastring.h>
+#include "DBRowReader.h"
+
+using namespace MAUtil;
+
+// The buffer need not be aligned, so values are copied out of it.
+static int readInt(const byte* p) {
+	int i;
+	memcpy(&i, p, sizeof(int));
+	return i;
+}
+
+DBRowReader::DBRowReader(const void* buffer, int rowCount)
+: mPos((const byte*)buffer), mRowsLeft(rowCount), mRowEnd(NULL), mValue(NULL),
+mType(MA_DB_TYPE_NULL)
+{
+}
+
+bool DBRowReader::nextRow() {
+	if(mRowEnd)
+		mPos = mRowEnd;
+	mValue = NULL;
+	mType = MA_DB_TYPE_NULL;
+	if(mRowsLeft <= 0) {
+		mRowEnd = NULL;
+		return false;
+	}
+	mRowsLeft--;
+	mRowEnd = mPos + readInt(mPos);
+	mPos += sizeof(int);
+	return true;
+}
+
+bool DBRowReader::nextColumn() {
+	if(mValue) {
+		int size;
+		switch(mType) {
+		case MA_DB_TYPE_INT:
+			size = sizeof(int);
+			break;
+		case MA_DB_TYPE_INT64:
+		case MA_DB_TYPE_DOUBLE:
+			size = 8;
+			break;
+		case MA_DB_TYPE_TEXT:
+			// the zero byte.
+			size = sizeof(int) + readInt(mValue) + 1;
+			break;
+		case MA_DB_TYPE_BLOB:
+			size = sizeof(int) + readInt(mValue);
+			break;
+		default:
+			size = 0;
+		}
+		mPos = mValue + ((size + 3) & ~3);
+	}
+	if(mPos >= mRowEnd) {
+		mValue = NULL;
+		mType = MA_DB_TYPE_NULL;
+		return false;
+	}
+	mType = readInt(mPos);
+	mValue = mPos + sizeof(int);
+	return true;
+}
+
+int DBRowReader::getInt() const {
+	switch(mType) {
+	case MA_DB_TYPE_INT:
+		return readInt(mValue);
+	case MA_DB_TYPE_INT64:
+		return (int)getInt64();
+	case MA_DB_TYPE_DOUBLE:
+		return (int)getDouble();
+	default:
+		return 0;
+	}
+}
+
+longlong DBRowReader::getInt64() const {
+	switch(mType) {
+	case MA_DB_TYPE_INT:
+		return readInt(mValue);
+	case MA_DB_TYPE_INT64: {
+		longlong ll;
+		memcpy(&ll, mValue, sizeof(ll));
+		return ll;
+	}
+	case MA_DB_TYPE_DOUBLE:
+		return (longlong)getDouble();
+	default:
+		return 0;
+	}
+}
+
+double DBRowReader::getDouble() const {
+	switch(mType) {
+	case MA_DB_TYPE_INT:
+	case MA_DB_TYPE_INT64:
+		return (double)getInt64();
+	case MA_DB_TYPE_DOUBLE: {
+		double d;
+		memcpy(&d, mValue, sizeof(d));
+		return d;
+	}
+	default:
+		return 0;
+	}
+}
+
+const char* DBRowReader::getText() const {
+	if(mType != MA_DB_TYPE_TEXT)
+		return NULL;
+	return (const char*)mValue + sizeof(int);
+}
+
+const void* DBRowReader::getData() const {
+	if(mType != MA_DB_TYPE_TEXT && mType != MA_DB_TYPE_BLOB)
+		return NULL;
+	return mValue + sizeof(int);
+}
+
+int DBRowReader::getLength() const {
+	if(mType != MA_DB_TYPE_TEXT && mType != MA_DB_TYPE_BLOB)
+		return 0;
+	return readInt(mValue);
+}
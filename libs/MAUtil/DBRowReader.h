@@ -0,0 +1,130 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/** \file DBRowReader.h
+* \brief Reads the rows that maDBCursorFetchRows() copies into a buffer.
+*/
+
+#ifndef _SE_MSAB_MAUTIL_DBROWREADER_H_
+#define _SE_MSAB_MAUTIL_DBROWREADER_H_
+
+#include <ma.h>
+
+namespace MAUtil {
+
+/**
+* \brief Reads the rows that maDBCursorFetchRows() copies into a buffer.
+*
+* The rows and their columns are read in order:
+* \code
+* char buffer[4096];
+* int rows;
+* while((rows = maDBCursorFetchRows(cursor, buffer, sizeof(buffer), 100)) > 0) {
+* 	DBRowReader reader(buffer, rows);
+* 	while(reader.nextRow()) {
+* 		reader.nextColumn();
+* 		int id = reader.getInt();
+* 		reader.nextColumn();
+* 		const char* name = reader.getText();
+* 	}
+* }
+* \endcode
+*
+* The reader does not copy the buffer, so the buffer must not change
+* while it is being read.
+*/
+class DBRowReader {
+public:
+	/**
+	* Reads \a rowCount rows, the return value of maDBCursorFetchRows(),
+	* from \a buffer.
+	*/
+	DBRowReader(const void* buffer, int rowCount);
+
+	/**
+	* Moves to the next row, or to the first row if this is the first call.
+	* \returns False if there are no more rows.
+	*/
+	bool nextRow();
+
+	/**
+	* Moves to the next column of the current row, or to its first column
+	* if this is the first call since nextRow().
+	* \returns False if there are no more columns in the row.
+	*/
+	bool nextColumn();
+
+	/**
+	* Returns the type of the current column, one of #MA_DB_TYPE_NULL,
+	* #MA_DB_TYPE_INT, #MA_DB_TYPE_INT64, #MA_DB_TYPE_DOUBLE,
+	* #MA_DB_TYPE_TEXT or #MA_DB_TYPE_BLOB.
+	*/
+	int getType() const { return mType; }
+
+	/**
+	* Returns true if the current column is NULL.
+	*/
+	bool isNull() const { return mType == MA_DB_TYPE_NULL; }
+
+	/**
+	* Returns the current column as an int. INT64 values are truncated,
+	* and DOUBLE values are converted. Other types are 0.
+	*/
+	int getInt() const;
+
+	/**
+	* Returns the current column as a longlong. DOUBLE values are converted.
+	* Other types are 0.
+	*/
+	longlong getInt64() const;
+
+	/**
+	* Returns the current column as a double. Integers are converted.
+	* Other types are 0.
+	*/
+	double getDouble() const;
+
+	/**
+	* Returns the current column as zero-terminated text,
+	* or NULL if it is not TEXT.
+	* The text stays valid as long as the buffer does.
+	*/
+	const char* getText() const;
+
+	/**
+	* Returns the bytes of the current column, if it is TEXT or BLOB,
+	* or NULL otherwise. getLength() returns their number.
+	*/
+	const void* getData() const;
+
+	/**
+	* Returns the length in bytes of the current column, if it is TEXT
+	* or BLOB, not counting the zero byte after TEXT. Otherwise returns 0.
+	*/
+	int getLength() const;
+
+private:
+	const byte* mPos;
+	int mRowsLeft;
+	const byte* mRowEnd;
+	const byte* mValue;
+	int mType;
+};
+
+}
+
+#endif	//_SE_MSAB_MAUTIL_DBROWREADER_H_
@@ -67,9 +67,11 @@ typedef void (*DrawTextWFunc)(int left, int top, const wchar_t* text);
 typedef void (*DrawImageFunc)(MAHandle image, int left, int top);
 typedef void (*DrawRGBFunc)(const MAPoint2d *dstPoint, const void *src, const MARect *srcRect, int scanlength);
 typedef void (*DrawImageRegionFunc)(MAHandle image, const MARect *srcRect, const MAPoint2d *dstPoint, int transformMode);
+typedef void (*DrawImageRegionsFunc)(MAHandle image, const MARect *srcRects, const MAPoint2d *dstPoints, int count, int transformMode);
 typedef void (*NotifyImageUpdated)(MAHandle image);
 typedef void (*BeginRendering)(void);
 typedef void (*UpdateScreen)(void);
+typedef void (*UpdateScreenRects)(const MARect *rects, int count);
 typedef void (*SetClearColor)(int r, int g, int b);
 typedef void (*SetColor)(int r, int g, int b);
 typedef void (*SetAlpha)(int a);
@@ -94,9 +96,11 @@ typedef struct MAGraphicsDriver_t {
 	DrawImageFunc drawImage;
 	DrawRGBFunc drawRGB;
 	DrawImageRegionFunc drawImageRegion;
+	DrawImageRegionsFunc drawImageRegions;
 	NotifyImageUpdated notifyImageUpdated; // not very pretty (for opengl so that it knows that it has to update the texture again)
 	BeginRendering beginRendering;
 	UpdateScreen updateScreen;
+	UpdateScreenRects updateScreenRects;
 	SetClearColor setClearColor;	
 	SetColor setColor;
 	SetAlpha setAlpha;
@@ -133,6 +137,9 @@ BOOL Gfx_intersectClipRect(int left, int top, int width, int height);
    **/
 BOOL Gfx_popClipRect(void);
 
+/** Returns the current clip rect, in screen coordinates. **/
+MARect Gfx_getClipRect(void);
+
 /** 
   * Clears the transform stack.
   **/
@@ -169,6 +176,8 @@ void Gfx_drawTextW(int left, int top, const wchar_t* text);
 void Gfx_drawImage(MAHandle image, int left, int top);
 void Gfx_drawRGB(const MAPoint2d *dstPoint, const void *src, const MARect *srcRect, int scanlength);
 void Gfx_drawImageRegion(MAHandle image, const MARect *srcRect, const MAPoint2d *dstPoint, int transformMode);
+/** Draws \a count regions of \a image, like Gfx_drawImageRegion() does for each of them, but with fewer syscalls. **/
+void Gfx_drawImageRegions(MAHandle image, const MARect *srcRects, const MAPoint2d *dstPoints, int count, int transformMode);
 
 void Gfx_notifyImageUpdated(MAHandle image);
 
@@ -176,6 +185,8 @@ void Gfx_notifyImageUpdated(MAHandle image);
 // software do nothing.
 void Gfx_beginRendering(void);
 void Gfx_updateScreen(void);
+/** Like Gfx_updateScreen(), but only \a rects, in screen coordinates, need to be updated. **/
+void Gfx_updateScreenRects(const MARect *rects, int count);
 void Gfx_setClearColor(int r, int g, int b);
 void Gfx_setColor(int r, int g, int b);
 void Gfx_setAlpha(int a);
@@ -37,9 +37,11 @@ static void ogl_drawTextW(int left, int top, const wchar_t* text);
 static void ogl_drawImage(MAHandle image, int left, int top);
 static void ogl_drawRGB(const MAPoint2d *dstPoint, const void *src, const MARect *srcRect, int scanlength);
 static void ogl_drawImageRegion(MAHandle image, const MARect *srcRect, const MAPoint2d *dstPoint, int transformMode);
+static void ogl_drawImageRegions(MAHandle image, const MARect *srcRects, const MAPoint2d *dstPoints, int count, int transformMode);
 static void ogl_notifyImageUpdated(MAHandle image);
 static void ogl_beginRendering(void);
 static void ogl_updateScreen(void);
+static void ogl_updateScreenRects(const MARect *rects, int count);
 static void ogl_setClearColor(int r, int g, int b);
 static void ogl_setColor(int r, int g, int b);
 static void ogl_setAlpha(int a);
@@ -64,9 +66,11 @@ static MAGraphicsDriver sGLGraphicsDriver = {
 	&ogl_drawImage,
 	&ogl_drawRGB,
 	&ogl_drawImageRegion,
+	&ogl_drawImageRegions,
 	&ogl_notifyImageUpdated,
 	&ogl_beginRendering,
 	&ogl_updateScreen,
+	&ogl_updateScreenRects,
 	&ogl_setClearColor,
 	&ogl_setColor,
 	&ogl_setAlpha
@@ -339,6 +343,13 @@ static void ogl_drawImageRegion(MAHandle image, const MARect *srcRect, const MAP
 	drawImage(textureCoords, vertexCoords, texture);
 }
 
+static void ogl_drawImageRegions(MAHandle image, const MARect *srcRects, const MAPoint2d *dstPoints, int count, int transformMode) {
+	int i;
+	for(i = 0; i < count; i++) {
+		ogl_drawImageRegion(image, &srcRects[i], &dstPoints[i], transformMode);
+	}
+}
+
 static void ogl_notifyImageUpdated(MAHandle image) {
 	int i;
 	GLuint handle;
@@ -375,6 +386,11 @@ static void ogl_updateScreen(void) {
 		maWidgetSetProperty(sNativeUIOpenGLView, "invalidate", "");
 }
 
+// The whole frame is rendered again anyway.
+static void ogl_updateScreenRects(const MARect *rects, int count) {
+	ogl_updateScreen();
+}
+
 static int sColorR = 255, sColorG = 255, sColorB = 255, sAlpha = 255;
 
 static void ogl_setClearColor(int r, int g, int b) {
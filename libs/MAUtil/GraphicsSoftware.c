@@ -20,6 +20,7 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 
 #define MA_CLIP_STACK_DEPTH 128
 #define MA_TRANSFORM_STACK_DEPTH 128
+#define MA_REGION_BATCH_SIZE 64
 
 static MAPoint2d sTransformStack[MA_TRANSFORM_STACK_DEPTH];
 static int sTransformStackPtr = -1;
@@ -48,9 +49,11 @@ static void soft_drawTextW(int left, int top, const wchar_t* text);
 static void soft_drawImage(MAHandle image, int left, int top);
 static void soft_drawRGB(const MAPoint2d *dstPoint, const void *src, const MARect *srcRect, int scanlength);
 static void soft_drawImageRegion(MAHandle image, const MARect *srcRect, const MAPoint2d *dstPoint, int transformMode);
+static void soft_drawImageRegions(MAHandle image, const MARect *srcRects, const MAPoint2d *dstPoints, int count, int transformMode);
 static void soft_notifyImageUpdated(MAHandle image);
 static void soft_beginRendering(void);
 static void soft_updateScreen(void);
+static void soft_updateScreenRects(const MARect *rects, int count);
 static void soft_setClearColor(int r, int g, int b);
 static void soft_setColor(int r, int g, int b);
 static void soft_setAlpha(int a);
@@ -72,9 +75,11 @@ static MAGraphicsDriver sSoftwareGraphicsDriver = {
 	&soft_drawImage,
 	&soft_drawRGB,
 	&soft_drawImageRegion,
+	&soft_drawImageRegions,
 	&soft_notifyImageUpdated,
 	&soft_beginRendering,
 	&soft_updateScreen,
+	&soft_updateScreenRects,
 	&soft_setClearColor,
 	&soft_setColor,
 	&soft_setAlpha
@@ -186,6 +191,48 @@ static void soft_drawImageRegion(MAHandle image, const MARect *srcRect, const MA
 	maDrawImageRegion(image, srcRect, &p, transformMode);
 }
 
+// Set when the runtime turns out not to have maDrawImageRegions().
+static int sNoDrawImageRegions = false;
+
+static void soft_drawImageRegionsSingly(MAHandle image, const MARect *srcRects, const MAPoint2d *dstPoints, int count, int transformMode) {
+	int i;
+	for(i = 0; i < count; i++) {
+		soft_drawImageRegion(image, &srcRects[i], &dstPoints[i], transformMode);
+	}
+}
+
+static void soft_drawImageRegions(MAHandle image, const MARect *srcRects, const MAPoint2d *dstPoints, int count, int transformMode) {
+	MAPoint2d points[MA_REGION_BATCH_SIZE];
+	int i, n;
+
+	if(sNoDrawImageRegions) {
+		soft_drawImageRegionsSingly(image, srcRects, dstPoints, count, transformMode);
+		return;
+	}
+
+	while(count > 0) {
+		const MAPoint2d* p = dstPoints;
+		n = count;
+		if(sCurrentOffset.x != 0 || sCurrentOffset.y != 0) {
+			if(n > MA_REGION_BATCH_SIZE)
+				n = MA_REGION_BATCH_SIZE;
+			for(i = 0; i < n; i++) {
+				points[i].x = dstPoints[i].x + sCurrentOffset.x;
+				points[i].y = dstPoints[i].y + sCurrentOffset.y;
+			}
+			p = points;
+		}
+		if(maDrawImageRegions(image, srcRects, p, n, transformMode) == IOCTL_UNAVAILABLE) {
+			sNoDrawImageRegions = true;
+			soft_drawImageRegionsSingly(image, srcRects, dstPoints, count, transformMode);
+			return;
+		}
+		srcRects += n;
+		dstPoints += n;
+		count -= n;
+	}
+}
+
 static void soft_notifyImageUpdated(MAHandle image) {
 }
 
@@ -196,6 +243,18 @@ static void soft_updateScreen(void) {
 	maUpdateScreen();
 }
 
+// Set when the runtime turns out not to have maUpdateScreenRects().
+static int sNoUpdateScreenRects = false;
+
+static void soft_updateScreenRects(const MARect *rects, int count) {
+	if(!sNoUpdateScreenRects) {
+		if(maUpdateScreenRects(rects, count) != IOCTL_UNAVAILABLE)
+			return;
+		sNoUpdateScreenRects = true;
+	}
+	maUpdateScreen();
+}
+
 static void soft_setClearColor(int r, int g, int b) {
 }
 
@@ -0,0 +1,61 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#include <ma.h>
+#include <maassert.h>
+#include "ImageAtlas.h"
+
+using namespace MAUtil;
+
+// The table is written by tools/pipe-tool/rescomp.c:
+// int atlas;
+// int count;
+// MARect rects[count];
+ImageAtlas::ImageAtlas(MAHandle table) {
+	int header[2];
+	MAASSERT(maGetDataSize(table) >= (int)sizeof(header));
+	maReadData(table, header, 0, sizeof(header));
+	mImage = header[0];
+	mCount = header[1];
+	MAASSERT(mCount > 0 &&
+		maGetDataSize(table) == (int)(sizeof(header) + mCount * sizeof(MARect)));
+	mRects = new MARect[mCount];
+	maReadData(table, mRects, sizeof(header), mCount * sizeof(MARect));
+}
+
+ImageAtlas::~ImageAtlas() {
+	delete[] mRects;
+}
+
+const MARect& ImageAtlas::getRect(int index) const {
+	MAASSERT(index >= 0 && index < mCount);
+	return mRects[index];
+}
+
+MAExtent ImageAtlas::getSize(int index) const {
+	const MARect& r(getRect(index));
+	return EXTENT(r.width, r.height);
+}
+
+void ImageAtlas::draw(int index, int x, int y) const {
+	draw(index, x, y, TRANS_NONE);
+}
+
+void ImageAtlas::draw(int index, int x, int y, int transformMode) const {
+	MAPoint2d dst = { x, y };
+	maDrawImageRegion(mImage, &getRect(index), &dst, transformMode);
+}
@@ -0,0 +1,96 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/** \file ImageAtlas.h
+* \brief Draws images that the resource compiler has packed into an atlas.
+*/
+
+#ifndef _SE_MSAB_MAUTIL_IMAGEATLAS_H_
+#define _SE_MSAB_MAUTIL_IMAGEATLAS_H_
+
+#include <ma.h>
+
+namespace MAUtil {
+
+/**
+* \brief Draws images that the resource compiler has packed into an atlas.
+*
+* An atlas is declared in a resource list like this:
+* \code
+* .res R_ICONS
+* .atlas 256
+* .atlasimage ICON_OK, "ok.png"
+* .atlasimage ICON_CANCEL, "cancel.png"
+* \endcode
+* The images become a single image resource, R_ICONS, and the resource compiler
+* adds a binary resource, R_ICONS_TABLE, with the position of each image in it.
+* ICON_OK and ICON_CANCEL are the indices of the images in the table.
+*
+* All images in an atlas share one image handle, so drawing several of them
+* in a row touches a single image.
+*/
+class ImageAtlas {
+public:
+	/**
+	* Reads the table resource of an atlas, such as R_ICONS_TABLE.
+	*/
+	ImageAtlas(MAHandle table);
+	~ImageAtlas();
+
+	/**
+	* Returns the image that holds all the images of the atlas.
+	*/
+	MAHandle getImage() const { return mImage; }
+
+	/**
+	* Returns the number of images in the atlas.
+	*/
+	int getCount() const { return mCount; }
+
+	/**
+	* Returns the position of image \a index in the atlas image.
+	*/
+	const MARect& getRect(int index) const;
+
+	/**
+	* Returns the size of image \a index.
+	*/
+	MAExtent getSize(int index) const;
+
+	/**
+	* Draws image \a index with its top left corner at (\a x, \a y).
+	*/
+	void draw(int index, int x, int y) const;
+
+	/**
+	* Draws image \a index, transformed by \a transformMode, which is
+	* one of the \link #TRANS_NONE TRANS \endlink constants.
+	*/
+	void draw(int index, int x, int y, int transformMode) const;
+
+private:
+	MAHandle mImage;
+	int mCount;
+	MARect* mRects;
+
+	ImageAtlas(const ImageAtlas&);
+	ImageAtlas& operator=(const ImageAtlas&);
+};
+
+}
+
+#endif	//_SE_MSAB_MAUTIL_IMAGEATLAS_H_
@@ -71,76 +71,96 @@ namespace MAUtil {
 		mTimerEvents.setRunning(false);
 	}
 
+	void Moblet::dispatchEvent(const MAEvent& event) {
+		switch(event.type) {
+			case EVENT_TYPE_CLOSE:
+				fireCloseEvent();
+				exit();
+				break;
+			case EVENT_TYPE_FOCUS_GAINED:
+				fireFocusGainedEvent();
+				break;
+			case EVENT_TYPE_FOCUS_LOST:
+				fireFocusLostEvent();
+				break;
+			case EVENT_TYPE_KEY_PRESSED:
+				fireKeyPressEvent(event.key, event.nativeKey);
+				break;
+			case EVENT_TYPE_KEY_RELEASED:
+				fireKeyReleaseEvent(event.key, event.nativeKey);
+				break;
+			case EVENT_TYPE_CHAR:
+				fireCharEvent(event.character);
+				break;
+			case EVENT_TYPE_POINTER_PRESSED:
+				if (event.touchId == 0)
+					firePointerPressEvent(event.point);
+				fireMultitouchPressEvent(event.point, event.touchId);
+				break;
+			case EVENT_TYPE_POINTER_DRAGGED:
+				if (event.touchId == 0)
+					firePointerMoveEvent(event.point);
+				fireMultitouchMoveEvent(event.point, event.touchId);
+				break;
+			case EVENT_TYPE_POINTER_RELEASED:
+				if (event.touchId == 0)
+					firePointerReleaseEvent(event.point);
+				fireMultitouchReleaseEvent(event.point, event.touchId);
+				break;
+			case EVENT_TYPE_CONN:
+				fireConnEvent(event.conn);
+				break;
+			case EVENT_TYPE_BT:
+				fireBluetoothEvent(event.state);
+				break;
+			case EVENT_TYPE_TEXTBOX:
+				fireTextBoxListeners(event.textboxResult, event.textboxLength);
+				break;
+			case EVENT_TYPE_SENSOR:
+				fireSensorListeners(event.sensor);
+				break;
+			case EVENT_TYPE_ORIENTATION_DID_CHANGE:
+				fireOrientationChangedEvent(event.orientation);
+				break;
+			case EVENT_TYPE_ORIENTATION_WILL_CHANGE:
+				fireOrientationWillChangeEvent();
+				break;
+		    case EVENT_TYPE_CAMERA_SNAPSHOT:
+				fireCameraEvent(event);
+				break;
+		    case EVENT_TYPE_CAMERA_PREVIEW:
+		        fireCameraEvent(event);
+		        // We need to fire a custom event for backwards compatibility.
+		        fireCustomEventListeners(event);
+		        break;
+			case EVENT_TYPE_MEDIA_EXPORT_FINISHED:
+				fireMediaExportEvent(event);
+				break;
+			default:
+				fireCustomEventListeners(event);
+		}
+	}
+
+	// maGetEvents() isn't available on older runtimes.
+	// In that case, this falls back to maGetEvent().
+	static int getEvents(MAEvent* events, int max) {
+		static bool sHaveGetEvents = true;
+		if(sHaveGetEvents) {
+			int res = maGetEvents(events, max);
+			if(res != IOCTL_UNAVAILABLE)
+				return res;
+			sHaveGetEvents = false;
+		}
+		return maGetEvent(events);
+	}
+
 	void Moblet::run(Moblet* moblet) {
 		while(moblet->mRun) {
-			MAEvent event;
-			while(maGetEvent(&event)) {
-				switch(event.type) {
-					case EVENT_TYPE_CLOSE:
-						moblet->fireCloseEvent();
-						moblet->exit();
-						break;
-					case EVENT_TYPE_FOCUS_GAINED:
-						moblet->fireFocusGainedEvent();
-						break;
-					case EVENT_TYPE_FOCUS_LOST:
-						moblet->fireFocusLostEvent();
-						break;
-					case EVENT_TYPE_KEY_PRESSED:
-						moblet->fireKeyPressEvent(event.key, event.nativeKey);
-						break;
-					case EVENT_TYPE_KEY_RELEASED:
-						moblet->fireKeyReleaseEvent(event.key, event.nativeKey);
-						break;
-					case EVENT_TYPE_CHAR:
-						moblet->fireCharEvent(event.character);
-						break;
-					case EVENT_TYPE_POINTER_PRESSED:
-						if (event.touchId == 0)
-							moblet->firePointerPressEvent(event.point);
-						moblet->fireMultitouchPressEvent(event.point, event.touchId);
-						break;
-					case EVENT_TYPE_POINTER_DRAGGED:
-						if (event.touchId == 0)
-							moblet->firePointerMoveEvent(event.point);
-						moblet->fireMultitouchMoveEvent(event.point, event.touchId);
-						break;
-					case EVENT_TYPE_POINTER_RELEASED:
-						if (event.touchId == 0)
-							moblet->firePointerReleaseEvent(event.point);
-						moblet->fireMultitouchReleaseEvent(event.point, event.touchId);
-						break;
-					case EVENT_TYPE_CONN:
-						moblet->fireConnEvent(event.conn);
-						break;
-					case EVENT_TYPE_BT:
-						moblet->fireBluetoothEvent(event.state);
-						break;
-					case EVENT_TYPE_TEXTBOX:
-						moblet->fireTextBoxListeners(event.textboxResult, event.textboxLength);
-						break;
-					case EVENT_TYPE_SENSOR:
-						moblet->fireSensorListeners(event.sensor);
-						break;
-					case EVENT_TYPE_ORIENTATION_DID_CHANGE:
-						moblet->fireOrientationChangedEvent(event.orientation);
-						break;
-					case EVENT_TYPE_ORIENTATION_WILL_CHANGE:
-						moblet->fireOrientationWillChangeEvent();
-						break;
-				    case EVENT_TYPE_CAMERA_SNAPSHOT:
-						moblet->fireCameraEvent(event);
-						break;
-				    case EVENT_TYPE_CAMERA_PREVIEW:
-				        moblet->fireCameraEvent(event);
-				        // We need to fire a custom event for backwards compatibility.
-				        moblet->fireCustomEventListeners(event);
-				        break;
-					case EVENT_TYPE_MEDIA_EXPORT_FINISHED:
-						moblet->fireMediaExportEvent(event);
-						break;
-					default:
-						moblet->fireCustomEventListeners(event);
+			MAEvent events[MOBLET_EVENT_BATCH];
+			int count;
+			while((count = getEvents(events, MOBLET_EVENT_BATCH)) > 0) {
+				for(int i=0; i<count; i++) {
+					moblet->dispatchEvent(events[i]);
 				}
 			}
 
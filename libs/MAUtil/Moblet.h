@@ -33,6 +33,11 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 #include "Environment.h"
 #include "Vector.h"
 
+/**
+* The maximum number of events Moblet::run() retrieves with each call to maGetEvents().
+*/
+#define MOBLET_EVENT_BATCH 16
+
 namespace MAUtil {
 
 	/**
@@ -129,6 +134,12 @@ namespace MAUtil {
 		*/
 		bool mRun;
 
+		/**
+		* Passes an event to the appropriate listeners.
+		* Moblet::run() calls this for each event it retrieves.
+		*/
+		void dispatchEvent(const MAEvent& event);
+
 		/**
 		* Moblet's destructor calls close(), ensuring that a Moblet-based application
 		* doesn't run without a live Moblet.
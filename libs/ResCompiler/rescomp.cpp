@@ -40,8 +40,15 @@ int resource_selector()
 {
 	resManager = new ResourceCompiler::VariantResourceLookup();
 
-	int labelMapping = maFindLabel("variant-mapping");
-	int labelTypes = maFindLabel("res-types");
+	const char* labels[] = { "variant-mapping", "res-types" };
+	int indices[2];
+	if (maFindLabels(labels, indices, 2) == IOCTL_UNAVAILABLE)
+	{
+		indices[0] = maFindLabel(labels[0]);
+		indices[1] = maFindLabel(labels[1]);
+	}
+	int labelMapping = indices[0];
+	int labelTypes = indices[1];
 
 	resManager->countResources();
 
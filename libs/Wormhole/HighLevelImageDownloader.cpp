@@ -33,7 +33,8 @@ namespace Wormhole
 /**
  * Constructor.
  */
-HighLevelImageDownloader::HighLevelImageDownloader()
+HighLevelImageDownloader::HighLevelImageDownloader() :
+	mDecodingImage(0)
 {
 }
 
@@ -42,6 +43,12 @@ HighLevelImageDownloader::HighLevelImageDownloader()
  */
 HighLevelImageDownloader::~HighLevelImageDownloader()
 {
+	if (mDecodingImage)
+	{
+		Environment::getEnvironment().removeCustomEventListener(this);
+		maCancelImageDecode(mDecodingImage);
+		maDestroyPlaceholder(mDecodingImage);
+	}
 }
 
 /**
@@ -62,9 +69,27 @@ void HighLevelImageDownloader::dataDownloaded(MAHandle data, int result)
 	// Do we have any data?
 	if (data)
 	{
-		// Convert data to image.
 		image = maCreatePlaceholder();
-		int res = maCreateImageFromData(
+
+		// Decode the image in the background if possible.
+		// The data is copied, so we can deallocate it right away.
+		int res = maCreateImageFromDataAsync(
+			image,
+			data,
+			0,
+			maGetDataSize(data));
+		if (RES_OK == res)
+		{
+			maDestroyPlaceholder(data);
+			mDecodingImage = image;
+			Environment::getEnvironment().addCustomEventListener(this);
+
+			// Next thing that happens is that customEvent is called.
+			return;
+		}
+
+		// Convert data to image.
+		res = maCreateImageFromData(
 			image,
 			data,
 			0,
@@ -85,4 +110,32 @@ void HighLevelImageDownloader::dataDownloaded(MAHandle data, int result)
 	onDownloadComplete(image);
 }
 
+/**
+ * Inherited from CustomEventListener.
+ * Receives the #EVENT_TYPE_IMAGE_DECODED event for the image.
+ * Calls onDownloadComplete.
+ */
+void HighLevelImageDownloader::customEvent(const MAEvent& event)
+{
+	if (EVENT_TYPE_IMAGE_DECODED != event.type
+		|| event.imagePlaceholder != mDecodingImage)
+	{
+		return;
+	}
+
+	MAHandle image = mDecodingImage;
+	mDecodingImage = 0;
+	Environment::getEnvironment().removeCustomEventListener(this);
+
+	// Do we have an error?
+	if (RES_OK != event.imageDecodeResult)
+	{
+		maDestroyPlaceholder(image);
+		image = 0;
+	}
+
+	// Notify download complete. This may delete the downloader.
+	onDownloadComplete(image);
+}
+
 } // namespace
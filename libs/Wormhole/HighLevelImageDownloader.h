@@ -34,6 +34,7 @@ MA 02110-1301, USA.
 #ifndef WORMHOLE_HIGH_LEVEL_IMAGE_DOWNLOADER_H
 #define WORMHOLE_HIGH_LEVEL_IMAGE_DOWNLOADER_H
 
+#include <MAUtil/Environment.h>
 #include "HighLevelHttpConnection.h"
 
 namespace Wormhole
@@ -45,6 +46,9 @@ namespace Wormhole
  *
  * Call maDestroyPlaceholder to deallocate the downloaded image.
  *
+ * The image is decoded in the background, using
+ * maCreateImageFromDataAsync, where the runtime supports it.
+ *
  * Example of use:
  *
  * class MyImageDownloader : public HighLevelImageDownloader
@@ -59,7 +63,9 @@ namespace Wormhole
  * // Start download.
  * (new MyDownloader())->get("http://...");
  */
-class HighLevelImageDownloader : public HighLevelHttpConnection
+class HighLevelImageDownloader :
+	public HighLevelHttpConnection,
+	public MAUtil::CustomEventListener
 {
 public:
 	/**
@@ -93,6 +99,20 @@ protected:
 	 * otherwise an HTTP error code.
 	 */
 	virtual void dataDownloaded(MAHandle data, int result);
+
+	/**
+	 * Inherited from CustomEventListener.
+	 * Receives the #EVENT_TYPE_IMAGE_DECODED event for the image.
+	 * Calls onDownloadComplete.
+	 */
+	virtual void customEvent(const MAEvent& event);
+
+private:
+	/**
+	 * The image that is being decoded in the background,
+	 * or 0 if there is none.
+	 */
+	MAHandle mDecodingImage;
 };
 
 }
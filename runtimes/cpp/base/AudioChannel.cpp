@@ -16,6 +16,7 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 */
 
 #include <cstdlib>
+#include <cstring>
 #include "AudioChannel.h"
 #include "AudioSource.h"
 
@@ -32,8 +33,13 @@ AudioChannel::AudioChannel ( int s, AudioSource* audioSource )
   mVolume( 0xffff ),
   mOutputSampleRate( s ),
   mAudioSource( audioSource ),
-  mBufferedSamples( 0 ),
-  mBufferedSamplePos( 0 )
+  mSourceGeneration( 0 ),
+  mResampler( AudioMix::LINEAR ),
+  mMixSource( NULL ),
+  mMixGeneration( -1 ),
+  mMixResampler( AudioMix::LINEAR ),
+  mSourceRate( 0 ),
+  mDelta( 0 )
 {
 }
 
@@ -44,9 +50,21 @@ AudioChannel::AudioChannel ( int s, AudioSource* audioSource )
  */
 void AudioChannel::setAudioSource ( AudioSource* as )
 {
+    // the generation is published first, so that mix() sees the new
+    // generation whenever it sees the new source.
+    atomicIncrement( &mSourceGeneration );
     mAudioSource = as;
 }
 
+/**
+ * Waits until the audio thread is no longer mixing a source
+ * that was replaced before this call.
+ */
+void AudioChannel::waitForMix ( void )
+{
+    mRcu.synchronize( );
+}
+
 /**
  * Returns the current audio source
  *
@@ -100,51 +118,74 @@ int AudioChannel::getVolume ( void )
 	return mVolume;
 }
 
+/**
+ * Sets how sources with another sample rate than the output
+ * are resampled.
+ *
+ * @param r     The resampler
+ */
+void AudioChannel::setResampler ( AudioMix::Resampler r )
+{
+    mResampler = r;
+}
+
 
 
 /**
- * This is a template for on the fly converting and mixing from
- * any source (8/16/mono/stereo) format to 32 bit signed stereo
+ * Starts mixing a new source, or the same source with a new
+ * sample rate or resampler. The frame buffer starts with silence
+ * in place of the history that the resampler reads.
  *
- * @param dst           Pointer to the destination buffer
- * @param numSamples    Number of samples to mix
- * @param src           Pointer to the source buffer
- * @param pos           The position in the source buffer to start (24.8 FIXP)
- * @param delta         The increment delta (24.8 FIXP)
- * @param vol           The source volume [0-1) (16.16 FIXP)
+ * @param as            Pointer to the audio source
+ * @param generation    The source generation that \a as was read with
  */
-template< typename SrcT, int srcBitDepth, int srcNumChannels, bool sign >
-void convert_audio ( int *dst, int numSamples, const SrcT *src,
-                     int pos, int delta, int vol )
+void AudioChannel::resetMixer ( AudioSource* as, long generation )
 {
-    int sample;
+    mMixSource      = as;
+    mMixGeneration  = generation;
+    mMixResampler   = mResampler;
+    mSourceRate     = as->getInfo().sampleRate;
+    // amount of src frames per dst frame (in 16:16 fixed point)
+    mDelta          = (int)(((long long)mSourceRate<<16)/mOutputSampleRate);
+
+    int history = AudioMix::lookBehind( mMixResampler );
+    mFrames.assign( history*2, 0 );
+    mPos.index  = history;
+    mPos.frac   = 0;
+
+    if ( mMixResampler == AudioMix::POLYPHASE )
+        AudioMix::makePolyphaseTable( mPolyphaseTable, mSourceRate, mOutputSampleRate );
+}
 
-    for( int i = 0; i < numSamples; i++ )
+/**
+ * Drops the frames that the resampler is done with, and appends
+ * the next buffer of the source.
+ *
+ * @return false if the source has ended
+ */
+bool AudioChannel::refill ( void )
+{
+    // when downsampling, the position may already be past the buffered frames.
+    int first = mPos.index - AudioMix::lookBehind( mMixResampler );
+    if ( first > (int)(mFrames.size( )/2) )
+        first = (int)(mFrames.size( )/2);
+    if ( first > 0 )
     {
-        sample = (int)src[((pos>>8)<<(srcNumChannels>>1))];
-        if ( sign == false )
-            sample -= ((1<<srcBitDepth)>>1);
-        sample <<= 16-srcBitDepth;
-        sample = (sample*vol)>>16;
-        dst[i*2+0] += sample;
-
-        if ( srcNumChannels == 2 )
-        {
-            sample = (int)src[((pos>>8)<<1)+1];
-            if ( sign == false)
-                sample -= ((1<<srcBitDepth)>>1);
-            sample <<= 16-srcBitDepth;
-            sample = (sample*vol)>>16;
-            dst[i*2+1] += sample;
-        }
-        else
-            dst[i*2+1] += sample;
-
-        pos+=delta;
+        mFrames.erase( mFrames.begin( ), mFrames.begin( ) + first*2 );
+        mPos.index -= first;
     }
-}
 
+    int numFrames = mMixSource->fillBuffer( );
+    if ( numFrames <= 0 )
+        return false;
 
+    const AudioSource::Info& info = mMixSource->getInfo( );
+    size_t old = mFrames.size( );
+    mFrames.resize( old + numFrames*2 );
+    AudioMix::toStereo16( &mFrames[old], mMixSource->getBuffer( ), numFrames,
+                          info.fmt, info.numChannels );
+    return true;
+}
 
 /**
  * Converts and mixes the audio source to the internal buffer
@@ -155,75 +196,51 @@ void convert_audio ( int *dst, int numSamples, const SrcT *src,
  */
 void AudioChannel::mix ( int *dst, int numSamples )
 {
-    if ( mAudioSource == NULL || mActive == false )
+    mRcu.readBegin( );
+    AudioSource *source = mAudioSource;
+    atomicMemoryBarrier( );
+    long generation = mSourceGeneration;
+    if ( source == NULL || mActive == false )
+    {
+        mRcu.readEnd( );
         return;
+    }
 
-    int samplesWritten = 0;
-    int srate   = mAudioSource->getInfo().sampleRate;
-    int delta   = (srate<<8)/mOutputSampleRate; // amount of src samples per dst sample (in 24:8 fixed point)
-    int snc     = mAudioSource->getInfo().numChannels;
-    //int numSourceSamples = srate*numSamples/mOutputSampleRate; //
-
-    AudioSource::Format sfmt = mAudioSource->getInfo().fmt;
-    
-
-    const void *src = mAudioSource->getBuffer();
+    // the address alone isn't enough; a new source may be allocated
+    // where a deleted one was.
+    if ( source != mMixSource || generation != mMixGeneration ||
+         mResampler != mMixResampler ||
+         source->getInfo( ).sampleRate != mSourceRate )
+        resetMixer( source, generation );
+    if ( mDelta <= 0 )
+    {
+        mRcu.readEnd( );
+        return;
+    }
 
+    int ahead = AudioMix::lookAhead( mMixResampler );
+    int samplesWritten = 0;
     while ( samplesWritten < numSamples )
     {
-        if ( mBufferedSamples == false )
+        // the outputs whose frames, and the frames after them that the
+        // resampler reads, are all buffered.
+        int numFrames = (int)(mFrames.size( )/2);
+        long long limit = (long long)(numFrames - ahead - mPos.index)*0x10000 - mPos.frac;
+        int count = limit > 0 ? (int)((limit + mDelta - 1)/mDelta) : 0;
+        if ( count > numSamples - samplesWritten )
+            count = numSamples - samplesWritten;
+
+        if ( count > 0 )
         {
-            if ( (mBufferedSamples=mAudioSource->fillBuffer( )) == false )
-            {
-                mActive = false;
-                break;
-            }
-            mBufferedSamplePos = 0;
+            AudioMix::resampleMix( &dst[samplesWritten<<1], count, &mFrames[0], mPos,
+                                   mDelta, mVolume, mMixResampler, mPolyphaseTable );
+            samplesWritten += count;
         }
-
-        int copySize = numSamples - samplesWritten;
-        int scaledBufferedSamples = (mBufferedSamples*mOutputSampleRate)/srate;
-
-        if ( copySize > scaledBufferedSamples )
-            copySize = scaledBufferedSamples;
-
-        if ( copySize > 0 )
+        else if ( refill( ) == false )
         {
-            switch ( sfmt )
-            {
-                case AudioSource::FMT_S8:
-                    if ( snc == 1 )
-                        convert_audio<char, sizeof(char)<<3, 1, true>( &dst[samplesWritten<<1], copySize, (char*)src, mBufferedSamplePos<<8, delta, mVolume );
-                    else
-                        convert_audio<char, sizeof(char)<<3, 2, true>( &dst[samplesWritten<<1], copySize, (char*)src, mBufferedSamplePos<<8, delta, mVolume );
-                    break;
-                case AudioSource::FMT_S16:
-                    if( snc == 1 )
-                        convert_audio<short, sizeof(short)<<3, 1, true>( &dst[samplesWritten<<1], copySize, (short*)src, mBufferedSamplePos<<8, delta, mVolume );
-                    else
-                        convert_audio<short, sizeof(short)<<3, 2, true>( &dst[samplesWritten<<1], copySize, (short*)src, mBufferedSamplePos<<8, delta, mVolume );
-                    break;
-                case AudioSource::FMT_U8:
-                    if ( snc == 1 )
-                        convert_audio<unsigned char, sizeof(char)<<3, 1, false>( &dst[samplesWritten<<1], copySize, (unsigned char*)src, mBufferedSamplePos<<8, delta, mVolume);
-                    else
-                        convert_audio<unsigned char, sizeof(char)<<3, 2, false>( &dst[samplesWritten<<1], copySize, (unsigned char*)src, mBufferedSamplePos<<8, delta, mVolume);
-                    break;
-                case AudioSource::FMT_U16:
-                    if ( snc == 1 )
-                        convert_audio<unsigned short, sizeof(short)<<3, 1, false>( &dst[samplesWritten<<1], copySize, (unsigned short*)src, mBufferedSamplePos<<8, delta, mVolume );
-                    else
-                        convert_audio<unsigned short, sizeof(short)<<3, 2, false>( &dst[samplesWritten<<1], copySize, (unsigned short*)src, mBufferedSamplePos<<8, delta, mVolume );
-                    break;
-            }
-
-            int scaledCopySize = (copySize*delta)>>8;
-            if ( scaledCopySize == 0 )
-                scaledCopySize = 1;
-
-            samplesWritten      += copySize;
-            mBufferedSamplePos  += scaledCopySize;
-            mBufferedSamples    -= scaledCopySize;
+            mActive = false;
+            break;
         }
     }
+    mRcu.readEnd( );
 }
@@ -19,6 +19,9 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 #define _AUDIO_CHANNEL_H_
 
 #include <cstdlib>
+#include <vector>
+#include <helpers/rcu.h>
+#include "AudioMix.h"
 
 class AudioSource;
 
@@ -27,6 +30,10 @@ class AudioSource;
  * as input and does on the fly conversion and mixing to
  * an internal buffer.
  *
+ * mix() is called by the audio thread, and the rest by the
+ * VM thread. They share no lock; the audio source is handed
+ * over with Rcu.
+ *
  */
 class AudioChannel
 {
@@ -36,9 +43,26 @@ protected:
 
     int             mOutputSampleRate;
 
-    AudioSource*    mAudioSource;
-    int             mBufferedSamples;
-    int             mBufferedSamplePos;
+    AudioSource* volatile mAudioSource;
+    // Incremented by every setAudioSource(), so that a new source is
+    // noticed even if it has the address of a deleted one.
+    volatile long   mSourceGeneration;
+    AudioMix::Resampler mResampler;
+    Rcu             mRcu;
+
+    // Mixer state, only used by the audio thread.
+    AudioSource*    mMixSource;
+    long            mMixGeneration;
+    AudioMix::Resampler mMixResampler;
+    int             mSourceRate;
+    int             mDelta;
+    // Converted frames, starting with the history the resampler needs.
+    std::vector<short> mFrames;
+    AudioMix::Position mPos;
+    short           mPolyphaseTable[POLYPHASE_TABLE_SIZE];
+
+    void resetMixer ( AudioSource* as, long generation );
+    bool refill ( void );
 
 public:
     /**
@@ -58,6 +82,14 @@ public:
      */
     void setAudioSource ( AudioSource* as );
 
+    /**
+     * Waits until the audio thread is no longer mixing a source
+     * that was replaced before this call, so that it may be
+     * deleted. Must not be called while the audio thread is
+     * blocked on the calling thread.
+     */
+    void waitForMix ( void );
+
     /**
      * Returns the current audio source
      *
@@ -96,6 +128,14 @@ public:
      */
     int getVolume ( void );
 
+    /**
+     * Sets how sources with another sample rate than the output
+     * are resampled. Default is AudioMix::LINEAR.
+     *
+     * @param r     The resampler
+     */
+    void setResampler ( AudioMix::Resampler r );
+
     /**
      * Converts and mixes the audio source to the internal buffer
      *
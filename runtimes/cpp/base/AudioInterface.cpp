@@ -22,11 +22,13 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
  * Created on July 16, 2009
  */
 #include <cstdlib>
+#include <algorithm>
 #include "helpers/types.h"
 #include "mostl/algorithm"
 #include "config_platform.h"
 #include "AudioChannel.h"
 #include "AudioInterface.h"
+#include "AudioMix.h"
 #include "thread/lock.hpp"
 #include "thread/mutexfactory.hpp"
 #include "allocationfailedexception.hpp"
@@ -68,6 +70,7 @@ AudioInterface::AudioInterface ( int r, int c, int b, bool s )
     m_outputSampleBits  = b;
     m_outputSampleRate  = r;
 	m_outputSigned		= s;
+    m_channelSet        = new ChannelSet;
 
     // Allocate mutex
     m_mutex = MutexFactory::getInstance( )->createMutex( );
@@ -86,6 +89,21 @@ AudioInterface::~AudioInterface ( void )
 {
     m_instance = NULL;
     delete m_mutex;
+    delete m_channelSet;
+}
+
+/**
+ * Makes s the channel set, and deletes the old set when the
+ * callback is done with it. Must be called with m_mutex locked.
+ *
+ * @param s     The new channel set
+ */
+void AudioInterface::publishChannels ( ChannelSet *s )
+{
+    ChannelSet *old = m_channelSet;
+    m_channelSet = s;
+    m_rcu.synchronize( );
+    delete old;
 }
 
 
@@ -100,7 +118,9 @@ void AudioInterface::removeChannel ( AudioChannel *c )
 {
     Lock l( m_mutex );
 
-    m_activeChanList.remove( c );
+    ChannelSet *s = new ChannelSet( *m_channelSet );
+    s->erase( std::remove( s->begin( ), s->end( ), c ), s->end( ) );
+    publishChannels( s );
 }
 
 /**
@@ -114,8 +134,10 @@ void AudioInterface::deleteChannels ( void )
 {
     Lock l( m_mutex );
 
-    while ( m_activeChanList.empty( ) == false )
-        delete m_activeChanList.front( );
+    ChannelSet channels = *m_channelSet;
+    publishChannels( new ChannelSet );
+    for ( size_t i = 0; i < channels.size( ); i++ )
+        delete channels[i];
 }
 
 
@@ -139,7 +161,9 @@ AudioChannel* AudioInterface::createChannel ( void )
     }
 
     Lock l( m_mutex );
-    m_activeChanList.push_back( c );
+    ChannelSet *s = new ChannelSet( *m_channelSet );
+    s->push_back( c );
+    publishChannels( s );
     return c;
 }
 
@@ -262,25 +286,21 @@ void convert_audio ( dst_t *dst, const int *src, int numSamples, int vol )
  */
 void AudioInterface::outputCallback ( void *b, size_t len )
 {
-    Lock    lck( m_mutex );
     size_t numSamples = len/((m_outputSampleBits/8)*m_outputChannels);
 
     // Reset audio buffer
     memset( m_audioBuffer, 0, AUDIO_BUF_SAMPLES*2*sizeof( int ) );
 
-    // Mix in all active channels
-    std::list<AudioChannel *>::iterator it;
-    for ( it = m_activeChanList.begin( ); it != m_activeChanList.end( ); ++it )    
-        (*it)->mix( m_audioBuffer, numSamples );
+    // Mix in all active channels, without taking the mutex
+    m_rcu.readBegin( );
+    const ChannelSet *channels = m_channelSet;
+    for ( size_t i = 0; i < channels->size( ); i++ )
+        (*channels)[i]->mix( m_audioBuffer, numSamples );
+    m_rcu.readEnd( );
 
     // Convert to output format
 #ifndef __SOUND_OUTPUT_USE_CONVERSION__
-    s16 *out = static_cast<s16 *>( b );
-    for ( size_t i = 0; i < numSamples; i++ )
-    {
-        out[i*2+0] = (s16)mostd::clamp<int>( -32768, m_audioBuffer[i*2+0], 32767 );
-        out[i*2+1] = (s16)mostd::clamp<int>( -32768, m_audioBuffer[i*2+1], 32767 );
-    }
+    AudioMix::clampToS16( static_cast<s16 *>( b ), m_audioBuffer, numSamples*2 );
 #else
     switch ( m_outputSampleBits )
     {
@@ -26,7 +26,9 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 #define	__AUDIOINTERFACE_H__
 
 #include <list>
+#include <vector>
 #include <thread/mutex.hpp>
+#include <helpers/rcu.h>
 #include "Stream.h"
 
 
@@ -49,7 +51,12 @@ class AudioInterface
 protected:
     static AudioInterface*      m_instance;
     Base::Thread::Mutex*        m_mutex;
-    std::list<AudioChannel *>   m_activeChanList;
+    // The channels that the callback mixes. The other threads
+    // replace the whole set under m_mutex, and never change it,
+    // so the callback can use it without locking.
+    typedef std::vector<AudioChannel *> ChannelSet;
+    ChannelSet* volatile        m_channelSet;
+    Rcu                         m_rcu;
     std::list<AudioSource *>    m_activeSourceList;
     bool			m_outputSigned;
     int                         m_outputSampleRate;
@@ -99,6 +106,14 @@ protected:
      */
     void deleteChannels ( void );
 
+    /**
+     * Makes \a s the channel set, and deletes the old set when the
+     * callback is done with it. Must be called with m_mutex locked.
+     *
+     * @param s     The new channel set
+     */
+    void publishChannels ( ChannelSet *s );
+
 
     /**
      * Deletes all the audio sources in the active source list.
@@ -0,0 +1,296 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#include "config_platform.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "AudioSource.h"
+#include "AudioMix.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIX_SSE2
+#include <emmintrin.h>
+#endif
+
+#define FP_ONE 0x10000
+#define FP_MASK 0xffff
+//the filter coefficients are 2.14 fixed point.
+#define TAP_BITS 14
+#define TAPS 8
+#define PHASE_SHIFT (16 - 5)
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace AudioMix {
+
+	int lookBehind(Resampler r) {
+		return r == POLYPHASE ? TAPS/2 - 1 : 0;
+	}
+
+	int lookAhead(Resampler r) {
+		return r == POLYPHASE ? TAPS/2 : r == LINEAR ? 1 : 0;
+	}
+
+	//*************************************************************************
+	// Conversion
+	//*************************************************************************
+
+	//the first sample of each format is shifted to 16 bits, then its sign bit
+	//is flipped if it's unsigned.
+	template<class T, bool sign> static inline short sample16(const T* src, int i) {
+		int s = (int)src[i] * (1 << (16 - sizeof(T) * 8));
+		return (short)(sign ? s : s ^ 0x8000);
+	}
+
+#ifdef MIX_SSE2
+	//loads 8 samples, as shorts.
+	template<class T, bool sign> static inline __m128i load8(const T* src) {
+		__m128i v;
+		if(sizeof(T) == 1)
+			v = _mm_unpacklo_epi8(_mm_setzero_si128(), _mm_loadl_epi64((const __m128i*)src));
+		else
+			v = _mm_loadu_si128((const __m128i*)src);
+		if(!sign)
+			v = _mm_xor_si128(v, _mm_set1_epi16((short)0x8000));
+		return v;
+	}
+#endif
+
+	template<class T, bool sign> static void convert(short* dst, const T* src, int frames, int channels) {
+		int i = 0;
+		if(channels == 2) {
+#ifdef MIX_SSE2
+			for(; i + 4 <= frames; i += 4) {
+				_mm_storeu_si128((__m128i*)(dst + i*2), load8<T, sign>(src + i*2));
+			}
+#endif
+			for(; i < frames; i++) {
+				dst[i*2] = sample16<T, sign>(src, i*2);
+				dst[i*2+1] = sample16<T, sign>(src, i*2+1);
+			}
+		} else {
+#ifdef MIX_SSE2
+			for(; i + 8 <= frames; i += 8) {
+				__m128i v = load8<T, sign>(src + i);
+				_mm_storeu_si128((__m128i*)(dst + i*2), _mm_unpacklo_epi16(v, v));
+				_mm_storeu_si128((__m128i*)(dst + i*2 + 8), _mm_unpackhi_epi16(v, v));
+			}
+#endif
+			for(; i < frames; i++) {
+				dst[i*2] = dst[i*2+1] = sample16<T, sign>(src, i);
+			}
+		}
+	}
+
+	void toStereo16(short* dst, const void* src, int frames, int format, int channels) {
+		switch(format) {
+		case AudioSource::FMT_S8:
+			convert<signed char, true>(dst, (const signed char*)src, frames, channels);
+			break;
+		case AudioSource::FMT_U8:
+			convert<unsigned char, false>(dst, (const unsigned char*)src, frames, channels);
+			break;
+		case AudioSource::FMT_S16:
+			if(channels == 2)
+				memcpy(dst, src, frames * 2 * sizeof(short));
+			else
+				convert<short, true>(dst, (const short*)src, frames, channels);
+			break;
+		case AudioSource::FMT_U16:
+			convert<unsigned short, false>(dst, (const unsigned short*)src, frames, channels);
+			break;
+		}
+	}
+
+	//*************************************************************************
+	// Polyphase filter
+	//*************************************************************************
+
+	//The taps of each phase are stored in the order that the SSE2 code
+	//multiplies them with left and right samples: c0 c1 c0 c1 c2 c3 c2 c3,
+	//then the same for c4 to c7.
+	static inline int tapIndex(int k) {
+		return (k >> 1) * 4 + (k & 1);
+	}
+
+	void makePolyphaseTable(short* table, int srcRate, int dstRate) {
+		//when downsampling, the cutoff is lowered to the output's Nyquist frequency.
+		double cutoff = dstRate < srcRate ? (double)dstRate / srcRate : 1.0;
+		for(int p=0; p<POLYPHASE_PHASES; p++) {
+			double frac = (double)p / POLYPHASE_PHASES;
+			double h[TAPS], sum = 0;
+			for(int k=0; k<TAPS; k++) {
+				//distance from the output position to the frame of the tap.
+				double t = k - (TAPS/2 - 1) - frac;
+				double x = M_PI * t * cutoff;
+				//the tap on the output position has t == 0, but x may not be
+				//exactly 0 after the multiplications.
+				double sinc = fabs(x) < 1e-9 ? 1.0 : sin(x) / x;
+				double window = 0.42 + 0.5 * cos(M_PI * t / (TAPS/2)) +
+					0.08 * cos(2 * M_PI * t / (TAPS/2));
+				h[k] = sinc * window;
+				sum += h[k];
+			}
+			//each phase has unity gain, so silence and DC stay exact.
+			int c[TAPS], total = 0;
+			for(int k=0; k<TAPS; k++) {
+				c[k] = (int)floor(h[k] / sum * (1 << TAP_BITS) + 0.5);
+				total += c[k];
+			}
+			c[frac < 0.5 ? TAPS/2 - 1 : TAPS/2] += (1 << TAP_BITS) - total;
+			short* taps = table + p * 16;
+			for(int k=0; k<TAPS; k++) {
+				taps[tapIndex(k)] = taps[tapIndex(k) + 2] = (short)c[k];
+			}
+		}
+	}
+
+	//*************************************************************************
+	// Resampling and mixing
+	//*************************************************************************
+
+	//the volume is applied as a 1.15 factor, so that the SSE2 code can
+	//multiply in 16 bits.
+	static inline int scale(int s, int vol15) {
+		return (s * vol15) >> 15;
+	}
+
+	static void mixFrames(int* dst, const short* src, int count, int vol15) {
+		int i = 0;
+#ifdef MIX_SSE2
+		__m128i v = _mm_set1_epi16((short)vol15);
+		for(; i + 8 <= count * 2; i += 8) {
+			__m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+			__m128i lo = _mm_mullo_epi16(s, v);
+			__m128i hi = _mm_mulhi_epi16(s, v);
+			__m128i p0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 15);
+			__m128i p1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 15);
+			__m128i* d = (__m128i*)(dst + i);
+			_mm_storeu_si128(d, _mm_add_epi32(_mm_loadu_si128(d), p0));
+			_mm_storeu_si128(d + 1, _mm_add_epi32(_mm_loadu_si128(d + 1), p1));
+		}
+#endif
+		for(; i < count * 2; i++) {
+			dst[i] += scale(src[i], vol15);
+		}
+	}
+
+	static inline void step(Position& pos, int delta) {
+		pos.frac += delta;
+		pos.index += pos.frac >> 16;
+		pos.frac &= FP_MASK;
+	}
+
+	static void mixNearest(int* dst, int count, const short* src, Position& pos, int delta, int vol15) {
+		for(int i=0; i<count; i++) {
+			const short* f = src + pos.index * 2;
+			dst[i*2] += scale(f[0], vol15);
+			dst[i*2+1] += scale(f[1], vol15);
+			step(pos, delta);
+		}
+	}
+
+	static void mixLinear(int* dst, int count, const short* src, Position& pos, int delta, int vol15) {
+		for(int i=0; i<count; i++) {
+			const short* f = src + pos.index * 2;
+			int t = pos.frac >> 1;
+			int l = f[0] + (((f[2] - f[0]) * t) >> 15);
+			int r = f[1] + (((f[3] - f[1]) * t) >> 15);
+			dst[i*2] += scale(l, vol15);
+			dst[i*2+1] += scale(r, vol15);
+			step(pos, delta);
+		}
+	}
+
+	static void mixPolyphase(int* dst, int count, const short* src, Position& pos, int delta,
+		int vol15, const short* table)
+	{
+		for(int i=0; i<count; i++) {
+			const short* f = src + (pos.index - (TAPS/2 - 1)) * 2;
+			const short* taps = table + (pos.frac >> PHASE_SHIFT) * 16;
+			int l, r;
+#ifdef MIX_SSE2
+			//reorder L0 R0 L1 R1 to L0 L1 R0 R1, so that each madd gives
+			//L0*c0 + L1*c1 and R0*c0 + R1*c1.
+			__m128i f0 = _mm_loadu_si128((const __m128i*)f);
+			__m128i f1 = _mm_loadu_si128((const __m128i*)(f + 8));
+			f0 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(f0, _MM_SHUFFLE(3,1,2,0)), _MM_SHUFFLE(3,1,2,0));
+			f1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(f1, _MM_SHUFFLE(3,1,2,0)), _MM_SHUFFLE(3,1,2,0));
+			__m128i sum = _mm_add_epi32(
+				_mm_madd_epi16(f0, _mm_loadu_si128((const __m128i*)taps)),
+				_mm_madd_epi16(f1, _mm_loadu_si128((const __m128i*)(taps + 8))));
+			sum = _mm_srai_epi32(_mm_add_epi32(sum, _mm_srli_si128(sum, 8)), TAP_BITS);
+			l = _mm_cvtsi128_si32(sum);
+			r = _mm_cvtsi128_si32(_mm_srli_si128(sum, 4));
+#else
+			l = r = 0;
+			for(int k=0; k<TAPS; k++) {
+				int c = taps[tapIndex(k)];
+				l += f[k*2] * c;
+				r += f[k*2+1] * c;
+			}
+			l >>= TAP_BITS;
+			r >>= TAP_BITS;
+#endif
+			dst[i*2] += scale(l, vol15);
+			dst[i*2+1] += scale(r, vol15);
+			step(pos, delta);
+		}
+	}
+
+	void resampleMix(int* dst, int count, const short* src, Position& pos, int delta,
+		int volume, Resampler r, const short* table)
+	{
+		int vol15 = volume >> 1;
+		if(delta == FP_ONE && pos.frac == 0) {
+			//every resampler gives the source frames unchanged.
+			mixFrames(dst, src + pos.index * 2, count, vol15);
+			pos.index += count;
+			return;
+		}
+		switch(r) {
+		case NEAREST:
+			mixNearest(dst, count, src, pos, delta, vol15);
+			break;
+		case LINEAR:
+			mixLinear(dst, count, src, pos, delta, vol15);
+			break;
+		case POLYPHASE:
+			mixPolyphase(dst, count, src, pos, delta, vol15, table);
+			break;
+		}
+	}
+
+	void clampToS16(short* dst, const int* src, int count) {
+		int i = 0;
+#ifdef MIX_SSE2
+		for(; i + 8 <= count; i += 8) {
+			__m128i a = _mm_loadu_si128((const __m128i*)(src + i));
+			__m128i b = _mm_loadu_si128((const __m128i*)(src + i + 4));
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(a, b));
+		}
+#endif
+		for(; i < count; i++) {
+			int s = src[i];
+			dst[i] = (short)(s < -32768 ? -32768 : s > 32767 ? 32767 : s);
+		}
+	}
+}
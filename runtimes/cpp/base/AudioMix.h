@@ -0,0 +1,73 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+// Sample conversion, resampling and mixing kernels for AudioChannel and
+// the audio engines.
+//
+// Sources are first converted to 16-bit signed interleaved stereo frames.
+// Those are then resampled and mixed, with a volume, into a buffer of
+// 32-bit stereo samples, which is finally clamped to the output.
+// The inner loops use SSE2 where available. The scalar code produces
+// exactly the same samples.
+
+#ifndef _AUDIO_MIX_H_
+#define _AUDIO_MIX_H_
+
+namespace AudioMix {
+
+	enum Resampler {
+		// Repeats or skips source frames. Cheapest, but aliases.
+		NEAREST,
+		// Interpolates between the two nearest frames.
+		LINEAR,
+		// Filters with a windowed sinc, band-limited to the lower of the
+		// two Nyquist frequencies.
+		POLYPHASE
+	};
+
+	// Number of frames before and after the current one that a resampler reads.
+	int lookBehind(Resampler r);
+	int lookAhead(Resampler r);
+
+	// Converts \a frames frames of AudioSource::Format \a format, with
+	// \a channels channels, to stereo. Mono is copied to both channels.
+	void toStereo16(short* dst, const void* src, int frames, int format, int channels);
+
+	// Number of phases, and shorts per phase, of a polyphase filter table.
+#define POLYPHASE_PHASES 32
+#define POLYPHASE_TABLE_SIZE (POLYPHASE_PHASES * 16)
+
+	// Fills \a table with the filter for resampling from \a srcRate to \a dstRate.
+	void makePolyphaseTable(short* table, int srcRate, int dstRate);
+
+	// The position of a resampler in a buffer of frames, in 16.16 fixed point.
+	struct Position {
+		int index;
+		int frac;
+	};
+
+	// Mixes \a count frames into \a dst, starting at frame \a pos of \a src and
+	// stepping \a delta (16.16) frames per output frame. Updates \a pos.
+	// \a volume is in 16.16 fixed point, [0,1). \a table is only used by POLYPHASE.
+	void resampleMix(int* dst, int count, const short* src, Position& pos, int delta,
+		int volume, Resampler r, const short* table);
+
+	// Clamps \a count samples to 16 bits.
+	void clampToS16(short* dst, const int* src, int count);
+}
+
+#endif	//_AUDIO_MIX_H_
@@ -0,0 +1,134 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#include "config_platform.h"
+
+#include <string.h>
+#include <helpers/helpers.h>
+
+#include "FileBuffer.h"
+
+namespace Base {
+
+	FileBuffer::FileBuffer() : mData(NULL), mReadPos(0), mReadEnd(0),
+		mWriteSize(0), mReadAhead(0)
+	{
+	}
+
+	FileBuffer::~FileBuffer() {
+		delete[] mData;
+	}
+
+	bool FileBuffer::read(FileStream& fs, void* dst, int size) {
+		TEST(flushWrites(fs));
+		byte* pos = (byte*)dst;
+		int buffered = mReadEnd - mReadPos;
+		if(buffered >= size) {
+			memcpy(pos, mData + mReadPos, size);
+			mReadPos += size;
+			return true;
+		}
+		if(buffered > 0) {
+			memcpy(pos, mData + mReadPos, buffered);
+			pos += buffered;
+			size -= buffered;
+		}
+		mReadPos = mReadEnd = 0;
+
+		//the first read after a seek may be the only one.
+		if(mReadAhead == 0) {
+			mReadAhead = FILE_BUFFER_READ_AHEAD_MIN;
+			return fs.read(pos, size);
+		}
+		if(size >= mReadAhead)
+			return fs.read(pos, size);
+		TEST(readAhead(fs));
+		if(mReadEnd < size) {
+			LOG("Unexpected EOF.\n");
+			mReadPos = mReadEnd;
+			FAIL;
+		}
+		memcpy(pos, mData, size);
+		mReadPos = size;
+		return true;
+	}
+
+	bool FileBuffer::readAhead(FileStream& fs) {
+		if(!mData)
+			mData = new char[FILE_BUFFER_SIZE];
+		//FileStream::read() fails at the end of the file, so don't go past it.
+		int pos, length;
+		TEST(fs.tell(pos));
+		TEST(fs.length(length));
+		int size = MIN(mReadAhead, length - pos);
+		if(size > 0) {
+			TEST(fs.read(mData, size));
+			mReadEnd = size;
+		}
+		mReadAhead = MIN(mReadAhead * 2, FILE_BUFFER_SIZE);
+		return true;
+	}
+
+	bool FileBuffer::write(FileStream& fs, const void* src, int size) {
+		if(mReadPos != mReadEnd) {
+			TEST(flush(fs));
+		}
+		mReadPos = mReadEnd = 0;
+		if(mWriteSize + size > FILE_BUFFER_SIZE) {
+			TEST(flushWrites(fs));
+		}
+		if(size >= FILE_BUFFER_SIZE)
+			return fs.write(src, size);
+		if(!mData)
+			mData = new char[FILE_BUFFER_SIZE];
+		memcpy(mData + mWriteSize, src, size);
+		mWriteSize += size;
+		return true;
+	}
+
+	bool FileBuffer::flushWrites(FileStream& fs) {
+		if(mWriteSize == 0)
+			return true;
+		int size = mWriteSize;
+		mWriteSize = 0;
+		return fs.write(mData, size);
+	}
+
+	bool FileBuffer::flush(FileStream& fs) {
+		bool res = flushWrites(fs);
+		int unread = mReadEnd - mReadPos;
+		mReadPos = mReadEnd = 0;
+		mReadAhead = 0;
+		if(unread > 0) {
+			res = fs.seek(Seek::Current, -unread) && res;
+		}
+		return res;
+	}
+
+	bool FileBuffer::tell(const FileStream& fs, int& pos) const {
+		TEST(fs.tell(pos));
+		pos += mWriteSize - (mReadEnd - mReadPos);
+		return true;
+	}
+
+	void FileBuffer::reset() {
+		mReadPos = mReadEnd = 0;
+		mWriteSize = 0;
+		mReadAhead = 0;
+	}
+
+} // namespace Base
@@ -0,0 +1,82 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#ifndef _BASE_FILE_BUFFER_H_
+#define _BASE_FILE_BUFFER_H_
+
+#include "FileStream.h"
+
+// The most a FileBuffer holds. Reads and writes this large or larger
+// go straight to the file.
+#define FILE_BUFFER_SIZE (32 * 1024)
+
+// The first read-ahead after a seek. Each one after that is twice as large,
+// up to FILE_BUFFER_SIZE.
+#define FILE_BUFFER_READ_AHEAD_MIN (4 * 1024)
+
+namespace Base {
+
+	// Buffers the reads and writes of one open file, so that a small read
+	// or write doesn't cost a read or write on the host each time.
+	//
+	// Reads are buffered once they are sequential. The first read after
+	// opening or flushing goes straight to the file. A read after that,
+	// which the buffer can't serve, reads ahead.
+	// Small writes are collected in the buffer, and written when it is full.
+	//
+	// The buffer doesn't own the stream. Its position is after any data
+	// read ahead, and before any collected writes, so call flush() before
+	// anything but read() and write() uses it.
+	class FileBuffer {
+	public:
+		FileBuffer();
+		~FileBuffer();
+
+		// Read or write exactly \a size bytes, like the FileStream functions.
+		bool read(FileStream& fs, void* dst, int size);
+		bool write(FileStream& fs, const void* src, int size);
+
+		// Writes the collected writes, and moves the stream back over the
+		// data read ahead. Afterwards, the stream's position is the file's.
+		// If the writes fail, they are dropped.
+		bool flush(FileStream& fs);
+
+		// Writes the collected writes, but keeps the data read ahead.
+		bool flushWrites(FileStream& fs);
+
+		// The position of the file, which may differ from the stream's.
+		bool tell(const FileStream& fs, int& pos) const;
+
+		// Drops the buffered data, without writing it. For when the stream
+		// is deleted along with the file.
+		void reset();
+
+	private:
+		char* mData;
+		int mReadPos, mReadEnd;	//the data read ahead is mData[mReadPos..mReadEnd).
+		int mWriteSize;	//the collected writes are mData[0..mWriteSize).
+		int mReadAhead;	//size of the next read-ahead. 0 until reads are sequential.
+
+		bool readAhead(FileStream& fs);
+
+		FileBuffer(const FileBuffer&);
+		FileBuffer& operator=(const FileBuffer&);
+	};
+
+} // namespace Base
+
+#endif // _BASE_FILE_BUFFER_H_
@@ -27,7 +27,8 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 #include "base_errors.h"
 using namespace MoSyncError;
 
-typedef s64 int64_t;
+#include "ImageBlit.h"
+#include "TileBins.h"
 
 #define SWAP(x, y, temp) {temp=x;x=y;y=temp;}
 
@@ -40,11 +41,11 @@ inline int32_t fp_ceil(int32_t x) {
 }
 
 inline int32_t fp_div32(int32_t a, int32_t b) {
-	return (int32_t)((((int64_t)a)<<FP_RESOLUTION)/((int64_t)b));
+	return (int32_t)((((s64)a)<<FP_RESOLUTION)/((s64)b));
 }
 
 inline int32_t fp_mul32(int32_t a, int32_t b) {
-	return (int32_t)(((int64_t)a * (int64_t)b)>>FP_RESOLUTION);
+	return (int32_t)(((s64)a * (s64)b)>>FP_RESOLUTION);
 }
 
 struct Point {
@@ -554,184 +555,32 @@ void Image::drawImageRegion(int left, int top, ClipRect *srcRect, Image *img, in
 
 	if(transWidth <= 0 || transHeight<= 0) return;
 
-	unsigned char *dst = &data[left*bytesPerPixel + top*pitch];
-	unsigned char *src = &img->data[transTopLeftX*img->bytesPerPixel + transTopLeftY*img->pitch];
-
-#define DUMP(x) LOG("%s: %i\n", #x, x);
-#define DUMPX(x) LOG("%s: 0x%x\n", #x, x);
-	//DUMP(transformMode);
-	//DUMPX(img->alpha);
-	//DUMP(bpp);
-
-	if(img->alpha) {
-		switch(bpp) {
-		case 2:
-			{
-				srcPitchX>>=1;
-				unsigned char *salpha = &img->alpha[transTopLeftX + transTopLeftY*img->alphaPitch];
-				unsigned char *ascan;
-				unsigned short *src_scan;
-				unsigned short *dst_scan;
-
-				while(transHeight--) {
-					src_scan = (unsigned short*)src;
-					dst_scan = (unsigned short*)dst;
-					ascan = salpha;
-					int x = transWidth;
-					while(x--) {
-						int sr = (((*src_scan)&img->redMask)>>img->redShift);
-						int sg = (((*src_scan)&img->greenMask)>>img->greenShift);
-						int sb = (((*src_scan)&img->blueMask)>>img->blueShift);
-						int dr = (((*dst_scan)&redMask)>>redShift);
-						int dg = (((*dst_scan)&greenMask)>>greenShift);
-						int db = (((*dst_scan)&blueMask)>>blueShift);
-
-						if(*ascan == 255) {
-							*dst_scan = (((sr)<< redShift)&redMask) |
-								(((sg)<< greenShift)&greenMask) |
-								(((sb)<< blueShift)&blueMask);
-						} else if(*ascan == 0) {
-							*dst_scan = (((dr)<< redShift)&redMask) |
-								(((dg)<< greenShift)&greenMask) |
-								(((db)<< blueShift)&blueMask);
-						} else {
-							*dst_scan =
-								(((dr + (((sr-dr)*(*ascan))>>8)) << redShift)&redMask) |
-								(((dg + (((sg-dg)*(*ascan))>>8)) << greenShift)&greenMask) |
-								(((db + (((sb-db)*(*ascan))>>8)) << blueShift)&blueMask);
-						}
-
-						src_scan+=srcPitchX;
-						dst_scan++;
-						ascan+=srcAPX;
-					}
-					src += srcPitchY;
-					dst += pitch;
-					salpha += srcAPY;
-				}
-			}
-			break;
-		case 4:
-			{
-				srcPitchX>>=2;
-				unsigned char *salpha = &img->alpha[transTopLeftX + transTopLeftY*img->alphaPitch];
-				unsigned char *ascan;
-				unsigned int *src_scan;
-				unsigned int *dst_scan;
-				//DUMP(srcPitchX);
-				//DUMP(srcPitchY);
-				//DUMP(transWidth);
-				//DUMP(transHeight);
-				//DUMP(pitch);
-				//DUMP(transTopLeftX);
-				//DUMP(transTopLeftY);
-
-				while(transHeight--) {
-					src_scan = (unsigned int*)src;
-					dst_scan = (unsigned int*)dst;
-					ascan = salpha;
-					int x = transWidth;
-					while(x--) {
-						int sr = (((*src_scan)&img->redMask)>>img->redShift);
-						int sg = (((*src_scan)&img->greenMask)>>img->greenShift);
-						int sb = (((*src_scan)&img->blueMask)>>img->blueShift);
-						int dr = (((*dst_scan)&redMask)>>redShift);
-						int dg = (((*dst_scan)&greenMask)>>greenShift);
-						int db = (((*dst_scan)&blueMask)>>blueShift);
-
-						if(*ascan == 255) {
-							*dst_scan = (((sr)<< redShift)&redMask) |
-								(((sg)<< greenShift)&greenMask) |
-								(((sb)<< blueShift)&blueMask);
-						} else if(*ascan == 0) {
-							*dst_scan = (((dr)<< redShift)&redMask) |
-								(((dg)<< greenShift)&greenMask) |
-								(((db)<< blueShift)&blueMask);
-						} else {
-							*dst_scan =
-								(((dr + (((sr-dr)*(*ascan))>>8)) << redShift)&redMask) |
-								(((dg + (((sg-dg)*(*ascan))>>8)) << greenShift)&greenMask) |
-								(((db + (((sb-db)*(*ascan))>>8)) << blueShift)&blueMask);
-						}
-
-						src_scan+=srcPitchX;
-						dst_scan++;
-						ascan+=srcAPX;
-					}
-					src += srcPitchY;
-					dst += pitch;
-					salpha += srcAPY;
-				}
-			}
-			break;
-		default:
-			BIG_PHAT_ERROR(ERR_UNSUPPORTED_BPP);
-		}
-	}
+	Blit::AlphaMode mode;
+	if(img->alpha)
+		mode = Blit::ALPHA_PLANE;
+	else if(img->alphaMask)
+		mode = Blit::ALPHA_CHANNEL;
 	else
-	{
-		if(img->alphaMask) {
-			switch(bpp) {
-			case 4:
-			{
-				srcPitchX>>=2;
-				unsigned int *src_scan;
-				unsigned int *dst_scan;
-
-				while(transHeight--) {
-					src_scan = (unsigned int*)src;
-					dst_scan = (unsigned int*)dst;
-					int x = transWidth;
-					while(x--) {
-						int sr = (((*src_scan)&img->redMask)>>img->redShift);
-						int sg = (((*src_scan)&img->greenMask)>>img->greenShift);
-						int sb = (((*src_scan)&img->blueMask)>>img->blueShift);
-						int sa = (((*src_scan)&img->alphaMask)>>img->alphaShift);
-
-						int dr = (((*dst_scan)&redMask)>>redShift);
-						int dg = (((*dst_scan)&greenMask)>>greenShift);
-						int db = (((*dst_scan)&blueMask)>>blueShift);
-
-						if(sa == 255) {
-							*dst_scan = (((sr)<< redShift)&redMask) |
-							(((sg)<< greenShift)&greenMask) |
-							(((sb)<< blueShift)&blueMask);
-						} else if(sa == 0) {
-							*dst_scan = (((dr)<< redShift)&redMask) |
-							(((dg)<< greenShift)&greenMask) |
-							(((db)<< blueShift)&blueMask);
-						} else {
-							*dst_scan =
-							(((dr + (((sr-dr)*(sa))>>8)) << redShift)&redMask) |
-							(((dg + (((sg-dg)*(sa))>>8)) << greenShift)&greenMask) |
-							(((db + (((sb-db)*(sa))>>8)) << blueShift)&blueMask);
-						}
-						src_scan+=srcPitchX;
-						dst_scan++;
-					}
-					src += srcPitchY;
-					dst += pitch;
-				}
-			}
-				break;
-			default:
-				BIG_PHAT_ERROR(ERR_UNSUPPORTED_BPP);
-			}
-		} else {
-			int dstOffsetY = -transWidth*bytesPerPixel + pitch;
-			int srcOffsetY = -srcPitchX*transWidth + srcPitchY;
-			while(transHeight--) {
-				width = transWidth;
-				while(width--) {
-					memcpy(dst, src, bytesPerPixel);
-					src+=srcPitchX;
-					dst+=bytesPerPixel;
-				}
-				dst+=dstOffsetY;
-				src+=srcOffsetY;
-			}
-		}
+		mode = Blit::ALPHA_NONE;
+	Blit::Kernel kernel = Blit::selectKernel(this, img, mode, srcPitchX / bpp);
+	if(!kernel) {
+		BIG_PHAT_ERROR(ERR_UNSUPPORTED_BPP);
 	}
+
+	Blit::Params p;
+	p.dst = &data[left*bytesPerPixel + top*pitch];
+	p.dstPitch = pitch;
+	p.src = &img->data[transTopLeftX*img->bytesPerPixel + transTopLeftY*img->pitch];
+	p.srcStepX = srcPitchX / bpp;
+	p.srcPitchY = srcPitchY;
+	p.alpha = img->alpha ? &img->alpha[transTopLeftX + transTopLeftY*img->alphaPitch] : NULL;
+	p.alphaStepX = srcAPX;
+	p.alphaPitchY = srcAPY;
+	p.width = transWidth;
+	p.height = transHeight;
+	p.srcImg = img;
+	p.dstImg = this;
+	kernel(p);
 }
 
 #ifndef SYMBIAN
@@ -1170,7 +1019,39 @@ void initRecipLut() {
 	}
 }
 
-void Image::drawTriangleWithoutClipping(int x1, int y1, int x2, int y2, int x3, int y3, int color) {
+//fills rows \a y0 to \a y1 - 1 of one half of a triangle. The edges are at
+//\a x_left and \a x_right on row \a y0, in fixed point, and move by
+//\a dxdy_left and \a dxdy_right per row. Only pixels inside \a window are
+//drawn. The window doesn't change the edges, so a triangle that is drawn
+//in pieces, one window at a time, gets the same pixels as one drawn whole.
+template<class T> static void fillTriangleRows(unsigned char* data, int pitch, int y0, int y1,
+	int x_left, int x_right, int dxdy_left, int dxdy_right, const ClipRect& window, T color)
+{
+	int top = MAX(y0, window.y);
+	int bottom = MIN(y1, window.y + window.height);
+	if(top >= bottom)
+		return;
+	x_left += dxdy_left * (top - y0);
+	x_right += dxdy_right * (top - y0);
+	int windowRight = window.x + window.width;
+	unsigned char *dst = &data[top*pitch];
+	for(int y = top; y < bottom; y++) {
+		int x_start = MAX(fp_ceil(x_left), window.x);
+		int w = (MIN(fp_ceil(x_right), windowRight)-x_start);
+		if(w>0) {
+			T *scan = (T*)dst;
+			scan+=x_start;
+			while(w--) *scan++=color;
+		}
+		dst+=pitch;
+		x_left+=dxdy_left;
+		x_right+=dxdy_right;
+	}
+}
+
+void Image::drawTriangleWithoutClipping(int x1, int y1, int x2, int y2, int x3, int y3, int color,
+	const ClipRect& window)
+{
 	int temp,
 		longest,
 		height,
@@ -1245,77 +1126,24 @@ void Image::drawTriangleWithoutClipping(int x1, int y1, int x2, int y2, int x3,
 		x_mid_right = x_right + dxdy_right1*(y2-y1);
 	}
 
-	unsigned char *dst = &data[y1*pitch];
 	switch(bytesPerPixel) {
 		case 2:
-			for(int y = y1; y < y2; y++) {
-				int x_start = fp_ceil(x_left);
-				int w = (fp_ceil(x_right)-x_start);
-				if(w>0) {
-					short *scan = (short*)dst;
-					scan+=x_start;
-					while(w--) *scan++=color;
-				}
-				dst+=pitch;
-				x_left+=dxdy_left1;
-				x_right+=dxdy_right1;
-			}
-			x_left = x_mid_left;
-			x_right = x_mid_right;
-			dst = &data[y2*pitch];
-			for(int y = y2; y < y3; y++) {
-				int x_start = fp_ceil(x_left);
-				int w = (fp_ceil(x_right)-x_start);
-				if(w>0) {
-					short *scan = (short*)dst;
-					scan+=x_start;
-					while(w--) *scan++=color;
-				}
-				dst+=pitch;
-				x_left+=dxdy_left2;
-				x_right+=dxdy_right2;
-			}
+			fillTriangleRows<short>(data, pitch, y1, y2, x_left, x_right,
+				dxdy_left1, dxdy_right1, window, color);
+			fillTriangleRows<short>(data, pitch, y2, y3, x_mid_left, x_mid_right,
+				dxdy_left2, dxdy_right2, window, color);
 			break;
 		case 4:
-			for(int y = y1; y < y2; y++) {
-				int x_start = fp_ceil(x_left);
-				int w = (fp_ceil(x_right)-x_start);
-				if(w>0) {
-					int *scan = (int*)dst;
-					scan+=x_start;
-					while(w--) *scan++=color;
-				}
-				dst+=pitch;
-				x_left+=dxdy_left1;
-				x_right+=dxdy_right1;
-			}
-			x_left = x_mid_left;
-			x_right = x_mid_right;
-			dst = &data[y2*pitch];
-			for(int y = y2; y < y3; y++) {
-				int x_start = fp_ceil(x_left);
-				int w = (fp_ceil(x_right)-x_start);
-				if(w>0) {
-					int *scan = (int*)dst;
-					scan+=x_start;
-					while(w--) *scan++=color;
-				}
-				dst+=pitch;
-				x_left+=dxdy_left2;
-				x_right+=dxdy_right2;
-			}
-		break;
+			fillTriangleRows<int>(data, pitch, y1, y2, x_left, x_right,
+				dxdy_left1, dxdy_right1, window, color);
+			fillTriangleRows<int>(data, pitch, y2, y3, x_mid_left, x_mid_right,
+				dxdy_left2, dxdy_right2, window, color);
+			break;
 	}
 }
 
-void Image::drawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, int color) {
-    /*
-    drawLine(x1, y1, x2, y2, color);
-    drawLine(x2, y2, x3, y3, color);
-    drawLine(x3, y3, x1, y1, color);
-    return;
-    */
-
+//clips a triangle to the clip rect, leaving a convex polygon in clippedPoints.
+bool Image::clipTriangle(int x1, int y1, int x2, int y2, int x3, int y3) {
 	clippedPoints[0][0].x = x1<<FP_RESOLUTION;
 	clippedPoints[0][0].y = y1<<FP_RESOLUTION;
 	clippedPoints[0][1].x = x2<<FP_RESOLUTION;
@@ -1325,17 +1153,34 @@ void Image::drawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, int col
 	currentList = 0;
 	numPoints[0] = 3;
 
-	if(!clipPolygon()) return;
+	return clipPolygon();
+}
+
+//the pixel coordinates of triangle \a i of the fan that covers the clipped polygon.
+static void clippedTriangle(int i, int* p) {
+	const Point* points = clippedPoints[currentList];
+	p[0] = fp_ceil(points[0].x);
+	p[1] = fp_ceil(points[0].y);
+	p[2] = fp_ceil(points[i].x);
+	p[3] = fp_ceil(points[i].y);
+	p[4] = fp_ceil(points[i+1].x);
+	p[5] = fp_ceil(points[i+1].y);
+}
+
+void Image::drawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, int color) {
+    /*
+    drawLine(x1, y1, x2, y2, color);
+    drawLine(x2, y2, x3, y3, color);
+    drawLine(x3, y3, x1, y1, color);
+    return;
+    */
+
+	if(!clipTriangle(x1, y1, x2, y2, x3, y3)) return;
 
 	for(int i = 0; i < numPoints[currentList]-1; i++) {
-         drawTriangleWithoutClipping(
-			fp_ceil(clippedPoints[currentList][0].x),
-			fp_ceil(clippedPoints[currentList][0].y),
-			fp_ceil(clippedPoints[currentList][i].x),
-			fp_ceil(clippedPoints[currentList][i].y),
-			fp_ceil(clippedPoints[currentList][i+1].x),
-			fp_ceil(clippedPoints[currentList][i+1].y),
-			color);
+		int p[6];
+		clippedTriangle(i, p);
+		drawTriangleWithoutClipping(p[0], p[1], p[2], p[3], p[4], p[5], color, clipRect);
 	}
 
 	/*
@@ -1363,4 +1208,64 @@ void Image::drawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, int col
 	}
 	*/
 }
+
+//fewer triangles than this are drawn on the calling thread.
+#define PARALLEL_TRIANGLES 64
+
+struct TriangleTiles {
+	Image* image;
+	const std::vector<int>* coords;	//six per triangle.
+	const TileBins* bins;
+	int color;
+};
+
+static std::vector<int> sTriangleCoords;
+static TileBins sTriangleBins;
+
+void Image::fillTriangleTile(void* data, int tile) {
+	const TriangleTiles& t = *(TriangleTiles*)data;
+	ClipRect window;
+	t.bins->tileRect(tile, window.x, window.y, window.width, window.height);
+	const std::vector<int>& triangles = t.bins->triangles(tile);
+	for(size_t i=0; i<triangles.size(); i++) {
+		const int* p = &(*t.coords)[triangles[i] * 6];
+		t.image->drawTriangleWithoutClipping(p[0], p[1], p[2], p[3], p[4], p[5], t.color, window);
+	}
+}
+
+void Image::fillTriangles(const int* points, int count, bool fan, int color, JobRunner* runner) {
+	if(!runner || count - 2 < PARALLEL_TRIANGLES) {
+		for(int i = 2; i < count; i++) {
+			const int* a = fan ? points : &points[(i-2)*2];
+			drawTriangle(a[0], a[1], points[(i-1)*2], points[(i-1)*2+1],
+				points[i*2], points[i*2+1], color);
+		}
+		return;
+	}
+
+	//the clipper isn't reentrant, so all triangles are clipped here, and
+	//the pieces are binned. The tiles are then drawn in parallel.
+	std::vector<int>& coords = sTriangleCoords;
+	coords.clear();
+	sTriangleBins.reset(clipRect.x, clipRect.y, clipRect.width, clipRect.height);
+	for(int i = 2; i < count; i++) {
+		const int* a = fan ? points : &points[(i-2)*2];
+		if(!clipTriangle(a[0], a[1], points[(i-1)*2], points[(i-1)*2+1],
+			points[i*2], points[i*2+1])) continue;
+		for(int j = 0; j < numPoints[currentList]-1; j++) {
+			int p[6];
+			clippedTriangle(j, p);
+			//the reciprocals are rounded down, so long edges may be off by a
+			//fraction of a pixel per 64k pixels of extent.
+			int extent = MAX(MAX(p[0], p[2]), p[4]) - MIN(MIN(p[0], p[2]), p[4]);
+			extent = MAX(extent, MAX(MAX(p[1], p[3]), p[5]) - MIN(MIN(p[1], p[3]), p[5]));
+			int margin = 2 + (int)(((s64)extent * (extent + 1)) >> 16);
+			sTriangleBins.add(coords.size() / 6, p[0], p[1], p[2], p[3], p[4], p[5], margin);
+			coords.insert(coords.end(), p, p + 6);
+		}
+	}
+
+	TriangleTiles tiles = { this, &coords, &sTriangleBins, color };
+	runner->run(fillTriangleTile, &tiles, sTriangleBins.tileCount());
+}
 #endif	//SYMBIAN
@@ -22,6 +22,8 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 typedef u32 uint32_t;
 typedef s32 int32_t;
 
+class JobRunner;
+
 struct ClipRect {
 	int x, y, width, height;
 };
@@ -46,7 +48,10 @@ private:
 	void clipPolygonLeft(int src, int dst);
 	void clipPolygonRight(int src, int dst);
 	void clipPolygonBottom(int src, int dst);
-	void drawTriangleWithoutClipping(int x1, int y1, int x2, int y2, int x3, int y3, int color);
+	bool clipTriangle(int x1, int y1, int x2, int y2, int x3, int y3);
+	void drawTriangleWithoutClipping(int x1, int y1, int x2, int y2, int x3, int y3, int color,
+		const ClipRect& window);
+	static void fillTriangleTile(void* data, int tile);
 
 public:
 	enum PixelFormat {
@@ -97,6 +102,12 @@ public:
 	void drawLine(int x1, int y1, int x2, int y2, int color);
 	void drawFilledRect(int x, int y, int w, int h, int color);
 	void drawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, int color);
+
+	// Fills the triangles of a strip or fan of \a count points, given as
+	// x, y pairs. Draws the same pixels as calling drawTriangle() for each.
+	// With a \a runner, large meshes are binned into tiles, which are
+	// filled in parallel.
+	void fillTriangles(const int* points, int count, bool fan, int color, JobRunner* runner);
 	void drawImageRegion(int left, int top, ClipRect *srcRect, Image *src, int transformMode);
 	void drawImage(int left, int top, Image *src);
 
@@ -0,0 +1,431 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+// Blit kernels for Image::drawImageRegion(). Only to be included by Image.cpp.
+//
+// A kernel is instantiated per pixel format, alpha mode and horizontal source
+// step. The step is +1 or -1 pixels for the unrotated transforms and a
+// runtime value (a multiple of the pitch) for the rotated ones.
+//
+// All kernels produce exactly the same pixels as the original per-pixel code:
+// a channel is blended as d + (((s-d)*a)>>8), which is the same as
+// (d*(256-a) + s*a) >> 8. Alpha 255 gives the source, which is the same as
+// blending with 256, and alpha 0 gives the destination.
+// In 32-bit formats, the alpha byte of a blended pixel is cleared.
+
+#ifndef _IMAGE_BLIT_H_
+#define _IMAGE_BLIT_H_
+
+#include <string.h>
+#include "Image.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLIT_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define BLIT_NEON
+#include <arm_neon.h>
+#endif
+
+namespace Blit {
+
+	enum AlphaMode {
+		ALPHA_NONE,	// straight copy
+		ALPHA_PLANE,	// separate 8-bit alpha plane, Image::alpha
+		ALPHA_CHANNEL	// alpha in the source pixels, Image::alphaMask
+	};
+
+	struct Params {
+		unsigned char* dst;
+		int dstPitch;	// bytes
+		const unsigned char* src;
+		int srcStepX;	// pixels
+		int srcPitchY;	// bytes
+		const unsigned char* alpha;
+		int alphaStepX;
+		int alphaPitchY;
+		int width, height;
+		const Image* srcImg;
+		const Image* dstImg;
+	};
+
+	typedef void (*Kernel)(const Params&);
+
+	//****************************************
+	// Pixel formats
+	//****************************************
+
+	// RGB565 to RGB565.
+	struct FormatRGB565 {
+		typedef unsigned short Pixel;
+
+		// no alpha channel.
+		static inline unsigned alpha(Pixel, const Params&) {
+			return 255;
+		}
+
+		static inline Pixel blend(Pixel s, Pixel d, unsigned a, const Params&) {
+			if(a == 255)
+				return s;
+			if(a == 0)
+				return d;
+			unsigned ia = 256 - a;
+			unsigned r = ((d >> 11) * ia + (s >> 11) * a) >> 8;
+			unsigned g = (((d >> 5) & 0x3f) * ia + ((s >> 5) & 0x3f) * a) >> 8;
+			unsigned b = ((d & 0x1f) * ia + (s & 0x1f) * a) >> 8;
+			return (Pixel)((r << 11) | (g << 5) | b);
+		}
+	};
+
+	// RGB888 or ARGB8888 to RGB888 or ARGB8888.
+	struct FormatXRGB8888 {
+		typedef unsigned int Pixel;
+
+		static inline unsigned alpha(Pixel s, const Params&) {
+			return s >> 24;
+		}
+
+		static inline Pixel blend(Pixel s, Pixel d, unsigned a, const Params&) {
+			if(a == 255)
+				return s & 0xffffff;
+			if(a == 0)
+				return d & 0xffffff;
+			unsigned ia = 256 - a;
+			// red and blue have 16 bits each to spare, green has 24.
+			unsigned rb = (((d & 0xff00ff) * ia + (s & 0xff00ff) * a) >> 8) & 0xff00ff;
+			unsigned g = (((d & 0xff00) * ia + (s & 0xff00) * a) >> 8) & 0xff00;
+			return rb | g;
+		}
+	};
+
+	// Any other format, with the masks and shifts read from the images.
+	template<class P> struct FormatMasked {
+		typedef P Pixel;
+
+		static inline unsigned alpha(Pixel s, const Params& p) {
+			return (s & p.srcImg->alphaMask) >> p.srcImg->alphaShift;
+		}
+
+		static inline Pixel blend(Pixel s, Pixel d, unsigned a, const Params& p) {
+			const Image* si = p.srcImg;
+			const Image* di = p.dstImg;
+			int sr = ((s & si->redMask) >> si->redShift);
+			int sg = ((s & si->greenMask) >> si->greenShift);
+			int sb = ((s & si->blueMask) >> si->blueShift);
+			int dr = ((d & di->redMask) >> di->redShift);
+			int dg = ((d & di->greenMask) >> di->greenShift);
+			int db = ((d & di->blueMask) >> di->blueShift);
+			if(a == 255) {
+				dr = sr;
+				dg = sg;
+				db = sb;
+			} else if(a != 0) {
+				dr += ((sr - dr) * (int)a) >> 8;
+				dg += ((sg - dg) * (int)a) >> 8;
+				db += ((sb - db) * (int)a) >> 8;
+			}
+			return (Pixel)(((dr << di->redShift) & di->redMask) |
+				((dg << di->greenShift) & di->greenMask) |
+				((db << di->blueShift) & di->blueMask));
+		}
+	};
+
+	//****************************************
+	// SIMD rows
+	//****************************************
+
+	// Blends the start of a row of forward-stepping pixels.
+	// Returns the number of pixels done; the caller does the rest.
+	template<class F, AlphaMode A> struct Simd {
+		static inline int row(const typename F::Pixel*, typename F::Pixel*, const unsigned char*, int) {
+			return 0;
+		}
+	};
+
+#ifdef BLIT_SSE2
+	// 8 16-bit channels, alpha in 0-256.
+	static inline __m128i blend16(__m128i s, __m128i d, __m128i a) {
+		__m128i ia = _mm_sub_epi16(_mm_set1_epi16(256), a);
+		return _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(d, ia), _mm_mullo_epi16(s, a)), 8);
+	}
+
+	// 4 pixels, alpha in the low byte of each 32-bit lane.
+	static inline __m128i blend8888(__m128i s, __m128i d, __m128i a) {
+		const __m128i zero = _mm_setzero_si128();
+		a = _mm_sub_epi32(a, _mm_cmpeq_epi32(a, _mm_set1_epi32(255)));
+		a = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+		__m128i lo = blend16(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero),
+			_mm_unpacklo_epi32(a, a));
+		__m128i hi = blend16(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero),
+			_mm_unpackhi_epi32(a, a));
+		return _mm_and_si128(_mm_packus_epi16(lo, hi), _mm_set1_epi32(0xffffff));
+	}
+
+	template<> struct Simd<FormatXRGB8888, ALPHA_PLANE> {
+		static inline int row(const unsigned int* s, unsigned int* d, const unsigned char* a, int w) {
+			const __m128i zero = _mm_setzero_si128();
+			int x = 0;
+			for(; x + 4 <= w; x += 4) {
+				int a4;
+				memcpy(&a4, a + x, 4);
+				__m128i av = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(a4), zero), zero);
+				__m128i sp = _mm_loadu_si128((const __m128i*)(s + x));
+				__m128i dp = _mm_loadu_si128((const __m128i*)(d + x));
+				_mm_storeu_si128((__m128i*)(d + x), blend8888(sp, dp, av));
+			}
+			return x;
+		}
+	};
+
+	template<> struct Simd<FormatXRGB8888, ALPHA_CHANNEL> {
+		static inline int row(const unsigned int* s, unsigned int* d, const unsigned char*, int w) {
+			int x = 0;
+			for(; x + 4 <= w; x += 4) {
+				__m128i sp = _mm_loadu_si128((const __m128i*)(s + x));
+				__m128i dp = _mm_loadu_si128((const __m128i*)(d + x));
+				_mm_storeu_si128((__m128i*)(d + x), blend8888(sp, dp, _mm_srli_epi32(sp, 24)));
+			}
+			return x;
+		}
+	};
+
+	template<> struct Simd<FormatRGB565, ALPHA_PLANE> {
+		static inline int row(const unsigned short* s, unsigned short* d, const unsigned char* a, int w) {
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i m6 = _mm_set1_epi16(0x3f);
+			const __m128i m5 = _mm_set1_epi16(0x1f);
+			int x = 0;
+			for(; x + 8 <= w; x += 8) {
+				__m128i av = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(a + x)), zero);
+				av = _mm_sub_epi16(av, _mm_cmpeq_epi16(av, _mm_set1_epi16(255)));
+				__m128i sp = _mm_loadu_si128((const __m128i*)(s + x));
+				__m128i dp = _mm_loadu_si128((const __m128i*)(d + x));
+				__m128i r = blend16(_mm_srli_epi16(sp, 11), _mm_srli_epi16(dp, 11), av);
+				__m128i g = blend16(_mm_and_si128(_mm_srli_epi16(sp, 5), m6),
+					_mm_and_si128(_mm_srli_epi16(dp, 5), m6), av);
+				__m128i b = blend16(_mm_and_si128(sp, m5), _mm_and_si128(dp, m5), av);
+				__m128i res = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(r, 11), _mm_slli_epi16(g, 5)), b);
+				_mm_storeu_si128((__m128i*)(d + x), res);
+			}
+			return x;
+		}
+	};
+#endif	//BLIT_SSE2
+
+#ifdef BLIT_NEON
+	// 8 8-bit channels, alpha in 0-256.
+	static inline uint8x8_t blend8(uint8x8_t s, uint8x8_t d, uint16x8_t a, uint16x8_t ia) {
+		return vshrn_n_u16(vmlaq_u16(vmulq_u16(vmovl_u8(d), ia), vmovl_u8(s), a), 8);
+	}
+
+	static inline uint16x8_t blend16(uint16x8_t s, uint16x8_t d, uint16x8_t a, uint16x8_t ia) {
+		return vshrq_n_u16(vmlaq_u16(vmulq_u16(d, ia), s, a), 8);
+	}
+
+	// 255 becomes 256.
+	static inline uint16x8_t fullAlpha(uint16x8_t a) {
+		return vsubq_u16(a, vceqq_u16(a, vdupq_n_u16(255)));
+	}
+
+	template<AlphaMode A> static inline int rowNeon8888(const unsigned int* s, unsigned int* d,
+		const unsigned char* a, int w)
+	{
+		int x = 0;
+		for(; x + 8 <= w; x += 8) {
+			// val[0] is blue, val[3] is alpha.
+			uint8x8x4_t sp = vld4_u8((const uint8_t*)(s + x));
+			uint8x8x4_t dp = vld4_u8((const uint8_t*)(d + x));
+			uint16x8_t av = fullAlpha(vmovl_u8(A == ALPHA_PLANE ? vld1_u8(a + x) : sp.val[3]));
+			uint16x8_t ia = vsubq_u16(vdupq_n_u16(256), av);
+			uint8x8x4_t res;
+			res.val[0] = blend8(sp.val[0], dp.val[0], av, ia);
+			res.val[1] = blend8(sp.val[1], dp.val[1], av, ia);
+			res.val[2] = blend8(sp.val[2], dp.val[2], av, ia);
+			res.val[3] = vdup_n_u8(0);
+			vst4_u8((uint8_t*)(d + x), res);
+		}
+		return x;
+	}
+
+	template<> struct Simd<FormatXRGB8888, ALPHA_PLANE> {
+		static inline int row(const unsigned int* s, unsigned int* d, const unsigned char* a, int w) {
+			return rowNeon8888<ALPHA_PLANE>(s, d, a, w);
+		}
+	};
+
+	template<> struct Simd<FormatXRGB8888, ALPHA_CHANNEL> {
+		static inline int row(const unsigned int* s, unsigned int* d, const unsigned char* a, int w) {
+			return rowNeon8888<ALPHA_CHANNEL>(s, d, a, w);
+		}
+	};
+
+	template<> struct Simd<FormatRGB565, ALPHA_PLANE> {
+		static inline int row(const unsigned short* s, unsigned short* d, const unsigned char* a, int w) {
+			const uint16x8_t m6 = vdupq_n_u16(0x3f);
+			const uint16x8_t m5 = vdupq_n_u16(0x1f);
+			int x = 0;
+			for(; x + 8 <= w; x += 8) {
+				uint16x8_t av = fullAlpha(vmovl_u8(vld1_u8(a + x)));
+				uint16x8_t ia = vsubq_u16(vdupq_n_u16(256), av);
+				uint16x8_t sp = vld1q_u16(s + x);
+				uint16x8_t dp = vld1q_u16(d + x);
+				uint16x8_t r = blend16(vshrq_n_u16(sp, 11), vshrq_n_u16(dp, 11), av, ia);
+				uint16x8_t g = blend16(vandq_u16(vshrq_n_u16(sp, 5), m6),
+					vandq_u16(vshrq_n_u16(dp, 5), m6), av, ia);
+				uint16x8_t b = blend16(vandq_u16(sp, m5), vandq_u16(dp, m5), av, ia);
+				vst1q_u16(d + x, vorrq_u16(vorrq_u16(vshlq_n_u16(r, 11), vshlq_n_u16(g, 5)), b));
+			}
+			return x;
+		}
+	};
+#endif	//BLIT_NEON
+
+	//****************************************
+	// Kernels
+	//****************************************
+
+	// STEP is the source step in pixels, or 0 if it's only known at runtime.
+	template<class F, AlphaMode A, int STEP> void blend(const Params& p) {
+		typedef typename F::Pixel Pixel;
+		const int step = STEP ? STEP : p.srcStepX;
+		const int astep = STEP ? STEP : p.alphaStepX;
+		unsigned char* dst = p.dst;
+		const unsigned char* src = p.src;
+		const unsigned char* alpha = p.alpha;
+		for(int y = 0; y < p.height; y++) {
+			const Pixel* s = (const Pixel*)src;
+			Pixel* d = (Pixel*)dst;
+			const unsigned char* a = alpha;
+			int x = 0;
+			if(STEP == 1) {
+				x = Simd<F, A>::row(s, d, a, p.width);
+				s += x;
+				a += x;
+			}
+			for(; x < p.width; x++) {
+				unsigned sa = (A == ALPHA_PLANE) ? *a : F::alpha(*s, p);
+				d[x] = F::blend(*s, d[x], sa, p);
+				s += step;
+				a += astep;
+			}
+			dst += p.dstPitch;
+			src += p.srcPitchY;
+			alpha += p.alphaPitchY;
+		}
+	}
+
+	template<class Pixel, int STEP> void copy(const Params& p) {
+		const int step = STEP ? STEP : p.srcStepX;
+		unsigned char* dst = p.dst;
+		const unsigned char* src = p.src;
+		for(int y = 0; y < p.height; y++) {
+			if(STEP == 1) {
+				memcpy(dst, src, p.width * sizeof(Pixel));
+			} else {
+				const Pixel* s = (const Pixel*)src;
+				Pixel* d = (Pixel*)dst;
+				for(int x = 0; x < p.width; x++) {
+					d[x] = *s;
+					s += step;
+				}
+			}
+			dst += p.dstPitch;
+			src += p.srcPitchY;
+		}
+	}
+
+	// Copies one pixel at a time, for formats that have no kernel.
+	static void copyBytes(const Params& p) {
+		int bpp = p.dstImg->bytesPerPixel;
+		int step = p.srcStepX * p.srcImg->bytesPerPixel;
+		unsigned char* dst = p.dst;
+		const unsigned char* src = p.src;
+		for(int y = 0; y < p.height; y++) {
+			const unsigned char* s = src;
+			for(int x = 0; x < p.width; x++) {
+				memcpy(dst + x * bpp, s, bpp);
+				s += step;
+			}
+			dst += p.dstPitch;
+			src += p.srcPitchY;
+		}
+	}
+
+	//****************************************
+	// Dispatch
+	//****************************************
+
+	template<class F, AlphaMode A> Kernel selectBlend(int step) {
+		if(step == 1)
+			return blend<F, A, 1>;
+		if(step == -1)
+			return blend<F, A, -1>;
+		return blend<F, A, 0>;
+	}
+
+	template<class Pixel> Kernel selectCopy(int step) {
+		if(step == 1)
+			return copy<Pixel, 1>;
+		if(step == -1)
+			return copy<Pixel, -1>;
+		return copy<Pixel, 0>;
+	}
+
+	static inline bool isRGB565(const Image* i) {
+		return i->bytesPerPixel == 2 &&
+			i->redMask == 0xf800 && i->greenMask == 0x07e0 && i->blueMask == 0x001f;
+	}
+
+	static inline bool isXRGB8888(const Image* i) {
+		return i->bytesPerPixel == 4 &&
+			i->redMask == 0xff0000 && i->greenMask == 0xff00 && i->blueMask == 0xff;
+	}
+
+	// Returns NULL if the source format is not supported.
+	// \a step is the source step in pixels.
+	static Kernel selectKernel(const Image* dst, const Image* src, AlphaMode mode, int step) {
+		int bpp = src->bytesPerPixel;
+		if(mode == ALPHA_NONE) {
+			if(bpp != dst->bytesPerPixel)
+				return copyBytes;
+			if(bpp == 2)
+				return selectCopy<unsigned short>(step);
+			if(bpp == 4)
+				return selectCopy<unsigned int>(step);
+			return copyBytes;
+		}
+		if(mode == ALPHA_PLANE) {
+			if(isRGB565(src) && isRGB565(dst))
+				return selectBlend<FormatRGB565, ALPHA_PLANE>(step);
+			if(isXRGB8888(src) && isXRGB8888(dst))
+				return selectBlend<FormatXRGB8888, ALPHA_PLANE>(step);
+			if(bpp == 2)
+				return selectBlend<FormatMasked<unsigned short>, ALPHA_PLANE>(step);
+			if(bpp == 4)
+				return selectBlend<FormatMasked<unsigned int>, ALPHA_PLANE>(step);
+			return NULL;
+		}
+		// ALPHA_CHANNEL
+		if(bpp != 4)
+			return NULL;
+		if(isXRGB8888(src) && isXRGB8888(dst) && src->alphaMask == 0xff000000)
+			return selectBlend<FormatXRGB8888, ALPHA_CHANNEL>(step);
+		return selectBlend<FormatMasked<unsigned int>, ALPHA_CHANNEL>(step);
+	}
+}
+
+#endif	//_IMAGE_BLIT_H_
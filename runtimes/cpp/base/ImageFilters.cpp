@@ -0,0 +1,370 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+// Channels are interpolated as (a*(256-w) + b*w) >> 8, with w in 0-256,
+// which fits in 16 bits. The SIMD code works on 16-bit channels and the
+// scalar code on two channels per 32-bit word, with the same results.
+// Gradient weights are computed in single precision floats in both.
+
+#include "config_platform.h"
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#include <helpers/helpers.h>
+
+#include "ImageFilters.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FILTERS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace ImageFilters {
+
+	static inline unsigned int lerp(unsigned int a, unsigned int b, unsigned int w) {
+		unsigned int iw = 256 - w;
+		unsigned int rb = ((((a & 0xff00ff) * iw + (b & 0xff00ff) * w) >> 8) & 0xff00ff);
+		unsigned int ag = ((((a >> 8) & 0xff00ff) * iw + ((b >> 8) & 0xff00ff) * w) & 0xff00ff00);
+		return rb | ag;
+	}
+
+	//clamped in floating point, which can hold weights that an int can't.
+	static inline int clampWeight(float t) {
+		if(t <= 0)
+			return 0;
+		if(t >= 256)
+			return 256;
+		return (int)t;
+	}
+
+#ifdef FILTERS_SSE2
+	// 8 16-bit channels, w in 0-256.
+	static inline __m128i lerp16(__m128i a, __m128i b, __m128i w) {
+		__m128i iw = _mm_sub_epi16(_mm_set1_epi16(256), w);
+		return _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(a, iw), _mm_mullo_epi16(b, w)), 8);
+	}
+
+	// two pixels, as 16-bit channels.
+	static inline __m128i pair(unsigned int p, unsigned int q) {
+		return _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128((int)p),
+			_mm_cvtsi32_si128((int)q)), _mm_setzero_si128());
+	}
+
+	static inline __m128i clampWeight4(__m128 t) {
+		t = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), _mm_set1_ps(256.0f));
+		return _mm_cvttps_epi32(t);
+	}
+
+	// stores 4 pixels between the colors \a c0 and \a c1, which are two
+	// copies of each color as 16-bit channels. \a t holds the 4 weights.
+	static inline void store4(unsigned int* d, __m128i c0, __m128i c1, __m128i t) {
+		__m128i w = _mm_packs_epi32(t, t);
+		w = _mm_unpacklo_epi16(w, w);
+		__m128i lo = lerp16(c0, c1, _mm_unpacklo_epi32(w, w));
+		__m128i hi = lerp16(c0, c1, _mm_unpackhi_epi32(w, w));
+		_mm_storeu_si128((__m128i*)d, _mm_packus_epi16(lo, hi));
+	}
+
+	static inline __m128i color16(unsigned int c) {
+		return _mm_unpacklo_epi8(_mm_set1_epi32((int)c), _mm_setzero_si128());
+	}
+#endif	//FILTERS_SSE2
+
+	static void fill(unsigned int* dst, int width, int height, int pitch, unsigned int color) {
+		for(int y=0; y<height; y++) {
+			unsigned int* d = dst + y * pitch;
+			for(int x=0; x<width; x++) {
+				d[x] = color;
+			}
+		}
+	}
+
+	//****************************************
+	// Scaling
+	//****************************************
+
+	// the sample positions along one axis, in 16.16 fixed point.
+	static void positions(std::vector<unsigned int>& pos, int dstSize, int srcSize) {
+		unsigned int delta = (unsigned int)(((u64)srcSize << 16) / dstSize);
+		pos.resize(dstSize);
+		unsigned int p = 0;
+		for(int i=0; i<dstSize; i++) {
+			pos[i] = p;
+			p += delta;
+		}
+	}
+
+	static void scaleNearest(unsigned int* dst, int dw, int dh, int dstPitch,
+		const unsigned int* src, int sw, int sh, int srcPitch)
+	{
+		std::vector<unsigned int> xs, ys;
+		positions(xs, dw, sw);
+		positions(ys, dh, sh);
+		for(int x=0; x<dw; x++) {
+			xs[x] >>= 16;
+		}
+		for(int y=0; y<dh; y++) {
+			unsigned int* d = dst + y * dstPitch;
+			//enlarged images repeat rows.
+			if(y > 0 && (ys[y] >> 16) == (ys[y-1] >> 16)) {
+				memcpy(d, d - dstPitch, dw * sizeof(unsigned int));
+				continue;
+			}
+			const unsigned int* row = src + (ys[y] >> 16) * srcPitch;
+			for(int x=0; x<dw; x++) {
+				d[x] = row[xs[x]];
+			}
+		}
+	}
+
+	struct Columns {
+		std::vector<int> x0, x1;
+		std::vector<unsigned int> fx;
+	};
+
+	static void bilinearRow(unsigned int* d, const unsigned int* r0, const unsigned int* r1,
+		const Columns& c, int width, unsigned int fy)
+	{
+		int x = 0;
+#ifdef FILTERS_SSE2
+		const __m128i wy = _mm_set1_epi16((short)fy);
+		for(; x + 2 <= width; x += 2) {
+			int a0 = c.x0[x], a1 = c.x1[x], b0 = c.x0[x+1], b1 = c.x1[x+1];
+			__m128i wx = _mm_unpacklo_epi64(_mm_set1_epi16((short)c.fx[x]),
+				_mm_set1_epi16((short)c.fx[x+1]));
+			__m128i top = lerp16(pair(r0[a0], r0[b0]), pair(r0[a1], r0[b1]), wx);
+			__m128i bottom = lerp16(pair(r1[a0], r1[b0]), pair(r1[a1], r1[b1]), wx);
+			__m128i res = lerp16(top, bottom, wy);
+			_mm_storel_epi64((__m128i*)(d + x), _mm_packus_epi16(res, res));
+		}
+#endif
+		for(; x<width; x++) {
+			int x0 = c.x0[x], x1 = c.x1[x];
+			unsigned int fx = c.fx[x];
+			d[x] = lerp(lerp(r0[x0], r0[x1], fx), lerp(r1[x0], r1[x1], fx), fy);
+		}
+	}
+
+	static void scaleBilinear(unsigned int* dst, int dw, int dh, int dstPitch,
+		const unsigned int* src, int sw, int sh, int srcPitch)
+	{
+		std::vector<unsigned int> xs, ys;
+		positions(xs, dw, sw);
+		positions(ys, dh, sh);
+		Columns c;
+		c.x0.resize(dw);
+		c.x1.resize(dw);
+		c.fx.resize(dw);
+		for(int x=0; x<dw; x++) {
+			c.x0[x] = xs[x] >> 16;
+			c.x1[x] = MIN(c.x0[x] + 1, sw - 1);
+			c.fx[x] = (xs[x] >> 8) & 0xff;
+		}
+		for(int y=0; y<dh; y++) {
+			int y0 = ys[y] >> 16;
+			int y1 = MIN(y0 + 1, sh - 1);
+			bilinearRow(dst + y * dstPitch, src + y0 * srcPitch, src + y1 * srcPitch,
+				c, dw, (ys[y] >> 8) & 0xff);
+		}
+	}
+
+	// the source pixels covered by each destination pixel along one axis:
+	// from begin[i] up to, but not including, end[i]. Never empty.
+	static void boxes(std::vector<int>& begin, std::vector<int>& end, int dstSize, int srcSize) {
+		begin.resize(dstSize);
+		end.resize(dstSize);
+		for(int i=0; i<dstSize; i++) {
+			begin[i] = (int)(((s64)i * srcSize) / dstSize);
+			end[i] = MAX((int)(((s64)(i + 1) * srcSize) / dstSize), begin[i] + 1);
+		}
+	}
+
+	// adds each channel of \a row to \a sums, which has 4 sums per pixel.
+	static void addRow(unsigned int* sums, const unsigned int* row, int width) {
+		int x = 0;
+#ifdef FILTERS_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		for(; x + 4 <= width; x += 4) {
+			__m128i p = _mm_loadu_si128((const __m128i*)(row + x));
+			__m128i lo = _mm_unpacklo_epi8(p, zero);
+			__m128i hi = _mm_unpackhi_epi8(p, zero);
+			__m128i* s = (__m128i*)(sums + x * 4);
+			_mm_storeu_si128(s, _mm_add_epi32(_mm_loadu_si128(s), _mm_unpacklo_epi16(lo, zero)));
+			_mm_storeu_si128(s + 1, _mm_add_epi32(_mm_loadu_si128(s + 1), _mm_unpackhi_epi16(lo, zero)));
+			_mm_storeu_si128(s + 2, _mm_add_epi32(_mm_loadu_si128(s + 2), _mm_unpacklo_epi16(hi, zero)));
+			_mm_storeu_si128(s + 3, _mm_add_epi32(_mm_loadu_si128(s + 3), _mm_unpackhi_epi16(hi, zero)));
+		}
+#endif
+		for(; x<width; x++) {
+			unsigned int p = row[x];
+			unsigned int* s = sums + x * 4;
+			s[0] += p & 0xff;
+			s[1] += (p >> 8) & 0xff;
+			s[2] += (p >> 16) & 0xff;
+			s[3] += p >> 24;
+		}
+	}
+
+	// adds up the channel sums of pixels \a begin to \a end.
+	static inline void addColumns(unsigned int* total, const unsigned int* sums, int begin, int end) {
+#ifdef FILTERS_SSE2
+		__m128i acc = _mm_setzero_si128();
+		for(int x=begin; x<end; x++) {
+			acc = _mm_add_epi32(acc, _mm_loadu_si128((const __m128i*)(sums + x * 4)));
+		}
+		_mm_storeu_si128((__m128i*)total, acc);
+#else
+		total[0] = total[1] = total[2] = total[3] = 0;
+		for(int x=begin; x<end; x++) {
+			const unsigned int* s = sums + x * 4;
+			total[0] += s[0];
+			total[1] += s[1];
+			total[2] += s[2];
+			total[3] += s[3];
+		}
+#endif
+	}
+
+	static void scaleBox(unsigned int* dst, int dw, int dh, int dstPitch,
+		const unsigned int* src, int sw, int sh, int srcPitch)
+	{
+		std::vector<int> xBegin, xEnd, yBegin, yEnd;
+		boxes(xBegin, xEnd, dw, sw);
+		boxes(yBegin, yEnd, dh, sh);
+		std::vector<unsigned int> sums(sw * 4);
+		for(int y=0; y<dh; y++) {
+			memset(&sums[0], 0, sums.size() * sizeof(unsigned int));
+			for(int sy=yBegin[y]; sy<yEnd[y]; sy++) {
+				addRow(&sums[0], src + sy * srcPitch, sw);
+			}
+			int rows = yEnd[y] - yBegin[y];
+			unsigned int* d = dst + y * dstPitch;
+			for(int x=0; x<dw; x++) {
+				unsigned int total[4];
+				addColumns(total, &sums[0], xBegin[x], xEnd[x]);
+				unsigned int count = (xEnd[x] - xBegin[x]) * rows;
+				unsigned int p = 0;
+				for(int k=0; k<4; k++) {
+					p |= ((total[k] + count / 2) / count) << (k * 8);
+				}
+				d[x] = p;
+			}
+		}
+	}
+
+	void scale(unsigned int* dst, int dstWidth, int dstHeight, int dstPitch,
+		const unsigned int* src, int srcWidth, int srcHeight, int srcPitch, Filter filter)
+	{
+		switch(filter) {
+		case NEAREST:
+			scaleNearest(dst, dstWidth, dstHeight, dstPitch, src, srcWidth, srcHeight, srcPitch);
+			break;
+		case BILINEAR:
+			scaleBilinear(dst, dstWidth, dstHeight, dstPitch, src, srcWidth, srcHeight, srcPitch);
+			break;
+		case BOX:
+			scaleBox(dst, dstWidth, dstHeight, dstPitch, src, srcWidth, srcHeight, srcPitch);
+			break;
+		}
+	}
+
+	//****************************************
+	// Gradients
+	//****************************************
+
+	void linearGradient(unsigned int* dst, int width, int height, int pitch, int left, int top,
+		int startX, int startY, int endX, int endY, unsigned int startColor, unsigned int endColor)
+	{
+		int gx = endX - startX;
+		int gy = endY - startY;
+		//the squares overflow an int for points more than 46340 pixels apart.
+		long long len2 = (long long)gx * gx + (long long)gy * gy;
+		if(len2 == 0) {
+			fill(dst, width, height, pitch, endColor);
+			return;
+		}
+		//the weight of a pixel is its projection on the gradient, from 0 to 256.
+		//It is computed from the start of each row, in floating point, so that
+		//no dot product can overflow.
+		double scale = 256.0 / (double)len2;
+		const float step = (float)(gx * scale);
+#ifdef FILTERS_SSE2
+		const __m128i c0 = color16(startColor);
+		const __m128i c1 = color16(endColor);
+		const __m128 step4 = _mm_set1_ps(step);
+#endif
+		for(int y=0; y<height; y++) {
+			unsigned int* d = dst + y * pitch;
+			float w0 = (float)(((double)left - startX) * gx * scale +
+				((double)top + y - startY) * gy * scale);
+			int x = 0;
+#ifdef FILTERS_SSE2
+			const __m128 w04 = _mm_set1_ps(w0);
+			__m128 xs = _mm_setr_ps(0, 1, 2, 3);
+			for(; x + 4 <= width; x += 4) {
+				__m128 w = _mm_add_ps(w04, _mm_mul_ps(xs, step4));
+				store4(d + x, c0, c1, clampWeight4(w));
+				xs = _mm_add_ps(xs, _mm_set1_ps(4.0f));
+			}
+#endif
+			for(; x<width; x++) {
+				d[x] = lerp(startColor, endColor, clampWeight(w0 + (float)x * step));
+			}
+		}
+	}
+
+	void radialGradient(unsigned int* dst, int width, int height, int pitch, int left, int top,
+		int centerX, int centerY, int radius, unsigned int centerColor, unsigned int edgeColor)
+	{
+		if(radius <= 0) {
+			fill(dst, width, height, pitch, edgeColor);
+			return;
+		}
+		float scale = 256.0f / (float)radius;
+#ifdef FILTERS_SSE2
+		const __m128i c0 = color16(centerColor);
+		const __m128i c1 = color16(edgeColor);
+		const __m128 scale4 = _mm_set1_ps(scale);
+#endif
+		//the distances are in floating point, as they may not fit in an int.
+		const float dx0 = (float)((double)left - centerX);
+		for(int y=0; y<height; y++) {
+			unsigned int* d = dst + y * pitch;
+			float dy = (float)((double)top + y - centerY);
+			float dy2 = dy * dy;
+			int x = 0;
+#ifdef FILTERS_SSE2
+			const __m128 dy2v = _mm_set1_ps(dy2);
+			const __m128 dx04 = _mm_set1_ps(dx0);
+			__m128 xs = _mm_setr_ps(0, 1, 2, 3);
+			for(; x + 4 <= width; x += 4) {
+				__m128 f = _mm_add_ps(dx04, xs);
+				__m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(f, f), dy2v));
+				store4(d + x, c0, c1, clampWeight4(_mm_mul_ps(len, scale4)));
+				xs = _mm_add_ps(xs, _mm_set1_ps(4.0f));
+			}
+#endif
+			for(; x<width; x++) {
+				float f = dx0 + (float)x;
+				float len = sqrtf(f * f + dy2);
+				d[x] = lerp(centerColor, edgeColor, clampWeight(len * scale));
+			}
+		}
+	}
+}
@@ -0,0 +1,62 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+// Image scaling and gradient generation, for maCreateScaledImage(),
+// maFillLinearGradient() and maFillRadialGradient().
+//
+// All buffers hold 32-bit 0xAARRGGBB pixels. Pitches are in pixels.
+// The inner loops use SSE2 where available. The scalar code produces
+// exactly the same pixels.
+
+#ifndef _IMAGE_FILTERS_H_
+#define _IMAGE_FILTERS_H_
+
+namespace ImageFilters {
+
+	// Same values as the IMAGE_SCALE constants.
+	enum Filter {
+		NEAREST = 0,
+		BILINEAR = 1,
+		BOX = 2
+	};
+
+	// Scales all of \a src to all of \a dst. All sizes must be > 0.
+	//
+	// NEAREST and BILINEAR sample the source at (x*srcWidth/dstWidth,
+	// y*srcHeight/dstHeight) in 16.16 fixed point, like MAUI::Scaler.
+	// BILINEAR uses 8-bit weights and repeats the last row and column.
+	// BOX averages all source pixels that a destination pixel covers.
+	// An axis that is enlarged uses one source pixel per destination pixel.
+	void scale(unsigned int* dst, int dstWidth, int dstHeight, int dstPitch,
+		const unsigned int* src, int srcWidth, int srcHeight, int srcPitch, Filter filter);
+
+	// Fills \a dst with a linear gradient. The first pixel of \a dst is at
+	// (\a left, \a top) in the coordinate system of the gradient.
+	// Pixels are \a startColor on the start side of the line through
+	// \a startX, \a startY that is perpendicular to the gradient, and
+	// \a endColor on the end side of the line through \a endX, \a endY.
+	// If the points are equal, all pixels are \a endColor.
+	void linearGradient(unsigned int* dst, int width, int height, int pitch, int left, int top,
+		int startX, int startY, int endX, int endY, unsigned int startColor, unsigned int endColor);
+
+	// Fills \a dst with a radial gradient, from \a centerColor at the center
+	// to \a edgeColor at \a radius and beyond.
+	void radialGradient(unsigned int* dst, int width, int height, int pitch, int left, int top,
+		int centerX, int centerY, int radius, unsigned int centerColor, unsigned int edgeColor);
+}
+
+#endif	//_IMAGE_FILTERS_H_
@@ -0,0 +1,453 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#include "config_platform.h"
+
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <helpers/helpers.h>
+#include <helpers/atomic.h>
+#include <helpers/cpp_defs.h>
+
+#ifdef WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "LogStore.h"
+
+// The file starts with this.
+#define MAGIC "MALOG01\n"
+#define MAGIC_SIZE 8
+
+// Each record starts with a checksum of the rest of the record, its key,
+// and the size of its data, which follows. A removal has no data.
+#define HEADER_SIZE 12
+#define REMOVED -1
+
+#define COPY_BUFFER_SIZE (64 * 1024)
+
+//*****************************************************************************
+// Helpers
+//*****************************************************************************
+
+// CRC-32, as in zip and png.
+static unsigned int sCrcTable[256];
+
+static unsigned int crc32(unsigned int crc, const void* data, int size) {
+	if(sCrcTable[1] == 0) {
+		for(unsigned int i=0; i<256; i++) {
+			unsigned int c = i;
+			for(int j=0; j<8; j++) {
+				c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+			}
+			sCrcTable[i] = c;
+		}
+	}
+	const unsigned char* p = (const unsigned char*)data;
+	crc = ~crc;
+	for(int i=0; i<size; i++) {
+		crc = sCrcTable[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+static unsigned int recordCrc(int key, int size, const void* data) {
+	int ks[2] = { key, size };
+	unsigned int crc = crc32(0, ks, sizeof(ks));
+	return size > 0 ? crc32(crc, data, size) : crc;
+}
+
+// Waits until the file's contents are on the disk.
+static bool syncFile(FILE* file) {
+	if(fflush(file) != 0)
+		return false;
+#ifdef WIN32
+	return _commit(_fileno(file)) == 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif
+}
+
+static bool truncateFile(FILE* file, int size) {
+	if(fflush(file) != 0)
+		return false;
+#ifdef WIN32
+	return _chsize(_fileno(file), size) == 0;
+#else
+	return ftruncate(fileno(file), size) == 0;
+#endif
+}
+
+// Replaces \a to with \a from, in one step.
+static bool replaceFile(const char* from, const char* to) {
+#ifdef WIN32
+	return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	return rename(from, to) == 0;
+#endif
+}
+
+// Copies \a size bytes from the current position of \a in to \a out.
+// Compactions of different stores may run at the same time.
+static bool copyBytes(FILE* in, FILE* out, int size) {
+	std::vector<char> buffer(MIN(size, COPY_BUFFER_SIZE) + 1);
+	while(size > 0) {
+		int n = MIN(size, COPY_BUFFER_SIZE);
+		if(fread(&buffer[0], 1, n, in) != (size_t)n)
+			return false;
+		if(fwrite(&buffer[0], 1, n, out) != (size_t)n)
+			return false;
+		size -= n;
+	}
+	return true;
+}
+
+static int writeError() {
+	return errno == ENOSPC ? STERR_FULL : STERR_GENERIC;
+}
+
+//*****************************************************************************
+// Opening
+//*****************************************************************************
+
+LogStore::LogStore(const std::string& path, FILE* file)
+: mPath(path), mFile(file), mFileSize(0), mLiveBytes(0), mCompactions(0),
+mCompacting(false), mSnapshotEnd(0), mCompactedSize(0), mCompactDone(0), mCompactOk(false)
+{
+}
+
+LogStore::~LogStore() {
+	finishCompaction(true);
+	if(mFile)
+		fclose(mFile);
+}
+
+LogStore* LogStore::open(const char* path, bool create, int* error) {
+	//left behind by a compaction that did not finish.
+	::remove((std::string(path) + ".tmp").c_str());
+
+	FILE* file = fopen(path, "r+b");
+	if(!file) {
+		if(!create) {
+			*error = STERR_NONEXISTENT;
+			return NULL;
+		}
+		file = fopen(path, "w+b");
+		if(!file) {
+			*error = STERR_GENERIC;
+			return NULL;
+		}
+	}
+	LogStore* store = new LogStore(path, file);
+	if(!store->recover()) {
+		delete store;
+		*error = STERR_GENERIC;
+		return NULL;
+	}
+	return store;
+}
+
+bool LogStore::recover() {
+	if(fseek(mFile, 0, SEEK_END) != 0)
+		return false;
+	long fileSize = ftell(mFile);
+	if(fileSize < 0 || fileSize > INT_MAX)
+		return false;
+
+	char magic[MAGIC_SIZE];
+	if(fileSize < MAGIC_SIZE) {
+		//new, or its creation was cut short.
+		if(!truncateFile(mFile, 0) || fseek(mFile, 0, SEEK_SET) != 0 ||
+			fwrite(MAGIC, 1, MAGIC_SIZE, mFile) != MAGIC_SIZE || fflush(mFile) != 0)
+		{
+			return false;
+		}
+		mFileSize = MAGIC_SIZE;
+		return true;
+	}
+	if(fseek(mFile, 0, SEEK_SET) != 0 || fread(magic, 1, MAGIC_SIZE, mFile) != MAGIC_SIZE ||
+		memcmp(magic, MAGIC, MAGIC_SIZE) != 0)
+	{
+		LOG("LogStore: %s is not a log store.\n", mPath.c_str());
+		return false;
+	}
+
+	//the file is read in order, so no seeks are needed.
+	std::vector<char> data;
+	int pos = MAGIC_SIZE;
+	while(pos <= fileSize - HEADER_SIZE) {
+		int header[3];
+		if(fread(header, 1, HEADER_SIZE, mFile) != HEADER_SIZE)
+			break;
+		int key = header[1], size = header[2];
+		if(size < REMOVED || size > fileSize - pos - HEADER_SIZE)
+			break;
+		if(size > 0) {
+			if((int)data.size() < size)
+				data.resize(size);
+			if(fread(&data[0], 1, size, mFile) != (size_t)size)
+				break;
+		}
+		if((unsigned int)header[0] != recordCrc(key, size, size > 0 ? &data[0] : NULL))
+			break;
+
+		Index::iterator itr = mIndex.find(key);
+		if(itr != mIndex.end()) {
+			mLiveBytes -= HEADER_SIZE + itr->second.size;
+			if(size == REMOVED)
+				mIndex.erase(itr);
+		}
+		if(size != REMOVED) {
+			Record& r = mIndex[key];
+			r.offset = pos;
+			r.size = size;
+			mLiveBytes += HEADER_SIZE + size;
+		}
+		pos += HEADER_SIZE + MAX(size, 0);
+	}
+
+	//a torn or damaged record, and anything after it.
+	if(pos < fileSize) {
+		LOG("LogStore: dropping %i bytes at the end of %s.\n", (int)fileSize - pos, mPath.c_str());
+		if(!truncateFile(mFile, pos))
+			return false;
+	}
+	mFileSize = pos;
+	return true;
+}
+
+//*****************************************************************************
+// Records
+//*****************************************************************************
+
+int LogStore::writeRecord(int key, const void* data, int size) {
+	if(!mFile)
+		return STERR_GENERIC;
+	if(MAX(size, 0) > INT_MAX - HEADER_SIZE - mFileSize)
+		return STERR_FULL;
+	int header[3] = { (int)recordCrc(key, size, data), key, size };
+	if(fseek(mFile, mFileSize, SEEK_SET) != 0 ||
+		fwrite(header, 1, HEADER_SIZE, mFile) != HEADER_SIZE ||
+		(size > 0 && fwrite(data, 1, size, mFile) != (size_t)size) ||
+		fflush(mFile) != 0)
+	{
+		int error = writeError();
+		//don't leave a partial record for the next one to follow.
+		clearerr(mFile);
+		truncateFile(mFile, mFileSize);
+		return error;
+	}
+	mFileSize += HEADER_SIZE + MAX(size, 0);
+	return 0;
+}
+
+int LogStore::append(int key, const void* data, int size) {
+	int res = finishCompaction(false);
+	if(res < 0)
+		return res;
+	int offset = mFileSize;
+	res = writeRecord(key, data, size);
+	if(res < 0)
+		return res;
+	Record& r = mIndex[key];
+	if(r.offset != 0)
+		mLiveBytes -= HEADER_SIZE + r.size;
+	r.offset = offset;
+	r.size = size;
+	mLiveBytes += HEADER_SIZE + size;
+	startCompaction();
+	return 0;
+}
+
+int LogStore::remove(int key) {
+	int res = finishCompaction(false);
+	if(res < 0)
+		return res;
+	Index::iterator itr = mIndex.find(key);
+	if(itr == mIndex.end())
+		return STERR_NONEXISTENT;
+	res = writeRecord(key, NULL, REMOVED);
+	if(res < 0)
+		return res;
+	mLiveBytes -= HEADER_SIZE + itr->second.size;
+	mIndex.erase(itr);
+	startCompaction();
+	return 0;
+}
+
+int LogStore::read(int key, void* dst, int dstSize) {
+	int res = finishCompaction(false);
+	if(res < 0)
+		return res;
+	Index::const_iterator itr = mIndex.find(key);
+	if(itr == mIndex.end())
+		return STERR_NONEXISTENT;
+	const Record& r = itr->second;
+	if(r.size <= dstSize && r.size > 0) {
+		if(!mFile)
+			return STERR_GENERIC;
+		if(fseek(mFile, r.offset + HEADER_SIZE, SEEK_SET) != 0 ||
+			fread(dst, 1, r.size, mFile) != (size_t)r.size)
+		{
+			clearerr(mFile);
+			return STERR_GENERIC;
+		}
+	}
+	return r.size;
+}
+
+int LogStore::next(int key) {
+	int res = finishCompaction(false);
+	if(res < 0)
+		return res;
+	Index::const_iterator itr = mIndex.upper_bound(key);
+	if(itr == mIndex.end())
+		return STERR_NONEXISTENT;
+	return itr->first;
+}
+
+//*****************************************************************************
+// Compaction
+//*****************************************************************************
+
+void LogStore::startCompaction() {
+	if(mCompacting || mFileSize < LOG_STORE_COMPACT_MIN ||
+		mFileSize - MAGIC_SIZE <= 2 * mLiveBytes)
+	{
+		return;
+	}
+	//the records keep their order.
+	std::map<int, int> sizes;
+	for(Index::const_iterator itr = mIndex.begin(); itr != mIndex.end(); ++itr) {
+		sizes[itr->second.offset] = itr->second.size;
+	}
+	mSnapshot.clear();
+	mSnapshot.reserve(sizes.size());
+	for(std::map<int, int>::const_iterator itr = sizes.begin(); itr != sizes.end(); ++itr) {
+		Record r = { itr->first, itr->second };
+		mSnapshot.push_back(r);
+	}
+	mNewOffsets.clear();
+	mSnapshotEnd = mFileSize;
+	mCompactDone = 0;
+	mCompacting = true;
+	mThread.start(homeRun, this);
+}
+
+int LogStore::homeRun(void* data) {
+	((LogStore*)data)->compact();
+	return 0;
+}
+
+void LogStore::compact() {
+	bool ok = false;
+	FILE* in = fopen(mPath.c_str(), "rb");
+	FILE* out = fopen((mPath + ".tmp").c_str(), "wb");
+	if(in && out && fwrite(MAGIC, 1, MAGIC_SIZE, out) == MAGIC_SIZE) {
+		int pos = MAGIC_SIZE;
+		mNewOffsets.reserve(mSnapshot.size());
+		ok = true;
+		for(size_t i=0; i<mSnapshot.size() && ok; i++) {
+			const Record& r = mSnapshot[i];
+			int size = HEADER_SIZE + r.size;
+			ok = fseek(in, r.offset, SEEK_SET) == 0 && copyBytes(in, out, size);
+			mNewOffsets.push_back(pos);
+			pos += size;
+		}
+		mCompactedSize = pos;
+	}
+	if(in)
+		fclose(in);
+	if(out) {
+		//synced here, so that finishCompaction() only waits for the tail.
+		ok = syncFile(out) && ok;
+		fclose(out);
+	}
+	mCompactOk = ok;
+	atomicMemoryBarrier();
+	mCompactDone = 1;
+}
+
+int LogStore::finishCompaction(bool wait) {
+	if(!mCompacting)
+		return 0;
+	if(!wait && !mCompactDone)
+		return 0;
+	mThread.join();
+	mCompacting = false;
+
+	std::string tmp = mPath + ".tmp";
+	bool ok = mCompactOk && mFile;
+	//the records appended since the compaction started.
+	if(ok) {
+		FILE* out = fopen(tmp.c_str(), "ab");
+		ok = out && fseek(mFile, mSnapshotEnd, SEEK_SET) == 0 &&
+			copyBytes(mFile, out, mFileSize - mSnapshotEnd);
+		if(out)
+			ok = syncFile(out) && ok;
+		if(out)
+			fclose(out);
+		clearerr(mFile);
+	}
+	if(ok) {
+		fclose(mFile);
+		ok = replaceFile(tmp.c_str(), mPath.c_str());
+		//the new file, or the old one if it was not replaced.
+		mFile = fopen(mPath.c_str(), "r+b");
+	}
+	if(!ok) {
+		LOG("LogStore: compaction of %s failed.\n", mPath.c_str());
+		::remove(tmp.c_str());
+		mSnapshot.clear();
+		mNewOffsets.clear();
+		//the store is still usable, unless its file could not be reopened.
+		return mFile ? 0 : STERR_GENERIC;
+	}
+
+	for(Index::iterator itr = mIndex.begin(); itr != mIndex.end(); ++itr) {
+		Record& r = itr->second;
+		if(r.offset >= mSnapshotEnd) {
+			r.offset += mCompactedSize - mSnapshotEnd;
+		} else {
+			//the snapshot is sorted by offset.
+			size_t lo = 0, hi = mSnapshot.size();
+			while(lo + 1 < hi) {
+				size_t mid = (lo + hi) / 2;
+				if(mSnapshot[mid].offset <= r.offset)
+					lo = mid;
+				else
+					hi = mid;
+			}
+			r.offset = mNewOffsets[lo];
+		}
+	}
+	LOG("LogStore: compacted %s from %i to %i bytes.\n", mPath.c_str(),
+		mFileSize, mCompactedSize + mFileSize - mSnapshotEnd);
+	mFileSize = mCompactedSize + mFileSize - mSnapshotEnd;
+	mCompactions++;
+	mSnapshot.clear();
+	mNewOffsets.clear();
+	if(!mFile) {
+		LOG("LogStore: could not reopen %s after compaction.\n", mPath.c_str());
+		return STERR_GENERIC;
+	}
+	return 0;
+}
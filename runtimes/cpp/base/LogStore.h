@@ -0,0 +1,109 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#ifndef _LOG_STORE_H_
+#define _LOG_STORE_H_
+
+#include <stdio.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ThreadPool.h"
+
+// A log store is smaller than this before it is compacted.
+#define LOG_STORE_COMPACT_MIN (256 * 1024)
+
+// A store of records, each with an int key, in a file that is only ever
+// appended to. Writing a record with a key that is already in the store
+// replaces it, and removing a record appends a marker. Each record has a
+// checksum. Opening a store drops a record that was only partly written,
+// such as one that was being written when the app or device died. Records
+// after it are dropped as well.
+//
+// The position of every record is kept in memory. Once the file is more
+// than twice the size of its live records, a thread of its own copies them
+// to a new file. That file replaces the old one at the next call.
+class LogStore {
+public:
+	// Returns NULL, and sets \a error to an STERR code, on failure.
+	static LogStore* open(const char* path, bool create, int* error);
+	// Finishes any compaction.
+	~LogStore();
+
+	// These return 0 or an STERR code.
+	int append(int key, const void* data, int size);
+	int remove(int key);
+
+	// Returns the size of the record, or STERR_NONEXISTENT.
+	// Copies the record to \a dst only if it fits in \a dstSize bytes.
+	int read(int key, void* dst, int dstSize);
+
+	// Returns the smallest key that is greater than \a key,
+	// or STERR_NONEXISTENT if there is none.
+	int next(int key);
+
+	const std::string& getPath() const { return mPath; }
+	int getFileSize() const { return mFileSize; }
+	int getLiveBytes() const { return mLiveBytes; }
+	int getCompactions() const { return mCompactions; }
+
+	// Waits for a compaction that is running, and finishes it.
+	// Returns 0 or an STERR code.
+	int finishCompaction() { return finishCompaction(true); }
+
+private:
+	struct Record {
+		int offset;	//of the record's header in the file.
+		int size;	//of the data.
+	};
+	typedef std::map<int, Record> Index;
+
+	std::string mPath;
+	FILE* mFile;
+	Index mIndex;
+	int mFileSize;
+	int mLiveBytes;
+	int mCompactions;
+
+	//compaction. mCompacting is true from the start of the thread until
+	//finishCompaction(). The thread copies the records in mSnapshot, which
+	//are before mSnapshotEnd, to the temporary file, and stores their new
+	//offsets in mNewOffsets. While it runs, nothing else touches those
+	//members, or the part of the file before mSnapshotEnd.
+	bool mCompacting;
+	MoSyncThread mThread;
+	std::vector<Record> mSnapshot;
+	std::vector<int> mNewOffsets;
+	int mSnapshotEnd;
+	int mCompactedSize;
+	volatile long mCompactDone;
+	bool mCompactOk;
+
+	LogStore(const std::string& path, FILE* file);
+	LogStore(const LogStore&);
+	LogStore& operator=(const LogStore&);
+
+	bool recover();
+	int writeRecord(int key, const void* data, int size);
+	void startCompaction();
+	int finishCompaction(bool wait);
+	void compact();
+	static int homeRun(void* data);
+};
+
+#endif	//_LOG_STORE_H_
@@ -0,0 +1,287 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#include "config_platform.h"
+#include <helpers/helpers.h>
+
+#include "Lz4Stream.h"
+#include "MemStream.h"
+
+#include <string.h>
+
+using namespace Base;
+
+#define LZ4_RAW_BLOCK 0x80000000
+#define LZ4_MIN_MATCH 4
+// Larger blocks would be a sign of a corrupt file.
+#define LZ4_MAX_BLOCK_SIZE (4*1024*1024)
+
+//******************************************************************************
+// Decompressor
+//******************************************************************************
+
+// Reads the part of a length that doesn't fit in a token nibble.
+// Fails if the length would be greater than \a max, so it can't overflow.
+static bool readLength(const byte*& ip, const byte* iend, int& len, int max) {
+	int b;
+	do {
+		if(ip >= iend)
+			return false;
+		b = *ip++;
+		len += b;
+		if(len > max)
+			return false;
+	} while(b == 255);
+	return true;
+}
+
+int Base::lz4Decompress(const byte* src, int srcSize, byte* dst, int dstSize) {
+	const byte* ip = src;
+	const byte* const iend = src + srcSize;
+	byte* op = dst;
+	byte* const oend = dst + dstSize;
+
+	while(ip < iend) {
+		int token = *ip++;
+
+		int litLen = token >> 4;
+		if(litLen == 15 && !readLength(ip, iend, litLen, oend - op))
+			return -1;
+		if(litLen > iend - ip || litLen > oend - op)
+			return -1;
+		memcpy(op, ip, litLen);
+		ip += litLen;
+		op += litLen;
+
+		// the last sequence has no match.
+		if(ip == iend)
+			break;
+
+		if(iend - ip < 2)
+			return -1;
+		int offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if(offset == 0 || offset > op - dst)
+			return -1;
+
+		int matchLen = token & 15;
+		if(matchLen == 15 && !readLength(ip, iend, matchLen, (oend - op) - LZ4_MIN_MATCH))
+			return -1;
+		matchLen += LZ4_MIN_MATCH;
+		if(matchLen > oend - op)
+			return -1;
+
+		const byte* match = op - offset;
+		if(offset >= matchLen) {
+			memcpy(op, match, matchLen);
+			op += matchLen;
+		} else {
+			// overlapping; repeats the last offset bytes.
+			for(int i=0; i<matchLen; i++) {
+				*op++ = *match++;
+			}
+		}
+	}
+	return op - dst;
+}
+
+//******************************************************************************
+// Lz4Stream
+//******************************************************************************
+
+static int readLE32(const byte* p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24);
+}
+
+Lz4Stream::Lz4Stream(Stream* src) : mSrc(src), mSize(-1), mBlockSize(0),
+	mBlockCount(0), mBlocks(NULL), mPos(0), mCachedBlock(-1), mCache(NULL),
+	mPacked(NULL), mMaxStoredSize(0)
+{
+	if(!readHeader())
+		mSize = -1;
+}
+
+Lz4Stream::~Lz4Stream() {
+	delete mSrc;
+	delete[] mBlocks;
+	delete[] mCache;
+	delete[] mPacked;
+}
+
+bool Lz4Stream::readHeader() {
+	TEST(mSrc->isOpen());
+	int srcLength;
+	TEST(mSrc->length(srcLength));
+	TEST(mSrc->seek(Seek::Start, 0));
+
+	byte header[8];
+	TEST(mSrc->read(header, sizeof(header)));
+	int size = readLE32(header);
+	mBlockSize = readLE32(header + 4);
+	if(size < 0 || mBlockSize <= 0 || mBlockSize > LZ4_MAX_BLOCK_SIZE) {
+		FAIL;
+	}
+	mBlockCount = size / mBlockSize + (size % mBlockSize != 0);
+	if(mBlockCount > (srcLength - 8) / 4) {
+		FAIL;
+	}
+
+	MemStream table(mBlockCount * 4);
+	TEST(mSrc->readFully(table));
+	const byte* entries = (const byte*)table.ptr();
+	mBlocks = new Block[mBlockCount];
+	int offset = 8 + mBlockCount * 4;
+	for(int i=0; i<mBlockCount; i++) {
+		int entry = readLE32(entries + i*4);
+		Block& b(mBlocks[i]);
+		b.offset = offset;
+		b.raw = (entry & LZ4_RAW_BLOCK) != 0;
+		b.storedSize = entry & ~LZ4_RAW_BLOCK;
+		int blockLen = MIN(mBlockSize, size - i * mBlockSize);
+		if(b.storedSize > srcLength - offset || (b.raw && b.storedSize != blockLen)) {
+			FAIL;
+		}
+		offset += b.storedSize;
+		mMaxStoredSize = MAX(mMaxStoredSize, b.storedSize);
+	}
+	mSize = size;
+	return true;
+}
+
+bool Lz4Stream::decodeBlock(int block, byte* dst) {
+	const Block& b(mBlocks[block]);
+	int blockLen = MIN(mBlockSize, mSize - block * mBlockSize);
+
+	// memory streams are decompressed in place.
+	const byte* base = (const byte*)mSrc->ptrc();
+	if(base != NULL) {
+		if(b.raw) {
+			memcpy(dst, base + b.offset, blockLen);
+			return true;
+		}
+		return lz4Decompress(base + b.offset, b.storedSize, dst, blockLen) == blockLen;
+	}
+
+	TEST(mSrc->seek(Seek::Start, b.offset));
+	if(b.raw) {
+		return mSrc->read(dst, blockLen);
+	}
+	if(mPacked == NULL)
+		mPacked = new byte[mMaxStoredSize];
+	TEST(mSrc->read(mPacked, b.storedSize));
+	return lz4Decompress(mPacked, b.storedSize, dst, blockLen) == blockLen;
+}
+
+bool Lz4Stream::isOpen() const {
+	return mSize >= 0;
+}
+
+bool Lz4Stream::read(void* dst, int size) {
+	TEST(isOpen());
+	if(size < 0 || size > mSize - mPos) {
+		FAIL;
+	}
+	byte* d = (byte*)dst;
+	while(size > 0) {
+		int block = mPos / mBlockSize;
+		int offset = mPos % mBlockSize;
+		int blockLen = MIN(mBlockSize, mSize - block * mBlockSize);
+		int len = MIN(size, blockLen - offset);
+		if(len == blockLen && block != mCachedBlock) {
+			TEST(decodeBlock(block, d));
+		} else {
+			if(block != mCachedBlock) {
+				if(mCache == NULL)
+					mCache = new byte[mBlockSize];
+				mCachedBlock = -1;
+				TEST(decodeBlock(block, mCache));
+				mCachedBlock = block;
+			}
+			memcpy(d, mCache + offset, len);
+		}
+		d += len;
+		mPos += len;
+		size -= len;
+	}
+	return true;
+}
+
+bool Lz4Stream::length(int& aLength) const {
+	TEST(isOpen());
+	aLength = mSize;
+	return true;
+}
+
+bool Lz4Stream::seek(Seek::Enum mode, int offset) {
+	TEST(isOpen());
+	int newPos;
+	if(mode == Seek::Start) {
+		newPos = offset;
+	} else if(mode == Seek::Current) {
+		newPos = mPos + offset;
+	} else if(mode == Seek::End) {
+		newPos = mSize + offset;
+	} else {	//unsupported mode
+		FAIL;
+	}
+	if(newPos < 0 || newPos > mSize) {
+		FAIL;
+	}
+	mPos = newPos;
+	return true;
+}
+
+bool Lz4Stream::tell(int& aPos) const {
+	TEST(isOpen());
+	aPos = mPos;
+	return true;
+}
+
+// The copy is decompressed, so keep it small.
+Stream* Lz4Stream::createLimitedCopy(int size) const {
+	TEST(isOpen());
+	if(size < 0)
+		size = mSize - mPos;
+	else if(size > mSize - mPos) {
+		FAIL;
+	}
+	Lz4Stream* copy = (Lz4Stream*)createCopy();
+	if(copy == NULL) {
+		FAIL;
+	}
+	MemStream* ms = new MemStream(size);
+	bool ok = copy->seek(Seek::Start, mPos) && copy->readFully(*ms);
+	delete copy;
+	if(!ok) {
+		delete ms;
+		FAIL;
+	}
+	return ms;
+}
+
+Stream* Lz4Stream::createCopy() const {
+	Stream* src = mSrc->createCopy();
+	if(src == NULL) {
+		FAIL;
+	}
+	Lz4Stream* copy = new Lz4Stream(src);
+	if(!copy->isOpen()) {
+		delete copy;
+		FAIL;
+	}
+	return copy;
+}
@@ -0,0 +1,94 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#ifndef _BASE_LZ4_STREAM_H_
+#define _BASE_LZ4_STREAM_H_
+
+#include "Stream.h"
+
+namespace Base {
+
+	// Decompresses one LZ4 block into dst.
+	// Returns the decompressed size, or -1 if the data is corrupt
+	// or would not fit in dstSize bytes.
+	int lz4Decompress(const byte* src, int srcSize, byte* dst, int dstSize);
+
+	// A read-only stream of the data in an LZ4_BINARY or LZ4_UBIN resource.
+	//
+	// The resource compiler splits the data into blocks that are compressed
+	// independently. Reads decompress only the blocks they touch. Whole blocks
+	// are decompressed straight into the destination; partial blocks go
+	// through a one-block cache. So memory use is bounded by the block size,
+	// however large the resource.
+	//
+	// Format, all ints little-endian:
+	// int size;
+	// int blockSize;
+	// int blocks[(size + blockSize - 1) / blockSize];
+	// followed by the blocks. Each entry in blocks[] is the stored size of a
+	// block, with LZ4_RAW_BLOCK set if the block is not compressed.
+	// Must match tools/pipe-tool/lz4pack.h.
+	class Lz4Stream : public Stream {
+	public:
+		// Takes ownership of \a src, which must contain exactly one resource.
+		// If the header is invalid, isOpen() returns false.
+		Lz4Stream(Stream* src);
+		virtual ~Lz4Stream();
+
+		bool isOpen() const;
+		bool read(void* dst, int size);
+		bool write(const void*, int) { FAIL; }
+
+		bool length(int& aLength) const;
+		bool seek(Seek::Enum mode, int offset);
+		bool tell(int& aPos) const;
+
+		Stream* createLimitedCopy(int size) const;
+		Stream* createCopy() const;
+
+	private:
+		struct Block {
+			int offset;	// from the start of mSrc.
+			int storedSize;
+			bool raw;
+		};
+
+		Stream* mSrc;
+		int mSize;
+		int mBlockSize;
+		int mBlockCount;
+		Block* mBlocks;
+		int mPos;
+
+		// The block in mCache, or -1.
+		int mCachedBlock;
+		byte* mCache;
+		// Holds a compressed block while it is being decompressed.
+		// Not needed if mSrc is in memory.
+		byte* mPacked;
+		int mMaxStoredSize;
+
+		bool readHeader();
+		bool decodeBlock(int block, byte* dst);
+
+		Lz4Stream(const Lz4Stream&);
+		Lz4Stream& operator=(const Lz4Stream&);
+	};
+
+} // namespace Base
+
+#endif // _BASE_LZ4_STREAM_H_
@@ -0,0 +1,103 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#include "config_platform.h"
+#include <helpers/helpers.h>
+
+#include "MappedFile.h"
+
+#if defined(WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+namespace Base {
+
+#if defined(WIN32)
+
+	MappedFile::MappedFile(const char* filename) : mData(NULL), mSize(0),
+		mFileHandle(INVALID_HANDLE_VALUE), mMappingHandle(NULL)
+	{
+		HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if(file == INVALID_HANDLE_VALUE) {
+			LOG("MappedFile: could not open %s. %i\n", filename, GetLastError());
+			return;
+		}
+		mFileHandle = file;
+		DWORD size = GetFileSize(file, NULL);
+		if(size == 0 || size == INVALID_FILE_SIZE || size > 0x7fffffff)
+			return;
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if(mapping == NULL) {
+			LOG("MappedFile: CreateFileMapping failed. %i\n", GetLastError());
+			return;
+		}
+		mMappingHandle = mapping;
+		mData = (char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if(mData == NULL) {
+			LOG("MappedFile: MapViewOfFile failed. %i\n", GetLastError());
+			return;
+		}
+		mSize = size;
+	}
+
+	MappedFile::~MappedFile() {
+		if(mData)
+			UnmapViewOfFile(mData);
+		if(mMappingHandle)
+			CloseHandle(mMappingHandle);
+		if(mFileHandle != INVALID_HANDLE_VALUE)
+			CloseHandle(mFileHandle);
+	}
+
+#else	//POSIX
+
+	MappedFile::MappedFile(const char* filename) : mData(NULL), mSize(0) {
+		int fd = open(filename, O_RDONLY);
+		if(fd < 0) {
+			LOG("MappedFile: could not open %s. %i\n", filename, errno);
+			return;
+		}
+		struct stat s;
+		if(fstat(fd, &s) == 0 && s.st_size > 0 && s.st_size <= 0x7fffffff) {
+			void* p = mmap(NULL, s.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if(p == MAP_FAILED) {
+				LOG("MappedFile: mmap failed. %i\n", errno);
+			} else {
+				mData = (char*)p;
+				mSize = (int)s.st_size;
+			}
+		}
+		//the mapping stays valid after the descriptor is closed.
+		close(fd);
+	}
+
+	MappedFile::~MappedFile() {
+		if(mData)
+			munmap(mData, mSize);
+	}
+
+#endif	//WIN32
+
+} // namespace Base
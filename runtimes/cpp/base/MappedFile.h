@@ -0,0 +1,47 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#ifndef _BASE_MAPPED_FILE_H_
+#define _BASE_MAPPED_FILE_H_
+
+namespace Base {
+
+	// A whole file, mapped into memory, read-only.
+	class MappedFile {
+	public:
+		MappedFile(const char* filename);
+		~MappedFile();
+
+		bool isOpen() const { return mData != NULL; }
+		const char* data() const { return mData; }
+		int size() const { return mSize; }
+
+	private:
+		char* mData;
+		int mSize;
+#if defined(WIN32)
+		void* mFileHandle;
+		void* mMappingHandle;
+#endif
+
+		MappedFile(const MappedFile&);
+		MappedFile& operator=(const MappedFile&);
+	};
+
+} // namespace Base
+
+#endif // _BASE_MAPPED_FILE_H_
@@ -123,3 +123,48 @@ bool MemStream::write(const void* src, int size) {
 	mPos += size;
 	return true;
 }
+
+//******************************************************************************
+//SharedMemStreamC
+//******************************************************************************
+SharedMemStreamC::SharedMemStreamC(const void* src, int _size, RefCounted* owner)
+	: MemStreamC(src, _size), mOwner(owner)
+{
+	mOwner->addRef();
+}
+
+SharedMemStreamC::~SharedMemStreamC() {
+	if(mOwner)
+		mOwner->release();
+}
+
+//******************************************************************************
+//CopyOnWriteMemStream
+//******************************************************************************
+CopyOnWriteMemStream::CopyOnWriteMemStream(const void* src, int _size, RefCounted* owner)
+	: SharedMemStreamC(src, _size, owner), mBuffer(NULL) {}
+
+CopyOnWriteMemStream::~CopyOnWriteMemStream() {
+	delete[] mBuffer;
+}
+
+void* CopyOnWriteMemStream::ptr() {
+	if(!mBuffer) {
+		mBuffer = new char[mSize];
+		memcpy(mBuffer, mSrc, mSize);
+		mSrc = mBuffer;
+		mOwner->release();
+		mOwner = NULL;
+	}
+	return mBuffer;
+}
+
+bool CopyOnWriteMemStream::write(const void* src, int size) {
+	TEST(isOpen());
+	if(mPos + size > mSize) {
+		FAIL;
+	}
+	memcpy((char*)ptr() + mPos, src, size);
+	mPos += size;
+	return true;
+}
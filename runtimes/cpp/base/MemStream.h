@@ -19,6 +19,7 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 #define _BASE_MEM_STREAM_H_
 
 #include "Stream.h"
+#include <helpers/RefCounted.h>
 
 namespace Base {
 
@@ -69,6 +70,28 @@ namespace Base {
 		char* mBuffer;
 	};
 
+	//does not own the memory, but holds a reference to its owner,
+	//which keeps the memory valid.
+	class SharedMemStreamC : public MemStreamC {
+	public:
+		SharedMemStreamC(const void* _src, int _size, RefCounted* owner);
+		virtual ~SharedMemStreamC();
+	protected:
+		RefCounted* mOwner;
+	};
+
+	//writable. Reads from the shared memory until the first write, or the
+	//first call to ptr(), which copy it, and release the owner.
+	class CopyOnWriteMemStream : public SharedMemStreamC {
+	public:
+		CopyOnWriteMemStream(const void* _src, int _size, RefCounted* owner);
+		virtual ~CopyOnWriteMemStream();
+		bool write(const void* src, int size);
+		void* ptr();
+	private:
+		char* mBuffer;
+	};
+
 
 } // namespace Base
 
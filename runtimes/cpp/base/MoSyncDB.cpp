@@ -34,93 +34,274 @@ MA 02110-1301, USA.
 #include "hashmap/hashmap.h"
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string>
+#include <list>
+#include <map>
 
 using namespace Base;
+
+class MoDB;
+
 /**
  * Class that represents a cursor for a query result.
  */
 class MoDBCursor
 {
 private:
+	/**
+	 * The database that the statement came from, or NULL
+	 * once that database has been closed.
+	 */
+	MoDB* mDB;
+
+	/**
+	 * The SQL text of the statement, which is its key in the
+	 * database's statement cache.
+	 */
+	std::string mSQL;
+
 	/**
 	 * Object that holds the query and the query result.
 	 */
 	sqlite3_stmt* mStatement;
 
 	/**
-	 * Just used internally to know if we are
-	 * at the first result.
+	 * True if the statement holds a row that the cursor
+	 * has not moved to yet. ExecSQL steps to the first row
+	 * before it creates the cursor.
+	 */
+	bool mRowPending;
+
+	/**
+	 * Set once the statement has run out of rows, to MA_DB_NO_ROW,
+	 * or failed, to MA_DB_ERROR. Otherwise MA_DB_OK.
 	 */
-	int mCursorPosition;
+	int mEnd;
 
 public:
-	MoDBCursor(sqlite3_stmt* statement) :
+	MoDBCursor(MoDB* db, const char* sql, sqlite3_stmt* statement) :
+		mDB(db),
+		mSQL(sql),
 		mStatement(statement),
-		mCursorPosition(0)
+		mRowPending(true),
+		mEnd(MA_DB_OK)
 	{
 	}
 
-	virtual ~MoDBCursor()
-	{
-		sqlite3_finalize(mStatement);
-	}
+	/**
+	 * Returns the statement to the database's cache, or
+	 * finalizes it if the database has been closed.
+	 */
+	virtual ~MoDBCursor();
 
 	sqlite3_stmt* getStatement()
 	{
 		return mStatement;
 	}
 
-	bool next()
+	MoDB* getDB()
+	{
+		return mDB;
+	}
+
+	/**
+	 * Called when the cursor's database is closed.
+	 */
+	void detach()
+	{
+		mDB = NULL;
+	}
+
+	/**
+	 * Makes the statement hold the row after the cursor's
+	 * current row, without moving the cursor to it.
+	 * Returns MA_DB_OK if there is such a row, MA_DB_NO_ROW
+	 * if there are no more rows, or MA_DB_ERROR if the query
+	 * failed. Once the query has failed, it keeps failing.
+	 */
+	int peek()
 	{
-		if (0 == mCursorPosition)
+		if (mRowPending)
 		{
-			// We have a cursor that has a result.
-			// No need to get next result yet.
-			// Advance cursor position. We are now at
-			// the first result.
-			++mCursorPosition;
-			return true;
+			return MA_DB_OK;
+		}
+		if (MA_DB_OK != mEnd)
+		{
+			return mEnd;
 		}
 
-		// Run the next stop of the query.
+		// Run the next step of the query.
 		int result = sqlite3_step(mStatement);
 
 		// Is there a query result available?
 		if (SQLITE_ROW == result)
 		{
-			++mCursorPosition;
-			return true;
+			mRowPending = true;
+			return MA_DB_OK;
 		}
 
-		// No more results.
-		return false;
+		// No more results, or an error.
+		mEnd = SQLITE_DONE == result ? MA_DB_NO_ROW : MA_DB_ERROR;
+		return mEnd;
+	}
+
+	/**
+	 * Moves the cursor to the next row.
+	 * Returns the same values as peek().
+	 */
+	int next()
+	{
+		int result = peek();
+		if (MA_DB_OK == result)
+		{
+			mRowPending = false;
+		}
+		return result;
 	}
 };
 
+/**
+ * The number of prepared statements that are kept for reuse
+ * by each database.
+ */
+#define DB_STATEMENT_CACHE_SIZE 16
+
+/**
+ * Class that represents an open database, and the prepared
+ * statements that have been run on it.
+ */
+class MoDB
+{
+private:
+	typedef std::pair<std::string, sqlite3_stmt*> CachedStatement;
+	typedef std::list<CachedStatement> StatementList;
+
+	sqlite3* mDB;
+
+	/**
+	 * Statements that are not in use, most recently used first.
+	 */
+	StatementList mStatements;
+
+	/**
+	 * The statements, by SQL text.
+	 */
+	std::map<std::string, StatementList::iterator> mStatementMap;
+
+public:
+	MoDB(sqlite3* db) :
+		mDB(db)
+	{
+	}
+
+	virtual ~MoDB()
+	{
+		for (StatementList::iterator i = mStatements.begin();
+			i != mStatements.end(); ++i)
+		{
+			sqlite3_finalize(i->second);
+		}
+		sqlite3_close(mDB);
+	}
+
+	sqlite3* getDB()
+	{
+		return mDB;
+	}
+
+	/**
+	 * Returns a statement for the SQL text, or NULL on error.
+	 * If there is one in the cache, it is removed from the cache
+	 * and reused, otherwise a new one is prepared.
+	 */
+	sqlite3_stmt* takeStatement(const char* sql)
+	{
+		std::map<std::string, StatementList::iterator>::iterator found =
+			mStatementMap.find(sql);
+		if (found != mStatementMap.end())
+		{
+			sqlite3_stmt* statement = found->second->second;
+			mStatements.erase(found->second);
+			mStatementMap.erase(found);
+			return statement;
+		}
+
+		sqlite3_stmt* statement;
+		int result = sqlite3_prepare_v2(
+			mDB,
+			sql,
+			-1,
+			&statement,
+			NULL);
+		if (SQLITE_OK != result)
+		{
+			//LOGD("sqlite3_prepare_v2 failed\n");
+			return NULL;
+		}
+		return statement;
+	}
+
+	/**
+	 * Resets a statement from takeStatement() and puts it first
+	 * in the cache. The least recently used statement is
+	 * finalized if the cache is full.
+	 */
+	void releaseStatement(const char* sql, sqlite3_stmt* statement)
+	{
+		sqlite3_reset(statement);
+		sqlite3_clear_bindings(statement);
+
+		// The same SQL may have been cached while this statement was in use.
+		if (mStatementMap.find(sql) != mStatementMap.end())
+		{
+			sqlite3_finalize(statement);
+			return;
+		}
+
+		mStatements.push_front(CachedStatement(sql, statement));
+		mStatementMap[sql] = mStatements.begin();
+		if (mStatements.size() > DB_STATEMENT_CACHE_SIZE)
+		{
+			mStatementMap.erase(mStatements.back().first);
+			sqlite3_finalize(mStatements.back().second);
+			mStatements.pop_back();
+		}
+	}
+};
+
+MoDBCursor::~MoDBCursor()
+{
+	if (mDB)
+	{
+		mDB->releaseStatement(mSQL.c_str(), mStatement);
+	}
+	else
+	{
+		sqlite3_finalize(mStatement);
+	}
+}
+
 // Handle counters.
 static int gDatabaseHandle = 0;
 static int gCursorHandle = 0;
 
 // Object tables.
-static HashMapNoDelete<sqlite3> gDatabaseTable;
+static HashMap<MoDB> gDatabaseTable;
 static HashMap<MoDBCursor> gCursorTable;
 
 void MoSyncDBInit(void) {
 }
 void MoSyncDBClose(void) {
 	gCursorTable.close();
-
-	HashMapNoDelete<sqlite3>::TIteratorC itr = gDatabaseTable.begin();
-	while(itr.hasMore()) {
-		sqlite3_close(itr.next().value);
-	}
 	gDatabaseTable.close();
 }
 
-static sqlite3* MoDBGetDatabase(MAHandle databaseHandle)
+static MoDB* MoDBGetDatabase(MAHandle databaseHandle)
 {
 	// Check if handle exists.
-	sqlite3* db = gDatabaseTable.find(databaseHandle);
+	MoDB* db = gDatabaseTable.find(databaseHandle);
 	if (db)
 	{
 		return db;
@@ -137,7 +318,7 @@ static MAHandle MoDBCreateDatabaseHandle(sqlite3* db)
 {
 	// Create new table entry.
 	++gDatabaseHandle;
-	gDatabaseTable.insert(gDatabaseHandle, db);
+	gDatabaseTable.insert(gDatabaseHandle, new MoDB(db));
 	return gDatabaseHandle;
 }
 
@@ -180,16 +361,38 @@ static MoDBCursor* MoDBGetCursor(MAHandle cursorHandle, int index, int* result)
 	return c;
 }
 
-static MAHandle MoDBCreateCursorHandle(sqlite3_stmt* statement)
+static MAHandle MoDBCreateCursorHandle(MoDB* db, const char* sql,
+	sqlite3_stmt* statement)
 {
 	// Create new table entry.
 	++gCursorHandle;
-	gCursorTable.insert(gCursorHandle, new MoDBCursor(statement));
+	gCursorTable.insert(gCursorHandle, new MoDBCursor(db, sql, statement));
 	return gCursorHandle;
 }
 
-extern "C"
-int maDBOpen(const char* path)
+/**
+ * Keeps the cursors of a database that is being closed
+ * from returning their statements to it.
+ */
+static void MoDBDetachCursors(MoDB* db)
+{
+	HashMap<MoDBCursor>::TIteratorC i = gCursorTable.begin();
+	while (i.hasMore())
+	{
+		MoDBCursor* cursor = i.next().value;
+		if (cursor->getDB() == db)
+		{
+			cursor->detach();
+		}
+	}
+}
+
+/**
+ * Opens the database at \a path, which is relative to the
+ * file system root, with the sqlite3_open_v2() \a flags.
+ * Returns NULL on error.
+ */
+static sqlite3* openDatabase(const char* path, int flags)
 {
 	sqlite3* db;
 
@@ -203,10 +406,22 @@ int maDBOpen(const char* path)
 	fn = path;
 #endif
 
-	int result = sqlite3_open(fn, &db);
+	int result = sqlite3_open_v2(fn, &db, flags, NULL);
 	if (result)
 	{
 		sqlite3_close(db);
+		return NULL;
+	}
+	return db;
+}
+
+extern "C"
+int maDBOpen(const char* path)
+{
+	sqlite3* db = openDatabase(path,
+		SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+	if (NULL == db)
+	{
 		return MA_DB_ERROR;
 	}
 	else
@@ -215,64 +430,196 @@ int maDBOpen(const char* path)
 	}
 }
 
+/**
+ * Runs a PRAGMA statement. If \a value is not NULL, it receives
+ * the first column of the first row the statement returns.
+ * Returns false on error.
+ */
+static bool runPragma(sqlite3* db, const char* sql, std::string* value)
+{
+	sqlite3_stmt* statement;
+	if (SQLITE_OK != sqlite3_prepare_v2(db, sql, -1, &statement, NULL))
+	{
+		return false;
+	}
+	int result;
+	while (SQLITE_ROW == (result = sqlite3_step(statement)))
+	{
+		const unsigned char* text = sqlite3_column_text(statement, 0);
+		if (value && text)
+		{
+			*value = (const char*)text;
+			value = NULL;
+		}
+	}
+	sqlite3_finalize(statement);
+	return SQLITE_DONE == result;
+}
+
+/**
+ * Applies the options of maDBOpenEx(). Options that the
+ * SQLite library does not support are left out.
+ * Returns false on error.
+ */
+static bool applyOptions(sqlite3* db, const MADBOpenOptions* options)
+{
+	static const char* const sJournalModes[] = {
+		NULL, "delete", "truncate", "persist", "memory", "wal", "off"
+	};
+	char sql[64];
+
+	if (MA_DB_JOURNAL_DEFAULT != options->journalMode)
+	{
+		// SQLite returns the journal mode it ends up in, in lower case,
+		// which is the old mode if it doesn't know the new one.
+		sprintf(sql, "PRAGMA journal_mode = %s",
+			sJournalModes[options->journalMode]);
+		std::string mode;
+		if (!runPragma(db, sql, &mode))
+		{
+			return false;
+		}
+		if (mode != sJournalModes[options->journalMode])
+		{
+			LOG("maDBOpenEx: journal mode %s is not supported, using %s\n",
+				sJournalModes[options->journalMode], mode.c_str());
+		}
+	}
+
+	if (MA_DB_SYNCHRONOUS_DEFAULT != options->synchronous)
+	{
+		// OFF, NORMAL and FULL are 0, 1 and 2 to SQLite.
+		sprintf(sql, "PRAGMA synchronous = %i",
+			options->synchronous - MA_DB_SYNCHRONOUS_OFF);
+		if (!runPragma(db, sql, NULL))
+		{
+			return false;
+		}
+	}
+
+	if (options->cacheSizeKiB > 0)
+	{
+		// Older versions of SQLite only take the cache size in pages.
+		std::string pageSize;
+		if (!runPragma(db, "PRAGMA page_size", &pageSize))
+		{
+			return false;
+		}
+		int pages = (int)((long long)options->cacheSizeKiB * 1024 /
+			MAX(atoi(pageSize.c_str()), 512));
+		sprintf(sql, "PRAGMA cache_size = %i", MAX(pages, 1));
+		if (!runPragma(db, sql, NULL))
+		{
+			return false;
+		}
+	}
+
+	if (options->mmapSize > 0)
+	{
+		// SQLite ignores pragmas it doesn't know.
+		sprintf(sql, "PRAGMA mmap_size = %i", options->mmapSize);
+		if (!runPragma(db, sql, NULL))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+extern "C"
+int maDBOpenEx(const char* path, int flags, const MADBOpenOptions* options)
+{
+	MYASSERT((flags & ~(MA_DB_OPEN_READ_ONLY | MA_DB_OPEN_SHARED_CACHE)) == 0 &&
+		options->journalMode >= MA_DB_JOURNAL_DEFAULT &&
+		options->journalMode <= MA_DB_JOURNAL_OFF &&
+		options->synchronous >= MA_DB_SYNCHRONOUS_DEFAULT &&
+		options->synchronous <= MA_DB_SYNCHRONOUS_FULL &&
+		options->cacheSizeKiB >= 0 && options->mmapSize >= 0,
+		ERR_DB_OPEN_OPTIONS);
+
+	int openFlags = (flags & MA_DB_OPEN_READ_ONLY) ? SQLITE_OPEN_READONLY :
+		SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+
+	// SQLite 3.6.18 and later take shared cache as an open flag.
+	// Older ones have a switch for the connections opened after it.
+	sqlite3* db;
+	if (flags & MA_DB_OPEN_SHARED_CACHE)
+	{
+#ifdef SQLITE_OPEN_SHAREDCACHE
+		db = openDatabase(path, openFlags | SQLITE_OPEN_SHAREDCACHE);
+#else
+		sqlite3_enable_shared_cache(1);
+		db = openDatabase(path, openFlags);
+		sqlite3_enable_shared_cache(0);
+#endif
+	}
+	else
+	{
+		db = openDatabase(path, openFlags);
+	}
+	if (NULL == db)
+	{
+		return MA_DB_ERROR;
+	}
+
+	// A read-only database can't change its journal mode.
+	MADBOpenOptions o = *options;
+	if (flags & MA_DB_OPEN_READ_ONLY)
+	{
+		o.journalMode = MA_DB_JOURNAL_DEFAULT;
+	}
+	if (!applyOptions(db, &o))
+	{
+		sqlite3_close(db);
+		return MA_DB_ERROR;
+	}
+	return MoDBCreateDatabaseHandle(db);
+}
+
 extern "C"
 int maDBClose(MAHandle databaseHandle)
 {
-	sqlite3* db = MoDBGetDatabase(databaseHandle);
+	MoDB* db = MoDBGetDatabase(databaseHandle);
 	if (NULL == db)
 	{
 		return MA_DB_ERROR;
 	}
-	sqlite3_close(db);
+	// Finalizes the cached statements and closes the database.
+	MoDBDetachCursors(db);
 	gDatabaseTable.erase(databaseHandle);
 	return MA_DB_OK;
 }
 
-static int prepStatement(MAHandle databaseHandle, const char* sql, sqlite3_stmt*& statement)
+static int prepStatement(MAHandle databaseHandle, const char* sql,
+	MoDB*& db, sqlite3_stmt*& statement)
 {
 	// Get database object.
-	sqlite3* db = MoDBGetDatabase(databaseHandle);
+	db = MoDBGetDatabase(databaseHandle);
 	if (NULL == db)
 	{
 		//LOGD("MoDBGetDatabase failed\n");
 		return MA_DB_ERROR;
 	}
 
-	// Prepare the query.
-	int result = sqlite3_prepare_v2(
-		db,
-		sql,
-		-1,
-		&statement,
-		NULL);
-	if (SQLITE_OK != result)
+	// Get a prepared statement for the query.
+	statement = db->takeStatement(sql);
+	if (NULL == statement)
 	{
-		//LOGD("sqlite3_prepare_v2 failed\n");
 		return MA_DB_ERROR;
 	}
 	return MA_DB_OK;
 }
 
-static int runStatement(sqlite3_stmt* statement)
+static int runStatement(MoDB* db, const char* sql, sqlite3_stmt* statement)
 {
 	// Run the query.
 	int result = sqlite3_step(statement);
 
-	// Was there an error?
-	if (SQLITE_BUSY == result ||
-		SQLITE_ERROR == result ||
-		SQLITE_MISUSE == result)
-	{
-		// The result was an error.
-		//LOGD("sqlite3_step failed\n");
-		sqlite3_finalize(statement);
-		return MA_DB_ERROR;
-	}
-
 	// Was the query completed?
 	if (SQLITE_DONE == result)
 	{
-		sqlite3_finalize(statement);
+		// Keep the statement for the next time this SQL is run.
+		db->releaseStatement(sql, statement);
 		return MA_DB_OK;
 	}
 
@@ -281,32 +628,22 @@ static int runStatement(sqlite3_stmt* statement)
 	{
 		// Return the handle to a cursor object
 		// that can be used for further processing
-		// of the result.
-		return MoDBCreateCursorHandle(statement);
+		// of the result. The cursor owns the statement
+		// until it is destroyed, and then returns it
+		// to the cache.
+		return MoDBCreateCursorHandle(db, sql, statement);
 	}
-	DEBIG_PHAT_ERROR;
-}
 
-extern "C"
-int maDBExecSQL(MAHandle databaseHandle, const char* sql)
-{
-	sqlite3_stmt* statement;
-	int result = prepStatement(databaseHandle, sql, statement);
-	if (result < 0)
-		return result;
-	return runStatement(statement);
+	// The result was an error, such as SQLITE_READONLY
+	// for a write to a read-only database.
+	//LOGD("sqlite3_step failed\n");
+	db->releaseStatement(sql, statement);
+	return MA_DB_ERROR;
 }
 
-extern "C"
-MAHandle maDBExecSQLParams(MAHandle databaseHandle, const char* sql,
-	const MADBValue* params, int paramCount)
+static void bindParams(sqlite3_stmt* statement, const MADBValue* params, int paramCount)
 {
-	sqlite3_stmt* statement;
-	int result = prepStatement(databaseHandle, sql, statement);
-	if (result < 0)
-		return result;
-
-	// Bind parameters
+	int result;
 	DEBUG_ASSERT(sizeof(MADBValue) == 12);
 	for(int i=1; i<=paramCount; i++) {
 		const MADBValue& v(params[i-1]);
@@ -361,8 +698,102 @@ MAHandle maDBExecSQLParams(MAHandle databaseHandle, const char* sql,
 		}
 		DEBUG_ASSERT(result == SQLITE_OK);
 	}
+}
+
+extern "C"
+int maDBExecSQL(MAHandle databaseHandle, const char* sql)
+{
+	MoDB* db;
+	sqlite3_stmt* statement;
+	int result = prepStatement(databaseHandle, sql, db, statement);
+	if (result < 0)
+		return result;
+	return runStatement(db, sql, statement);
+}
 
-	return runStatement(statement);
+extern "C"
+MAHandle maDBExecSQLParams(MAHandle databaseHandle, const char* sql,
+	const MADBValue* params, int paramCount)
+{
+	MoDB* db;
+	sqlite3_stmt* statement;
+	int result = prepStatement(databaseHandle, sql, db, statement);
+	if (result < 0)
+		return result;
+
+	// Bind parameters
+	bindParams(statement, params, paramCount);
+
+	return runStatement(db, sql, statement);
+}
+
+/**
+ * Runs a statement that takes no parameters, and ignores its rows.
+ */
+static int execSimple(MoDB* db, const char* sql)
+{
+	sqlite3_stmt* statement = db->takeStatement(sql);
+	if (NULL == statement)
+	{
+		return MA_DB_ERROR;
+	}
+	int result;
+	do {
+		result = sqlite3_step(statement);
+	} while (SQLITE_ROW == result);
+	db->releaseStatement(sql, statement);
+	return SQLITE_DONE == result ? MA_DB_OK : MA_DB_ERROR;
+}
+
+extern "C"
+int maDBExecSQLBatch(MAHandle databaseHandle, const char* sql,
+	const MADBValue* params, int paramCount, int rowCount)
+{
+	MYASSERT(paramCount >= 0 && rowCount >= 0 &&
+		(paramCount == 0 || rowCount <= INT_MAX / paramCount / (int)sizeof(MADBValue)),
+		ERR_DB_BATCH_COUNT);
+	gSyscall->ValidateMemRange(params, paramCount * rowCount * sizeof(MADBValue));
+
+	MoDB* db;
+	sqlite3_stmt* statement;
+	int result = prepStatement(databaseHandle, sql, db, statement);
+	if (result < 0)
+		return result;
+
+	// A savepoint starts a transaction, or nests in one the
+	// application has already started.
+	if (execSimple(db, "SAVEPOINT maDBExecSQLBatch") < 0)
+	{
+		db->releaseStatement(sql, statement);
+		return MA_DB_ERROR;
+	}
+
+	for (int row = 0; row < rowCount && MA_DB_OK == result; row++)
+	{
+		bindParams(statement, params + row * paramCount, paramCount);
+		int stepResult;
+		do {
+			stepResult = sqlite3_step(statement);
+		} while (SQLITE_ROW == stepResult);
+		sqlite3_reset(statement);
+		if (SQLITE_DONE != stepResult)
+		{
+			//LOGD("sqlite3_step failed\n");
+			result = MA_DB_ERROR;
+		}
+	}
+	db->releaseStatement(sql, statement);
+
+	if (MA_DB_OK == result)
+	{
+		result = execSimple(db, "RELEASE maDBExecSQLBatch");
+	}
+	if (MA_DB_OK != result)
+	{
+		execSimple(db, "ROLLBACK TO maDBExecSQLBatch");
+		execSimple(db, "RELEASE maDBExecSQLBatch");
+	}
+	return result;
 }
 
 extern "C"
@@ -388,14 +819,7 @@ int maDBCursorNext(MAHandle cursorHandle)
 	}
 
 	// Advance the cursor.
-	if (cursor->next())
-	{
-		return MA_DB_OK;
-	}
-	else
-	{
-		return MA_DB_NO_ROW;
-	}
+	return cursor->next();
 }
 
 extern "C"
@@ -534,3 +958,162 @@ int maDBCursorGetColumnDouble(
 	*value = v;
 	return MA_DB_OK;
 }
+
+/**
+ * Appends \a size bytes from \a src to the row at \a out,
+ * at \a *pos, followed by zero bytes up to the next multiple of 4.
+ * Returns false if that would go past \a space.
+ */
+static bool putBytes(byte* out, int* pos, int space, const void* src, int size)
+{
+	if (size > space - *pos)
+	{
+		return false;
+	}
+	int padded = (size + 3) & ~3;
+	if (padded > space - *pos)
+	{
+		return false;
+	}
+	if (size > 0)
+	{
+		memcpy(out + *pos, src, size);
+	}
+	memset(out + *pos + size, 0, padded - size);
+	*pos += padded;
+	return true;
+}
+
+static bool putInt(byte* out, int* pos, int space, int value)
+{
+	return putBytes(out, pos, space, &value, sizeof(int));
+}
+
+/**
+ * Writes the current row of \a statement to \a out, in the format
+ * described by maDBCursorFetchRows(). The buffer may not be aligned,
+ * so all values are copied with memcpy.
+ * Returns the size of the row, or -1 if it does not fit in \a space bytes.
+ */
+static int writeRow(sqlite3_stmt* statement, byte* out, int space)
+{
+	int pos = 0;
+	// The size is filled in at the end.
+	if (!putInt(out, &pos, space, 0))
+	{
+		return -1;
+	}
+
+	int columnCount = sqlite3_column_count(statement);
+	for (int i = 0; i < columnCount; i++)
+	{
+		bool fits = true;
+		switch (sqlite3_column_type(statement, i))
+		{
+			case SQLITE_INTEGER:
+			{
+				sqlite3_int64 v = sqlite3_column_int64(statement, i);
+				if (v >= INT_MIN && v <= INT_MAX)
+				{
+					fits = putInt(out, &pos, space, MA_DB_TYPE_INT) &&
+						putInt(out, &pos, space, (int)v);
+				}
+				else
+				{
+					longlong ll = v;
+					fits = putInt(out, &pos, space, MA_DB_TYPE_INT64) &&
+						putBytes(out, &pos, space, &ll, sizeof(ll));
+				}
+				break;
+			}
+			case SQLITE_FLOAT:
+			{
+				double d = sqlite3_column_double(statement, i);
+				fits = putInt(out, &pos, space, MA_DB_TYPE_DOUBLE) &&
+					putBytes(out, &pos, space, &d, sizeof(d));
+				break;
+			}
+			case SQLITE_TEXT:
+			{
+				// The text must be fetched before its size.
+				// See http://sqlite.org/c3ref/column_blob.html
+				const unsigned char* text = sqlite3_column_text(statement, i);
+				int length = sqlite3_column_bytes(statement, i);
+				// The zero byte is written with the padding.
+				fits = putInt(out, &pos, space, MA_DB_TYPE_TEXT) &&
+					putInt(out, &pos, space, length) &&
+					putBytes(out, &pos, space, text, length + 1);
+				break;
+			}
+			case SQLITE_BLOB:
+			{
+				const void* blob = sqlite3_column_blob(statement, i);
+				int length = sqlite3_column_bytes(statement, i);
+				fits = putInt(out, &pos, space, MA_DB_TYPE_BLOB) &&
+					putInt(out, &pos, space, length) &&
+					putBytes(out, &pos, space, blob, length);
+				break;
+			}
+			default:
+				fits = putInt(out, &pos, space, MA_DB_TYPE_NULL);
+		}
+		if (!fits)
+		{
+			return -1;
+		}
+	}
+
+	memcpy(out, &pos, sizeof(int));
+	return pos;
+}
+
+extern "C"
+int maDBCursorFetchRows(
+	MAHandle cursorHandle,
+	void* buffer,
+	int bufferSize,
+	int maxRows)
+{
+	MYASSERT(bufferSize >= 0 && maxRows >= 0, ERR_DB_FETCH_ARGUMENTS);
+	gSyscall->ValidateMemRange(buffer, bufferSize);
+
+	// Get the cursor object.
+	MoDBCursor* cursor = MoDBGetCursor(cursorHandle);
+	if (NULL == cursor)
+	{
+		return MA_DB_ERROR;
+	}
+
+	byte* out = (byte*)buffer;
+	int used = 0;
+	int rows = 0;
+	while (rows < maxRows)
+	{
+		int result = cursor->peek();
+		if (MA_DB_NO_ROW == result)
+		{
+			break;
+		}
+		if (MA_DB_ERROR == result)
+		{
+			// The rows that were copied are returned first. The
+			// error stays, so the next call returns it.
+			return rows > 0 ? rows : MA_DB_ERROR;
+		}
+
+		int size = writeRow(cursor->getStatement(), out + used, bufferSize - used);
+		if (size < 0)
+		{
+			// The row stays pending, for the next call.
+			if (0 == rows)
+			{
+				return MA_DB_FETCH_BUFFER_TOO_SMALL;
+			}
+			break;
+		}
+		cursor->next();
+		used += size;
+		rows++;
+	}
+	return rows;
+}
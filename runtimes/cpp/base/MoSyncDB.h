@@ -33,10 +33,14 @@ extern "C" {
 #endif
 
 MAHandle maDBOpen(const char* path);
+MAHandle maDBOpenEx(const char* path, int flags,
+	const MADBOpenOptions* options);
 int maDBClose(MAHandle databaseHandle);
 MAHandle maDBExecSQL(MAHandle databaseHandle, const char* sql);
 MAHandle maDBExecSQLParams(MAHandle databaseHandle, const char* sql,
 	const MADBValue* params, int paramCount);
+int maDBExecSQLBatch(MAHandle databaseHandle, const char* sql,
+	const MADBValue* params, int paramCount, int rowCount);
 int maDBCursorDestroy(MAHandle cursorHandle);
 int maDBCursorNext(MAHandle cursorHandle);
 int maDBCursorGetColumnData(
@@ -56,6 +60,11 @@ int maDBCursorGetColumnDouble(
 	MAHandle cursorHandle,
 	int columnIndex,
 	double* value);
+int maDBCursorFetchRows(
+	MAHandle cursorHandle,
+	void* buffer,
+	int bufferSize,
+	int maxRows);
 
 void MoSyncDBInit(void);
 void MoSyncDBClose(void);
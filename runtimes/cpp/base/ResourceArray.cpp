@@ -56,6 +56,12 @@ namespace Base {
 		mResSize(0),
 		mRes(NULL),
 		mResTypes(NULL),
+		mResUnloaded(NULL),
+		mLoader(NULL),
+		mLabelSlots(NULL),
+		mLabelCapacity(0),
+		mLabelCount(0),
+		mLabelUsed(0),
 		mDynResSize(1),
 		mDynResCapacity(1),
 		mDynRes(NULL),
@@ -77,16 +83,21 @@ namespace Base {
 		mResSize = MAX(numResources + 1, oldResSize);
 		void** oldRes = mRes;
 		byte* oldTypes = mResTypes;
+		byte* oldUnloaded = mResUnloaded;
 		mRes = new void*[mResSize];
 		MYASSERT(mRes != NULL, ERR_OOM);
 		mResTypes = new byte[mResSize];
 		MYASSERT(mResTypes != NULL, ERR_OOM);
+		mResUnloaded = new byte[mResSize];
+		MYASSERT(mResUnloaded != NULL, ERR_OOM);
 
 		if(oldRes) {
 			memcpy(mRes, oldRes, oldResSize*sizeof(void*));
 			memcpy(mResTypes, oldTypes, oldResSize*sizeof(byte));
+			memcpy(mResUnloaded, oldUnloaded, oldResSize*sizeof(byte));
 			delete[] oldRes;
 			delete[] oldTypes;
+			delete[] oldUnloaded;
 		}
 
 		if(mResSize > oldResSize) {
@@ -96,6 +107,7 @@ namespace Base {
 			memset(&mRes[oldResSize], 0, (mResSize - oldResSize) * sizeof(void*));
 			// Set to placeholder type.
 			memset(mResTypes + oldResSize, RT_PLACEHOLDER, (mResSize - oldResSize));
+			memset(mResUnloaded + oldResSize, 0, (mResSize - oldResSize));
 		}
 	}
 
@@ -110,6 +122,8 @@ namespace Base {
 		}
 		delete[] mRes;
 		delete[] mResTypes;
+		delete[] mResUnloaded;
+		delete[] mLabelSlots;
 
 		// Destroy dynamic resources.
 		for(unsigned i=1; i<mDynResSize; ++i) {
@@ -131,6 +145,121 @@ namespace Base {
 		_destroy(index);
 	}
 
+	void ResourceArray::add_unloaded(unsigned index, byte type) {
+		TESTINDEX(index, mResSize);
+		if(mRes[index] != NULL || mResTypes[index] != RT_PLACEHOLDER) {
+			BIG_PHAT_ERROR(ERR_RES_OVERWRITE);
+		}
+		mResUnloaded[index] = type;
+	}
+
+	void ResourceArray::setLoader(ResourceLoader* loader) {
+		mLoader = loader;
+	}
+
+	void ResourceArray::clear_unloaded() {
+		if(mResUnloaded)
+			memset(mResUnloaded, 0, mResSize);
+	}
+
+	void ResourceArray::_loadIfUnloaded(unsigned index) {
+		byte type = mResUnloaded[index];
+		if(type == 0)
+			return;
+		// cleared first, so that the loader can add the resource.
+		mResUnloaded[index] = 0;
+		DEBUG_ASSERT(mLoader != NULL);
+		LOGD("Loading resource %i, type %i\n", index, type);
+		mLoader->loadUnloadedResource(index);
+		DEBUG_ASSERT(mResTypes[index] == type);
+	}
+
+	// Marks a slot whose label was removed. Lookups probe past it.
+#define LABEL_SLOT_REMOVED (~0u)
+
+	// FNV-1a.
+	static unsigned hashLabel(const char* name) {
+		unsigned hash = 2166136261u;
+		while(*name) {
+			hash ^= (byte)*name++;
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	int ResourceArray::findLabel(const char* name) {
+		if(mLabelCount == 0)
+			return -1;
+		unsigned mask = mLabelCapacity - 1;
+		unsigned found = LABEL_SLOT_REMOVED;
+		for(unsigned i = hashLabel(name) & mask; mLabelSlots[i] != 0; i = (i + 1) & mask) {
+			unsigned index = mLabelSlots[i];
+			if(index < found &&
+				::strcmp(((Label*)mRes[index])->getName(), name) == 0)
+			{
+				found = index;
+			}
+		}
+		return found == LABEL_SLOT_REMOVED ? -1 : (int)found;
+	}
+
+	void ResourceArray::_indexLabel(unsigned index) {
+		// keep the table at most half full, counting removed slots.
+		if((mLabelUsed + 1) * 2 > mLabelCapacity) {
+			unsigned capacity = MAX(mLabelCapacity, 16u);
+			while((mLabelCount + 1) * 2 > capacity)
+				capacity *= 2;
+			_rehashLabels(capacity);
+		}
+		unsigned mask = mLabelCapacity - 1;
+		unsigned i = hashLabel(((Label*)mRes[index])->getName()) & mask;
+		while(mLabelSlots[i] != 0 && mLabelSlots[i] != LABEL_SLOT_REMOVED)
+			i = (i + 1) & mask;
+		if(mLabelSlots[i] == 0)
+			mLabelUsed++;
+		mLabelSlots[i] = index;
+		mLabelCount++;
+	}
+
+	void ResourceArray::_unindexLabel(unsigned index) {
+		if(mLabelCount == 0)
+			return;
+		unsigned mask = mLabelCapacity - 1;
+		for(unsigned i = hashLabel(((Label*)mRes[index])->getName()) & mask;
+			mLabelSlots[i] != 0; i = (i + 1) & mask)
+		{
+			if(mLabelSlots[i] == index) {
+				mLabelSlots[i] = LABEL_SLOT_REMOVED;
+				mLabelCount--;
+				return;
+			}
+		}
+	}
+
+	void ResourceArray::_rehashLabels(unsigned capacity) {
+		unsigned* oldSlots = mLabelSlots;
+		unsigned oldCapacity = mLabelCapacity;
+		mLabelSlots = new unsigned[capacity];
+		MYASSERT(mLabelSlots != NULL, ERR_OOM);
+		memset(mLabelSlots, 0, capacity * sizeof(unsigned));
+		mLabelCapacity = capacity;
+		mLabelCount = 0;
+		mLabelUsed = 0;
+		unsigned mask = capacity - 1;
+		for(unsigned j = 0; j < oldCapacity; j++) {
+			unsigned index = oldSlots[j];
+			if(index == 0 || index == LABEL_SLOT_REMOVED)
+				continue;
+			unsigned i = hashLabel(((Label*)mRes[index])->getName()) & mask;
+			while(mLabelSlots[i] != 0)
+				i = (i + 1) & mask;
+			mLabelSlots[i] = index;
+			mLabelCount++;
+			mLabelUsed++;
+		}
+		delete[] oldSlots;
+	}
+
 	byte ResourceArray::get_type(unsigned index) {
 		if(index&DYNAMIC_PLACEHOLDER_BIT) {
 			index&=~DYNAMIC_PLACEHOLDER_BIT;
@@ -138,6 +267,9 @@ namespace Base {
 			return mDynResTypes[index];
 		} else {
 			TESTINDEX(index, mResSize);
+			// the type it will have once loaded.
+			if(mResUnloaded[index] != 0)
+				return mResUnloaded[index];
 			return mResTypes[index];
 		}
 	}
@@ -162,6 +294,11 @@ namespace Base {
 		{
 			return true;
 		}
+		// deferred static resources count as loaded.
+		if (res == mRes && mResUnloaded[index] != 0)
+		{
+			return true;
+		}
 		return false;
 	}
 
@@ -382,6 +519,8 @@ namespace Base {
 			TESTINDEX(index, mDynResSize);
 		} else {
 			TESTINDEX(index, mResSize);
+			// an explicit add replaces the unloaded resource.
+			mResUnloaded[index] = 0;
 		}
 
 		// obj is the resource data. If the resource is NULL
@@ -412,6 +551,9 @@ namespace Base {
 #endif	//RESOURCE_MEMORY_LIMIT
 		res[index] = obj;
 		types[index] = type;
+		if(type == RT_LABEL && res == mRes) {
+			_indexLabel(index);
+		}
 		return RES_OK;
 	}
 
@@ -431,6 +573,7 @@ namespace Base {
 			TESTINDEX(index, mDynResSize);
 		} else {
 			TESTINDEX(index, mResSize);
+			_loadIfUnloaded(index);
 		}
 
 		if(types[index] != R) {
@@ -449,6 +592,7 @@ namespace Base {
 			TESTINDEX(index, mDynResSize);
 		} else {
 			TESTINDEX(index, mResSize);
+			_loadIfUnloaded(index);
 		}
 
 		if(types[index] != R) {
@@ -465,6 +609,10 @@ namespace Base {
 		}
 #endif	//RESOURCE_MEMORY_LIMIT
 
+		if(R == RT_LABEL && res == mRes) {
+			_unindexLabel(index);
+		}
+
 		void* temp = res[index];
 		res[index] = NULL;
 		types[index] = RT_PLACEHOLDER;
@@ -489,6 +637,7 @@ LOGD("%s: %s %s %i\n", #R, #D, #T, index); break;
 			TESTINDEX(index, mDynResSize);
 		} else {
 			TESTINDEX(index, mResSize);
+			mResUnloaded[index] = 0;
 		}
 
 		MYASSERT(types[index] != RT_FLUX, ERR_RES_DESTROY_FLUX);
@@ -503,6 +652,10 @@ LOGD("%s: %s %s %i\n", #R, #D, #T, index); break;
 		}
 #endif	//RESOURCE_MEMORY_LIMIT
 
+		if(types[index] == RT_LABEL && res == mRes) {
+			_unindexLabel(index);
+		}
+
 		__destroy(res[index], types[index], index);
 
 		res[index] = NULL;
@@ -81,6 +81,19 @@ namespace Base {
 #define DECLARE_RESOURCE_TYPES(R, T, D) typedef T R##_Type;
     TYPES(DECLARE_RESOURCE_TYPES);
 
+	/**
+	 * Loads static resources that were added with
+	 * ResourceArray::add_unloaded(), when they are first used.
+	 */
+	class ResourceLoader {
+	public:
+		/**
+		 * Must add the resource at \a index, with the type given to add_unloaded().
+		 */
+		virtual void loadUnloadedResource(unsigned index) = 0;
+		virtual ~ResourceLoader() {}
+	};
+
 #define ROOM(func) if((func) == RES_OUT_OF_MEMORY) { BIG_PHAT_ERROR(ERR_RES_OOM); }
 
 	/**
@@ -129,6 +142,27 @@ namespace Base {
 
 		void destroy(unsigned index);
 
+		/**
+		 * Marks a static resource as present but not yet loaded.
+		 * The first get_*() or extract_*() on it asks the loader to load it.
+		 * Until then, it takes no memory besides this entry.
+		 * @param index Resource index.
+		 * @param type The type the resource will have once loaded.
+		 */
+		void add_unloaded(unsigned index, byte type);
+
+		/**
+		 * Sets the loader used for resources added with add_unloaded().
+		 * Does not take ownership.
+		 */
+		void setLoader(ResourceLoader* loader);
+
+		/**
+		 * Turns the resources added with add_unloaded(), that are not
+		 * loaded yet, back into placeholders.
+		 */
+		void clear_unloaded();
+
 		byte get_type(unsigned index);
 
 		/**
@@ -139,6 +173,14 @@ namespace Base {
 		 */
 		bool is_loaded(unsigned index);
 
+		/**
+		 * Finds a static label resource by name, using a hash index.
+		 * If several labels have the same name, the lowest index is returned.
+		 * @param name The name of the label.
+		 * @return The index of the label, or -1 if there is no such label.
+		 */
+		int findLabel(const char* name);
+
 		/**
 		 * @return The size of the static resource array.
 		 */
@@ -199,6 +241,23 @@ namespace Base {
 
 		void _destroy(unsigned index);
 
+		/**
+		 * Loads a static resource if it was added with add_unloaded().
+		 */
+		void _loadIfUnloaded(unsigned index);
+
+		/**
+		 * Adds or removes a static label in the label index.
+		 * The label must be in the resource array.
+		 */
+		void _indexLabel(unsigned index);
+		void _unindexLabel(unsigned index);
+
+		/**
+		 * Rebuilds the label index with the given number of slots.
+		 */
+		void _rehashLabels(unsigned capacity);
+
 #ifdef RESOURCE_MEMORY_LIMIT
 		// Max size of all resource data.
 		const uint mResmemMax;
@@ -218,6 +277,22 @@ namespace Base {
 		void** mRes;
 		// Resource type info array.
 		byte* mResTypes;
+		// Types of resources that are not loaded yet, or zero.
+		byte* mResUnloaded;
+		// Loads the resources in mResUnloaded.
+		ResourceLoader* mLoader;
+
+		// ****** Label index ****** //
+
+		// Open-addressed hash table of static label indices,
+		// keyed by label name. Empty slots are zero.
+		unsigned* mLabelSlots;
+		// Number of slots. Zero or a power of two.
+		unsigned mLabelCapacity;
+		// Number of labels in the table.
+		unsigned mLabelCount;
+		// Number of slots that are not empty, including removed labels.
+		unsigned mLabelUsed;
 
 		// ****** Dynamic resources ****** //
 
@@ -130,7 +130,13 @@ namespace Base {
 		} else {
 			void* pdst = this->ptr();
 			if(pdst) {	//memory destination stream
-				TEST(src.read(pdst, size));
+				int pos;
+				TEST(this->tell(pos));
+				int dstSize;
+				TEST(this->length(dstSize));
+				TEST(pos + size <= dstSize);
+				TEST(src.read((char*)pdst + pos, size));
+				TEST(this->seek(Seek::Current, size));
 			} else {
 				Smartie<char> temp(new char[size]);
 				TEST(temp);
@@ -0,0 +1,260 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#include "config_platform.h"
+
+#include <string.h>
+#include <helpers/helpers.h>
+#include <helpers/atomic.h>
+
+#include "StreamingAudioSource.h"
+
+//frames returned by each fillBuffer().
+#define CHUNK_FRAMES 1024
+//frames of silence returned when the ring is empty.
+#define UNDERRUN_FRAMES 256
+
+StreamingAudioSource::StreamingAudioSource(AudioSource* decoder, int bufferMs)
+: mDecoder(decoder), mBufferMs(bufferMs), mFrameBytes(0),
+mRing(NULL), mCapacity(0), mWrite(0), mRead(0), mPeakFrames(0), mOut(NULL),
+mSeekRequest(0), mSeekDone(0), mSeekSeen(0), mSeekMs(0), mFlushFrom(0),
+mEnd(false), mPositionMs(0), mPlayed(0), mUnderruns(0),
+mStarted(false), mQuit(false), mWaiting(0), mReadyPosted(false)
+{
+}
+
+StreamingAudioSource::~StreamingAudioSource() {
+	close();
+	delete mDecoder;
+	delete[] mRing;
+	delete[] mOut;
+}
+
+int StreamingAudioSource::init() {
+	int res = mDecoder->init();
+	if(res != 0)
+		return res;
+
+	//not every decoder sets bytesPerSample.
+	info = mDecoder->getInfo();
+	info.bytesPerSample = info.fmt >= FMT_S16 ? 2 : 1;
+	info.bufferSize = CHUNK_FRAMES * info.bytesPerSample * info.numChannels;
+	mFrameBytes = info.bytesPerSample * info.numChannels;
+
+	//a power of two, so that the frame counters can wrap.
+	unsigned long frames = (unsigned long)((long long)info.sampleRate * mBufferMs / 1000);
+	mCapacity = 4 * CHUNK_FRAMES;
+	while(mCapacity < frames)
+		mCapacity <<= 1;
+	mRing = new unsigned char[mCapacity * mFrameBytes];
+	mOut = new unsigned char[info.bufferSize];
+
+	mStarted = true;
+	mThread.start(homeRun, this);
+	mReady.wait();
+	return 0;
+}
+
+void StreamingAudioSource::close() {
+	if(!mStarted)
+		return;
+	mQuit = true;
+	mWake.post();
+	mThread.join();
+	mStarted = false;
+	mDecoder->close();
+	LOG("StreamingAudioSource: %i of %i bytes buffered at peak, %i underruns.\n",
+		getPeakBufferedBytes(), getAllocatedBytes(), mUnderruns);
+}
+
+int StreamingAudioSource::getAllocatedBytes() const {
+	return (int)mCapacity * mFrameBytes + info.bufferSize;
+}
+
+//*****************************************************************************
+// Playback side
+//*****************************************************************************
+
+void StreamingAudioSource::wake() {
+	if(atomicCompareAndSwap(&mWaiting, 1, 0))
+		mWake.post();
+}
+
+void StreamingAudioSource::fillSilence(int frames) {
+	int samples = frames * info.numChannels;
+	switch(info.fmt) {
+	case FMT_U8:
+		memset(mOut, 0x80, samples);
+		break;
+	case FMT_U16:
+		for(int i=0; i<samples; i++) {
+			((unsigned short*)mOut)[i] = 0x8000;
+		}
+		break;
+	default:
+		memset(mOut, 0, samples * info.bytesPerSample);
+	}
+}
+
+int StreamingAudioSource::fillBuffer() {
+	//the buffered frames are from the old position, and the new ones
+	//are not decoded yet.
+	if(mSeekRequest != mSeekDone) {
+		fillSilence(UNDERRUN_FRAMES);
+		return UNDERRUN_FRAMES;
+	}
+	if(mSeekSeen != mSeekDone) {
+		mSeekSeen = mSeekDone;
+		atomicMemoryBarrier();
+		unsigned long from = mFlushFrom;
+		//a later seek may have flushed less than one we've already skipped.
+		if((long)(from - mRead) > 0)
+			mRead = from;
+		mPositionMs = mSeekMs;
+		mPlayed = 0;
+		wake();
+	}
+
+	bool end = mEnd;
+	atomicMemoryBarrier();
+	unsigned long available = mWrite - mRead;
+	if(available == 0) {
+		if(end)
+			return 0;
+		mUnderruns++;
+		fillSilence(UNDERRUN_FRAMES);
+		return UNDERRUN_FRAMES;
+	}
+
+	int frames = (int)MIN(available, (unsigned long)CHUNK_FRAMES);
+	unsigned long start = mRead & (mCapacity - 1);
+	unsigned long first = MIN((unsigned long)frames, mCapacity - start);
+	memcpy(mOut, mRing + start * mFrameBytes, first * mFrameBytes);
+	memcpy(mOut + first * mFrameBytes, mRing, (frames - first) * mFrameBytes);
+	//the copy must be done before the decoder thread may overwrite it.
+	atomicMemoryBarrier();
+	mRead += frames;
+	mPlayed += frames;
+
+	if(mCapacity - (mWrite - mRead) >= mCapacity / 4)
+		wake();
+	return frames;
+}
+
+const void* StreamingAudioSource::getBuffer() const {
+	return mOut;
+}
+
+void StreamingAudioSource::setPosition(int ms) {
+	mSeekMs = ms;
+	atomicIncrement(&mSeekRequest);
+	wake();
+}
+
+int StreamingAudioSource::getPosition() const {
+	return mPositionMs + (int)((long long)mPlayed * 1000 / info.sampleRate);
+}
+
+int StreamingAudioSource::getLength() const {
+	return mDecoder->getLength();
+}
+
+void StreamingAudioSource::setNumLoops(int i) {
+	mDecoder->setNumLoops(i);
+}
+
+int StreamingAudioSource::getNumLoops() {
+	return mDecoder->getNumLoops();
+}
+
+//*****************************************************************************
+// Decoder thread
+//*****************************************************************************
+
+int StreamingAudioSource::homeRun(void* data) {
+	((StreamingAudioSource*)data)->run();
+	return 0;
+}
+
+void StreamingAudioSource::run() {
+	//decoded frames that did not fit in the ring.
+	const unsigned char* pending = NULL;
+	int pendingFrames = 0;
+	bool decoderEnded = false;
+
+	while(!mQuit) {
+		long request = mSeekRequest;
+		if(request != mSeekDone) {
+			mDecoder->setPosition(mSeekMs);
+			pendingFrames = 0;
+			decoderEnded = false;
+			mEnd = false;
+			mFlushFrom = mWrite;
+			atomicMemoryBarrier();
+			mSeekDone = request;
+		}
+
+		if(pendingFrames == 0 && !decoderEnded) {
+			//looping is done by the decoder.
+			int frames = mDecoder->fillBuffer();
+			if(frames > 0) {
+				pending = (const unsigned char*)mDecoder->getBuffer();
+				pendingFrames = frames;
+			} else {
+				decoderEnded = true;
+				atomicMemoryBarrier();
+				mEnd = true;
+			}
+		}
+
+		unsigned long used = mWrite - mRead;
+		if(pendingFrames > 0 && used < mCapacity) {
+			int frames = (int)MIN(mCapacity - used, (unsigned long)pendingFrames);
+			unsigned long start = mWrite & (mCapacity - 1);
+			unsigned long first = MIN((unsigned long)frames, mCapacity - start);
+			memcpy(mRing + start * mFrameBytes, pending, first * mFrameBytes);
+			memcpy(mRing, pending + first * mFrameBytes, (frames - first) * mFrameBytes);
+			//the frames must be in the ring before the reader can see them.
+			atomicMemoryBarrier();
+			mWrite += frames;
+			pending += frames * mFrameBytes;
+			pendingFrames -= frames;
+
+			used += frames;
+			if((int)used > mPeakFrames)
+				mPeakFrames = (int)used;
+			if(!mReadyPosted && used >= mCapacity / 2) {
+				mReadyPosted = true;
+				mReady.post();
+			}
+			continue;
+		}
+		if(decoderEnded && !mReadyPosted) {
+			mReadyPosted = true;
+			mReady.post();
+		}
+
+		//sleep until the ring has room, or there is a seek to do.
+		mWaiting = 1;
+		atomicMemoryBarrier();
+		bool work = mQuit || mSeekRequest != mSeekDone ||
+			(pendingFrames > 0 && mCapacity - (mWrite - mRead) >= mCapacity / 4);
+		if(work && atomicCompareAndSwap(&mWaiting, 1, 0))
+			continue;
+		mWake.wait();
+	}
+}
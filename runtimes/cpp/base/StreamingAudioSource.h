@@ -0,0 +1,105 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#ifndef _STREAMING_AUDIO_SOURCE_H_
+#define _STREAMING_AUDIO_SOURCE_H_
+
+#include "AudioSource.h"
+#include "ThreadPool.h"
+
+// Default amount of decoded audio to keep ahead of playback.
+#define STREAMING_AUDIO_BUFFER_MS 500
+
+// Decodes another source on a thread of its own, into a ring buffer of
+// bounded size. fillBuffer() only copies frames out of the ring, so it can
+// be called from an audio callback without waiting for the decoder or for
+// file I/O. If the ring is empty, it returns silence and counts an underrun.
+class StreamingAudioSource : public AudioSource {
+public:
+	// Takes ownership of \a decoder, which must not have been initialised.
+	StreamingAudioSource(AudioSource* decoder, int bufferMs = STREAMING_AUDIO_BUFFER_MS);
+	~StreamingAudioSource();
+
+	// Initialises the decoder, then waits until the ring is half full.
+	int init();
+	void close();
+
+	int fillBuffer();
+	const void* getBuffer() const;
+
+	void setPosition(int ms);
+	int getPosition() const;
+	int getLength() const;
+
+	void setNumLoops(int i);
+	int getNumLoops();
+
+	// Number of fillBuffer() calls that found the ring empty.
+	int getUnderruns() const { return mUnderruns; }
+	// The most bytes of decoded audio that have been buffered at once.
+	int getPeakBufferedBytes() const { return mPeakFrames * mFrameBytes; }
+	// Bytes allocated for the ring and the output buffer.
+	int getAllocatedBytes() const;
+
+private:
+	AudioSource* mDecoder;
+	int mBufferMs;
+	int mFrameBytes;
+
+	//the ring. mWrite and mRead count frames and only ever grow; they are
+	//masked to index the ring. Only the decoder thread writes mWrite, and
+	//only the caller of fillBuffer() writes mRead.
+	unsigned char* mRing;
+	unsigned long mCapacity;
+	volatile unsigned long mWrite, mRead;
+	int mPeakFrames;
+
+	//the output of fillBuffer().
+	unsigned char* mOut;
+
+	//seeks. setPosition() increments mSeekRequest. The decoder thread seeks,
+	//sets mFlushFrom to where the new frames will start, then sets mSeekDone.
+	volatile long mSeekRequest, mSeekDone;
+	long mSeekSeen;
+	volatile int mSeekMs;
+	volatile unsigned long mFlushFrom;
+
+	//set by the decoder thread once the decoder has ended and its frames are in the ring.
+	volatile bool mEnd;
+
+	//the position of the last seek, and the frames played since.
+	int mPositionMs;
+	unsigned long mPlayed;
+	int mUnderruns;
+
+	MoSyncThread mThread;
+	bool mStarted;
+	volatile bool mQuit;
+	//the decoder thread sleeps on mWake, after setting mWaiting.
+	MoSyncSemaphore mWake;
+	volatile long mWaiting;
+	//posted once the ring is half full, or the decoder has ended.
+	MoSyncSemaphore mReady;
+	bool mReadyPosted;
+
+	void wake();
+	void fillSilence(int frames);
+	void run();
+	static int homeRun(void* data);
+};
+
+#endif	//_STREAMING_AUDIO_SOURCE_H_
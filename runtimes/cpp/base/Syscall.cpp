@@ -25,6 +25,12 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 #include "Syscall.h"
 #include "FileStream.h"
 #include "MemStream.h"
+#ifdef LAZY_RESOURCES
+#include "MappedFile.h"
+#endif
+#ifdef COMPRESSED_RESOURCES
+#include "Lz4Stream.h"
+#endif
 #include <helpers/smartie.h>
 #include <filelist/filelist.h>
 
@@ -137,10 +143,30 @@ namespace Base {
 	Syscall::~Syscall() {
 		LOGD("~Syscall\n");
 		gStores.close();
+#ifdef LOG_STORES
+		gLogStores.close();
+#endif
 		gFileHandles.close();
 		platformDestruct();
 	}
 
+#ifdef COMPRESSED_RESOURCES
+	// Decompresses an LZ4_BINARY resource. Takes ownership of \a packed.
+	static MemStream* unpackBinary(Stream* packed) {
+		MYASSERT(packed != NULL, ERR_RES_FILE_INCONSISTENT);
+		Lz4Stream unpacker(packed);
+		MYASSERT(unpacker.isOpen(), ERR_RES_FILE_INCONSISTENT);
+		int size;
+		TEST(unpacker.length(size));
+		MemStream* ms = new MemStream(size);
+		if(!unpacker.readFully(*ms)) {
+			delete ms;
+			BIG_PHAT_ERROR(ERR_RES_FILE_INCONSISTENT);
+		}
+		return ms;
+	}
+#endif
+
 	/*
 	* Loads all resources from the given buffer.
 	*/
@@ -199,6 +225,12 @@ namespace Base {
 #endif
 				}
 				break;
+#ifdef COMPRESSED_RESOURCES
+			case RT_LZ4_BINARY:
+				ROOM(resources.dadd_RT_BINARY(rI, unpackBinary(file.createLimitedCopy(size))));
+				TEST(file.seek(Seek::Current, size));
+				break;
+#endif
 			case RT_UBIN:
 				{
 					int pos;
@@ -269,6 +301,15 @@ namespace Base {
 #endif
 				}
 				break;
+#ifdef IMAGE_ATLASES
+			case RT_ATLAS:
+				{
+					MemStream b(size);
+					TEST(file.readFully(b));
+					ROOM(resources.dadd_RT_IMAGE(rI, loadAtlas(b)));
+				}
+				break;
+#endif
 			case RT_LABEL:
 				{
 					MemStream b(size);
@@ -315,6 +356,70 @@ namespace Base {
 	int *resourceType;
 #endif
 
+#ifdef LAZY_RESOURCES
+	// The resource file, mapped by loadResources().
+	// Binaries and ubins read from it hold a reference, so it stays mapped
+	// until they are destroyed, even if another resource file is loaded.
+	class ResourceMap : public MappedFile, public RefCounted {
+	public:
+		ResourceMap(const char* filename) : MappedFile(filename) {}
+	};
+	static ResourceMap* resourceMap = NULL;
+
+	// For each static resource that maLoadResource() has deferred,
+	// the resource to load into it.
+	static MAHandle* deferredSource = NULL;
+
+	static bool isMapped(int offset, int size) {
+		return resourceMap != NULL && offset >= 0 && size >= 0 &&
+			offset <= resourceMap->size() - size;
+	}
+
+	// Loads the binaries, images and sprites deferred by maLoadResource(),
+	// the first time they're used.
+	class MappedResourceLoader : public ResourceLoader {
+	public:
+		void loadUnloadedResource(unsigned index) {
+			MemStreamC file(resourceMap->data(), resourceMap->size());
+			if(!SYSCALL_THIS->loadResource(file, deferredSource[index], index))
+				BIG_PHAT_ERROR(ERR_RES_FILE_INCONSISTENT);
+		}
+	};
+	static MappedResourceLoader resourceLoader;
+
+	// Defers loading resource \a handle into \a placeholder until it is used.
+	// Returns false if it can't be deferred.
+	static bool deferResource(MAHandle handle, MAHandle placeholder) {
+		if(resourceMap == NULL || handle < 1 || handle > resourcesCount ||
+			placeholder < 1 || placeholder > resourcesCount)
+		{
+			return false;
+		}
+		int type = resourceType[handle - 1];
+		switch(type) {
+		case RT_BINARY:
+		case RT_IMAGE:
+		case RT_SPRITE:
+#ifdef COMPRESSED_RESOURCES
+		case RT_LZ4_BINARY:
+#endif
+#ifdef IMAGE_ATLASES
+		case RT_ATLAS:
+#endif
+			break;
+		default:
+			return false;
+		}
+		if(!isMapped(resourceOffset[handle - 1], resourceSize[handle - 1]))
+			return false;
+		deferredSource[placeholder] = handle;
+		// sprites and atlases are images once loaded, and compressed binaries are binaries.
+		SYSCALL_THIS->resources.add_unloaded(placeholder,
+			(type == RT_BINARY || type == RT_LZ4_BINARY) ? RT_BINARY : RT_IMAGE);
+		return true;
+	}
+#endif
+
 	/*
 	* Loads all resources from the stream, except images, binaries and sprites.
 	*/
@@ -351,6 +456,28 @@ namespace Base {
 		resourcesFilename = new char[strlen(aFilename) + 1];
 		strcpy(resourcesFilename, aFilename);
 
+#ifdef LAZY_RESOURCES
+		// Offsets reported by file.tell() are from the start of the file,
+		// so this works for combined program and resource files too.
+		if(resourceMap != NULL) {
+			resourceMap->release();
+			resourceMap = NULL;
+		}
+		// resources deferred from the previous file can't be loaded from this one.
+		resources.clear_unloaded();
+		delete[] deferredSource;
+		deferredSource = NULL;
+		resourceMap = new ResourceMap(aFilename);
+		if(!resourceMap->isOpen()) {
+			LOG("Could not map %s. Resources will be read from the file.\n", aFilename);
+			resourceMap->release();
+			resourceMap = NULL;
+		} else {
+			deferredSource = new MAHandle[nResources + 1];
+			resources.setLoader(&resourceLoader);
+		}
+#endif
+
 		// rI is the resource index.
 		int rI = 1;
 
@@ -376,6 +503,12 @@ namespace Base {
 					int pos;
 					MYASSERT(aFilename, ERR_RES_LOAD_UBIN);
 					TEST(file.tell(pos));
+#ifdef LAZY_RESOURCES
+					if(isMapped(pos, size)) {
+						ROOM(resources.dadd_RT_BINARY(rI,
+							new SharedMemStreamC(resourceMap->data() + pos, size, resourceMap)));
+					} else
+#endif
 #ifndef _android
 					ROOM(resources.dadd_RT_BINARY(rI,
 						new LimitedFileStream(aFilename, pos, size)));
@@ -393,6 +526,26 @@ namespace Base {
 					TEST(file.seek(Seek::Current, size));
 				}
 				break;
+#ifdef COMPRESSED_RESOURCES
+			case RT_LZ4_UBIN:
+				{
+					int pos;
+					MYASSERT(aFilename, ERR_RES_LOAD_UBIN);
+					TEST(file.tell(pos));
+					Stream* packed;
+#ifdef LAZY_RESOURCES
+					if(isMapped(pos, size))
+						packed = new SharedMemStreamC(resourceMap->data() + pos, size, resourceMap);
+					else
+#endif
+						packed = new LimitedFileStream(aFilename, pos, size);
+					Lz4Stream* unpacker = new Lz4Stream(packed);
+					MYASSERT(unpacker->isOpen(), ERR_RES_FILE_INCONSISTENT);
+					ROOM(resources.dadd_RT_BINARY(rI, unpacker));
+					TEST(file.seek(Seek::Current, size));
+				}
+				break;
+#endif
 			case RT_PLACEHOLDER:
 				ROOM(resources.dadd_RT_PLACEHOLDER(rI, NULL));
 				break;
@@ -463,6 +616,14 @@ namespace Base {
 		switch(type) {
 		case RT_BINARY:
 			{
+#ifdef LAZY_RESOURCES
+				// reads from the mapping, until the binary is written to.
+				if(isMapped(offset, size)) {
+					ROOM(resources.dadd_RT_BINARY(rI,
+						new CopyOnWriteMemStream(resourceMap->data() + offset, size, resourceMap)));
+					break;
+				}
+#endif
 #ifndef _android
 				MemStream* ms = new MemStream(size);
 #else
@@ -476,6 +637,11 @@ namespace Base {
 #endif
 			}
 			break;
+#ifdef COMPRESSED_RESOURCES
+		case RT_LZ4_BINARY:
+			ROOM(resources.dadd_RT_BINARY(rI, unpackBinary(file.createLimitedCopy(size))));
+			break;
+#endif
 		case RT_IMAGE:
 			{
 				MemStream b(size);
@@ -521,6 +687,15 @@ namespace Base {
 #endif
 				}
 				break;
+#ifdef IMAGE_ATLASES
+			case RT_ATLAS:
+				{
+					MemStream b(size);
+					TEST(file.readFully(b));
+					ROOM(resources.dadd_RT_IMAGE(rI, loadAtlas(b)));
+				}
+				break;
+#endif
 		default:
 			LOG("Cannot load resource type %d.", type);
 		}
@@ -531,6 +706,24 @@ namespace Base {
 	{
 		return resourcesCount;
 	}
+
+#ifndef SYMBIAN
+	int maFindLabels(MAAddress names, MAAddress indices, int count) {
+		MYASSERT(count > 0 && count <= INT_MAX / (int)sizeof(int), ERR_LABEL_COUNT);
+		const int* nameArray = (const int*)SYSCALL_THIS->GetValidatedMemRange(names,
+			count * sizeof(int));
+		int* indexArray = (int*)SYSCALL_THIS->GetValidatedMemRange(indices,
+			count * sizeof(int));
+		int found = 0;
+		for(int i=0; i<count; i++) {
+			const char* name = SYSCALL_THIS->GetValidatedStr(nameArray[i]);
+			indexArray[i] = SYSCALL_THIS->resources.findLabel(name);
+			if(indexArray[i] >= 0)
+				found++;
+		}
+		return found;
+	}
+#endif
 }	//namespace Base
 
 	//***************************************************************************
@@ -916,6 +1109,98 @@ namespace Base {
 		}
 		SYSCALL_THIS->gStores.erase(store);
 	}
+
+#ifdef LOG_STORES
+#define LOG_STORE_PATH "logstores/"
+
+	// Log stores have a directory of their own, so that they never share a
+	// file with a store of maOpenStore(). The suffix keeps a store apart
+	// from the temporary file of another store's compaction.
+	static std::string logStorePath(const char* name) {
+#ifdef __IPHONE__
+		std::string dir = getWriteablePath(LOG_STORE_PATH);
+		_mkdir(dir.c_str());
+		return dir + "/" + name + ".log";
+#else
+		_mkdir(LOG_STORE_PATH);
+		return LOG_STORE_PATH + std::string(name) + ".log";
+#endif
+	}
+
+	LogStore& Syscall::getLogStore(MAHandle store) {
+		LogStore* ls = gLogStores.find(store);
+		MYASSERT(ls, ERR_STORE_HANDLE_INVALID);
+		return *ls;
+	}
+
+	// Returns true if a log store other than \a except has the file \a path.
+	// Two stores on one file would write over each other's records.
+	static bool logStoreIsOpen(const HashMap<LogStore>& stores, const std::string& path,
+		MAHandle except)
+	{
+		HashMap<LogStore>::TIteratorC itr = stores.begin();
+		while(itr.hasMore()) {
+			const HashMap<LogStore>::Pair& p(itr.next());
+			if((MAHandle)p.key != except && p.value->getPath() == path)
+				return true;
+		}
+		return false;
+	}
+
+	MAHandle Syscall::maOpenLogStore(const char* name, int flags) {
+		std::string path = logStorePath(name);
+		if(logStoreIsOpen(gLogStores, path, 0)) {
+			LOG("maOpenLogStore: %s is already open.\n", name);
+			return STERR_GENERIC;
+		}
+		int error;
+		LogStore* ls = LogStore::open(path.c_str(), (flags & MAS_CREATE_IF_NECESSARY) != 0, &error);
+		if(!ls)
+			return error;
+		gLogStores.insert(gStoreNextId, ls);
+		return gStoreNextId++;
+	}
+
+	int Syscall::maStoreAppend(MAHandle store, int key, const void* src, int size) {
+		LogStore& ls(getLogStore(store));
+		MYASSERT(key >= 0 && size >= 0, ERR_STORE_RECORD_INVALID);
+		ValidateMemRange(src, size);
+		return ls.append(key, src, size);
+	}
+
+	int Syscall::maStoreRemoveRecord(MAHandle store, int key) {
+		LogStore& ls(getLogStore(store));
+		MYASSERT(key >= 0, ERR_STORE_RECORD_INVALID);
+		return ls.remove(key);
+	}
+
+	int Syscall::maStoreReadRecord(MAHandle store, int key, void* dst, int dstSize) {
+		LogStore& ls(getLogStore(store));
+		MYASSERT(key >= 0 && dstSize >= 0, ERR_STORE_RECORD_INVALID);
+		ValidateMemRange(dst, dstSize);
+		return ls.read(key, dst, dstSize);
+	}
+
+	int Syscall::maStoreNextRecord(MAHandle store, int key) {
+		return getLogStore(store).next(key);
+	}
+
+	void Syscall::maCloseLogStore(MAHandle store, int _delete) {
+		std::string path = getLogStore(store).getPath();
+		bool shared = logStoreIsOpen(gLogStores, path, store);
+		// closes the file, after any compaction.
+		gLogStores.erase(store);
+		if(_delete && shared) {
+			LOG("maCloseLogStore: %s is open in another handle, not deleted.\n", path.c_str());
+		} else if(_delete) {
+			int res = remove(path.c_str());
+			if(res != 0) {
+				LOG("maCloseLogStore: remove error %i. errno %i.\n", res, errno);
+				DEBIG_PHAT_ERROR;
+			}
+		}
+	}
+#endif	//LOG_STORES
 #endif // NOT _android
 
 	SYSCALL(int, maLoadResources(MAHandle data)) {
@@ -932,6 +1217,16 @@ namespace Base {
 #ifndef _android
 	SYSCALL(int, maLoadResource(MAHandle handle, MAHandle placeholder, int flag)) {
 		DEBUG_ASSERT(resourcesFilename != NULL);
+#ifdef LAZY_RESOURCES
+		if(resourceMap != NULL) {
+			if(SYSCALL_THIS->resources.is_loaded(placeholder))
+				return true;
+			if(deferResource(handle, placeholder))
+				return true;
+			MemStreamC file(resourceMap->data(), resourceMap->size());
+			return SYSCALL_THIS->loadResource(file, handle, placeholder);
+		}
+#endif
 		if (((flag & MA_RESOURCE_OPEN) != 0) && (resource == NULL))
 		{
 			resource = new FileStream(resourcesFilename);
@@ -964,16 +1259,7 @@ namespace Base {
 	}
 
 	SYSCALL(int, maFindLabel(const char* name)) {
-		for(unsigned i = 1; i < SYSCALL_THIS->resources.size(); i++) {
-			if(SYSCALL_THIS->resources.get_type(i)==RT_LABEL)
-			{
-				Label *l = SYSCALL_THIS->resources.get_RT_LABEL(i);
-				if(::strcmp(l->getName(), name)==0) {
-					return i;
-				}
-			}
-		}
-		return -1;
+		return SYSCALL_THIS->resources.findLabel(name);
 	}
 
 	SYSCALL(int, maCheckInterfaceVersion(int hash)) {
@@ -1040,6 +1326,41 @@ namespace Base {
 		return 0;
 	}
 
+	// Writes any buffered writes and moves the stream back over any data read
+	// ahead, for the calls that use the stream rather than the buffer.
+	static bool flushFile(Syscall::FileHandle& fh) {
+#ifdef FILE_BUFFERS
+		if(fh.fs)
+			return fh.buffer.flush(*fh.fs);
+#endif
+		return true;
+	}
+
+#ifdef FILE_BUFFERS
+	// A file that is open in more than one handle isn't buffered, so that
+	// each handle sees what the others write at once. Called when a handle
+	// to \a name is opened, closed or renamed. Different paths to the same
+	// file are not caught.
+	static void updateSharing(Syscall::FileMap& handles, const char* name) {
+		int count = 0;
+		Syscall::FileMap::TIteratorC itr = handles.begin();
+		while(itr.hasMore()) {
+			if(strcmp(itr.next().value->name, name) == 0)
+				count++;
+		}
+		Syscall::FileMap::TIteratorC itr2 = handles.begin();
+		while(itr2.hasMore()) {
+			Syscall::FileHandle& fh(*itr2.next().value);
+			if(strcmp(fh.name, name) != 0)
+				continue;
+			if(count > 1 && !fh.shared && !flushFile(fh)) {
+				LOG("File: buffered writes to %s failed.\n", name);
+			}
+			fh.shared = count > 1;
+		}
+	}
+#endif
+
 	MAHandle Syscall::maFileOpen(const char* path, int mode) {
 		LOGF("maFileOpen(%s, %x): %i\n", path, mode, gFileNextHandle);
 		Smartie<FileHandle> fhs(new FileHandle);
@@ -1084,6 +1405,9 @@ namespace Base {
 		CLEANUPSTACK_PUSH(fhp);
 		gFileHandles.insert(gFileNextHandle, fhp);
 		CLEANUPSTACK_POP(fhp);
+#ifdef FILE_BUFFERS
+		updateSharing(gFileHandles, fhp->name);
+#endif
 		return gFileNextHandle++;
 	}
 
@@ -1113,8 +1437,17 @@ namespace Base {
 		FileHandle* fhp = gFileHandles.find(file);
 		MYASSERT(fhp, ERR_FILE_HANDLE_INVALID);
 		FileHandle& fh(*fhp);
+		bool res = flushFile(fh);
 		SAFE_DELETE(fh.fs);
+#ifdef FILE_BUFFERS
+		std::string name(fh.name);
+		gFileHandles.erase(file);
+		updateSharing(gFileHandles, name.c_str());
+#else
 		gFileHandles.erase(file);
+#endif
+		if(!res)
+			FILE_FAIL(MA_FERR_GENERIC);
 		return 0;
 	}
 
@@ -1153,6 +1486,9 @@ namespace Base {
 		LOGF("maFileDelete(%i)\n", file);
 		FileHandle& fh(getFileHandle(file));
 		MYASSERT(fh.mode == MA_ACCESS_READ_WRITE, ERR_INVALID_FILE_ACCESS_MODE);
+#ifdef FILE_BUFFERS
+		fh.buffer.reset();
+#endif
 		SAFE_DELETE(fh.fs);
 		int res;
 #ifdef _WIN32_WCE
@@ -1182,6 +1518,8 @@ namespace Base {
 		FileHandle& fh(getFileHandle(file));
 		if(!fh.fs)
 			FILE_FAIL(MA_FERR_GENERIC);
+		if(!flushFile(fh))
+			FILE_FAIL(MA_FERR_GENERIC);
 		int len;
 		bool res = fh.fs->length(len);
 		if(!res)
@@ -1203,6 +1541,7 @@ namespace Base {
 		else
 			wasOpen = false;
 		if(wasOpen) {
+			if(!flushFile(fh)) FILE_FAIL(MA_FERR_GENERIC);
 			if(!fh.fs->tell(oldPos)) FILE_FAIL(MA_FERR_GENERIC);
 			delete fh.fs;
 			fh.fs = NULL;
@@ -1284,8 +1623,15 @@ namespace Base {
 			else
 				FILE_FAIL(MA_FERR_GENERIC);
 		}
+#ifdef FILE_BUFFERS
+		std::string oldName(fh.name);
+#endif
 		fh.name.resize(strlen(newName) + 1);
 		strcpy(fh.name, newName);
+#ifdef FILE_BUFFERS
+		updateSharing(gFileHandles, oldName.c_str());
+		updateSharing(gFileHandles, fh.name);
+#endif
 
 		if(!wasOpen)
 			return 0;
@@ -1346,6 +1692,7 @@ namespace Base {
 		time_t t;
 		if(fh.fs) {
 			if(!fh.fs->isOpen()) FILE_FAIL(MA_FERR_GENERIC);
+			if(!flushFile(fh)) FILE_FAIL(MA_FERR_GENERIC);
 			if(!fh.fs->mTime(t)) FILE_FAIL(MA_FERR_GENERIC);
 		} else {
 			const char* statName = fh.name;
@@ -1374,6 +1721,7 @@ namespace Base {
 		FileHandle& fh(getFileHandle(file));
 		if(!fh.fs) FILE_FAIL(MA_FERR_GENERIC);
 		if(!fh.fs->isOpen()) FILE_FAIL(MA_FERR_GENERIC);
+		if(!flushFile(fh)) FILE_FAIL(MA_FERR_GENERIC);
 		if(!fh.fs->truncate(offset)) FILE_FAIL(MA_FERR_GENERIC);
 		return 0;
 	}
@@ -1384,7 +1732,16 @@ namespace Base {
 		FileHandle& fh(getFileHandle(file));
 		if(!fh.fs)
 			FILE_FAIL(MA_FERR_GENERIC);
+#ifdef FILE_BUFFERS
+		//a read-only stream fails the write.
+		bool res;
+		if(fh.mode == MA_ACCESS_READ_WRITE && !fh.shared)
+			res = fh.buffer.write(*fh.fs, src, len);
+		else
+			res = fh.fs->write(src, len);
+#else
 		bool res = fh.fs->write(src, len);
+#endif
 		if(!res)
 			FILE_FAIL(MA_FERR_GENERIC);
 		return 0;
@@ -1398,6 +1755,8 @@ namespace Base {
 		//todo: add ERR_DATA_OOB check for length.
 		if(!fh.fs)
 			FILE_FAIL(MA_FERR_GENERIC);
+		if(!flushFile(fh))
+			FILE_FAIL(MA_FERR_GENERIC);
 		bool res = fh.fs->writeStream(*b, len);
 		if(!res)
 			FILE_FAIL(MA_FERR_GENERIC);
@@ -1409,12 +1768,44 @@ namespace Base {
 		FileHandle& fh(getFileHandle(file));
 		if(!fh.fs)
 			FILE_FAIL(MA_FERR_GENERIC);
+#ifdef FILE_BUFFERS
+		bool res;
+		if(fh.shared)
+			res = fh.fs->read(dst, len);
+		else
+			res = fh.buffer.read(*fh.fs, dst, len);
+#else
 		bool res = fh.fs->read(dst, len);
+#endif
 		if(!res)
 			FILE_FAIL(MA_FERR_GENERIC);
 		return 0;
 	}
 
+#ifdef LAZY_RESOURCES
+	// maFileReadToData() copies reads this large or larger straight from a
+	// mapping of the file. Smaller ones are faster with a read().
+	//
+	// The data object isn't backed by the mapping itself: it already exists,
+	// the read may start anywhere in it, and it must stay writable and keep
+	// its contents if the file changes later. A private mapping would show
+	// later changes to the file in the pages the app hasn't written to yet.
+#define FILE_MAP_MIN (1024 * 1024)
+
+	// Returns false, having read nothing, if the file could not be mapped.
+	// Otherwise sets \a res to the result of the read.
+	static bool readMapped(Syscall::FileHandle& fh, Stream& dst, int len, bool& res) {
+		int pos;
+		if(!fh.fs->tell(pos))
+			return false;
+		MappedFile map(fh.name);
+		if(!map.isOpen() || pos > map.size() - len)
+			return false;
+		res = dst.write(map.data() + pos, len) && fh.fs->seek(Seek::Current, len);
+		return true;
+	}
+#endif
+
 	int Syscall::maFileReadToData(MAHandle file, MAHandle data, int offset, int len) {
 		LOGF("maFileReadToData(%i, %i)\n", file, len);
         if(len < 0) FILE_FAIL(MA_FERR_GENERIC);
@@ -1425,6 +1816,18 @@ namespace Base {
 		//todo: add ERR_DATA_OOB check for length.
 		if(!fh.fs)
 			FILE_FAIL(MA_FERR_GENERIC);
+		if(!flushFile(fh))
+			FILE_FAIL(MA_FERR_GENERIC);
+#ifdef LAZY_RESOURCES
+		if(len >= FILE_MAP_MIN) {
+			bool res;
+			if(readMapped(fh, *b, len, res)) {
+				if(!res)
+					FILE_FAIL(MA_FERR_GENERIC);
+				return 0;
+			}
+		}
+#endif
 		bool res = b->writeStream(*fh.fs, len);
 		if(!res)
 			FILE_FAIL(MA_FERR_GENERIC);
@@ -1436,7 +1839,16 @@ namespace Base {
 		FileHandle& fh(getFileHandle(file));
 		MYASSERT(fh.fs, ERR_FILE_CLOSED);
 		int pos;
+#ifdef FILE_BUFFERS
+		//the data read ahead is kept, so that a parser may call this often.
+		bool res;
+		if(fh.shared)
+			res = fh.fs->tell(pos);
+		else
+			res = fh.buffer.flushWrites(*fh.fs) && fh.buffer.tell(*fh.fs, pos);
+#else
 		bool res = fh.fs->tell(pos);
+#endif
 		if(!res)
 			FILE_FAIL(MA_FERR_GENERIC);
 		return pos;
@@ -1453,6 +1865,8 @@ namespace Base {
 		case MA_SEEK_END: mode = Seek::End; break;
 		default: BIG_PHAT_ERROR(ERR_INVALID_FILE_SEEK_MODE);
 		}
+		if(!flushFile(fh))
+			FILE_FAIL(MA_FERR_GENERIC);
 		bool res = fh.fs->seek(mode, offset);
 		if(!res)
 			FILE_FAIL(MA_FERR_GENERIC);
@@ -35,8 +35,39 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 #include <jni.h>
 #endif
 
+// LAZY_RESOURCES maps the resource file into memory. maLoadResource() then
+// defers loading binaries, images and sprites until they're first used, and
+// binaries read from the mapping until they are written to.
+// IMAGE_ATLASES supports the ATLAS resource type, which needs loadAtlas().
+#if !defined(SYMBIAN) && !defined(_android) && !defined(_WIN32_WCE) && !defined(__IPHONE__)
+#define LAZY_RESOURCES
+#define IMAGE_ATLASES
+#endif
+
+// COMPRESSED_RESOURCES supports the LZ4_BINARY and LZ4_UBIN resource types.
+// The package tool refuses resource files with those types for the other
+// platforms.
+#if !defined(SYMBIAN) && !defined(_android)
+#define COMPRESSED_RESOURCES
+#endif
+
+// LOG_STORES supports maOpenLogStore() and the other log store syscalls.
+// FILE_BUFFERS buffers maFileRead() and maFileWrite() in a FileBuffer.
+#if !defined(SYMBIAN) && !defined(_android) && !defined(_WIN32_WCE)
+#define LOG_STORES
+#define FILE_BUFFERS
+#endif
+
 #include <hashmap/hashmap.h>
 
+#ifdef LOG_STORES
+#include "LogStore.h"
+#endif
+
+#ifdef FILE_BUFFERS
+#include "FileBuffer.h"
+#endif
+
 #include <helpers/CPP_IX_STREAMING.h>
 #include <helpers/CPP_IX_WIDGET.h>
 
@@ -100,6 +131,19 @@ namespace Base {
 		int gStoreNextId;
 		StringMap gStores;
 
+#ifdef LOG_STORES
+		HashMap<LogStore> gLogStores;
+
+		LogStore& getLogStore(MAHandle store);
+
+		MAHandle maOpenLogStore(const char* name, int flags);
+		int maStoreAppend(MAHandle store, int key, const void* src, int size);
+		int maStoreRemoveRecord(MAHandle store, int key);
+		int maStoreReadRecord(MAHandle store, int key, void* dst, int dstSize);
+		int maStoreNextRecord(MAHandle store, int key);
+		void maCloseLogStore(MAHandle store, int _delete);
+#endif
+
 #ifdef SYMBIAN
 #define DIRSEP '\\'
 #else
@@ -111,10 +155,26 @@ namespace Base {
 			FileStream* fs;
 			int mode;
 			Array<char> name;
+#ifdef FILE_BUFFERS
+			FileBuffer buffer;
+			bool shared;	//the file is open in another handle, so the buffer isn't used.
+#endif
 			bool isDirectory() const {
 				return name[name.size()-2] == DIRSEP;
 			}
+#ifdef FILE_BUFFERS
+			FileHandle() : name(0), shared(false) {}
+#else
 			FileHandle() : name(0) {}
+#endif
+#ifdef FILE_BUFFERS
+			// The stream is left open, but the writes still in the buffer
+			// are written.
+			~FileHandle() {
+				if(fs)
+					buffer.flushWrites(*fs);
+			}
+#endif
 		};
 		typedef HashMap<FileHandle> FileMap;
 		FileMap gFileHandles;
@@ -183,6 +243,14 @@ namespace Base {
 	};
 
 	int maAccept(MAHandle conn);
+	int maDnsPrefetch(const char* hostname);
+	int maDnsFlush();
+	void maConnReadFromMulti(MAHandle conn, MAAddress datagrams, int count);
+	void maConnWriteToMulti(MAHandle conn, MAAddress datagrams, int count);
+	int maFindLabels(MAAddress names, MAAddress indices, int count);
+	int maCreateImageFromDataAsync(MAHandle placeholder, MAHandle data, int offset, int size);
+	int maCancelImageDecode(MAHandle placeholder);
+	int maSetImageDecodeConcurrency(int max);
 
 	//platform-dependent, works like atoi.
 	int atoiLen(const char* str, int len);
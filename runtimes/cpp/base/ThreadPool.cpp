@@ -128,3 +128,76 @@ void WorkerThread::run() {
 		mR = NULL;
 	}
 }
+
+//*****************************************************************************
+//ParallelJobRunner
+//*****************************************************************************
+
+class ParallelJobRunner::Worker {
+public:
+	Worker(ParallelJobRunner* runner, int first) : mRunner(runner), mFirst(first) {
+		mThread.start(homeRun, this);
+	}
+	~Worker() {
+		mThread.join();
+	}
+
+	MoSyncSemaphore mStart;
+private:
+	MoSyncThread mThread;
+	ParallelJobRunner* mRunner;
+	int mFirst;
+
+	static int homeRun(void* data) {
+		Worker* w = (Worker*)data;
+		ParallelJobRunner* r = w->mRunner;
+		while(true) {
+			w->mStart.wait();
+			if(r->mQuit)
+				return 0;
+			r->runJobs(w->mFirst);
+			r->mDone.post();
+		}
+	}
+};
+
+ParallelJobRunner::ParallelJobRunner(int threadCount)
+: mThreadCount(threadCount), mJob(NULL), mData(NULL), mCount(0), mQuit(false)
+{
+}
+
+ParallelJobRunner::~ParallelJobRunner() {
+	mQuit = true;
+	for(uint i=0; i<mWorkers.size(); i++) {
+		mWorkers[i]->mStart.post();
+	}
+	for(uint i=0; i<mWorkers.size(); i++) {
+		delete mWorkers[i];
+	}
+}
+
+void ParallelJobRunner::run(void (*job)(void* data, int index), void* data, int count) {
+	if(mWorkers.empty()) {
+		for(int i=0; i<mThreadCount; i++) {
+			mWorkers.push_back(new Worker(this, i + 1));
+		}
+	}
+	mJob = job;
+	mData = data;
+	mCount = count;
+	//the semaphores order these writes before the reads in the workers.
+	for(uint i=0; i<mWorkers.size(); i++) {
+		mWorkers[i]->mStart.post();
+	}
+	runJobs(0);
+	for(uint i=0; i<mWorkers.size(); i++) {
+		mDone.wait();
+	}
+}
+
+void ParallelJobRunner::runJobs(int first) {
+	int stride = mThreadCount + 1;
+	for(int i=first; i<mCount; i+=stride) {
+		mJob(mData, i);
+	}
+}
@@ -20,6 +20,7 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 
 #include <vector>
 #include "ThreadPoolImpl.h"
+#include "TileBins.h"
 
 class Runnable {
 public:
@@ -42,4 +43,29 @@ private:
 	std::vector<WorkerThread*> mThreads;
 };
 
+// Runs jobs on a fixed set of worker threads and the calling thread.
+// The threads are started by the first call to run().
+// run() must not be called from more than one thread at a time.
+class ParallelJobRunner : public JobRunner {
+public:
+	ParallelJobRunner(int threadCount);
+	~ParallelJobRunner();
+
+	void run(void (*job)(void* data, int index), void* data, int count);
+private:
+	class Worker;
+	friend class Worker;
+	std::vector<Worker*> mWorkers;
+	int mThreadCount;
+	MoSyncSemaphore mDone;
+
+	void (*mJob)(void*, int);
+	void* mData;
+	int mCount;
+	bool mQuit;
+
+	//runs the jobs of one thread; every (mThreadCount+1)th job, starting at \a first.
+	void runJobs(int first);
+};
+
 #endif	//THREADPOOL_H
@@ -0,0 +1,146 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+// Binning of triangles into screen tiles, for rasterisers that draw the
+// tiles in parallel. Each tile is drawn with its triangles in the order they
+// were added, clipped to the tile, so the result is the same as drawing all
+// triangles in order. Header only, because it is used by Image.cpp, which
+// is built on more platforms than the rest of base.
+
+#ifndef _TILE_BINS_H_
+#define _TILE_BINS_H_
+
+#include <vector>
+#include <algorithm>
+
+// Runs independent jobs, possibly in parallel.
+class JobRunner {
+public:
+	virtual ~JobRunner() {}
+
+	// Calls job(data, i) for each i from 0 to \a count - 1, in any order and
+	// on any thread. Returns when all calls have returned.
+	virtual void run(void (*job)(void* data, int index), void* data, int count) = 0;
+};
+
+#define TILE_BIN_SIZE 64
+
+class TileBins {
+public:
+	// Covers the area with tiles and empties them.
+	void reset(int left, int top, int width, int height) {
+		mLeft = left;
+		mTop = top;
+		mRight = left + width;
+		mBottom = top + height;
+		mColumns = width > 0 ? (width + TILE_BIN_SIZE - 1) / TILE_BIN_SIZE : 0;
+		mRows = height > 0 ? (height + TILE_BIN_SIZE - 1) / TILE_BIN_SIZE : 0;
+		mTiles.resize(mColumns * mRows);
+		for(size_t i=0; i<mTiles.size(); i++) {
+			mTiles[i].clear();
+		}
+	}
+
+	// Adds triangle \a index to the tiles it may draw to. The rasteriser
+	// must only draw pixels that are at most \a margin pixels away from
+	// the triangle, horizontally and vertically. Tiles are skipped when
+	// they are outside of one of the triangle's edges.
+	void add(int index, int x1, int y1, int x2, int y2, int x3, int y3, int margin) {
+		int minX = MIN3(x1, x2, x3) - margin, maxX = MAX3(x1, x2, x3) + margin;
+		int minY = MIN3(y1, y2, y3) - margin, maxY = MAX3(y1, y2, y3) + margin;
+		if(maxX < mLeft || minX >= mRight || maxY < mTop || minY >= mBottom)
+			return;
+		int c0 = column(minX), c1 = column(maxX);
+		int r0 = row(minY), r1 = row(maxY);
+
+		//a single tile needs no edge tests.
+		if(c0 == c1 && r0 == r1) {
+			mTiles[r0 * mColumns + c0].push_back(index);
+			return;
+		}
+
+		//edge functions, positive on the inside. Degenerate triangles have
+		//no inside, but some rasterisers draw their edges, so they only use
+		//the bounding box.
+		long long area = (long long)(x2 - x1) * (y3 - y1) - (long long)(y2 - y1) * (x3 - x1);
+		int sign = area > 0 ? 1 : area < 0 ? -1 : 0;
+		Edge edges[3] = {
+			edge(x1, y1, x2, y2, sign), edge(x2, y2, x3, y3, sign), edge(x3, y3, x1, y1, sign)
+		};
+
+		for(int r=r0; r<=r1; r++) {
+			for(int c=c0; c<=c1; c++) {
+				//the pixels of the tile, and the margin around them.
+				int left = mLeft + c * TILE_BIN_SIZE - margin;
+				int top = mTop + r * TILE_BIN_SIZE - margin;
+				int right = mLeft + (c + 1) * TILE_BIN_SIZE - 1 + margin;
+				int bottom = mTop + (r + 1) * TILE_BIN_SIZE - 1 + margin;
+				if(sign == 0 || (touches(edges[0], left, top, right, bottom) &&
+					touches(edges[1], left, top, right, bottom) &&
+					touches(edges[2], left, top, right, bottom)))
+				{
+					mTiles[r * mColumns + c].push_back(index);
+				}
+			}
+		}
+	}
+
+	int tileCount() const { return (int)mTiles.size(); }
+
+	// The pixels of a tile, clipped to the area.
+	void tileRect(int tile, int& left, int& top, int& width, int& height) const {
+		left = mLeft + (tile % mColumns) * TILE_BIN_SIZE;
+		top = mTop + (tile / mColumns) * TILE_BIN_SIZE;
+		width = std::min(TILE_BIN_SIZE, mRight - left);
+		height = std::min(TILE_BIN_SIZE, mBottom - top);
+	}
+
+	const std::vector<int>& triangles(int tile) const { return mTiles[tile]; }
+
+private:
+	struct Edge {
+		long long a, b, c;
+	};
+
+	static int MIN3(int a, int b, int c) { return std::min(a, std::min(b, c)); }
+	static int MAX3(int a, int b, int c) { return std::max(a, std::max(b, c)); }
+
+	static Edge edge(int x1, int y1, int x2, int y2, int sign) {
+		Edge e;
+		e.a = (long long)(y1 - y2) * sign;
+		e.b = (long long)(x2 - x1) * sign;
+		e.c = -(e.a * x1 + e.b * y1);
+		return e;
+	}
+
+	//false if the whole box is outside of the edge.
+	static bool touches(const Edge& e, int left, int top, int right, int bottom) {
+		//the corner that is furthest inside.
+		long long x = e.a < 0 ? left : right;
+		long long y = e.b < 0 ? top : bottom;
+		return e.a * x + e.b * y + e.c >= 0;
+	}
+
+	int column(int x) const { return std::min(std::max(x - mLeft, 0) / TILE_BIN_SIZE, mColumns - 1); }
+	int row(int y) const { return std::min(std::max(y - mTop, 0) / TILE_BIN_SIZE, mRows - 1); }
+
+	int mLeft, mTop, mRight, mBottom;
+	int mColumns, mRows;
+	std::vector<std::vector<int> > mTiles;
+};
+
+#endif	//_TILE_BINS_H_
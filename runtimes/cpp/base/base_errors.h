@@ -101,6 +101,17 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 	m(40081, ERR_RES_PLACEHOLDER_ALREADY_DESTROYED, "Placeholder is already destroyed")\
 	m(40082, ERR_ORIENTATION_INVALID, "Invalid orientation")\
 	m(40083, ERR_DB_PARAM_TYPE_INVALID, "DB: Invalid parameter type")\
+	m(40084, ERR_CONN_DATAGRAM_COUNT, "Invalid datagram count")\
+	m(40085, ERR_EVENT_COUNT, "Invalid event count")\
+	m(40086, ERR_LABEL_COUNT, "Invalid label count")\
+	m(40087, ERR_IMAGE_DECODE_CONCURRENCY, "Invalid image decode concurrency")\
+	m(40088, ERR_IMAGE_REGION_COUNT, "Invalid image region count")\
+	m(40089, ERR_SCREEN_RECT_COUNT, "Invalid screen rectangle count")\
+	m(40090, ERR_IMAGE_SCALE_FILTER, "Invalid image scale filter")\
+	m(40091, ERR_DB_BATCH_COUNT, "DB: Invalid batch size")\
+	m(40092, ERR_DB_OPEN_OPTIONS, "DB: Invalid open options")\
+	m(40093, ERR_STORE_RECORD_INVALID, "Invalid log store record key or size")\
+	m(40094, ERR_DB_FETCH_ARGUMENTS, "DB: Invalid fetch buffer size or row count")\
 
 DECLARE_ERROR_ENUM(BASE)
 
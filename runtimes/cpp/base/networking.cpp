@@ -601,6 +601,20 @@ int Base::maAccept(MAHandle conn) {
 	return 0;
 }
 
+int Base::maDnsPrefetch(const char* hostname) {
+	LOGST("DnsPrefetch %s", hostname);
+	if(hostname[0] == 0)
+		return CONNERR_URL;
+	gThreadPool.execute(new DnsPrefetch(hostname));
+	return 0;
+}
+
+int Base::maDnsFlush() {
+	LOGST("DnsFlush");
+	Resolver::flush();
+	return 0;
+}
+
 SYSCALL(int, maConnGetAddr(MAHandle conn, MAConnAddr* addr)) {
 	LOGST("ConnGetAddr %i", conn);
 	if(conn == HANDLE_LOCAL) {
@@ -649,6 +663,45 @@ SYSCALL(void, maConnWriteTo(MAHandle conn, const void* src, int size, const MACo
 	gThreadPool.execute(new ConnWriteTo(mac, src, size, *dst));
 }
 
+//Validates a guest array of MAConnDatagram and the buffers it points to.
+static MAConnDatagram* getDatagrams(MAAddress datagrams, int count,
+	std::vector<DatagramBuffer>& bufs)
+{
+	MYASSERT(count > 0 && count <= CONN_MAX_DATAGRAMS, ERR_CONN_DATAGRAM_COUNT);
+	MAConnDatagram* dgs = (MAConnDatagram*)SYSCALL_THIS->GetValidatedMemRange(datagrams,
+		count * sizeof(MAConnDatagram));
+	bufs.resize(count);
+	for(int i=0; i<count; i++) {
+		DatagramBuffer& buf(bufs[i]);
+		MYASSERT(dgs[i].size >= 0, ERR_MEMORY_OOB);
+		buf.size = dgs[i].size;
+		buf.data = SYSCALL_THIS->GetValidatedMemRange(dgs[i].data, buf.size);
+		buf.length = 0;
+		buf.addr = dgs[i].addr;
+	}
+	return dgs;
+}
+
+void Base::maConnReadFromMulti(MAHandle conn, MAAddress datagrams, int count) {
+	LOGST("ConnReadFromMulti %i %i", conn, count);
+	MAStreamConn& mac = getStreamConn(conn);
+	MYASSERT((mac.state & CONNOP_READ) == 0, ERR_CONN_ALREADY_READING);
+	std::vector<DatagramBuffer> bufs;
+	MAConnDatagram* dgs = getDatagrams(datagrams, count, bufs);
+	mac.state |= CONNOP_READ;
+	gThreadPool.execute(new ConnReadFromMulti(mac, bufs, dgs));
+}
+
+void Base::maConnWriteToMulti(MAHandle conn, MAAddress datagrams, int count) {
+	LOGST("ConnWriteToMulti %i %i", conn, count);
+	MAStreamConn& mac = getStreamConn(conn);
+	MYASSERT((mac.state & CONNOP_WRITE) == 0, ERR_CONN_ALREADY_WRITING);
+	std::vector<DatagramBuffer> bufs;
+	getDatagrams(datagrams, count, bufs);
+	mac.state |= CONNOP_WRITE;
+	gThreadPool.execute(new ConnWriteToMulti(mac, bufs));
+}
+
 SYSCALL(void, maConnReadToData(MAHandle conn, MAHandle data, int offset, int size)) {
 	LOGST("ConnReadToData %i %i %i %i", conn, data, offset, size);
 	MYASSERT(offset >= 0, ERR_DATA_OOB);
@@ -20,6 +20,7 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 #endif	//NETWORKING_H
 
 #include <string>
+#include <vector>
 
 #include <helpers/hash_map.h>
 
@@ -29,6 +30,8 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 #include <bluetooth/connection.h>
 #include <bluetooth/server.h>
 
+#include <net/resolver.h>
+
 #include "MemStream.h"
 
 #include "TcpConnection.h"
@@ -222,6 +225,38 @@ private:
 	const MAConnAddr& dst;
 };
 
+//Takes over the contents of b.
+class ConnReadFromMulti : public ConnStreamOp {
+public:
+	ConnReadFromMulti(MAStreamConn& m, std::vector<DatagramBuffer>& b, MAConnDatagram* d)
+		: ConnStreamOp(m), dgs(d) { bufs.swap(b); }
+	void run() {
+		LOGST("ConnReadFromMulti %i %i", mac.handle, (int)bufs.size());
+		int result = masc.conn->readFromMulti(&bufs[0], bufs.size());
+		for(int i=0; i<result; i++) {
+			dgs[i].length = bufs[i].length;
+			dgs[i].addr = bufs[i].addr;
+		}
+		handleResult(CONNOP_READ, result);
+	}
+private:
+	std::vector<DatagramBuffer> bufs;
+	MAConnDatagram* dgs;
+};
+
+//Takes over the contents of b.
+class ConnWriteToMulti : public ConnStreamOp {
+public:
+	ConnWriteToMulti(MAStreamConn& m, std::vector<DatagramBuffer>& b)
+		: ConnStreamOp(m) { bufs.swap(b); }
+	void run() {
+		LOGST("ConnWriteToMulti %i %i", mac.handle, (int)bufs.size());
+		handleResult(CONNOP_WRITE, masc.conn->writeToMulti(&bufs[0], bufs.size()));
+	}
+private:
+	std::vector<DatagramBuffer> bufs;
+};
+
 class ConnReadToData : public ConnStreamOp {
 public:
 	ConnReadToData(MAStreamConn& m, MemStream& d, MAHandle h, int o, int s)
@@ -311,6 +346,19 @@ private:
 	MAServerConn& masc;
 };
 
+//Resolves a host name, so that the result ends up in the cache.
+class DnsPrefetch : public Runnable {
+public:
+	DnsPrefetch(const char* h) : hostname(h) {}
+	void run() {
+		LOGST("DnsPrefetch %s", hostname.c_str());
+		uint inetAddr;
+		Resolver::resolve(hostname.c_str(), inetAddr);
+	}
+private:
+	const std::string hostname;
+};
+
 //***************************************************************************
 //Functions
 //***************************************************************************
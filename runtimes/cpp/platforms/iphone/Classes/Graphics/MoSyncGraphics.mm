@@ -14,6 +14,7 @@
 #import "MoSyncFonts.h"
 
 #include "CMGlyphDrawing.h"
+#include "ThreadPool.h"
 
 namespace Base
 {
@@ -114,21 +115,20 @@ SYSCALL(void, maFillRect(int left, int top, int width, int height))
 	gDrawTarget->mImageDrawer->drawFilledRect(left, top, width, height, realColor);
 }
 
+//draws the tiles of large meshes on the MoSync thread and one worker thread.
+static ParallelJobRunner* getTriangleRunner()
+{
+	static ParallelJobRunner* runner = new ParallelJobRunner(1);
+	return runner;
+}
+
 SYSCALL(void, maFillTriangleStrip(const MAPoint2d *points, int count))
 {
 	Base::SYSCALL_THIS->ValidateMemRange(points, sizeof(MAPoint2d) * count);
 	CHECK_INT_ALIGNMENT(points);
 	MYASSERT(count >= 3, ERR_POLYGON_TOO_FEW_POINTS);
-	for(int i = 2; i < count; i++) {
-		gDrawTarget->mImageDrawer->drawTriangle(
-												points[i-2].x,
-												points[i-2].y,
-												points[i-1].x,
-												points[i-1].y,
-												points[i].x,
-												points[i].y,
-												realColor);
-	}
+	gDrawTarget->mImageDrawer->fillTriangles((const int*)points, count, false, realColor,
+		getTriangleRunner());
 }
 
 SYSCALL(void, maFillTriangleFan(const MAPoint2d *points, int count))
@@ -136,16 +136,8 @@ SYSCALL(void, maFillTriangleFan(const MAPoint2d *points, int count))
 	Base::SYSCALL_THIS->ValidateMemRange(points, sizeof(MAPoint2d) * count);
 	CHECK_INT_ALIGNMENT(points);
 	MYASSERT(count >= 3, ERR_POLYGON_TOO_FEW_POINTS);
-	for(int i = 2; i < count; i++) {
-		gDrawTarget->mImageDrawer->drawTriangle(
-												points[0].x,
-												points[0].y,
-												points[i-1].x,
-												points[i-1].y,
-												points[i].x,
-												points[i].y,
-												realColor);
-	}
+	gDrawTarget->mImageDrawer->fillTriangles((const int*)points, count, true, realColor,
+		getTriangleRunner());
 }
 
 SYSCALL(void, maUpdateScreen())
@@ -349,6 +349,15 @@ namespace Base {
 		maIOCtl_case(maDBCursorGetColumnText);
 		maIOCtl_case(maDBCursorGetColumnInt);
 		maIOCtl_case(maDBCursorGetColumnDouble);
+		maIOCtl_case(maDBExecSQLBatch);
+		maIOCtl_case(maDBCursorFetchRows);
+		maIOCtl_case(maDBOpenEx);
+		maIOCtl_syscall_case(maOpenLogStore);
+		maIOCtl_syscall_case(maStoreAppend);
+		maIOCtl_syscall_case(maStoreRemoveRecord);
+		maIOCtl_syscall_case(maStoreReadRecord);
+		maIOCtl_syscall_case(maStoreNextRecord);
+		maIOCtl_syscall_case(maCloseLogStore);
 		maIOCtl_case(maScreenSetSupportedOrientations);
 		maIOCtl_case(maScreenGetSupportedOrientations);
 		maIOCtl_case(maScreenGetCurrentOrientation);
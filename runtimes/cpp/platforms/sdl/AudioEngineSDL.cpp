@@ -19,10 +19,12 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 #include "config_platform.h"
 #include "AudioEngine.h"
 #include "AudioChannel.h"
+#include "AudioMix.h"
 #include "AudioSource.h"
 #include "Stream.h"
 #include "WaveAudioSource.h"
 #include "AmrAudioSource.h"
+#include "StreamingAudioSource.h"
 #ifndef __NO_SDL_SOUND__
 #include <SDL/SDL_sound.h>
 #include "SDLSoundAudioSource.h"
@@ -55,15 +57,7 @@ namespace AudioEngine {
 			}
 		}
 
-		Sint16* dst = (Sint16*)buf;
-		for(int i = 0; i < numSamples<<1; i++) {
-			int sample = gTempBuffer[i];
-			if(sample<-32768) 
-				sample = 32768;
-			else if(sample>=32767) 
-				sample = 32767;
-			*dst++ = (Sint16) (gTempBuffer[i]);
-		}
+		AudioMix::clampToS16((short*)buf, gTempBuffer, numSamples<<1);
 	}
 
 	int getSampleRate() {
@@ -88,6 +82,7 @@ namespace AudioEngine {
 
 		for(int i = 0; i < MAX_CHANNELS; i++) {
 			gChannels[i] = new AudioChannel(gAudioSpec.freq, NULL);
+			gChannels[i]->setResampler(AudioMix::POLYPHASE);
 		}
 
 		SDL_PauseAudio(0);
@@ -158,6 +153,9 @@ namespace AudioEngine {
 		}
 #endif		
 
+		//decode ahead on a thread of its own, rather than in soundCallback.
+		audioSource = new StreamingAudioSource(audioSource);
+
 		if(audioSource->init() !=0) {
 			delete audioSource;
 			return NULL;
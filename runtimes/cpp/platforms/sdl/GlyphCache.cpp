@@ -0,0 +1,320 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+// Each font has an atlas: rows of ATLAS_WIDTH bytes, into which the glyph
+// bitmaps from TTF_RenderGlyph_Solid() are packed in shelves. A Solid glyph is
+// one bit per pixel, so the atlas only stores coverage. The colour is applied
+// when drawing, as the pixel value that SDL would have mapped the palette of
+// the Solid surface to.
+//
+// Strings are laid out the way SDL_ttf 2.0 lays them out in TTF_SizeUNICODE()
+// and TTF_RenderUNICODE_Solid(), without kerning and bold style, which the
+// runtime's fonts don't use.
+
+#include "config_platform.h"
+
+#include <map>
+#include <vector>
+#include <string.h>
+
+#include <helpers/helpers.h>
+
+#include "GlyphCache.h"
+
+#define ATLAS_WIDTH 512
+//the atlas is cleared at the start of a call when it has grown beyond this.
+#define ATLAS_MAX_BYTES (4*1024*1024)
+#define PAGE_SIZE 256
+#define PAGE_COUNT (0x10000 / PAGE_SIZE)
+
+namespace Base {
+
+	struct Glyph {
+		bool loaded;
+		int minx, maxx, miny, maxy, advance;
+		//position and size of the bitmap in the atlas.
+		int x, y, w, h;
+	};
+
+	struct FontGlyphs {
+		TTF_Font* font;
+		int height, ascent;
+		//glyphs by code point, in pages that are allocated on first use.
+		Glyph* pages[PAGE_COUNT];
+		std::vector<byte> atlas;
+		int shelfX, shelfY, shelfH;
+	};
+
+	struct PlacedGlyph {
+		const Glyph* glyph;
+		//left edge of the glyph's origin, relative to the left edge of the text.
+		int x;
+	};
+
+	typedef std::map<TTF_Font*, FontGlyphs*> FontMap;
+	static FontMap sFonts;
+	static FontGlyphs* sLastFont = NULL;
+	static std::vector<PlacedGlyph> sLayout;
+
+	static void clearGlyphs(FontGlyphs* f) {
+		for(int i=0; i<PAGE_COUNT; i++) {
+			delete[] f->pages[i];
+			f->pages[i] = NULL;
+		}
+		f->atlas.clear();
+		f->shelfX = f->shelfY = f->shelfH = 0;
+	}
+
+	static FontGlyphs* getFont(TTF_Font* font) {
+		FontGlyphs* f = sLastFont;
+		if(!f || f->font != font) {
+			FontMap::iterator itr = sFonts.find(font);
+			if(itr != sFonts.end()) {
+				f = itr->second;
+			} else {
+				f = new FontGlyphs;
+				f->font = font;
+				f->height = TTF_FontHeight(font);
+				f->ascent = TTF_FontAscent(font);
+				memset(f->pages, 0, sizeof(f->pages));
+				f->shelfX = f->shelfY = f->shelfH = 0;
+				sFonts[font] = f;
+			}
+			sLastFont = f;
+		}
+		//glyphs are only removed between calls, so that a layout stays valid.
+		if(f->atlas.size() > ATLAS_MAX_BYTES)
+			clearGlyphs(f);
+		return f;
+	}
+
+	//copies the bitmap of \a surf into the next free spot of the atlas.
+	static void storeBitmap(FontGlyphs* f, Glyph& g, SDL_Surface* surf) {
+		if(f->shelfX + g.w > ATLAS_WIDTH) {
+			f->shelfY += f->shelfH;
+			f->shelfX = f->shelfH = 0;
+		}
+		g.x = f->shelfX;
+		g.y = f->shelfY;
+		f->shelfX += g.w;
+		f->shelfH = MAX(f->shelfH, g.h);
+		size_t rows = f->shelfY + f->shelfH;
+		if(f->atlas.size() < rows * ATLAS_WIDTH)
+			f->atlas.resize(rows * ATLAS_WIDTH);
+
+		if(SDL_MUSTLOCK(surf))
+			SDL_LockSurface(surf);
+		const byte* src = (const byte*)surf->pixels;
+		byte* dst = &f->atlas[g.y * ATLAS_WIDTH + g.x];
+		for(int y=0; y<g.h; y++) {
+			memcpy(dst, src, g.w);
+			src += surf->pitch;
+			dst += ATLAS_WIDTH;
+		}
+		if(SDL_MUSTLOCK(surf))
+			SDL_UnlockSurface(surf);
+	}
+
+	static const Glyph* getGlyph(FontGlyphs* f, Uint16 c) {
+		Glyph*& page = f->pages[c / PAGE_SIZE];
+		if(!page)
+			page = new Glyph[PAGE_SIZE]();
+		Glyph& g = page[c % PAGE_SIZE];
+		if(g.loaded)
+			return &g;
+
+		if(TTF_GlyphMetrics(f->font, c, &g.minx, &g.maxx, &g.miny, &g.maxy, &g.advance) != 0)
+			return NULL;
+		g.x = g.y = g.w = g.h = 0;
+		if(g.maxx > g.minx) {
+			//the colour doesn't matter; only the bitmap is used.
+			SDL_Color white = { 255, 255, 255, 0 };
+			SDL_Surface* surf = TTF_RenderGlyph_Solid(f->font, c, white);
+			//a glyph without pixels has no surface.
+			if(surf) {
+				//FreeType may report a bitmap wider than the glyph. SDL_ttf ignores the rest.
+				g.w = MIN(MIN(surf->w, g.maxx - g.minx), ATLAS_WIDTH);
+				g.h = surf->h;
+				storeBitmap(f, g, surf);
+				SDL_FreeSurface(surf);
+			}
+		}
+		g.loaded = true;
+		return &g;
+	}
+
+	//returns false for byte order marks, which only change the byte order
+	//of the rest of the string.
+	static inline bool charCode(char c, bool&, Uint16& code) {
+		code = (byte)c;
+		return true;
+	}
+	static inline bool charCode(Uint16 c, bool& swapped, Uint16& code) {
+		if(c == UNICODE_BOM_NATIVE) {
+			swapped = false;
+			return false;
+		}
+		if(c == UNICODE_BOM_SWAPPED) {
+			swapped = true;
+			return false;
+		}
+		code = swapped ? SDL_Swap16(c) : c;
+		return true;
+	}
+
+	//fills sLayout and returns the width of the text, or -1 on failure.
+	template<class Tchar> static int layout(FontGlyphs* f, const Tchar* str) {
+		sLayout.clear();
+		bool swapped = false;
+		int x = 0, minx = 0, maxx = 0;
+		for(const Tchar* p = str; *p; p++) {
+			Uint16 c;
+			if(!charCode(*p, swapped, c))
+				continue;
+			const Glyph* g = getGlyph(f, c);
+			if(!g)
+				return -1;
+			//SDL_ttf moves the text right if the first glyph extends to the left.
+			if(p == str && g->minx < 0)
+				x -= g->minx;
+			minx = MIN(minx, x + g->minx);
+			maxx = MAX(maxx, x + MAX(g->advance, g->maxx));
+			PlacedGlyph pg = { g, x };
+			sLayout.push_back(pg);
+			x += g->advance;
+		}
+		return maxx - minx;
+	}
+
+	template<class Tchar> static bool size(TTF_Font* font, const Tchar* str, int* w, int* h) {
+		FontGlyphs* f = getFont(font);
+		int width = layout(f, str);
+		if(width < 0)
+			return false;
+		*w = width;
+		*h = f->height;
+		return true;
+	}
+
+	bool GlyphCacheSize(TTF_Font* font, const char* str, int* w, int* h) {
+		return size(font, str, w, h);
+	}
+	bool GlyphCacheSize(TTF_Font* font, const Uint16* str, int* w, int* h) {
+		return size(font, str, w, h);
+	}
+
+	template<class T> static inline void plot(byte* p, Uint32 pixel) {
+		*(T*)p = (T)pixel;
+	}
+	static inline void plot24(byte* p, Uint32 pixel) {
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+		p[0] = (byte)pixel;
+		p[1] = (byte)(pixel >> 8);
+		p[2] = (byte)(pixel >> 16);
+#else
+		p[0] = (byte)(pixel >> 16);
+		p[1] = (byte)(pixel >> 8);
+		p[2] = (byte)pixel;
+#endif
+	}
+
+	//draws the glyphs of sLayout, clipped to the text's box and to \a clip.
+	template<int BPP, void PLOT(byte*, Uint32)>
+	static void drawGlyphs(const FontGlyphs* f, SDL_Surface* dst, int left, int top,
+		const SDL_Rect& clip, Uint32 pixel)
+	{
+		for(size_t i=0; i<sLayout.size(); i++) {
+			const Glyph* g = sLayout[i].glyph;
+			if(g->w == 0)
+				continue;
+			int gx = left + sLayout[i].x + g->minx;
+			int gy = top + f->ascent - g->maxy;
+			int x0 = MAX(gx, (int)clip.x);
+			int y0 = MAX(gy, (int)clip.y);
+			int x1 = MIN(gx + g->w, clip.x + clip.w);
+			int y1 = MIN(gy + g->h, clip.y + clip.h);
+			if(x0 >= x1 || y0 >= y1)
+				continue;
+			const byte* src = &f->atlas[(g->y + y0 - gy) * ATLAS_WIDTH + g->x + x0 - gx];
+			byte* dstRow = (byte*)dst->pixels + y0 * dst->pitch + x0 * BPP;
+			for(int y=y0; y<y1; y++) {
+				for(int x=0; x<x1-x0; x++) {
+					if(src[x])
+						PLOT(dstRow + x * BPP, pixel);
+				}
+				src += ATLAS_WIDTH;
+				dstRow += dst->pitch;
+			}
+		}
+	}
+
+	template<class Tchar> static bool draw(TTF_Font* font, SDL_Surface* dst, int left, int top,
+		const Tchar* str, SDL_Color color, int* w, int* h)
+	{
+		FontGlyphs* f = getFont(font);
+		int width = layout(f, str);
+		//TTF_Render*_Solid() fails on text without width.
+		if(width <= 0)
+			return false;
+		*w = width;
+		*h = f->height;
+
+		//the box that the Solid surface would have covered.
+		SDL_Rect clip;
+		clip.x = MAX(left, (int)dst->clip_rect.x);
+		clip.y = MAX(top, (int)dst->clip_rect.y);
+		int right = MIN(left + width, dst->clip_rect.x + dst->clip_rect.w);
+		int bottom = MIN(top + f->height, dst->clip_rect.y + dst->clip_rect.h);
+		if(clip.x >= right || clip.y >= bottom)
+			return true;
+		clip.w = right - clip.x;
+		clip.h = bottom - clip.y;
+
+		Uint32 pixel = SDL_MapRGB(dst->format, color.r, color.g, color.b);
+		if(SDL_MUSTLOCK(dst) && SDL_LockSurface(dst) < 0)
+			return false;
+		switch(dst->format->BytesPerPixel) {
+		case 1: drawGlyphs<1, plot<Uint8> >(f, dst, left, top, clip, pixel); break;
+		case 2: drawGlyphs<2, plot<Uint16> >(f, dst, left, top, clip, pixel); break;
+		case 3: drawGlyphs<3, plot24>(f, dst, left, top, clip, pixel); break;
+		case 4: drawGlyphs<4, plot<Uint32> >(f, dst, left, top, clip, pixel); break;
+		}
+		if(SDL_MUSTLOCK(dst))
+			SDL_UnlockSurface(dst);
+		return true;
+	}
+
+	bool GlyphCacheDraw(TTF_Font* font, SDL_Surface* dst, int left, int top,
+		const char* str, SDL_Color color, int* w, int* h)
+	{
+		return draw(font, dst, left, top, str, color, w, h);
+	}
+	bool GlyphCacheDraw(TTF_Font* font, SDL_Surface* dst, int left, int top,
+		const Uint16* str, SDL_Color color, int* w, int* h)
+	{
+		return draw(font, dst, left, top, str, color, w, h);
+	}
+
+	void GlyphCacheClear() {
+		for(FontMap::iterator itr = sFonts.begin(); itr != sFonts.end(); itr++) {
+			clearGlyphs(itr->second);
+			delete itr->second;
+		}
+		sFonts.clear();
+		sLastFont = NULL;
+	}
+}
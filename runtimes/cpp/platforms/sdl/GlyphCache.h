@@ -0,0 +1,48 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#ifndef _SDL_GLYPH_CACHE_H_
+#define _SDL_GLYPH_CACHE_H_
+
+#include <SDL/SDL.h>
+#include <SDL/SDL_ttf.h>
+
+namespace Base {
+
+	// Cache of rasterised glyphs and their metrics, per font, so that text
+	// can be measured and drawn without rendering every string with SDL_ttf.
+	// The results are the same as those of TTF_Size*() and of blitting the
+	// surface from TTF_Render*_Solid(). Main thread only.
+
+	// Like TTF_SizeText(). The string is Latin-1. Returns false on failure.
+	bool GlyphCacheSize(TTF_Font* font, const char* str, int* w, int* h);
+	// Like TTF_SizeUNICODE().
+	bool GlyphCacheSize(TTF_Font* font, const Uint16* str, int* w, int* h);
+
+	// Draws \a str onto \a dst, with its top left corner at \a left, \a top,
+	// clipped to the clip rect of \a dst. Stores the size of the text,
+	// unclipped, in \a w and \a h. Returns false on failure.
+	bool GlyphCacheDraw(TTF_Font* font, SDL_Surface* dst, int left, int top,
+		const char* str, SDL_Color color, int* w, int* h);
+	bool GlyphCacheDraw(TTF_Font* font, SDL_Surface* dst, int left, int top,
+		const Uint16* str, SDL_Color color, int* w, int* h);
+
+	// Forgets all glyphs. Call before a cached font is closed.
+	void GlyphCacheClear();
+}
+
+#endif	//_SDL_GLYPH_CACHE_H_
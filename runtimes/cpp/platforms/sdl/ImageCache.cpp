@@ -0,0 +1,293 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+// Each cached image is a file in the cache directory, named after the hash of
+// its key. The file is a CacheHeader followed by the rows of pixels, without
+// padding. Cached files are mapped, not read, when loaded.
+//
+// The modification time of a file is its last use. It is updated on every hit,
+// so that the least recently used entries can be found by the next run, too.
+//
+// The cache is per program, like its stores, because the size limit is only
+// kept within one process.
+
+#include "config_platform.h"
+
+#include <string>
+#include <map>
+#include <stdio.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef WIN32
+#include <sys/utime.h>
+#include <process.h>
+#define getpid _getpid
+#else
+#include <utime.h>
+#include <unistd.h>
+#endif
+
+#include <helpers/helpers.h>
+#include <helpers/mkdir.h>
+#include <filelist/filelist.h>
+
+#include "MappedFile.h"
+#include "ImageCache.h"
+
+#define IMAGE_CACHE_PATH "imagecache/"
+#define IMAGE_CACHE_MAGIC 0x4943414d	//"MACI"
+#define IMAGE_CACHE_VERSION 1
+
+namespace Base {
+
+	struct CacheHeader {
+		int magic;
+		int version;
+		int encodedSize;
+		int width, height;
+		int bytesPerPixel;
+		Uint32 rmask, gmask, bmask, amask;
+	};
+
+	struct CacheEntry {
+		int size;
+		time_t lastUse;
+	};
+
+	typedef std::map<std::string, CacheEntry> CacheMap;
+	static CacheMap sEntries;
+	static bool sEnabled = false;
+	static unsigned sMaxBytes = 0;
+	static unsigned sBytes = 0;
+	//ends with a slash.
+	static std::string sDir;
+
+	//the format that SDL_DisplayFormatAlpha() converts to.
+	static int sBytesPerPixel;
+	static Uint32 sRmask, sGmask, sBmask, sAmask;
+
+	//FNV-1a
+	static void hash(unsigned long long& h, const void* data, int size) {
+		const byte* p = (const byte*)data;
+		for(int i=0; i<size; i++) {
+			h ^= p[i];
+			h *= 0x100000001b3ULL;
+		}
+	}
+
+	static std::string entryName(const void* data, int size) {
+		unsigned long long h = 0xcbf29ce484222325ULL;
+		Uint32 format[] = { (Uint32)sBytesPerPixel, sRmask, sGmask, sBmask, sAmask, IMAGE_CACHE_VERSION };
+		hash(h, format, sizeof(format));
+		hash(h, data, size);
+		char name[32];
+		sprintf(name, "%08x%08x.img", (Uint32)(h >> 32), (Uint32)h);
+		return name;
+	}
+
+	static void removeEntry(CacheMap::iterator itr) {
+		std::string path = sDir + itr->first;
+		remove(path.c_str());
+		sBytes -= itr->second.size;
+		sEntries.erase(itr);
+	}
+
+	//removes the least recently used entries, except \a keep, until the cache fits.
+	static void evict(const std::string& keep) {
+		while(sBytes > sMaxBytes) {
+			CacheMap::iterator oldest = sEntries.end();
+			for(CacheMap::iterator itr = sEntries.begin(); itr != sEntries.end(); itr++) {
+				if(itr->first == keep)
+					continue;
+				if(oldest == sEntries.end() || itr->second.lastUse < oldest->second.lastUse)
+					oldest = itr;
+			}
+			if(oldest == sEntries.end())
+				break;
+			removeEntry(oldest);
+		}
+	}
+
+	static void scanCallback(const char* filename) {
+		std::string path = sDir + filename;
+		struct stat s;
+		if(stat(path.c_str(), &s) != 0)
+			return;
+		CacheEntry e;
+		e.size = (int)s.st_size;
+		e.lastUse = s.st_mtime;
+		sEntries[filename] = e;
+		sBytes += e.size;
+	}
+
+	//creates every directory in \a path, which ends with a slash.
+	static bool makeDirs(const std::string& path) {
+		for(size_t i=1; i<path.size(); i++) {
+			if(path[i] == '/' || path[i] == '\\')
+				_mkdir(path.substr(0, i).c_str());
+		}
+		struct stat s;
+		return stat(path.substr(0, path.size() - 1).c_str(), &s) == 0 && (s.st_mode & S_IFDIR);
+	}
+
+	void ImageCacheInit(unsigned maxBytes, const char* dir) {
+		if(maxBytes == 0)
+			return;
+
+		sDir = dir && dir[0] ? dir : IMAGE_CACHE_PATH;
+		char last = sDir[sDir.size() - 1];
+		if(last != '/' && last != '\\')
+			sDir += '/';
+		if(!makeDirs(sDir)) {
+			LOG("ImageCache: can't create %s\n", sDir.c_str());
+			return;
+		}
+
+		SDL_Surface* probe = SDL_CreateRGBSurface(SDL_SWSURFACE, 1, 1, 32,
+			0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+		if(!probe)
+			return;
+		SDL_Surface* display = SDL_DisplayFormatAlpha(probe);
+		SDL_FreeSurface(probe);
+		if(!display) {
+			LOG("ImageCache: no display format. %s\n", SDL_GetError());
+			return;
+		}
+		sBytesPerPixel = display->format->BytesPerPixel;
+		sRmask = display->format->Rmask;
+		sGmask = display->format->Gmask;
+		sBmask = display->format->Bmask;
+		sAmask = display->format->Amask;
+		SDL_FreeSurface(display);
+
+		sEntries.clear();
+		sBytes = 0;
+		scanDirectory((sDir + "*.img").c_str(), scanCallback);
+		sMaxBytes = maxBytes;
+		sEnabled = true;
+		evict(std::string());
+		LOG("ImageCache: %s, %i entries, %u of %u bytes\n", sDir.c_str(),
+			(int)sEntries.size(), sBytes, sMaxBytes);
+	}
+
+	SDL_Surface* ImageCacheLoad(const void* data, int size) {
+		if(!sEnabled)
+			return NULL;
+		std::string name = entryName(data, size);
+		CacheMap::iterator itr = sEntries.find(name);
+		if(itr == sEntries.end())
+			return NULL;
+
+		std::string path = sDir + name;
+		MappedFile file(path.c_str());
+		const CacheHeader* h = (const CacheHeader*)file.data();
+		if(!file.isOpen() || file.size() < (int)sizeof(CacheHeader) ||
+			h->magic != IMAGE_CACHE_MAGIC || h->version != IMAGE_CACHE_VERSION ||
+			h->encodedSize != size || h->bytesPerPixel != sBytesPerPixel ||
+			h->rmask != sRmask || h->gmask != sGmask || h->bmask != sBmask || h->amask != sAmask ||
+			h->width <= 0 || h->height <= 0 ||
+			file.size() != (int)sizeof(CacheHeader) + h->width * h->height * sBytesPerPixel)
+		{
+			LOG("ImageCache: bad entry %s\n", name.c_str());
+			removeEntry(itr);
+			return NULL;
+		}
+
+		SDL_Surface* surf = SDL_CreateRGBSurface(SDL_SWSURFACE, h->width, h->height,
+			sBytesPerPixel * 8, sRmask, sGmask, sBmask, sAmask);
+		if(!surf)
+			return NULL;
+		int rowSize = h->width * sBytesPerPixel;
+		const char* src = file.data() + sizeof(CacheHeader);
+		char* dst = (char*)surf->pixels;
+		for(int y=0; y<h->height; y++) {
+			memcpy(dst, src, rowSize);
+			src += rowSize;
+			dst += surf->pitch;
+		}
+
+		itr->second.lastUse = time(NULL);
+		utime(path.c_str(), NULL);
+		return surf;
+	}
+
+	void ImageCacheStore(const void* data, int size, SDL_Surface* surf) {
+		if(!sEnabled)
+			return;
+		const SDL_PixelFormat* f = surf->format;
+		if(f->BytesPerPixel != sBytesPerPixel || f->Rmask != sRmask || f->Gmask != sGmask ||
+			f->Bmask != sBmask || f->Amask != sAmask)
+		{
+			return;
+		}
+		int rowSize = surf->w * sBytesPerPixel;
+		int total = sizeof(CacheHeader) + rowSize * surf->h;
+		if((unsigned)total > sMaxBytes)
+			return;
+		std::string name = entryName(data, size);
+		if(sEntries.find(name) != sEntries.end())
+			return;
+
+		//written to a temporary file first, so that a crash never leaves half an entry.
+		//the pid keeps it apart from the temporary file of another program that
+		//uses the same directory.
+		std::string path = sDir + name;
+		char suffix[32];
+		sprintf(suffix, ".%i.tmp", (int)getpid());
+		std::string temp = path + suffix;
+		FILE* file = fopen(temp.c_str(), "wb");
+		if(!file)
+			return;
+		CacheHeader h;
+		h.magic = IMAGE_CACHE_MAGIC;
+		h.version = IMAGE_CACHE_VERSION;
+		h.encodedSize = size;
+		h.width = surf->w;
+		h.height = surf->h;
+		h.bytesPerPixel = sBytesPerPixel;
+		h.rmask = sRmask;
+		h.gmask = sGmask;
+		h.bmask = sBmask;
+		h.amask = sAmask;
+		bool ok = fwrite(&h, sizeof(h), 1, file) == 1;
+		if(SDL_MUSTLOCK(surf))
+			SDL_LockSurface(surf);
+		const char* src = (const char*)surf->pixels;
+		for(int y=0; ok && y<surf->h; y++) {
+			ok = fwrite(src, rowSize, 1, file) == 1;
+			src += surf->pitch;
+		}
+		if(SDL_MUSTLOCK(surf))
+			SDL_UnlockSurface(surf);
+		if(fclose(file) != 0)
+			ok = false;
+		//rename() doesn't replace existing files on Windows.
+		remove(path.c_str());
+		if(!ok || rename(temp.c_str(), path.c_str()) != 0) {
+			remove(temp.c_str());
+			return;
+		}
+
+		CacheEntry e;
+		e.size = total;
+		e.lastUse = time(NULL);
+		sEntries[name] = e;
+		sBytes += total;
+		evict(name);
+	}
+}
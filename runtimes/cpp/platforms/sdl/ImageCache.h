@@ -0,0 +1,44 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#ifndef _SDL_IMAGE_CACHE_H_
+#define _SDL_IMAGE_CACHE_H_
+
+#include <SDL/SDL.h>
+
+namespace Base {
+
+	// On-disk cache of decoded images, so that images that were decoded
+	// by an earlier run of the program don't have to be decoded again.
+	// Entries are keyed by a hash of the encoded bytes and the display format.
+	// Main thread only.
+
+	// Enables the cache, if maxBytes is not zero. Call after the screen is set up.
+	// The cache is kept in \a dir, which is created if needed. If \a dir is NULL,
+	// it is kept in IMAGE_CACHE_PATH, in the working directory, next to the stores.
+	void ImageCacheInit(unsigned maxBytes, const char* dir);
+
+	// Returns a surface in the display format, or NULL if the image isn't cached.
+	SDL_Surface* ImageCacheLoad(const void* data, int size);
+
+	// Stores \a surf, which must be in the display format, as the decoded
+	// version of \a data. Entries that haven't been used for the longest time
+	// are removed to keep the cache within its size limit.
+	void ImageCacheStore(const void* data, int size, SDL_Surface* surf);
+}
+
+#endif	//_SDL_IMAGE_CACHE_H_
@@ -0,0 +1,283 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+// Background decoding for maCreateImageFromDataAsync().
+//
+// The VM thread copies the encoded data and queues a job. Worker threads
+// decode PNG/JPEG into a plain SDL surface. The finished job is handed back
+// to the main thread with an FE_IMAGE_DECODED event, where the surface is
+// converted to the display format (SDL video calls are not thread-safe),
+// stored in the placeholder and reported with EVENT_TYPE_IMAGE_DECODED.
+//
+// While a job is in progress, its placeholder is RT_FLUX, like the data
+// objects of maConnReadToData().
+
+#include "config_platform.h"
+
+#include <SDL/SDL_image.h>
+
+#include <deque>
+#include <map>
+#include <vector>
+
+#include <helpers/helpers.h>
+#include <MemStream.h>
+
+#include "Syscall.h"
+#include "ThreadPoolImpl.h"
+
+#include "fastevents.h"
+#include "sdl_syscall.h"
+#include "sdl_stream.h"
+#include "ImageCache.h"
+
+#define DEFAULT_CONCURRENCY 2
+
+namespace Base {
+
+	struct DecodeJob {
+		MAHandle placeholder;
+		MemStream* data;
+		SDL_Surface* surface;
+		int result;
+		//set by maCancelImageDecode() while the job is being decoded.
+		//only accessed by the main thread.
+		bool cancelled;
+	};
+
+	//main thread only. Every job that hasn't been finished or cancelled.
+	typedef std::map<MAHandle, DecodeJob*> JobMap;
+	static JobMap sJobs;
+
+	//the rest is protected by sMutex.
+	static SDL_mutex* sMutex = NULL;
+	static SDL_cond* sCond = NULL;
+	static std::deque<DecodeJob*> sQueue;
+	static std::vector<MoSyncThread*> sThreads;
+	static int sRunning = 0;
+	static int sMax = DEFAULT_CONCURRENCY;
+	static bool sQuit = false;
+
+	static void decode(DecodeJob* job) {
+		SDL_RWops* rwops = SDL_RWFromStream(job->data);
+		if(!rwops) {
+			job->result = RES_OUT_OF_MEMORY;
+			return;
+		}
+		job->surface = IMG_LoadPNG_RW(rwops);
+		if(!job->surface)
+			job->surface = IMG_LoadJPG_RW(rwops);
+		SDL_FreeRW(rwops);
+		job->result = job->surface ? RES_OK : RES_BAD_INPUT;
+	}
+
+	static int SDLCALL decodeThread(void*) {
+		SDL_mutexP(sMutex);
+		while(true) {
+			while(!sQuit && (sQueue.empty() || sRunning >= sMax)) {
+				SDL_CondWait(sCond, sMutex);
+			}
+			if(sQuit)
+				break;
+			DecodeJob* job = sQueue.front();
+			sQueue.pop_front();
+			sRunning++;
+			SDL_mutexV(sMutex);
+
+			decode(job);
+			SDL_UserEvent event = { FE_IMAGE_DECODED, 0, job, NULL };
+			FE_PushEvent((SDL_Event*)&event);
+
+			SDL_mutexP(sMutex);
+			sRunning--;
+			//a waiting job may have been held back by the limit.
+			SDL_CondSignal(sCond);
+		}
+		SDL_mutexV(sMutex);
+		return 0;
+	}
+
+	//call with sMutex locked.
+	static void startThreads() {
+		while((int)sThreads.size() < sMax) {
+			MoSyncThread* t = new MoSyncThread;
+			t->start(decodeThread, NULL);
+			sThreads.push_back(t);
+		}
+	}
+
+	static void deleteJob(DecodeJob* job) {
+		delete job->data;
+		if(job->surface)
+			SDL_FreeSurface(job->surface);
+		delete job;
+	}
+
+	int maCreateImageFromDataAsync(MAHandle placeholder, MAHandle data, int offset, int size) {
+		MYASSERT(size > 0, ERR_DATA_OOB);
+		Stream* src = SYSCALL_THIS->resources.get_RT_BINARY(data);
+		MYASSERT(src->seek(Seek::Start, offset), ERR_DATA_OOB);
+
+		//the application may change or destroy the data object right away.
+		MemStream* copy = new MemStream(size);
+		if(!src->read(copy->ptr(), size)) {
+			delete copy;
+			BIG_PHAT_ERROR(ERR_DATA_OOB);
+		}
+
+		//a cached image needs no worker.
+		SDL_Surface* cached = ImageCacheLoad(copy->ptr(), size);
+		if(cached) {
+			delete copy;
+			MAEvent event;
+			event.type = EVENT_TYPE_IMAGE_DECODED;
+			event.imagePlaceholder = placeholder;
+			event.imageDecodeResult = SYSCALL_THIS->resources.add_RT_IMAGE(placeholder, cached);
+			MAPostEvent(event);
+			return RES_OK;
+		}
+
+		int res = SYSCALL_THIS->resources.add_RT_FLUX(placeholder, NULL);
+		if(res != RES_OK) {
+			delete copy;
+			return res;
+		}
+
+		DecodeJob* job = new DecodeJob;
+		job->placeholder = placeholder;
+		job->data = copy;
+		job->surface = NULL;
+		job->result = RES_OK;
+		job->cancelled = false;
+		sJobs[placeholder] = job;
+
+		if(!sMutex) {
+			sMutex = SDL_CreateMutex();
+			sCond = SDL_CreateCond();
+			MYASSERT(sMutex && sCond, ERR_OOM);
+		}
+		SDL_mutexP(sMutex);
+		startThreads();
+		sQueue.push_back(job);
+		SDL_CondSignal(sCond);
+		SDL_mutexV(sMutex);
+		return RES_OK;
+	}
+
+	int maCancelImageDecode(MAHandle placeholder) {
+		JobMap::iterator itr = sJobs.find(placeholder);
+		if(itr == sJobs.end())
+			return 0;
+		DecodeJob* job = itr->second;
+		sJobs.erase(itr);
+		SYSCALL_THIS->resources.extract_RT_FLUX(placeholder);
+
+		bool queued = false;
+		SDL_mutexP(sMutex);
+		for(std::deque<DecodeJob*>::iterator q = sQueue.begin(); q != sQueue.end(); q++) {
+			if(*q == job) {
+				sQueue.erase(q);
+				queued = true;
+				break;
+			}
+		}
+		SDL_mutexV(sMutex);
+
+		if(queued) {
+			deleteJob(job);
+		} else {
+			//a worker has it. MAImageDecodeFinish() will throw the result away.
+			job->cancelled = true;
+		}
+		return 1;
+	}
+
+	int maSetImageDecodeConcurrency(int max) {
+		MYASSERT(max >= 1 && max <= IMAGE_DECODE_MAX_CONCURRENCY, ERR_IMAGE_DECODE_CONCURRENCY);
+		int old = sMax;
+		if(!sMutex) {
+			sMax = max;
+			return old;
+		}
+		SDL_mutexP(sMutex);
+		sMax = max;
+		if(!sQueue.empty())
+			startThreads();
+		//extra threads stay, but sit idle while sRunning >= sMax.
+		SDL_CondBroadcast(sCond);
+		SDL_mutexV(sMutex);
+		return old;
+	}
+
+	void MAImageDecodeFinish(void* data) {
+		DecodeJob* job = (DecodeJob*)data;
+		if(job->cancelled) {
+			deleteJob(job);
+			return;
+		}
+		sJobs.erase(job->placeholder);
+		SYSCALL_THIS->resources.extract_RT_FLUX(job->placeholder);
+
+		int result = job->result;
+		if(job->surface) {
+			SDL_Surface* surf = SDL_DisplayFormatAlpha(job->surface);
+			if(surf) {
+				int size;
+				job->data->length(size);
+				ImageCacheStore(job->data->ptr(), size, surf);
+				result = SYSCALL_THIS->resources.add_RT_IMAGE(job->placeholder, surf);
+			} else {
+				result = RES_OUT_OF_MEMORY;
+			}
+		}
+
+		MAEvent event;
+		event.type = EVENT_TYPE_IMAGE_DECODED;
+		event.imagePlaceholder = job->placeholder;
+		event.imageDecodeResult = result;
+		MAPostEvent(event);
+		deleteJob(job);
+	}
+
+	//Stops the workers and forgets all jobs, for reload and exit.
+	//Finished jobs still in the SDL event queue are deleted when they arrive.
+	void MAImageDecodeClose() {
+		if(!sMutex)
+			return;
+		SDL_mutexP(sMutex);
+		sQuit = true;
+		SDL_CondBroadcast(sCond);
+		SDL_mutexV(sMutex);
+		for(size_t i=0; i<sThreads.size(); i++) {
+			sThreads[i]->join();
+			delete sThreads[i];
+		}
+		sThreads.clear();
+
+		for(size_t i=0; i<sQueue.size(); i++) {
+			sJobs.erase(sQueue[i]->placeholder);
+			deleteJob(sQueue[i]);
+		}
+		sQueue.clear();
+		for(JobMap::iterator itr = sJobs.begin(); itr != sJobs.end(); itr++) {
+			itr->second->cancelled = true;
+		}
+		sJobs.clear();
+		sRunning = 0;
+		sQuit = false;
+	}
+}
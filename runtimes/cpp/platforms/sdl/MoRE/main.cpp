@@ -141,6 +141,8 @@ int main2(int argc, char **argv) {
 				"  -model <string>                        set model. Used to choose skin.\n"
 				"  -sld <filename:string>                 load sld-file.\n"
 				"  -resmem <bytes:integer>                set resource memory limit.\n"
+				"  -imagecache <bytes:integer>            cache decoded images on disk, up to the given size.\n"
+				"  -imagecachedir <path:string>           directory of the image cache (default: imagecache/ in the working directory).\n"
 				"  -gdb                                   start gdb stub.\n"
 				"  -x <filename:string>                   load extension config file.\n"
 #ifdef EMULATOR
@@ -240,6 +242,20 @@ int main2(int argc, char **argv) {
 				return 1;
 			}
 			settings.resmem = atoi(argv[i]);
+		} else if(strcmp(argv[i], "-imagecache")==0) {
+			i++;
+			if(i>=argc) {
+				LOG("not enough parameters for -imagecache");
+				return 1;
+			}
+			settings.imageCache = atoi(argv[i]);
+		} else if(strcmp(argv[i], "-imagecachedir")==0) {
+			i++;
+			if(i>=argc) {
+				LOG("not enough parameters for -imagecachedir");
+				return 1;
+			}
+			settings.imageCacheDir = argv[i];
 		} else if(strcmp(argv[i], "-x")==0) {
 			i++;
 			if(i>=argc) {
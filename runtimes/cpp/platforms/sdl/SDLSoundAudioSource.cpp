@@ -107,7 +107,11 @@ int SDLSoundAudioSource::fillBuffer()
 			//LOG("%s\n", Sound_GetError());
 			//BIG_PHAT_ERROR(SDLERR_SOUND_LOOP_FAILED);
 			// rewind failed.
+			return 0;
 		}
+
+		// start the next loop straight away; returning 0 would end playback.
+		return Sound_Decode(sample) / ((info.bitDepth>>3)*info.numChannels);
 	}
 
 	return 0;
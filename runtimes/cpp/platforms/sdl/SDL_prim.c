@@ -520,9 +520,13 @@ void SDL_drawCircle_TG( SDL_Surface *surf, int x1, int y1, int r, Uint32 clr,
 void SDL_drawTriangle_TG(SDL_Surface *surf, int x1, int y1, int x2, int y2,
 						 int x3, int y3, Uint32 clr, Uint8 alpha, Uint8 flags)
 {
-	int x, y, c, xlen, ylen, i, aaoffset;
+	int x, y, c, xlen, ylen, i, aaoffset, ylo, yhi;
 	float a1, b1, a2, b2, slopea, slopeb, aa, aastep, pb1, pb2;
 	float slope1, slope2, slope3;
+	int clipLeft = surf->clip_rect.x;
+	int clipTop = surf->clip_rect.y;
+	int clipRight = clipLeft + surf->clip_rect.w;
+	int clipBottom = clipTop + surf->clip_rect.h;
 
 	/* avoid compiler warnings... */
 	aa = 0.0;
@@ -667,12 +671,24 @@ void SDL_drawTriangle_TG(SDL_Surface *surf, int x1, int y1, int x2, int y2,
 				/* Explicit cast now - tdd */
 				for (x = (int) a1; x <= a2; x++) {
 					if (flags & SDL_TG_FILL) {
-						c = ((int)b1 < (int)b2) ? 1 : -1;
-						for (y = (int)b1; (c > 0 ? y <= (int)b2 : y >= (int)b2); y += c) {
-							if (alpha < 255)
-								SDL_blendPixel(surf, x, y, clr, alpha);
-							else
-								SDL_putPixel(surf, x, y, clr);
+						/*
+						* only the rows and columns inside the clip rect are
+						* visited. The edges are still stepped on every column,
+						* so the pixels are the same as without clipping.
+						*/
+						if (x >= clipLeft && x < clipRight) {
+							ylo = (int)b1 < (int)b2 ? (int)b1 : (int)b2;
+							yhi = (int)b1 < (int)b2 ? (int)b2 : (int)b1;
+							if (ylo < clipTop)
+								ylo = clipTop;
+							if (yhi >= clipBottom)
+								yhi = clipBottom - 1;
+							for (y = ylo; y <= yhi; y++) {
+								if (alpha < 255)
+									SDL_blendPixel(surf, x, y, clr, alpha);
+								else
+									SDL_putPixel(surf, x, y, clr);
+							}
 						}
 						if (flags & SDL_TG_ANTIALIAS) {
 							__TRI_FILL_AA(pb1, b1, b2, slopea)
@@ -0,0 +1,107 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#include "config_platform.h"
+
+#include <helpers/helpers.h>
+
+#include "ScreenDamage.h"
+
+namespace Base {
+
+	static int area(const SDL_Rect& r) {
+		return r.w * r.h;
+	}
+
+	static SDL_Rect unite(const SDL_Rect& a, const SDL_Rect& b) {
+		int x = MIN(a.x, b.x);
+		int y = MIN(a.y, b.y);
+		SDL_Rect r = { (Sint16)x, (Sint16)y,
+			(Uint16)(MAX(a.x + a.w, b.x + b.w) - x),
+			(Uint16)(MAX(a.y + a.h, b.y + b.h) - y) };
+		return r;
+	}
+
+	ScreenDamage::ScreenDamage() : mCount(0), mWidth(0), mHeight(0) {
+	}
+
+	void ScreenDamage::setBounds(int width, int height) {
+		if(width == mWidth && height == mHeight)
+			return;
+		mWidth = width;
+		mHeight = height;
+		addAll();
+	}
+
+	void ScreenDamage::add(int x, int y, int w, int h) {
+		int right = MIN(x + w, mWidth);
+		int bottom = MIN(y + h, mHeight);
+		x = MAX(x, 0);
+		y = MAX(y, 0);
+		if(x >= right || y >= bottom)
+			return;
+		SDL_Rect r = { (Sint16)x, (Sint16)y, (Uint16)(right - x), (Uint16)(bottom - y) };
+		insert(r);
+	}
+
+	void ScreenDamage::addAll() {
+		mCount = 0;
+		if(mWidth > 0 && mHeight > 0) {
+			SDL_Rect r = { 0, 0, (Uint16)mWidth, (Uint16)mHeight };
+			mRects[mCount++] = r;
+		}
+	}
+
+	void ScreenDamage::clear() {
+		mCount = 0;
+	}
+
+	void ScreenDamage::remove(int i) {
+		mRects[i] = mRects[--mCount];
+	}
+
+	void ScreenDamage::insert(SDL_Rect r) {
+		//merging may make the rectangle overlap others, so start over after each merge.
+		for(int i=0; i<mCount; ) {
+			SDL_Rect u = unite(mRects[i], r);
+			if(area(u) == area(mRects[i]))
+				return;
+			if(area(u) <= area(mRects[i]) + area(r)) {
+				remove(i);
+				r = u;
+				i = 0;
+			} else {
+				i++;
+			}
+		}
+		if(mCount < SCREEN_DAMAGE_MAX_RECTS) {
+			mRects[mCount++] = r;
+			return;
+		}
+		int best = 0, bestGrowth = 0;
+		for(int i=0; i<mCount; i++) {
+			int growth = area(unite(mRects[i], r)) - area(mRects[i]);
+			if(i == 0 || growth < bestGrowth) {
+				best = i;
+				bestGrowth = growth;
+			}
+		}
+		r = unite(mRects[best], r);
+		remove(best);
+		insert(r);
+	}
+}
@@ -0,0 +1,56 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#ifndef _SDL_SCREEN_DAMAGE_H_
+#define _SDL_SCREEN_DAMAGE_H_
+
+#include <SDL/SDL.h>
+
+#define SCREEN_DAMAGE_MAX_RECTS 16
+
+namespace Base {
+
+	// The parts of the back buffer that have changed since the screen was
+	// last updated, as a short list of rectangles. Rectangles that overlap or
+	// touch are merged, and when the list is full, new rectangles are merged
+	// into the one that grows the least. Main thread only.
+	class ScreenDamage {
+	public:
+		ScreenDamage();
+
+		// Sets the size of the screen. If it changed, all of it is damaged.
+		void setBounds(int width, int height);
+
+		// Adds a rectangle, which is clipped to the screen.
+		void add(int x, int y, int w, int h);
+		void addAll();
+		void clear();
+
+		int count() const { return mCount; }
+		const SDL_Rect* rects() const { return mRects; }
+
+	private:
+		void insert(SDL_Rect r);
+		void remove(int i);
+
+		SDL_Rect mRects[SCREEN_DAMAGE_MAX_RECTS];
+		int mCount;
+		int mWidth, mHeight;
+	};
+}
+
+#endif	//_SDL_SCREEN_DAMAGE_H_
@@ -23,6 +23,8 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 //#include <map>
 //#include <utility>
 
+#include <SDL/SDL.h>
+
 #include "DeviceProfile.h"
 
 namespace MoRE {
@@ -50,9 +52,15 @@ namespace MoRE {
 		virtual void drawDevice() const = 0;
 		virtual void drawScreen() const = 0;
 		/**
-		* If activated, draws two markers to simulate multi touch
+		* Like drawScreen(), but only copies the parts of the phone screen
+		* inside \a rects, which are in phone screen coordinates.
+		*/
+		virtual void drawScreenRects(const SDL_Rect* rects, int count) const = 0;
+		/**
+		* If activated, draws two markers to simulate multi touch.
+		* Returns true if the markers were drawn.
 		*/
-		virtual void drawMultiTouchSimulation() const = 0;
+		virtual bool drawMultiTouchSimulation() const = 0;
 		virtual void rotateCW() = 0;
 		virtual void rotateCCW() = 0;
 		virtual void mouseDragged(int x, int y) = 0;
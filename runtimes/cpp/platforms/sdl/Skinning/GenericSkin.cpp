@@ -24,6 +24,9 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 #define CONFIG_H
 #include "helpers/log.h"
 
+//the number of rectangles that drawScreenRects() updates at once.
+#define UPDATE_RECTS_BATCH 16
+
 namespace MoRE {
 	bool KeyRect::contains(int lx, int ly) {
 		if(lx>=this->x && lx<this->x+this->w && ly>=this->y && ly<this->y+this->h) return true;
@@ -262,9 +265,33 @@ namespace MoRE {
 		SDL_SetClipRect(getWindowSurface(), &clipRect);
 	}
 
-	void GenericSkin::drawMultiTouchSimulation() const
+	void GenericSkin::drawScreenRects(const SDL_Rect* rects, int count) const {
+		SDL_Rect clipRect;
+		SDL_GetClipRect(getWindowSurface(), &clipRect);
+		SDL_SetClipRect(getWindowSurface(), &windowRect);
+
+		SDL_Rect dstRects[UPDATE_RECTS_BATCH];
+		while(count > 0) {
+			int n = count < UPDATE_RECTS_BATCH ? count : UPDATE_RECTS_BATCH;
+			for(int i=0; i<n; i++) {
+				SDL_Rect src = rects[i];
+				dstRects[i].x = screenRect.x + src.x;
+				dstRects[i].y = screenRect.y + src.y;
+				if(SDL_BlitSurface(getPhoneScreen(), &src, getWindowSurface(), &dstRects[i]) != 0) {
+					LOG("ERROR BLITTING!!!!\n");
+				}
+			}
+			//the blit sets the destination rects to the clipped area.
+			SDL_UpdateRects(getWindowSurface(), n, dstRects);
+			rects += n;
+			count -= n;
+		}
+		SDL_SetClipRect(getWindowSurface(), &clipRect);
+	}
+
+	bool GenericSkin::drawMultiTouchSimulation() const
 	{
-		if( !mIsSimulatingMultiTouch ) return;
+		if( !mIsSimulatingMultiTouch ) return false;
 
 		SDL_Rect clipRect;
 		SDL_GetClipRect(getWindowSurface(), &clipRect);
@@ -293,6 +320,7 @@ namespace MoRE {
 											windowRect.w, windowRect.h);
 
 		SDL_SetClipRect(getWindowSurface(), &clipRect);
+		return true;
 	}
 
 	void GenericSkin::skinPhone(SDL_Surface* surface, SDL_Surface* keypad) const {
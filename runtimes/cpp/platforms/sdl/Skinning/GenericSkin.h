@@ -45,7 +45,8 @@ namespace MoRE {
 		int getWindowHeight() const;
 		void drawDevice() const;
 		void drawScreen() const;
-		void drawMultiTouchSimulation() const;
+		void drawScreenRects(const SDL_Rect* rects, int count) const;
+		bool drawMultiTouchSimulation() const;
 		void rotateCW();
 		void rotateCCW();
 		void mouseDragged(int x, int y);
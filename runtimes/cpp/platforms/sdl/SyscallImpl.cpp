@@ -52,7 +52,7 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 #include <limits.h>
 
 
-#include <helpers/fifo.h>
+#include <helpers/mpsc_fifo.h>
 #include <helpers/log.h>
 #include <helpers/helpers.h>
 #include <helpers/attribute.h>
@@ -89,6 +89,11 @@ extern "C" {
 #include "ConfigParser.h"
 #include "sdl_stream.h"
 #include "MoSyncDB.h"
+#include "ImageCache.h"
+#include "ThreadPool.h"
+#include "GlyphCache.h"
+#include "ScreenDamage.h"
+#include "ImageFilters.h"
 
 #include "Skinning/Screen.h"
 #include "Skinning/SkinManager.h"
@@ -122,6 +127,10 @@ namespace Base {
 
 	static SDL_Surface *gScreen = NULL, *gDrawSurface = NULL;
 	SDL_Surface *gBackBuffer = NULL;
+	//the runtime's own back buffer, while the application's is in use. See maFrameBufferInit().
+	static SDL_Surface *internalBackBuffer = NULL;
+	//the parts of gBackBuffer that haven't been shown yet.
+	static ScreenDamage sDamage;
 	static int gCurrentUnconvertedColor = 0, gCurrentConvertedColor = 0;
 	static TTF_Font *gFont = NULL;
 	static MAHandle gDrawTargetHandle = HANDLE_SCREEN;
@@ -130,12 +139,12 @@ namespace Base {
 	static MAPoint2dNative gCameraViewFinderPoint, gCameraViewFinderDirection;
 	static SDL_TimerID gCameraViewFinderTimer = NULL;
 
-	static CircularFifo<MAEvent, EVENT_BUFFER_SIZE> gEventFifo;
-	static bool gEventOverflow = false, gClosing = false;
+	//Written to by any thread, read only by the main thread. See MAPostEvent().
+	typedef MpscFifo<MAEvent, EVENT_BUFFER_SIZE> EventFifo;
+	static EventFifo gEventFifo;
+	static volatile long gEventsDropped = 0, gEventsCoalesced = 0;
+	static bool gClosing = false;
 
-	static SDL_TimerID gTimerId = NULL;
-	static int gTimerSequence;
-	static SDL_mutex* gTimerMutex = NULL;
 	static bool gShowScreen;
 
 	static SDL_TimerID gExitTimer = NULL;
@@ -239,12 +248,23 @@ namespace Base {
 		gSyscall->pimClose();
 #endif
 		MoSyncDBClose();
+		GlyphCacheClear();
 	}
 
 	//***************************************************************************
 	//Initialization
 	//***************************************************************************
 
+	//the glyph cache is keyed by font pointer, so it must forget a font before
+	//the font is closed; a new font may be given the same address.
+	static void closeFont() {
+		GlyphCacheClear();
+		if(gFont) {
+			TTF_CloseFont(gFont);
+			gFont = NULL;
+		}
+	}
+
 #ifdef MOBILEAUTHOR
 	//TODO: combine with MALibInit to avoid code duplication
 	bool MAMoSyncInit() {
@@ -261,8 +281,6 @@ namespace Base {
 		//TEST_NZ(FE_Init());
 		atexit(FE_Quit);
 
-		TEST_Z(gTimerMutex = SDL_CreateMutex());
-
 		TEST_NZ(TTF_Init());
 		atexit(TTF_Quit);
 
@@ -300,6 +318,7 @@ namespace Base {
 		strcpy(destDir, mosyncDir);
 		strcat(destDir, "/bin/unifont-5.1.20080907.ttf");
 
+		closeFont();
 		TEST_Z(gFont = TTF_OpenFont(destDir, 16));
 
 		return true;
@@ -370,6 +389,7 @@ namespace Base {
 
 		MoRE::setWindowSurface(gScreen);
 		MoRE::setPhoneScreen(gBackBuffer);
+		sDamage.addAll();
 		if(sSkin) {
 			sSkin->drawDevice();
 			sSkin->drawScreen();
@@ -403,8 +423,6 @@ namespace Base {
 		TEST_NZ(FE_Init());
 		atexit(FE_Quit);
 
-		TEST_Z(gTimerMutex = SDL_CreateMutex());
-
 		TEST_NZ(TTF_Init());
 		atexit(TTF_Quit);
 
@@ -459,11 +477,14 @@ namespace Base {
 
 		gDrawSurface = gBackBuffer;
 
+		ImageCacheInit(settings.imageCache, settings.imageCacheDir);
+
 		char destDir[256];
 		destDir[0] = 0;
 
 		strcpy(destDir, mosyncDir);
 		strcat(destDir, "/bin/unifont-5.1.20080907.ttf");
+		closeFont();
 		gFont = TTF_OpenFont(destDir, 16);
 
 #ifdef WIN32
@@ -501,9 +522,6 @@ namespace Base {
 
 		Bluetooth::MABtClose();
 
-		if(gTimerMutex)
-			SDL_DestroyMutex(gTimerMutex);
-
 		SDL_FreeSurface(gBackBuffer);
 
 #ifndef MOBILEAUTHOR
@@ -555,13 +573,18 @@ namespace Base {
 	SDL_Surface* Syscall::loadImage(MemStream& s) {
 		int size;
 		TEST(s.length(size));
+		SDL_Surface* surf = ImageCacheLoad(s.ptr(), size);
+		if(surf)
+			return surf;
 		SDL_RWops* rwops = SDL_RWFromConstMem(s.ptr(), size);
 		//SDL_Surface* surf = IMG_LoadPNG_RW(rwops);
 		//if(!surf) IMG_LoadJPG_RW(rwops);
-		SDL_Surface* surf = IMG_Load_RW(rwops, 0);
+		surf = IMG_Load_RW(rwops, 0);
 		MYASSERT(surf, SDLERR_IMAGE_LOAD_FAILED);
 		surf = SDL_DisplayFormatAlpha(surf);
 		SDL_FreeRW(rwops);
+		if(surf)
+			ImageCacheStore(s.ptr(), size, surf);
 
 		return surf;
 	}
@@ -583,6 +606,61 @@ namespace Base {
 		return surf;
 	}
 
+	//Decodes the images of an ATLAS resource into a single surface.
+	//The format is described in tools/pipe-tool/rescomp.c.
+	//draws the \a count images that follow in \a s on \a atlas.
+	static bool drawAtlasImages(MemStream& s, SDL_Surface* atlas, int count) {
+		int length;
+		TEST(s.length(length));
+		const char* data = (const char*)s.ptr();
+		for(int i=0; i<count; i++) {
+			ushort x, y;
+			int size, pos;
+			TEST(s.readUnsignedShort(x));
+			TEST(s.readUnsignedShort(y));
+			TEST(s.readUnsignedVarInt(size));
+			TEST(s.tell(pos));
+			MYASSERT(size > 0 && size <= length - pos, ERR_RES_FILE_INCONSISTENT);
+
+			SDL_RWops* rwops = SDL_RWFromConstMem(data + pos, size);
+			SDL_Surface* image = IMG_Load_RW(rwops, 0);
+			SDL_FreeRW(rwops);
+			MYASSERT(image, SDLERR_IMAGE_LOAD_FAILED);
+
+			//copy the alpha channel rather than blending with it.
+			SDL_SetAlpha(image, 0, 0);
+			SDL_Rect rect;
+			rect.x = x;
+			rect.y = y;
+			SDL_BlitSurface(image, NULL, atlas, &rect);
+			SDL_FreeSurface(image);
+			TEST(s.seek(Seek::Current, size));
+		}
+		return true;
+	}
+
+	SDL_Surface* Syscall::loadAtlas(MemStream& s) {
+		ushort width, height, count;
+		TEST(s.readUnsignedShort(width));
+		TEST(s.readUnsignedShort(height));
+		TEST(s.readUnsignedShort(count));
+
+		SDL_Surface* atlas = SDL_CreateRGBSurface(SDL_SWSURFACE, width, height, 32,
+			0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+		MYASSERT(atlas, SDLERR_IMAGE_LOAD_FAILED);
+		//the space between the images is transparent.
+		SDL_FillRect(atlas, NULL, 0);
+		if(!drawAtlasImages(s, atlas, count)) {
+			SDL_FreeSurface(atlas);
+			return NULL;
+		}
+
+		SDL_Surface* surf = SDL_DisplayFormatAlpha(atlas);
+		SDL_FreeSurface(atlas);
+		MYASSERT(surf, SDLERR_IMAGE_LOAD_FAILED);
+		return surf;
+	}
+
 	//***************************************************************************
 	// SDL Streams
 	//***************************************************************************
@@ -723,20 +801,42 @@ namespace Base {
 		}
 		SDL_UnlockSurface(srcSurface);
 		SDL_UnlockSurface(dstSurface);
-		SDL_UpdateRect(dstSurface, x, y, srcSurface->w*multiplier, srcSurface->h*multiplier);
+		SDL_UpdateRect(dstSurface, x, y, srcRect.w*multiplier, srcRect.h*multiplier);
 	}
 
 
+	//records that a rectangle of gDrawSurface may have changed.
+	static void damage(int x, int y, int w, int h) {
+		if(gDrawSurface != gBackBuffer)
+			return;
+		sDamage.setBounds(gBackBuffer->w, gBackBuffer->h);
+		const SDL_Rect& clip = gBackBuffer->clip_rect;
+		int right = MIN(x + w, clip.x + clip.w);
+		int bottom = MIN(y + h, clip.y + clip.h);
+		x = MAX(x, (int)clip.x);
+		y = MAX(y, (int)clip.y);
+		sDamage.add(x, y, right - x, bottom - y);
+	}
+
+	//copies the damaged parts of the back buffer to the screen.
 	static void MAUpdateScreen() {
 #ifndef MOBILEAUTHOR
+		sDamage.setBounds(gBackBuffer->w, gBackBuffer->h);
 		if(sSkin) {
-			sSkin->drawScreen();
-			sSkin->drawMultiTouchSimulation();
-
-			SDL_UpdateRect(gScreen, 0, 0, 0, 0);
+			sSkin->drawScreenRects(sDamage.rects(), sDamage.count());
+			sDamage.clear();
+			//the markers are on top of the screen. They must be painted over next time.
+			if(sSkin->drawMultiTouchSimulation())
+				sDamage.addAll();
 		} else {
-			SDL_BlitSurface(gBackBuffer, NULL, gScreen, NULL);
-			SDL_UpdateRect(gScreen, 0, 0, 0, 0);
+			SDL_Rect rects[SCREEN_DAMAGE_MAX_RECTS];
+			for(int i=0; i<sDamage.count(); i++) {
+				SDL_Rect src = sDamage.rects()[i];
+				rects[i] = src;
+				SDL_BlitSurface(gBackBuffer, &src, gScreen, &rects[i]);
+			}
+			SDL_UpdateRects(gScreen, sDamage.count(), rects);
+			sDamage.clear();
 		}
 #endif
 	}
@@ -785,29 +885,54 @@ namespace Base {
 		return 0;
 	}
 
+	//returns true if the queued event \a q can be replaced by the new event \a e
+	//without the application missing anything but intermediate positions or readings.
+	static bool MAEventsCoalesce(const MAEvent& q, const MAEvent& e) {
+		if(q.type != e.type)
+			return false;
+		if(e.type == EVENT_TYPE_POINTER_DRAGGED)
+			return q.touchId == e.touchId;
+		if(e.type == EVENT_TYPE_SENSOR)
+			return q.sensor.type == e.sensor.type;
+		return false;
+	}
+
+	//Thread-safe. Never blocks.
+	//If the queue is full, the event is dropped. One slot is kept free for the Close event.
+	static void MAPutEvent(const MAEvent& e) {
+		EventFifo::PutResult res;
+		if(e.type == EVENT_TYPE_CLOSE)
+			res = gEventFifo.put(e) ? EventFifo::PUT : EventFifo::DROPPED;
+		else
+			res = gEventFifo.putCoalesced(e, MAEventsCoalesce, 1);
+		if(res == EventFifo::COALESCED) {
+			atomicIncrement(&gEventsCoalesced);
+		} else if(res == EventFifo::DROPPED) {
+			long dropped = atomicIncrement(&gEventsDropped);
+			LOG("EventBuffer overflow! Event type %i dropped. %li dropped, %li coalesced so far.\n",
+				e.type, dropped, gEventsCoalesced);
+		}
+	}
+
+	//Any thread. Queues the event and wakes up maWait().
+	void MAPostEvent(const MAEvent& e) {
+		MAPutEvent(e);
+		FE_Wake();
+	}
+
 	static void MASendPointerEvent(int x, int y, int touchId, int type) {
-			if(!gEventOverflow) {
-				if(gEventFifo.count() + 2 == EVENT_BUFFER_SIZE) {	//leave space for Close event
-					gEventOverflow = true;
-					gEventFifo.clear();
-					LOG("EventBuffer overflow!\n");
-				}
+			if(!gClosing) {
 				MAEvent event;
 				event.type = type;
 				event.point.x = x;
 				event.point.y = y;
 				event.touchId = touchId;
-				gEventFifo.put(event);
+				MAPutEvent(event);
 			}
 	}
 
 	static void MAHandleKeyEventMAK(int mak, bool pressed, int nativeKey) {
-		if(!gEventOverflow) {
-			if(gEventFifo.count() + 2 == EVENT_BUFFER_SIZE) {	//leave space for Close event
-				gEventOverflow = true;
-				gEventFifo.clear();
-				LOG("EventBuffer overflow!\n");
-			}
+		if(!gClosing) {
 			MAEvent event;
 			event.type = pressed ? EVENT_TYPE_KEY_PRESSED : EVENT_TYPE_KEY_RELEASED;
 
@@ -820,7 +945,7 @@ namespace Base {
 
 			event.key = mak;
 			event.nativeKey = nativeKey;
-			gEventFifo.put(event);
+			MAPutEvent(event);
 		}
 		if(sSkin)
 		{
@@ -842,7 +967,7 @@ namespace Base {
 		MAEvent event;
 		event.type = EVENT_TYPE_CHAR;
 		event.character = unicode;
-		gEventFifo.put(event);
+		MAPutEvent(event);
 	}
 
 	static Uint32 GCCATTRIB(noreturn) SDLCALL ExitCallback(Uint32 interval, void*) {
@@ -879,12 +1004,13 @@ namespace Base {
 	}
 
 	static void MASetClose() {
-		//fix up the event queue
-		gEventOverflow = gClosing = true;
+		//no more input events after this.
+		gClosing = true;
 		gReload = false;
+		LOG("Events dropped: %li, coalesced: %li\n", gEventsDropped, gEventsCoalesced);
 		MAEvent event;
 		event.type = EVENT_TYPE_CLOSE;
-		gEventFifo.put(event);
+		MAPutEvent(event);
 		gExitTimer = SDL_AddTimer(EVENT_CLOSE_TIMEOUT, ExitCallback, NULL);
 		DEBUG_ASSERT(NULL != gExitTimer);
 	}
@@ -906,7 +1032,7 @@ namespace Base {
 		// send event
 		MAEvent e;
 		e.type = EVENT_TYPE_SCREEN_CHANGED;
-		gEventFifo.put(e);
+		MAPutEvent(e);
 	}
 
 	//returns true iff maWait should return.
@@ -942,7 +1068,7 @@ namespace Base {
 						} else {
 							e.type = EVENT_TYPE_FOCUS_LOST;
 						}
-						gEventFifo.put(e);
+						MAPutEvent(e);
 				}
 				break;
 #ifndef MOBILEAUTHOR
@@ -1018,27 +1144,15 @@ namespace Base {
 				MASetClose();
 				break;
 			case SDL_VIDEOEXPOSE:
+				sDamage.addAll();
 				MAUpdateScreen();
 				break;
-			case FE_ADD_EVENT:
-				{
-					LOGDT("FE_ADD_EVENT");
-					MAEvent* pe = (MAEvent*)event.user.data1;
-					gEventFifo.put(*pe);
-					delete pe;
-				}
-				break;
 			case FE_DEFLUX_BINARY:
 				LOGDT("FE_DEFLUX_BINARY");
 				SYSCALL_THIS->resources.extract_RT_FLUX(event.user.code);
 				ROOM(SYSCALL_THIS->resources.add_RT_BINARY(event.user.code,
 					(Stream*)event.user.data1));
 				break;
-			case FE_TIMER:
-				LOGDT("Timer event handled: %i %i", gTimerSequence, event.user.code);
-				if(gTimerSequence == event.user.code)
-					ret = true;
-				break;
 			case FE_INTERRUPT:
 				LOGDT("FE_INTERRUPT");
 				ret = true;
@@ -1047,6 +1161,10 @@ namespace Base {
 				LOGDT("FE_CAMERA_VIEWFINDER_UPDATE");
 				cameraViewFinderUpdate();
 				break;
+			case FE_IMAGE_DECODED:
+				LOGDT("FE_IMAGE_DECODED");
+				MAImageDecodeFinish(event.user.data1);
+				break;
 			default:
 				LOG("Unhandled event, type %i\n", event.type);
 			}
@@ -1058,25 +1176,12 @@ namespace Base {
 		return ret;
 	}
 
-	static Uint32 SDLCALL MATimerCallback(Uint32 interval, void* sequence) {
-		LOGD("MATimerCallback %i...", (int)sequence);
-		DEBUG_ASRTZERO(SDL_LockMutex(gTimerMutex));
-		{
-			SDL_UserEvent event = { FE_TIMER, (int)(size_t)sequence, NULL, NULL };
-			FE_PushEvent((SDL_Event*)&event);
-		}
-		DEBUG_ASRTZERO(SDL_UnlockMutex(gTimerMutex));
-		LOGD("MATimerCallback %i done\n", (int)sequence);
-		return (Uint32)-1;
-	}
-
 	static void BtWaitTrigger() {
 		LOGD("BtWaitTrigger\n");
-		MAEvent* ep = new MAEvent;
-		ep->type = EVENT_TYPE_BT;
-		ep->state = Bluetooth::maBtDiscoveryState();
-		SDL_UserEvent event = { FE_ADD_EVENT, 0, ep, NULL };
-		FE_PushEvent((SDL_Event*)&event);
+		MAEvent e;
+		e.type = EVENT_TYPE_BT;
+		e.state = Bluetooth::maBtDiscoveryState();
+		MAPostEvent(e);
 	}
 }	//namespace Base
 
@@ -1116,29 +1221,138 @@ namespace Base {
 	}
 	SYSCALL(void, maPlot(int posX, int posY)) {
 		SDL_putPixel(gDrawSurface, posX, posY, gCurrentConvertedColor);
+		damage(posX, posY, 1, 1);
 	}
 	SYSCALL(void, maLine(int startX, int startY, int endX, int endY)) {
 		SDL_drawLine(gDrawSurface, startX, startY, endX, endY, gCurrentConvertedColor);
+		damage(MIN(startX, endX), MIN(startY, endY),
+			abs(endX - startX) + 1, abs(endY - startY) + 1);
 	}
 	SYSCALL(void, maFillRect(int left, int top, int width, int height)) {
 		SDL_Rect rect = { (Sint16)left, (Sint16)top, (Uint16)width, (Uint16)height };
 		DEBUG_ASRTZERO(SDL_FillRect(gDrawSurface, &rect, gCurrentConvertedColor));
+		damage(rect.x, rect.y, rect.w, rect.h);
+	}
+
+	//damages the bounding box of \a points.
+	static void damagePoints(const MAPoint2d* points, int count) {
+		int left = points[0].x, top = points[0].y, right = left, bottom = top;
+		for(int i=1; i<count; i++) {
+			left = MIN(left, points[i].x);
+			top = MIN(top, points[i].y);
+			right = MAX(right, points[i].x);
+			bottom = MAX(bottom, points[i].y);
+		}
+		damage(left, top, right - left + 1, bottom - top + 1);
+	}
+
+	//fewer triangles than this are drawn on the main thread.
+#define PARALLEL_TRIANGLES 64
+#define TRIANGLE_THREADS 3
+#define MAX_BINNED_COORD 0x4000
+
+	struct TriangleTiles {
+		const MAPoint2d* points;
+		bool fan;
+		const TileBins* bins;
+	};
+
+	static TileBins sTriangleBins;
+	//surfaces that share the pixels of gDrawSurface, one per tile, clipped to the tile.
+	static std::vector<SDL_Surface*> sTileViews;
+	static ParallelJobRunner* sTriangleRunner = NULL;
+
+	static void updateTileViews() {
+		SDL_Surface* s = gDrawSurface;
+		if(!sTileViews.empty()) {
+			SDL_Surface* v = sTileViews[0];
+			if(v->pixels != s->pixels || v->w != s->w || v->h != s->h || v->pitch != s->pitch ||
+				v->format->BytesPerPixel != s->format->BytesPerPixel)
+			{
+				for(size_t i=0; i<sTileViews.size(); i++) {
+					SDL_FreeSurface(sTileViews[i]);
+				}
+				sTileViews.clear();
+			}
+		}
+		while((int)sTileViews.size() < sTriangleBins.tileCount()) {
+			SDL_Surface* v = SDL_CreateRGBSurfaceFrom(s->pixels, s->w, s->h,
+				s->format->BitsPerPixel, s->pitch, s->format->Rmask, s->format->Gmask,
+				s->format->Bmask, s->format->Amask);
+			DEBUG_ASSERT(v != NULL);
+			sTileViews.push_back(v);
+		}
+		for(int i=0; i<sTriangleBins.tileCount(); i++) {
+			int left, top, width, height;
+			sTriangleBins.tileRect(i, left, top, width, height);
+			SDL_Rect rect = { (Sint16)left, (Sint16)top, (Uint16)width, (Uint16)height };
+			SDL_SetClipRect(sTileViews[i], &rect);
+		}
+	}
+
+	static void fillTriangleTile(void* data, int tile) {
+		const TriangleTiles& t = *(TriangleTiles*)data;
+		const std::vector<int>& triangles = t.bins->triangles(tile);
+		for(size_t j=0; j<triangles.size(); j++) {
+			int i = triangles[j];
+			const MAPoint2d& a = t.fan ? t.points[0] : t.points[i-2];
+			SDL_fillTriangle(sTileViews[tile], a.x, a.y,
+				t.points[i-1].x, t.points[i-1].y, t.points[i].x, t.points[i].y,
+				gCurrentConvertedColor);
+		}
+	}
+
+	//draws the triangles of a strip or fan. Large meshes are binned into tiles,
+	//which are drawn in parallel. SDL_fillTriangle() only visits the rows and
+	//columns inside the clip rect, without changing its edges, so every tile
+	//gets the same pixels as it would if the mesh was drawn whole.
+	static void fillTriangles(const MAPoint2d* points, int count, bool fan) {
+		//beyond this, the margins below would get too wide to be of any use.
+		bool inRange = true;
+		for(int i = 0; i < count && inRange; i++) {
+			const MAPoint2d& p = points[i];
+			inRange = p.x >= -MAX_BINNED_COORD && p.x <= MAX_BINNED_COORD &&
+				p.y >= -MAX_BINNED_COORD && p.y <= MAX_BINNED_COORD;
+		}
+		if(count - 2 < PARALLEL_TRIANGLES || !inRange) {
+			for(int i = 2; i < count; i++) {
+				const MAPoint2d& a = fan ? points[0] : points[i-2];
+				SDL_fillTriangle(gDrawSurface, a.x, a.y,
+					points[i-1].x, points[i-1].y, points[i].x, points[i].y,
+					gCurrentConvertedColor);
+			}
+			return;
+		}
+
+		const SDL_Rect& clip = gDrawSurface->clip_rect;
+		sTriangleBins.reset(clip.x, clip.y, clip.w, clip.h);
+		if(sTriangleBins.tileCount() == 0)
+			return;
+		for(int i = 2; i < count; i++) {
+			const MAPoint2d& a = fan ? points[0] : points[i-2];
+			const MAPoint2d& b = points[i-1];
+			const MAPoint2d& c = points[i];
+			//the float rasteriser steps its edges once per column, so they may
+			//drift past the true edges by about a float epsilon of the largest
+			//y coordinate per column.
+			int width = MAX(MAX(a.x, b.x), c.x) - MIN(MIN(a.x, b.x), c.x);
+			int maxY = MAX(MAX(abs(a.y), abs(b.y)), abs(c.y));
+			int margin = 2 + (int)(((s64)width * (maxY + 1)) >> 22);
+			sTriangleBins.add(i, a.x, a.y, b.x, b.y, c.x, c.y, margin);
+		}
+		updateTileViews();
+		if(!sTriangleRunner)
+			sTriangleRunner = new ParallelJobRunner(TRIANGLE_THREADS);
+		TriangleTiles tiles = { points, fan, &sTriangleBins };
+		sTriangleRunner->run(fillTriangleTile, &tiles, sTriangleBins.tileCount());
 	}
 
 	SYSCALL(void, maFillTriangleStrip(const MAPoint2d* points, int count)) {
 		SYSCALL_THIS->ValidateMemRange(points, sizeof(MAPoint2d) * count);
 		CHECK_INT_ALIGNMENT(points);
 		MYASSERT(count >= 3, ERR_POLYGON_TOO_FEW_POINTS);
-		for(int i = 2; i < count; i++) {
-			SDL_fillTriangle(gDrawSurface,
-				points[i-2].x,
-				points[i-2].y,
-				points[i-1].x,
-				points[i-1].y,
-				points[i].x,
-				points[i].y,
-				gCurrentConvertedColor);
-		}
+		fillTriangles(points, count, false);
+		damagePoints(points, count);
 		LOGG("fp color 0x%08x %i:", gCurrentConvertedColor, count);
 		for(int i=0; i<count; i++) {
 			LOGG(" %ix%i", points[i].x, points[i].y);
@@ -1150,16 +1364,8 @@ namespace Base {
 		SYSCALL_THIS->ValidateMemRange(points, sizeof(MAPoint2d) * count);
 		CHECK_INT_ALIGNMENT(points);
 		MYASSERT(count >= 3, ERR_POLYGON_TOO_FEW_POINTS);
-		for(int i = 2; i < count; i++) {
-			SDL_fillTriangle(gDrawSurface,
-				points[0].x,
-				points[0].y,
-				points[i-1].x,
-				points[i-1].y,
-				points[i].x,
-				points[i].y,
-				gCurrentConvertedColor);
-		}
+		fillTriangles(points, count, true);
+		damagePoints(points, count);
 		LOGG("fp color 0x%08x %i:", gCurrentConvertedColor, count);
 		for(int i=0; i<count; i++) {
 			LOGG(" %ix%i", points[i].x, points[i].y);
@@ -1167,53 +1373,54 @@ namespace Base {
 		LOGG("\n");
 	}
 
-	template<class Tchar, int SDLCALL sizeFunc(TTF_Font*, const Tchar*, int*, int*)>
+	template<class Tchar>
 	static MAExtent getTextSize(const Tchar* str) {
 		if(*str == 0) {
 			return 0;
 		}
 		int x,y;
 		DEBUG_ASSERT(gFont != NULL);
-		if(sizeFunc(gFont, str, &x, &y) != 0) {
+		if(!GlyphCacheSize(gFont, str, &x, &y)) {
 			BIG_PHAT_ERROR(SDLERR_TEXT_SIZE_FAILED);
 		}
 		return EXTENT(x, y);
 	}
 
 	SYSCALL(MAExtent, maGetTextSize(const char* str)) {
-		return getTextSize<char, TTF_SizeText>(str);
+		return getTextSize(str);
 	}
 	SYSCALL(MAExtent, maGetTextSizeW(const wchar* str)) {
-		return getTextSize<wchar, TTF_SizeUNICODE>(str);
+		return getTextSize(str);
 	}
 
-	template<class Tchar, SDL_Surface* SDLCALL renderFunc(TTF_Font*, const Tchar*, SDL_Color)>
+	template<class Tchar>
 	static void drawText(int left, int top, const Tchar* str) {
 		if(*str == 0) {
 			return;
 		}
 		int argb = gCurrentUnconvertedColor;
 		SDL_Color color = { (Uint8)(argb >> 16), (Uint8)(argb >> 8), (Uint8)argb, 0 };
-		SDL_Surface* text_surface = renderFunc(gFont, str, color);
-		if(!text_surface) {
+		int w, h;
+		if(!GlyphCacheDraw(gFont, gDrawSurface, left, top, str, color, &w, &h)) {
 			BIG_PHAT_ERROR(SDLERR_TEXT_RENDER_FAILED);
 		}
-		SDL_Rect rect = { (Sint16)left, (Sint16)top, 0, 0 };
-		SDL_BlitSurface(text_surface, NULL, gDrawSurface, &rect);
-		SDL_FreeSurface(text_surface);
+		damage(left, top, w, h);
 	}
 
 	SYSCALL(void, maDrawText(int left, int top, const char* str)) {
-		drawText<char, TTF_RenderText_Solid>(left, top, str);
+		drawText(left, top, str);
 	}
 	SYSCALL(void, maDrawTextW(int left, int top, const wchar* str)) {
-		drawText<wchar, TTF_RenderUNICODE_Solid>(left, top, str);
+		drawText(left, top, str);
 	}
 
 	SYSCALL(void, maUpdateScreen()) {
 		LOGG("maUpdateScreen()\n");
 		if(gClosing)
 			return;
+		//the application draws into its frame buffer without telling us where.
+		if(internalBackBuffer)
+			sDamage.addAll();
 		MAUpdateScreen();
 		MAProcessEvents();
 
@@ -1222,6 +1429,28 @@ namespace Base {
 				Base::openGLSwap(sSubView);
 #endif
 	}
+
+	static int maUpdateScreenRects(const MARect* rects, int count) {
+		MYASSERT(count > 0 && count <= INT_MAX / (int)sizeof(MARect), ERR_SCREEN_RECT_COUNT);
+		gSyscall->ValidateMemRange(rects, sizeof(MARect) * count);
+		CHECK_INT_ALIGNMENT(rects);
+		LOGG("maUpdateScreenRects(%i)\n", count);
+		if(gClosing)
+			return 0;
+		sDamage.setBounds(gBackBuffer->w, gBackBuffer->h);
+		for(int i=0; i<count; i++) {
+			sDamage.add(rects[i].left, rects[i].top, rects[i].width, rects[i].height);
+		}
+		MAUpdateScreen();
+		MAProcessEvents();
+
+#ifdef SUPPORT_OPENGL_ES
+		if(sOpenGLMode)
+				Base::openGLSwap(sSubView);
+#endif
+		return 0;
+	}
+
 	SYSCALL(void, maResetBacklight()) {
 	}
 	SYSCALL(MAExtent, maGetScrSize()) {
@@ -1232,6 +1461,7 @@ namespace Base {
 		SDL_Surface* surf = gSyscall->resources.get_RT_IMAGE(image);
 		SDL_Rect rect = { (Sint16)left, (Sint16)top, 0, 0 };
 		SDL_BlitSurface(surf, NULL, gDrawSurface, &rect);
+		damage(left, top, surf->w, surf->h);
 	}
 
 	SYSCALL(void, maDrawRGB(const MAPoint2d* dstPoint, const void* src,
@@ -1254,17 +1484,13 @@ namespace Base {
 
 		SDL_SetAlpha(srcSurface, SDL_SRCALPHA, 0x0);
 		SDL_BlitSurface(srcSurface, &srcSurfaceRect, gDrawSurface, &dstSurfaceRect);
+		damage(dstSurfaceRect.x, dstSurfaceRect.y, dstSurfaceRect.w, dstSurfaceRect.h);
 
 		SDL_FreeSurface(srcSurface);
 	}
 
-	SYSCALL(void, maDrawImageRegion(MAHandle image, const MARect* src, const MAPoint2d* dstTopLeft, int transformMode)) {
-		//LOG("Entering DrawImageRegion start\n");
-
-		SDL_Surface* surf = gSyscall->resources.get_RT_IMAGE(image);
-		gSyscall->ValidateMemRange(src, sizeof(MARect));
-		gSyscall->ValidateMemRange(dstTopLeft, sizeof(MAPoint2d));
-
+	//draws one region of surf on gDrawSurface. The arguments must be validated.
+	static void drawImageRegion(SDL_Surface* surf, const MARect* src, const MAPoint2d* dstTopLeft, int transformMode) {
 		unsigned int* srcPixels = (unsigned int*) surf->pixels;
 		unsigned int* destPixels = (unsigned int*) gDrawSurface->pixels;
 		int dstPitchY = gDrawSurface->pitch>>2;
@@ -1396,42 +1622,45 @@ namespace Base {
 		unsigned int srcAlphaMask = surf->format->Amask;
 		unsigned int srcAlphaShift = surf->format->Ashift;
 
+		//the horizontal part of the clip rect is the same for every row.
+		const SDL_Rect& clip = gDrawSurface->clip_rect;
+		int firstX = clip.x - left;
+		if(firstX < 0)
+			firstX = 0;
+		int endX = clip.x + clip.w - left;
+		if(endX > transWidth)
+			endX = transWidth;
+		if(firstX >= endX)
+			return;
+		damage(left + firstX, top, endX - firstX, transHeight);
+
 		//LOG("Entering DrawImageRegion Loop\n");
 
 		if(surf->flags&SDL_SRCALPHA) {
 			while(transHeight) {
-				int destX = left;
-				int srcX = transTopLeftX;
-				width = transWidth;
-
-				if(	y >= gDrawSurface->clip_rect.y &&
-					y < gDrawSurface->clip_rect.y + gDrawSurface->clip_rect.h) {
-
-						while(width) {
-							if( destX >= gDrawSurface->clip_rect.x &&
-								destX < gDrawSurface->clip_rect.x + gDrawSurface->clip_rect.w )
-							{
-								int d = destPixels[destX + destY];
-								int s = srcPixels[srcX + srcY];
-								int a = (srcPixels[srcX + srcY]&srcAlphaMask)>>srcAlphaShift;
-								int sr = (((s)&srcRedMask)>>srcRedShift);
-								int sg = (((s)&srcGreenMask)>>srcGreenShift);
-								int sb = (((s)&srcBlueMask)>>srcBlueShift);
-								int dr = (((d)&dstRedMask)>>dstRedShift);
-								int dg = (((d)&dstGreenMask)>>dstGreenShift);
-								int db = (((d)&dstBlueMask)>>dstBlueShift);
-
-								/* Do alpha blitting */
-								destPixels[destX + destY] =
-									(((dr + (((sr-dr)*(a))>>8)) << dstRedShift)  &dstRedMask) |
-									(((dg + (((sg-dg)*(a))>>8)) << dstGreenShift)&dstGreenMask) |
-									(((db + (((sb-db)*(a))>>8)) << dstBlueShift) &dstBlueMask);
-
-							}
-							srcX+=srcPitchX;
-							destX++;
-							width--;
-						}
+				if(y >= clip.y && y < clip.y + clip.h) {
+					int destX = left + firstX;
+					int srcX = transTopLeftX + firstX * srcPitchX;
+					for(int x = firstX; x < endX; x++) {
+						int d = destPixels[destX + destY];
+						int s = srcPixels[srcX + srcY];
+						int a = (srcPixels[srcX + srcY]&srcAlphaMask)>>srcAlphaShift;
+						int sr = (((s)&srcRedMask)>>srcRedShift);
+						int sg = (((s)&srcGreenMask)>>srcGreenShift);
+						int sb = (((s)&srcBlueMask)>>srcBlueShift);
+						int dr = (((d)&dstRedMask)>>dstRedShift);
+						int dg = (((d)&dstGreenMask)>>dstGreenShift);
+						int db = (((d)&dstBlueMask)>>dstBlueShift);
+
+						/* Do alpha blitting */
+						destPixels[destX + destY] =
+							(((dr + (((sr-dr)*(a))>>8)) << dstRedShift)  &dstRedMask) |
+							(((dg + (((sg-dg)*(a))>>8)) << dstGreenShift)&dstGreenMask) |
+							(((db + (((sb-db)*(a))>>8)) << dstBlueShift) &dstBlueMask);
+
+						srcX+=srcPitchX;
+						destX++;
+					}
 				}
 				srcY+=srcPitchY;
 				destY+=dstPitchY;
@@ -1439,26 +1668,18 @@ namespace Base {
 				y++;
 			}
 		} else {
+			unsigned int srcColorMask = srcRedMask | srcGreenMask | srcBlueMask;
 			while(transHeight) {
-				int destX = left;
-				int srcX = transTopLeftX;
-				width = transWidth;
-
-				if(	y >= gDrawSurface->clip_rect.y &&
-					y < gDrawSurface->clip_rect.y + gDrawSurface->clip_rect.h) {
-
-						while(width) {
-							if( destX >= gDrawSurface->clip_rect.x &&
-								destX < gDrawSurface->clip_rect.x + gDrawSurface->clip_rect.w )
-							{
-								/* Do blitting without alpha */
-								destPixels[destX + destY] = (destPixels[destX + destY] & dstAlphaMask) |
-									(srcPixels[srcX + srcY] & (srcRedMask | srcGreenMask | srcBlueMask));
-							}
-							srcX+=srcPitchX;
-							destX++;
-							width--;
-						}
+				if(y >= clip.y && y < clip.y + clip.h) {
+					int destX = left + firstX;
+					int srcX = transTopLeftX + firstX * srcPitchX;
+					for(int x = firstX; x < endX; x++) {
+						/* Do blitting without alpha */
+						destPixels[destX + destY] = (destPixels[destX + destY] & dstAlphaMask) |
+							(srcPixels[srcX + srcY] & srcColorMask);
+						srcX+=srcPitchX;
+						destX++;
+					}
 				}
 				srcY+=srcPitchY;
 				destY+=dstPitchY;
@@ -1468,6 +1689,115 @@ namespace Base {
 		}
 	}
 
+	SYSCALL(void, maDrawImageRegion(MAHandle image, const MARect* src, const MAPoint2d* dstTopLeft, int transformMode)) {
+		SDL_Surface* surf = gSyscall->resources.get_RT_IMAGE(image);
+		gSyscall->ValidateMemRange(src, sizeof(MARect));
+		gSyscall->ValidateMemRange(dstTopLeft, sizeof(MAPoint2d));
+		drawImageRegion(surf, src, dstTopLeft, transformMode);
+	}
+
+	static int maDrawImageRegions(MAHandle image, const MARect* srcs, const MAPoint2d* dsts,
+		int count, int transformMode)
+	{
+		MYASSERT(count > 0 && count <= INT_MAX / (int)sizeof(MARect), ERR_IMAGE_REGION_COUNT);
+		SDL_Surface* surf = gSyscall->resources.get_RT_IMAGE(image);
+		gSyscall->ValidateMemRange(srcs, sizeof(MARect) * count);
+		gSyscall->ValidateMemRange(dsts, sizeof(MAPoint2d) * count);
+		CHECK_INT_ALIGNMENT(srcs);
+		CHECK_INT_ALIGNMENT(dsts);
+		for(int i=0; i<count; i++) {
+			drawImageRegion(surf, &srcs[i], &dsts[i], transformMode);
+		}
+		return 0;
+	}
+
+	//true if the pixels of \a fmt are 0xAARRGGBB or 0x..RRGGBB.
+	static bool isXrgb8888(const SDL_PixelFormat* fmt) {
+		return fmt->BytesPerPixel == 4 && fmt->Rmask == 0x00ff0000 && fmt->Gmask == 0x0000ff00 &&
+			fmt->Bmask == 0x000000ff && (fmt->Amask == 0 || fmt->Amask == 0xff000000);
+	}
+
+	//a part of gDrawSurface that a gradient is drawn into.
+	struct GradientTarget {
+		SDL_Rect rect;
+		//32-bit pixels, or NULL if there is nothing to draw.
+		unsigned int* pixels;
+		int pitch;
+		//blended onto gDrawSurface by endGradient(), or NULL if the pixels are in gDrawSurface.
+		SDL_Surface* temp;
+	};
+
+	//clips \a rect. If both colors are opaque and the draw target is 32-bit,
+	//the gradient can be drawn directly. Otherwise it must be blended,
+	//like the pixels of maDrawRGB().
+	static int beginGradient(GradientTarget& t, const MARect* rect, int color0, int color1) {
+		CHECK_INT_ALIGNMENT(rect);
+		t.pixels = NULL;
+		t.temp = NULL;
+		const SDL_Rect& clip = gDrawSurface->clip_rect;
+		int left = MAX(rect->left, (int)clip.x);
+		int top = MAX(rect->top, (int)clip.y);
+		int right = MIN(rect->left + rect->width, clip.x + clip.w);
+		int bottom = MIN(rect->top + rect->height, clip.y + clip.h);
+		if(left >= right || top >= bottom)
+			return 0;
+		t.rect.x = (Sint16)left;
+		t.rect.y = (Sint16)top;
+		t.rect.w = (Uint16)(right - left);
+		t.rect.h = (Uint16)(bottom - top);
+
+		bool opaque = ((unsigned int)(color0 & color1) >> 24) == 0xff;
+		if(opaque && isXrgb8888(gDrawSurface->format) && gDrawSurface->format->Amask == 0) {
+			t.pixels = (unsigned int*)((byte*)gDrawSurface->pixels + top * gDrawSurface->pitch) + left;
+			t.pitch = gDrawSurface->pitch >> 2;
+			return 0;
+		}
+		t.temp = SDL_CreateRGBSurface(SDL_SWSURFACE, t.rect.w, t.rect.h, 32,
+			0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+		if(t.temp==0) return RES_OUT_OF_MEMORY;
+		t.pixels = (unsigned int*)t.temp->pixels;
+		t.pitch = t.temp->pitch >> 2;
+		return 0;
+	}
+
+	static void endGradient(GradientTarget& t) {
+		if(t.temp) {
+			SDL_SetAlpha(t.temp, SDL_SRCALPHA, 0);
+			SDL_Rect dstRect = t.rect;
+			SDL_BlitSurface(t.temp, NULL, gDrawSurface, &dstRect);
+			SDL_FreeSurface(t.temp);
+		}
+		damage(t.rect.x, t.rect.y, t.rect.w, t.rect.h);
+	}
+
+	static int maFillLinearGradient(const MARect* rect, const MAPoint2d* start, const MAPoint2d* end,
+		int startColor, int endColor)
+	{
+		CHECK_INT_ALIGNMENT(start);
+		CHECK_INT_ALIGNMENT(end);
+		GradientTarget t;
+		int res = beginGradient(t, rect, startColor, endColor);
+		if(res != 0 || !t.pixels)
+			return res;
+		ImageFilters::linearGradient(t.pixels, t.rect.w, t.rect.h, t.pitch, t.rect.x, t.rect.y,
+			start->x, start->y, end->x, end->y, startColor, endColor);
+		endGradient(t);
+		return 0;
+	}
+
+	static int maFillRadialGradient(const MARect* rect, const MAPoint2d* center, int radius,
+		int centerColor, int edgeColor)
+	{
+		CHECK_INT_ALIGNMENT(center);
+		GradientTarget t;
+		int res = beginGradient(t, rect, centerColor, edgeColor);
+		if(res != 0 || !t.pixels)
+			return res;
+		ImageFilters::radialGradient(t.pixels, t.rect.w, t.rect.h, t.pitch, t.rect.x, t.rect.y,
+			center->x, center->y, radius, centerColor, edgeColor);
+		endGradient(t);
+		return 0;
+	}
 
 	SYSCALL(MAExtent, maGetImageSize(MAHandle image)) {
 		SDL_Surface* surf = gSyscall->resources.get_RT_IMAGE(image);
@@ -1547,6 +1877,13 @@ namespace Base {
 		MYASSERT(src->seek(Seek::Start, offset), ERR_DATA_OOB);
 		Smartie<Stream> copy(src->createLimitedCopy(size));
 		MYASSERT(copy, ERR_DATA_OOB);
+		//only images in memory can be looked up in the cache.
+		const void* encoded = copy->ptrc();
+		if(encoded) {
+			SDL_Surface* cached = ImageCacheLoad(encoded, size);
+			if(cached)
+				return gSyscall->resources.add_RT_IMAGE(placeholder, cached);
+		}
 		SDL_RWops* rwops = SDL_RWFromStream(copy());
 		if(!rwops)
 		{
@@ -1561,6 +1898,8 @@ namespace Base {
 			return RES_BAD_INPUT;
 
 		surf = SDL_DisplayFormatAlpha(surf);
+		if(surf && encoded)
+			ImageCacheStore(encoded, size, surf);
 
 		return gSyscall->resources.add_RT_IMAGE(placeholder, surf);
 	}
@@ -1605,17 +1944,81 @@ namespace Base {
 		return gSyscall->resources.add_RT_IMAGE(placeholder, surf);
 	}
 
+	static int maCreateScaledImage(MAHandle placeholder, MAHandle image, const MARect* srcRect,
+		int width, int height, int filter)
+	{
+		SDL_Surface* surf = gSyscall->resources.get_RT_IMAGE(image);
+		CHECK_INT_ALIGNMENT(srcRect);
+		//written so that no sum can overflow.
+		MYASSERT(srcRect->width > 0 && srcRect->height > 0 &&
+			srcRect->left >= 0 && srcRect->top >= 0 &&
+			srcRect->width <= surf->w - srcRect->left &&
+			srcRect->height <= surf->h - srcRect->top, ERR_IMAGE_OOB);
+		//the pitch of an SDL surface is 16 bits, and the size in bytes must fit in an int.
+		MYASSERT(width > 0 && height > 0 && width <= 0xffff / 4 &&
+			height <= INT_MAX / 4 / width, ERR_IMAGE_SIZE_INVALID);
+		MYASSERT(filter >= IMAGE_SCALE_NEAREST && filter <= IMAGE_SCALE_BOX, ERR_IMAGE_SCALE_FILTER);
+
+		bool alpha = surf->format->Amask != 0;
+		SDL_Surface* dst = SDL_CreateRGBSurface(SDL_SWSURFACE|(alpha?SDL_SRCALPHA:0), width, height, 32,
+			0x00ff0000, 0x0000ff00, 0x000000ff, (alpha?0xff000000:0));
+		if(dst==0) return RES_OUT_OF_MEMORY;
+
+		//the filters work on 32-bit pixels. Other formats are converted first.
+		SDL_Surface* src = surf;
+		SDL_Rect rect = { (Sint16)srcRect->left, (Sint16)srcRect->top,
+			(Uint16)srcRect->width, (Uint16)srcRect->height };
+		if(!isXrgb8888(surf->format)) {
+			src = SDL_CreateRGBSurface(SDL_SWSURFACE, rect.w, rect.h, 32,
+				0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+			if(src==0) {
+				SDL_FreeSurface(dst);
+				return RES_OUT_OF_MEMORY;
+			}
+			bool srcAlpha = (surf->flags & SDL_SRCALPHA) != 0;
+			if(srcAlpha)
+				SDL_SetAlpha(surf, 0, 0);
+			SDL_BlitSurface(surf, &rect, src, NULL);
+			if(srcAlpha)
+				SDL_SetAlpha(surf, SDL_SRCALPHA, 0);
+			rect.x = rect.y = 0;
+		}
+
+		const unsigned int* pixels = (const unsigned int*)((const byte*)src->pixels +
+			rect.y * src->pitch) + rect.x;
+		ImageFilters::scale((unsigned int*)dst->pixels, width, height, dst->pitch >> 2,
+			pixels, rect.w, rect.h, src->pitch >> 2, (ImageFilters::Filter)filter);
+		if(src != surf)
+			SDL_FreeSurface(src);
+
+		return gSyscall->resources.add_RT_IMAGE(placeholder, dst);
+	}
+
 	SYSCALL(int, maGetEvent(MAEvent* dst)) {
 		CHECK_INT_ALIGNMENT(dst);
 		gSyscall->ValidateMemRange(dst, sizeof(MAEvent));
 		MAProcessEvents();
-		if(!gClosing)
-			gEventOverflow = false;
-		if(gEventFifo.count() == 0) {
-			return 0;
+		return gEventFifo.get(*dst) ? 1 : 0;
+	}
+
+	static int maGetEvents(int events, int max) {
+		MYASSERT(max > 0, ERR_EVENT_COUNT);
+		//the queue never holds more than this.
+		if(max > EVENT_BUFFER_SIZE)
+			max = EVENT_BUFFER_SIZE;
+		MAEvent* dst = (MAEvent*)SYSCALL_THIS->GetValidatedMemRange(events, max * sizeof(MAEvent));
+		CHECK_INT_ALIGNMENT(dst);
+		MAProcessEvents();
+		int count = 0;
+		while(count < max && gEventFifo.get(dst[count])) {
+			count++;
 		}
-		*dst = gEventFifo.get();
-		return 1;
+		return count;
+	}
+
+	static void maGetEventQueueStats(int* dropped, int* coalesced) {
+		*dropped = (int)gEventsDropped;
+		*coalesced = (int)gEventsCoalesced;
 	}
 
 	SYSCALL(void, maWait(int timeout)) {
@@ -1626,12 +2029,8 @@ namespace Base {
 		if(gEventFifo.count() != 0)
 			return;
 
-		DEBUG_ASSERT(gTimerId == NULL);
-		if(timeout > 0) {
-			//LOGD("Setting timer sequence %i\n", gTimerSequence);
-			gTimerId = SDL_AddTimer(timeout, MATimerCallback, (void*)(size_t)gTimerSequence);
-			DEBUG_ASSERT(gTimerId != NULL);
-		}
+		//absolute, so that wakeups that don't end the wait don't extend it either.
+		Uint32 deadline = SDL_GetTicks() + timeout;
 		while(true) {
 			bool ret = MAProcessEvents();
 			if(ret) {
@@ -1639,21 +2038,10 @@ namespace Base {
 			}
 			if(gEventFifo.count() != 0)
 				break;
-			if(FE_WaitEvent(NULL) != 1) {
-				LOGT("FE_WaitEvent failed");
-				DEBIG_PHAT_ERROR;
-			}
-		}
-
-		DEBUG_ASRTZERO(SDL_LockMutex(gTimerMutex));
-		{
-			if(gTimerId != NULL) {
-				DEBUG_ASSERT(SDL_RemoveTimer(gTimerId));
-				gTimerId = NULL;
-			}
-			gTimerSequence++;
+			if(timeout > 0 && (Sint32)(deadline - SDL_GetTicks()) <= 0)
+				break;
+			FE_WaitEventUntil(timeout > 0 ? &deadline : NULL);
 		}
-		DEBUG_ASRTZERO(SDL_UnlockMutex(gTimerMutex));
 	}
 
 	SYSCALL(int, maTime()) {
@@ -1733,6 +2121,8 @@ namespace Base {
 		AudioChannel *chnl = AudioEngine::getChannel(chan);
 		AudioSource *audioSource = chnl->getAudioSource();
 		if(audioSource!=NULL) {
+			chnl->setAudioSource(NULL);
+			chnl->waitForMix();
 			audioSource->close();
 			delete audioSource;
 		}
@@ -1791,13 +2181,14 @@ namespace Base {
 		return 1;
 	}
 
-	static SDL_Surface *internalBackBuffer = NULL;
 	static int maFrameBufferInit(void *data) {
 		if(internalBackBuffer!=NULL) return 0;
 		internalBackBuffer = gBackBuffer;
 		gBackBuffer = SDL_CreateRGBSurfaceFrom(data, gBackBuffer->w, gBackBuffer->h, gBackBuffer->format->BitsPerPixel, gBackBuffer->pitch, gBackBuffer->format->Rmask, gBackBuffer->format->Gmask, gBackBuffer->format->Bmask, gBackBuffer->format->Amask);
 		if(gBackBuffer == NULL) return 0;
 		gDrawSurface = gBackBuffer;
+		//the whole screen comes from another buffer now.
+		sDamage.addAll();
 		return 1;
 	}
 
@@ -1807,15 +2198,15 @@ namespace Base {
 		gBackBuffer = internalBackBuffer;
 		internalBackBuffer = NULL;
 		gDrawSurface = gBackBuffer;
+		sDamage.addAll();
 		return 1;
 	}
 
 	static void fillBufferCallback() {
-		MAEvent* ep = new MAEvent;
-		ep->type = EVENT_TYPE_AUDIOBUFFER_FILL;
-		ep->state = 1;
-		SDL_UserEvent event = { FE_ADD_EVENT, 0, ep, NULL };
-		FE_PushEvent((SDL_Event*)&event);
+		MAEvent e;
+		e.type = EVENT_TYPE_AUDIOBUFFER_FILL;
+		e.state = 1;
+		MAPostEvent(e);
 	}
 
 
@@ -2108,6 +2499,31 @@ namespace Base {
 			maIOCtl_case(atanh);
 
 			maIOCtl_case(maAccept);
+			maIOCtl_case(maDnsPrefetch);
+			maIOCtl_case(maDnsFlush);
+
+		case maIOCtl_maConnReadFromMulti:
+			maConnReadFromMulti(a, b, c);
+			return 0;
+		case maIOCtl_maConnWriteToMulti:
+			maConnWriteToMulti(a, b, c);
+			return 0;
+
+		case maIOCtl_maGetEvents:
+			return maGetEvents(a, b);
+		maIOCtl_case(maGetEventQueueStats);
+		case maIOCtl_maFindLabels:
+			return maFindLabels(a, b, c);
+		maIOCtl_case(maCreateImageFromDataAsync);
+		case maIOCtl_maCancelImageDecode:
+			return maCancelImageDecode(a);
+		case maIOCtl_maSetImageDecodeConcurrency:
+			return maSetImageDecodeConcurrency(a);
+		maIOCtl_case(maDrawImageRegions);
+		maIOCtl_case(maUpdateScreenRects);
+		maIOCtl_case(maCreateScaledImage);
+		maIOCtl_case(maFillLinearGradient);
+		maIOCtl_case(maFillRadialGradient);
 
 		case maIOCtl_maBtStartDeviceDiscovery:
 			return BLUETOOTH(maBtStartDeviceDiscovery)(BtWaitTrigger, a != 0);
@@ -2211,6 +2627,15 @@ namespace Base {
 			maIOCtl_case(maDBCursorGetColumnText);
 			maIOCtl_case(maDBCursorGetColumnInt);
 			maIOCtl_case(maDBCursorGetColumnDouble);
+			maIOCtl_case(maDBExecSQLBatch);
+			maIOCtl_case(maDBCursorFetchRows);
+			maIOCtl_case(maDBOpenEx);
+			maIOCtl_syscall_case(maOpenLogStore);
+			maIOCtl_syscall_case(maStoreAppend);
+			maIOCtl_syscall_case(maStoreRemoveRecord);
+			maIOCtl_syscall_case(maStoreReadRecord);
+			maIOCtl_syscall_case(maStoreNextRecord);
+			maIOCtl_syscall_case(maCloseLogStore);
 #ifdef EMULATOR
 		maIOCtl_syscall_case(maPimListOpen);
 		maIOCtl_syscall_case(maPimListNext);
@@ -2313,7 +2738,7 @@ namespace Base {
 					e.type = EVENT_TYPE_TEXTBOX;
 					e.textboxResult = (id == IDOK) ? MA_TB_RES_OK : MA_TB_RES_CANCEL;
 					e.textboxLength = length;
-					gEventFifo.put(e);
+					MAPutEvent(e);
 
 					// time to close
 					LOG("DestroyWindow\n");
@@ -2446,6 +2871,7 @@ namespace Base {
 		bouncingBoxCoordUpdate(gCameraViewFinderPoint.y, gCameraViewFinderDirection.y,
 			CAMERA_BOX_RADIUS_OUTER, gBackBuffer->h);
 
+		sDamage.addAll();
 		MAUpdateScreen();
 	}
 
@@ -2733,6 +3159,7 @@ void MoSyncExit(int r) {
 		AudioEngine::close();
 
 		MANetworkReset();
+		MAImageDecodeClose();
 
 		//there is no Bluetooth cancel function, so we'll just ignore that for now.
 		//chalk one up for Known Issues.
@@ -2758,6 +3185,7 @@ void MoSyncExit(int r) {
 #ifdef USE_MALIBQUIT
 		MALibQuit();	//disabled, hack to allow static destructors
 #endif
+		MAImageDecodeClose();
 		AudioEngine::close();
 		MoSyncDBClose();
 
@@ -23,6 +23,7 @@ public:
 SDL_Surface* loadImage(MemStream& s);
 SDL_Surface* loadSprite(SDL_Surface* surface, ushort left, ushort top,
 	ushort width, ushort height, ushort cx, ushort cy);
+SDL_Surface* loadAtlas(MemStream& s);
 
 public:
 		struct STARTUP_SETTINGS {
@@ -32,12 +33,16 @@ public:
 				id         = NULL;
 				iconPath   = NULL;
 				resmem     = ((uint)-1);
+				imageCache = 0;
+				imageCacheDir = NULL;
 			}
 
 			bool showScreen;
 			const char* id;
 			const char *iconPath;
 			uint resmem;
+			uint imageCache;	//maximum size of the decoded-image cache, in bytes. 0 disables it.
+			const char* imageCacheDir;	//NULL for the default.
 			MoRE::DeviceProfile profile;
 			bool haveSkin;
 #ifdef EMULATOR
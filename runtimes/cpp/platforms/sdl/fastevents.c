@@ -58,6 +58,7 @@ const char *FE_GetError(void)
 static SDL_mutex *eventLock = NULL;
 static SDL_cond *eventWait = NULL;
 static SDL_TimerID eventTimer = 0;
+static int wakePending = 0;
 
 //----------------------------------------
 //
@@ -130,6 +131,55 @@ int FE_WaitEvent(SDL_Event *event)
 	return val;
 }
 
+//----------------------------------------
+//
+// Like FE_WaitEvent(), but also returns when FE_Wake() is called
+// or when SDL_GetTicks() reaches *deadline. A NULL deadline never passes.
+// Does not remove the event from the queue.
+// Returns 1 if there is an event in the queue, 0 otherwise.
+//
+
+int FE_WaitEventUntil(const Uint32 *deadline)
+{
+	int val = 0;
+
+	SDL_LockMutex(eventLock);
+	if (0 >= (val = SDL_PollEvent(NULL)) && !wakePending)
+	{
+		if (NULL == deadline)
+		{
+			SDL_CondWait(eventWait, eventLock);
+		}
+		else
+		{
+			Sint32 left = (Sint32)(*deadline - SDL_GetTicks());
+			if (0 < left)
+			{
+				SDL_CondWaitTimeout(eventWait, eventLock, left);
+			}
+		}
+		val = SDL_PollEvent(NULL);
+	}
+	wakePending = 0;
+	SDL_UnlockMutex(eventLock);
+
+	return 0 < val;
+}
+
+//----------------------------------------
+//
+// Wakes up FE_WaitEventUntil(). If nobody is waiting,
+// the next call to it returns immediately. Thread-safe.
+//
+
+void FE_Wake(void)
+{
+	SDL_LockMutex(eventLock);
+	wakePending = 1;
+	SDL_UnlockMutex(eventLock);
+	SDL_CondBroadcast(eventWait);
+}
+
 //----------------------------------------
 //
 //
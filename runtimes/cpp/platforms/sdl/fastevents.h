@@ -39,6 +39,8 @@ extern "C" {
 	int FE_PollEvent(SDL_Event *event);    // replacement for SDL_PollEvent
 	int FE_WaitEvent(SDL_Event *event);    // replacement for SDL_WaitEvent
 	int FE_PushEvent(SDL_Event *event);    // replacement for SDL_PushEvent
+	int FE_WaitEventUntil(const Uint32 *deadline);  // FE_WaitEvent with a deadline and FE_Wake
+	void FE_Wake(void);                        // wake up FE_WaitEventUntil
 
 	const char *FE_GetError(void);                   // get the last error
 #ifdef __cplusplus
@@ -36,14 +36,11 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 //***************************************************************************
 
 void ConnWaitEvent() {
-	if(FE_WaitEvent(NULL) != 1) {
-		LOGT("FE_WaitEvent failed");
-		DEBIG_PHAT_ERROR;
-	}
+	FE_WaitEventUntil(NULL);
 }
 void ConnPushEvent(MAEvent* ep) {
-	SDL_UserEvent event = { FE_ADD_EVENT, 0, ep, NULL };
-	FE_PushEvent((SDL_Event*)&event);
+	MAPostEvent(*ep);
+	delete ep;
 }
 void DefluxBinPushEvent(MAHandle handle, Stream& s) {
 	SDL_UserEvent event = { FE_DEFLUX_BINARY, handle, &s, NULL };
@@ -15,12 +15,11 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 02111-1307, USA.
 */
 
-#define FE_ADD_EVENT (SDL_USEREVENT + 1)
-#define FE_TIMER (SDL_USEREVENT + 2)
 #define FE_DEFLUX_BINARY (SDL_USEREVENT + 3)
 #define FE_MA_NETWORK_MESSAGE (SDL_USEREVENT + 4)
 #define FE_INTERRUPT (SDL_USEREVENT + 5)
 #define FE_CAMERA_VIEWFINDER_UPDATE (SDL_USEREVENT + 6)
+#define FE_IMAGE_DECODED (SDL_USEREVENT + 7)
 
 namespace Base {
 	class Syscall;
@@ -39,6 +38,13 @@ void __attribute((noreturn)) reloadProgram();
 	int maDumpCallStackEx(const char*, int);
 	int getRuntimeIp();
 	bool MAProcessEvents();
+
+	//Thread-safe. Queues an event for maGetEvent() and wakes up maWait().
+	void MAPostEvent(const MAEvent& e);
+
+	//Main thread only. See ImageDecoder.cpp.
+	void MAImageDecodeFinish(void* job);
+	void MAImageDecodeClose();
 }
 using namespace Base;
 
@@ -17,6 +17,7 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 
 #include "AudioEngine.h"
 #include "AudioChannel.h"
+#include "AudioMix.h"
 #include "AudioSource.h"
 
 #include "WaveAudioSource.h"
@@ -47,15 +48,7 @@ namespace AudioEngine {
 			}
 		}
 
-		short* dst = (short*)buf;
-		for(int i = 0; i < numSamples<<1; i++) {
-			int sample = gTempBuffer[i];
-			if(sample<-32768) 
-				sample = 32768;
-			else if(sample>=32767) 
-				sample = 32767;
-			*dst++ = (short) (gTempBuffer[i]);
-		}
+		AudioMix::clampToS16((short*)buf, gTempBuffer, numSamples<<1);
 	}
 
 	int getSampleRate() {
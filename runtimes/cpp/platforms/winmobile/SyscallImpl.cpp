@@ -1368,32 +1368,15 @@ DWORD GetScreenOrientation()
 		SYSCALL_THIS->ValidateMemRange(points, sizeof(MAPoint2d) * count);
 		CHECK_INT_ALIGNMENT(points);
 		MYASSERT(count >= 3, ERR_POLYGON_TOO_FEW_POINTS);
-		for(int i = 2; i < count; i++) {
-			currentDrawSurface->drawTriangle(
-				points[i-2].x,
-				points[i-2].y,
-				points[i-1].x,
-				points[i-1].y,
-				points[i].x,
-				points[i].y,
-				realColor);
-		}
+		//most devices have a single core, so the triangles are drawn in order.
+		currentDrawSurface->fillTriangles((const int*)points, count, false, realColor, NULL);
 	}
 
 	SYSCALL(void, maFillTriangleFan(const MAPoint2d *points, int count)) {
 		SYSCALL_THIS->ValidateMemRange(points, sizeof(MAPoint2d) * count);
 		CHECK_INT_ALIGNMENT(points);
 		MYASSERT(count >= 3, ERR_POLYGON_TOO_FEW_POINTS);
-		for(int i = 2; i < count; i++) {
-			currentDrawSurface->drawTriangle(
-				points[0].x,
-				points[0].y,
-				points[i-1].x,
-				points[i-1].y,
-				points[i].x,
-				points[i].y,
-				realColor);
-		}
+		currentDrawSurface->fillTriangles((const int*)points, count, true, realColor, NULL);
 	}
 
 	SYSCALL(MAExtent, maGetTextSize(const char* str)) {
@@ -1945,16 +1928,20 @@ DWORD GetScreenOrientation()
 
 		AudioChannel *chnl = AudioEngine::getChannel(chan);
 		chnl->setActive(false);
-		if(gCurrentSoundSource) {
-			delete gCurrentSoundSource;
-		}
-		gCurrentSoundSource = src;
-
+		//the old source reads gCurrentSoundSource, so both must be out of
+		//the audio thread's hands before they are deleted.
 		AudioSource *audioSource = chnl->getAudioSource();
+		chnl->setAudioSource(NULL);
+		chnl->waitForMix();
 		if(audioSource!=NULL) {
 			audioSource->close();
 			delete audioSource;
 		}
+		if(gCurrentSoundSource) {
+			delete gCurrentSoundSource;
+		}
+		gCurrentSoundSource = src;
+
 		audioSource = AudioEngine::getAudioSource(mimeString, src);
 		if(!audioSource) return -1;
 
@@ -0,0 +1,97 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Tests image atlases.
+
+ res.lst has the same images twice: as separate images, R_IMAGE_0 and up,
+ and packed into the atlas R_ATLAS. Checks that each atlas region has the
+ same pixels as the separate image, then compares the time it takes to
+ draw the images both ways.
+*/
+
+#include <ma.h>
+#include <mastring.h>
+#include <conprint.h>
+#include <maassert.h>
+#include <MAUtil/ImageAtlas.h>
+#include "MAHeaders.h"
+
+using namespace MAUtil;
+
+#define NIMAGES 8
+#define ROUNDS 2000
+
+static void checkExit() {
+	MAEvent event;
+	while(maGetEvent(&event)) {
+		if(event.type == EVENT_TYPE_CLOSE ||
+			(event.type == EVENT_TYPE_KEY_PRESSED && event.key == MAK_0))
+		{
+			maExit(0);
+		}
+	}
+}
+
+static void compare(const ImageAtlas& atlas, int index, MAHandle image) {
+	MAExtent e = maGetImageSize(image);
+	MAASSERT(atlas.getSize(index) == e);
+	int w = EXTENT_X(e), h = EXTENT_Y(e);
+	int* a = new int[w * h];
+	int* b = new int[w * h];
+	MARect rect = { 0, 0, w, h };
+	maGetImageData(image, a, &rect, w);
+	maGetImageData(atlas.getImage(), b, &atlas.getRect(index), w);
+	MAASSERT(memcmp(a, b, w * h * sizeof(int)) == 0);
+	delete[] a;
+	delete[] b;
+}
+
+extern "C" int MAMain() {
+	InitConsole();
+	gConsoleLogging = 1;
+
+	ImageAtlas atlas(R_ATLAS_TABLE);
+	MAASSERT(atlas.getImage() == R_ATLAS);
+	MAASSERT(atlas.getCount() == NIMAGES);
+	MAASSERT(ATLAS_IMAGE_0 == 0 && ATLAS_IMAGE_7 == NIMAGES - 1);
+	for(int i=0; i<NIMAGES; i++) {
+		compare(atlas, i, R_IMAGE_0 + i);
+	}
+	printf("Atlas matches the images.\n");
+
+	int start = maGetMilliSecondCount();
+	for(int r=0; r<ROUNDS; r++) {
+		for(int i=0; i<NIMAGES; i++) {
+			maDrawImage(R_IMAGE_0 + i, i * 8, r % 64);
+		}
+	}
+	int separate = maGetMilliSecondCount() - start;
+	checkExit();
+
+	start = maGetMilliSecondCount();
+	for(int r=0; r<ROUNDS; r++) {
+		for(int i=0; i<NIMAGES; i++) {
+			atlas.draw(i, i * 8, r % 64);
+		}
+	}
+	int packed = maGetMilliSecondCount() - start;
+
+	printf("%i draws: images %i ms, atlas %i ms\n", ROUNDS * NIMAGES, separate, packed);
+	printf("Done.\n");
+	FREEZE;
+}
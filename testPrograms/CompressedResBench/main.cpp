@@ -0,0 +1,91 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Compares the load time of raw and LZ4-compressed resources.
+
+ res.lst holds the same file four times: as .bin, .lz4bin, .ubin and .lz4ubin.
+ Each one is read in full, first in one maReadData() call, then in small
+ chunks, and checked against the raw binary.
+
+ For cold-cache numbers, flush the OS file cache before starting the
+ program, e.g. "sync; echo 3 > /proc/sys/vm/drop_caches" on Linux.
+ Only the first measurement of each resource is cold.
+ tests/lz4ResourceBench does the same comparison on the host.
+*/
+
+#include <ma.h>
+#include <mastring.h>
+#include <conprint.h>
+#include <maassert.h>
+#include "MAHeaders.h"
+
+#define CHUNK 4096
+
+static void checkExit() {
+	MAEvent event;
+	while(maGetEvent(&event)) {
+		if(event.type == EVENT_TYPE_CLOSE ||
+			(event.type == EVENT_TYPE_KEY_PRESSED && event.key == MAK_0))
+		{
+			maExit(0);
+		}
+	}
+}
+
+static char* sReference;
+
+static void bench(const char* name, MAHandle h) {
+	int start = maGetMilliSecondCount();
+	int size = maGetDataSize(h);
+	char* buf = new char[size];
+	maReadData(h, buf, 0, size);
+	int whole = maGetMilliSecondCount() - start;
+
+	if(sReference == NULL) {
+		sReference = buf;
+	} else {
+		MAASSERT(memcmp(buf, sReference, size) == 0);
+		delete[] buf;
+	}
+
+	char chunk[CHUNK];
+	start = maGetMilliSecondCount();
+	for(int pos=0; pos<size; pos+=CHUNK) {
+		int len = size - pos < CHUNK ? size - pos : CHUNK;
+		maReadData(h, chunk, pos, len);
+		MAASSERT(memcmp(chunk, sReference + pos, len) == 0);
+	}
+	int chunked = maGetMilliSecondCount() - start;
+
+	printf("%s: %i bytes, whole %i ms, %i-byte chunks %i ms\n",
+		name, size, whole, CHUNK, chunked);
+	checkExit();
+}
+
+extern "C" int MAMain() {
+	InitConsole();
+	gConsoleLogging = 1;
+
+	bench("bin", R_RAW_BIN);
+	bench("lz4bin", R_LZ4_BIN);
+	bench("ubin", R_RAW_UBIN);
+	bench("lz4ubin", R_LZ4_UBIN);
+
+	printf("Done.\n");
+	FREEZE;
+}
@@ -0,0 +1,150 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Measures inserting 100000 rows of an integer, a text and a double.
+
+ First with one maDBExecSQLParams() per row, each in its own transaction.
+ That is slow enough that only the first 1000 rows are inserted, and the
+ time is scaled up. Then with one maDBExecSQLParams() per row, all in one
+ transaction. Then with maDBExecSQLBatch(), 1000 rows per call.
+ Reports the time of each, in milliseconds, and checks the row count.
+*/
+
+#include <ma.h>
+#include <mastring.h>
+#include <mastdlib.h>
+#include <conprint.h>
+#include <maassert.h>
+
+#define ROWS 100000
+#define AUTOCOMMIT_ROWS 1000
+#define BATCH_ROWS 1000
+#define PARAMS 3
+#define INSERT "INSERT INTO bench VALUES (?, ?, ?)"
+
+static char sTexts[BATCH_ROWS][16];
+static MADBValue sValues[BATCH_ROWS * PARAMS];
+
+static void checkExit() {
+	MAEvent event;
+	while(maGetEvent(&event)) {
+		if(event.type == EVENT_TYPE_CLOSE ||
+			(event.type == EVENT_TYPE_KEY_PRESSED && event.key == MAK_0))
+		{
+			maExit(0);
+		}
+	}
+}
+
+static MAHandle openDatabase() {
+	char path[1024];
+	int size = maGetSystemProperty("mosync.path.local", path, sizeof(path) - 32);
+	if(size < 0 || size > (int)sizeof(path) - 32)
+		strcpy(path, "/");
+	strcat(path, "DBBatchBench.db");
+	MAHandle db = maDBOpen(path);
+	MAASSERT(db > 0);
+	MAASSERT(maDBExecSQL(db, "DROP TABLE IF EXISTS bench") == MA_DB_OK);
+	MAASSERT(maDBExecSQL(db, "CREATE TABLE bench (i INTEGER, t TEXT, d DOUBLE)") == MA_DB_OK);
+	return db;
+}
+
+// Fills the parameters of \a count rows, starting with row \a first.
+static void fillValues(int first, int count) {
+	for(int i=0; i<count; i++) {
+		MADBValue* v = sValues + i * PARAMS;
+		sprintf(sTexts[i], "row %i", first + i);
+		v[0].type = MA_DB_TYPE_INT;
+		v[0].i = first + i;
+		v[1].type = MA_DB_TYPE_TEXT;
+		v[1].text.addr = sTexts[i];
+		v[1].text.length = -1;
+		v[2].type = MA_DB_TYPE_DOUBLE;
+		v[2].d = (first + i) * 0.5;
+	}
+}
+
+static int insertRows(MAHandle db, int rows) {
+	int start = maGetMilliSecondCount();
+	for(int first=0; first<rows; first+=BATCH_ROWS) {
+		int count = rows - first < BATCH_ROWS ? rows - first : BATCH_ROWS;
+		fillValues(first, count);
+		for(int i=0; i<count; i++) {
+			MAASSERT(maDBExecSQLParams(db, INSERT, sValues + i * PARAMS, PARAMS) == MA_DB_OK);
+		}
+		checkExit();
+	}
+	return maGetMilliSecondCount() - start;
+}
+
+// Returns -1 if maDBExecSQLBatch() is not available.
+static int insertBatches(MAHandle db, int rows) {
+	int start = maGetMilliSecondCount();
+	for(int first=0; first<rows; first+=BATCH_ROWS) {
+		int count = rows - first < BATCH_ROWS ? rows - first : BATCH_ROWS;
+		fillValues(first, count);
+		int res = maDBExecSQLBatch(db, INSERT, sValues, PARAMS, count);
+		if(res == IOCTL_UNAVAILABLE)
+			return -1;
+		MAASSERT(res == MA_DB_OK);
+		checkExit();
+	}
+	return maGetMilliSecondCount() - start;
+}
+
+static int countRows(MAHandle db) {
+	MAHandle cursor = maDBExecSQL(db, "SELECT COUNT(*) FROM bench");
+	MAASSERT(cursor > 0);
+	MAASSERT(maDBCursorNext(cursor) == MA_DB_OK);
+	int count;
+	MAASSERT(maDBCursorGetColumnInt(cursor, 0, &count) == MA_DB_OK);
+	maDBCursorDestroy(cursor);
+	return count;
+}
+
+extern "C" int MAMain() {
+	InitConsole();
+	gConsoleLogging = 1;
+	printf("Inserting %i rows:\n", ROWS);
+
+	MAHandle db = openDatabase();
+	int autocommit = insertRows(db, AUTOCOMMIT_ROWS);
+	printf("a transaction per row: %i ms (%i ms for %i)\n",
+		autocommit * (ROWS / AUTOCOMMIT_ROWS), autocommit, AUTOCOMMIT_ROWS);
+	maDBClose(db);
+
+	db = openDatabase();
+	MAASSERT(maDBExecSQL(db, "BEGIN") == MA_DB_OK);
+	int transaction = insertRows(db, ROWS);
+	MAASSERT(maDBExecSQL(db, "COMMIT") == MA_DB_OK);
+	MAASSERT(countRows(db) == ROWS);
+	printf("one transaction: %i ms\n", transaction);
+	maDBClose(db);
+
+	db = openDatabase();
+	int batch = insertBatches(db, ROWS);
+	if(batch < 0) {
+		printf("maDBExecSQLBatch is not available.\n");
+	} else {
+		MAASSERT(countRows(db) == ROWS);
+		printf("maDBExecSQLBatch, %i rows per call: %i ms\n", BATCH_ROWS, batch);
+	}
+	maDBClose(db);
+	printf("Done.\n");
+	FREEZE;
+}
@@ -0,0 +1,172 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Measures reading 10000 rows of 8 columns.
+
+ First with maDBCursorNext() and one maDBCursorGetColumn call per column,
+ then with maDBCursorFetchRows() and MAUtil::DBRowReader.
+ Reports the time and the number of syscalls of each, and checks that
+ both read the same values.
+*/
+
+#include <ma.h>
+#include <mastring.h>
+#include <mastdlib.h>
+#include <conprint.h>
+#include <maassert.h>
+#include <MAUtil/DBRowReader.h>
+
+using namespace MAUtil;
+
+#define ROWS 10000
+#define COLUMNS 8
+#define FETCH_ROWS 256
+#define SELECT "SELECT * FROM bench"
+
+static char sBuffer[32 * 1024];
+
+static void checkExit() {
+	MAEvent event;
+	while(maGetEvent(&event)) {
+		if(event.type == EVENT_TYPE_CLOSE ||
+			(event.type == EVENT_TYPE_KEY_PRESSED && event.key == MAK_0))
+		{
+			maExit(0);
+		}
+	}
+}
+
+// Three ints, two doubles and three texts.
+static MAHandle openDatabase() {
+	char path[1024];
+	int size = maGetSystemProperty("mosync.path.local", path, sizeof(path) - 32);
+	if(size < 0 || size > (int)sizeof(path) - 32)
+		strcpy(path, "/");
+	strcat(path, "DBFetchBench.db");
+	MAHandle db = maDBOpen(path);
+	MAASSERT(db > 0);
+	MAASSERT(maDBExecSQL(db, "DROP TABLE IF EXISTS bench") == MA_DB_OK);
+	MAASSERT(maDBExecSQL(db, "CREATE TABLE bench (a INTEGER, b TEXT, c DOUBLE, "
+		"d INTEGER, e TEXT, f DOUBLE, g INTEGER, h TEXT)") == MA_DB_OK);
+	MAASSERT(maDBExecSQL(db, "BEGIN") == MA_DB_OK);
+	for(int i=0; i<ROWS; i++) {
+		char sql[256];
+		sprintf(sql, "INSERT INTO bench VALUES (%i, 'name %i', %i.5, %i, 'street %i', "
+			"%i.25, %i, 'city %i')", i, i, i, i * 2, i, i, i % 100, i % 50);
+		MAASSERT(maDBExecSQL(db, sql) == MA_DB_OK);
+	}
+	MAASSERT(maDBExecSQL(db, "COMMIT") == MA_DB_OK);
+	return db;
+}
+
+static int sum(int type, int i, double d, int textLength) {
+	if(type == MA_DB_TYPE_INT)
+		return i;
+	if(type == MA_DB_TYPE_DOUBLE)
+		return (int)d;
+	return textLength;
+}
+
+static int readColumns(MAHandle db, int* checksum, int* syscalls) {
+	int start = maGetMilliSecondCount();
+	MAHandle cursor = maDBExecSQL(db, SELECT);
+	MAASSERT(cursor > 0);
+	int calls = 1, total = 0, rows = 0;
+	char text[64];
+	while(maDBCursorNext(cursor) == MA_DB_OK) {
+		calls++;
+		for(int col=0; col<COLUMNS; col++) {
+			int i = 0, length = 0;
+			double d = 0;
+			int type;
+			switch(col) {
+			case 0: case 3: case 6:
+				type = MA_DB_TYPE_INT;
+				MAASSERT(maDBCursorGetColumnInt(cursor, col, &i) == MA_DB_OK);
+				break;
+			case 2: case 5:
+				type = MA_DB_TYPE_DOUBLE;
+				MAASSERT(maDBCursorGetColumnDouble(cursor, col, &d) == MA_DB_OK);
+				break;
+			default:
+				type = MA_DB_TYPE_TEXT;
+				length = maDBCursorGetColumnText(cursor, col, text, sizeof(text));
+				MAASSERT(length >= 0 && length <= (int)sizeof(text));
+			}
+			calls++;
+			total += sum(type, i, d, length);
+		}
+		if(++rows % 1000 == 0)
+			checkExit();
+	}
+	maDBCursorDestroy(cursor);
+	*checksum = total;
+	*syscalls = calls + 2;
+	return maGetMilliSecondCount() - start;
+}
+
+// Returns -1 if maDBCursorFetchRows() is not available.
+static int fetchRows(MAHandle db, int* checksum, int* syscalls) {
+	int start = maGetMilliSecondCount();
+	MAHandle cursor = maDBExecSQL(db, SELECT);
+	MAASSERT(cursor > 0);
+	int calls = 1, total = 0;
+	int rows;
+	while((rows = maDBCursorFetchRows(cursor, sBuffer, sizeof(sBuffer), FETCH_ROWS)) > 0) {
+		calls++;
+		DBRowReader reader(sBuffer, rows);
+		while(reader.nextRow()) {
+			while(reader.nextColumn()) {
+				total += sum(reader.getType(), reader.getInt(), reader.getDouble(),
+					reader.getLength());
+			}
+		}
+		checkExit();
+	}
+	maDBCursorDestroy(cursor);
+	if(rows == IOCTL_UNAVAILABLE)
+		return -1;
+	MAASSERT(rows == 0);
+	*checksum = total;
+	*syscalls = calls + 2;
+	return maGetMilliSecondCount() - start;
+}
+
+extern "C" int MAMain() {
+	InitConsole();
+	gConsoleLogging = 1;
+	printf("Reading %i rows of %i columns:\n", ROWS, COLUMNS);
+
+	MAHandle db = openDatabase();
+	int columnSum, columnCalls;
+	int columns = readColumns(db, &columnSum, &columnCalls);
+	printf("a syscall per column: %i ms, %i syscalls\n", columns, columnCalls);
+
+	int fetchSum, fetchCalls;
+	int fetch = fetchRows(db, &fetchSum, &fetchCalls);
+	if(fetch < 0) {
+		printf("maDBCursorFetchRows is not available.\n");
+	} else {
+		MAASSERT(fetchSum == columnSum);
+		printf("maDBCursorFetchRows, %i rows per call: %i ms, %i syscalls\n",
+			FETCH_ROWS, fetch, fetchCalls);
+	}
+	maDBClose(db);
+	printf("Done.\n");
+	FREEZE;
+}
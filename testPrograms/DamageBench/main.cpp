@@ -0,0 +1,111 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Measures the per-frame cost of a mostly static MAUI screen.
+
+ The screen is a grid of labels and a status label at the bottom. Each
+ frame changes the text of the status label and repaints, so that only the
+ status label is damaged and Engine::repaint() updates only its part of the
+ screen. For comparison, the same is done while the whole screen is
+ repainted every frame. Reports the average time per frame.
+*/
+
+#include <ma.h>
+#include <mastring.h>
+#include <mavsprintf.h>
+#include <conprint.h>
+#include <maassert.h>
+#include <MAUI/Engine.h>
+#include <MAUI/Label.h>
+#include <MAUI/Font.h>
+#include "MAHeaders.h"
+
+using namespace MAUI;
+using namespace MAUtil;
+
+#define FRAMES 200
+#define COLUMNS 4
+#define ROWS 12
+
+static void checkExit() {
+	MAEvent event;
+	while(maGetEvent(&event)) {
+		if(event.type == EVENT_TYPE_CLOSE ||
+			(event.type == EVENT_TYPE_KEY_PRESSED && event.key == MAK_0))
+		{
+			maExit(0);
+		}
+	}
+}
+
+// Returns the average time per frame, in milliseconds.
+static int run(Engine& engine, Widget* main, Label* status, bool full) {
+	char buf[32];
+	int start = maGetMilliSecondCount();
+	for(int frame=0; frame<FRAMES; frame++) {
+		checkExit();
+		sprintf(buf, "Frame %i", frame);
+		status->setCaption(buf);
+		if(full)
+			main->requestRepaint();
+		engine.repaint();
+	}
+	return (maGetMilliSecondCount() - start) / FRAMES;
+}
+
+extern "C" int MAMain() {
+	MAExtent scr = maGetScrSize();
+	int w = EXTENT_X(scr), h = EXTENT_Y(scr);
+
+	//one pixel, off-screen.
+	MARect probe = { -1, -1, 1, 1 };
+	if(maUpdateScreenRects(&probe, 1) == IOCTL_UNAVAILABLE) {
+		InitConsole();
+		printf("maUpdateScreenRects is not available.\n");
+		FREEZE;
+	}
+
+	Font* font = new Font(R_FONT);
+	Engine& engine = Engine::getSingleton();
+	engine.setDefaultFont(font);
+
+	Widget* main = new Label(0, 0, w, h, NULL, "", 0x202020, font);
+	int statusHeight = font->getCharset().lineHeight + 4;
+	int cellW = w / COLUMNS, cellH = (h - statusHeight) / ROWS;
+	char buf[32];
+	for(int y=0; y<ROWS; y++) {
+		for(int x=0; x<COLUMNS; x++) {
+			sprintf(buf, "Item %i", y * COLUMNS + x);
+			new Label(x * cellW, y * cellH, cellW - 2, cellH - 2, main, buf, 0x404040, font);
+		}
+	}
+	Label* status = new Label(0, h - statusHeight, w, statusHeight, main, "", 0x000080, font);
+	engine.setMain(main);
+	engine.repaint();
+
+	int partial = run(engine, main, status, false);
+	int full = run(engine, main, status, true);
+
+	InitConsole();
+	gConsoleLogging = 1;
+	printf("%i labels\n", COLUMNS * ROWS + 1);
+	printf("status label only: %i ms/frame\n", partial);
+	printf("whole screen: %i ms/frame\n", full);
+	printf("Done.\n");
+	FREEZE;
+}
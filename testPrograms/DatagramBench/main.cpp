@@ -0,0 +1,136 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Compares maConnWriteTo()/maConnReadFrom() with
+ maConnWriteToMulti()/maConnReadFromMulti() over the loopback interface.
+
+ Sends COUNT datagrams of SIZE bytes from one unbound datagram connection
+ to another and prints the throughput of each method.
+*/
+
+#include <ma.h>
+#include <conprint.h>
+#include <maassert.h>
+#include <mastring.h>
+
+#define PORT 4321
+#define COUNT 4096
+#define SIZE 512
+#define BATCH 32
+
+static char sSendBuf[BATCH][SIZE];
+static char sRecvBuf[BATCH][SIZE];
+
+static void checkExit(const MAEvent& event) {
+	if(event.type == EVENT_TYPE_CLOSE ||
+		(event.type == EVENT_TYPE_KEY_PRESSED && event.key == MAK_0))
+	{
+		maExit(0);
+	}
+}
+
+// Waits for an operation on \a conn to finish. Returns its result.
+static int waitConn(MAHandle conn, int opType) {
+	while(true) {
+		MAEvent event;
+		while(maGetEvent(&event)) {
+			checkExit(event);
+			if(event.type == EVENT_TYPE_CONN && event.conn.handle == conn) {
+				MAASSERT(event.conn.opType == opType);
+				return event.conn.result;
+			}
+		}
+		maWait(0);
+	}
+}
+
+static MAConnAddr loopback() {
+	MAConnAddr addr;
+	addr.family = CONN_FAMILY_INET4;
+	addr.inet4.addr = (127 << 24) | 1;
+	addr.inet4.port = PORT;
+	return addr;
+}
+
+static int benchSingle(MAHandle tx, MAHandle rx) {
+	MAConnAddr dst = loopback();
+	MAConnAddr src;
+	int start = maGetMilliSecondCount();
+	for(int i=0; i<COUNT; i++) {
+		maConnWriteTo(tx, sSendBuf[0], SIZE, &dst);
+		MAASSERT(waitConn(tx, CONNOP_WRITE) > 0);
+		maConnReadFrom(rx, sRecvBuf[0], SIZE, &src);
+		MAASSERT(waitConn(rx, CONNOP_READ) == SIZE);
+	}
+	return maGetMilliSecondCount() - start;
+}
+
+static int benchMulti(MAHandle tx, MAHandle rx) {
+	MAConnDatagram out[BATCH], in[BATCH];
+	for(int i=0; i<BATCH; i++) {
+		out[i].data = sSendBuf[i];
+		out[i].size = SIZE;
+		out[i].addr = loopback();
+		in[i].data = sRecvBuf[i];
+		in[i].size = SIZE;
+	}
+	int start = maGetMilliSecondCount();
+	for(int sent=0; sent<COUNT; sent+=BATCH) {
+		maConnWriteToMulti(tx, out, BATCH);
+		MAASSERT(waitConn(tx, CONNOP_WRITE) == BATCH);
+		int received = 0;
+		while(received < BATCH) {
+			maConnReadFromMulti(rx, in, BATCH - received);
+			int res = waitConn(rx, CONNOP_READ);
+			MAASSERT(res > 0);
+			received += res;
+		}
+	}
+	return maGetMilliSecondCount() - start;
+}
+
+static void report(const char* name, int ms) {
+	if(ms <= 0)
+		ms = 1;
+	printf("%s: %i ms, %i dgrams/s\n", name, ms, (int)((long long)COUNT * 1000 / ms));
+}
+
+extern "C" int MAMain() {
+	InitConsole();
+	gConsoleLogging = 1;
+
+	MAHandle rx = maConnect("datagram://:4321");
+	printf("rx: %i\n", rx);
+	MAHandle tx = maConnect("datagram://");
+	printf("tx: %i\n", tx);
+	if(rx < 0 || tx < 0) {
+		FREEZE;
+	}
+
+	for(int i=0; i<BATCH; i++) {
+		memset(sSendBuf[i], i, SIZE);
+	}
+
+	report("Single", benchSingle(tx, rx));
+	report("Multi", benchMulti(tx, rx));
+
+	maConnClose(tx);
+	maConnClose(rx);
+	printf("Done.\n");
+	FREEZE;
+}
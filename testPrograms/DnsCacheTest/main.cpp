@@ -0,0 +1,104 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Tests maDnsPrefetch() and maDnsFlush().
+
+ Measures how long maConnect() takes to complete with a cold cache,
+ with a cache warmed by maDnsPrefetch(), and for repeated connections.
+ Point HOST at a name in your hosts file (or a local stub DNS server)
+ that has something listening on PORT.
+
+ tests/dnsCacheTest checks the cache itself, with a stub backend.
+*/
+
+#include <ma.h>
+#include <conprint.h>
+#include <maassert.h>
+
+#define HOST "localhost"
+#define PORT "80"
+#define URL "socket://" HOST ":" PORT
+#define REPEATS 10
+
+static void checkExit(const MAEvent& event) {
+	if(event.type == EVENT_TYPE_CLOSE ||
+		(event.type == EVENT_TYPE_KEY_PRESSED && event.key == MAK_0))
+	{
+		maExit(0);
+	}
+}
+
+// Returns the time in milliseconds, or a CONNERR code.
+static int timeConnect() {
+	int start = maGetMilliSecondCount();
+	MAHandle conn = maConnect(URL);
+	if(conn < 0)
+		return conn;
+	while(true) {
+		MAEvent event;
+		while(maGetEvent(&event)) {
+			checkExit(event);
+			if(event.type == EVENT_TYPE_CONN && event.conn.handle == conn) {
+				int time = maGetMilliSecondCount() - start;
+				maConnClose(conn);
+				return event.conn.result < 0 ? event.conn.result : time;
+			}
+		}
+		maWait(0);
+	}
+}
+
+static void idle(int ms) {
+	int end = maGetMilliSecondCount() + ms;
+	while(maGetMilliSecondCount() < end) {
+		MAEvent event;
+		while(maGetEvent(&event)) {
+			checkExit(event);
+		}
+		int left = end - maGetMilliSecondCount();
+		if(left > 0)
+			maWait(left);
+	}
+}
+
+extern "C" int MAMain() {
+	InitConsole();
+	gConsoleLogging = 1;
+
+	if(maDnsFlush() == IOCTL_UNAVAILABLE) {
+		printf("DNS cache unavailable.\n");
+		FREEZE;
+	}
+	MAASSERT(maDnsPrefetch("") == CONNERR_URL);
+
+	printf("Cold: %i ms\n", timeConnect());
+
+	int total = 0;
+	for(int i=0; i<REPEATS; i++) {
+		total += timeConnect();
+	}
+	printf("Cached: %i ms avg\n", total / REPEATS);
+
+	maDnsFlush();
+	maDnsPrefetch(HOST);
+	idle(1000);
+	printf("Prefetched: %i ms\n", timeConnect());
+
+	printf("Done.\n");
+	FREEZE;
+}
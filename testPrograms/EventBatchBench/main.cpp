@@ -0,0 +1,141 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Measures the cost of event retrieval and dispatch per frame.
+
+ 1. Polls an empty queue with maGetEvent() and with maGetEvents().
+    This is the fixed per-call cost, paid at least once per frame.
+ 2. Dispatches a synthetic frame of pointer drags through
+    Moblet::dispatchEvent(), as Moblet::run() does.
+ 3. For a few seconds, drains real input once per frame with each method
+    and reports the number of syscalls and events. Drag the mouse meanwhile.
+*/
+
+#include <ma.h>
+#include <conprint.h>
+#include <maassert.h>
+#include <MAUtil/Moblet.h>
+
+using namespace MAUtil;
+
+#define POLLS 10000
+#define FRAMES 1000
+#define EVENTS_PER_FRAME 32
+#define LIVE_MS 3000
+#define FRAME_MS 16
+
+class BenchMoblet : public Moblet {
+public:
+	BenchMoblet() : mMoves(0) {}
+
+	virtual void pointerMoveEvent(MAPoint2d p) {
+		mMoves++;
+	}
+
+	void runBenchmarks() {
+		if(maGetEvents(mEvents, 1) == IOCTL_UNAVAILABLE) {
+			printf("maGetEvents() unavailable.\n");
+			return;
+		}
+		benchPolling();
+		benchDispatch();
+		benchLive("maGetEvent", false);
+		benchLive("maGetEvents", true);
+	}
+
+private:
+	MAEvent mEvents[MOBLET_EVENT_BATCH];
+	int mMoves;
+
+	void drain() {
+		while(maGetEvents(mEvents, MOBLET_EVENT_BATCH) > 0) {}
+	}
+
+	void benchPolling() {
+		drain();
+		int start = maGetMilliSecondCount();
+		for(int i=0; i<POLLS; i++) {
+			maGetEvent(mEvents);
+		}
+		int single = maGetMilliSecondCount() - start;
+
+		start = maGetMilliSecondCount();
+		for(int i=0; i<POLLS; i++) {
+			maGetEvents(mEvents, MOBLET_EVENT_BATCH);
+		}
+		int batch = maGetMilliSecondCount() - start;
+		printf("Empty poll, %i calls:\n", POLLS);
+		printf(" maGetEvent %i ms, maGetEvents %i ms\n", single, batch);
+	}
+
+	void benchDispatch() {
+		MAEvent frame[EVENTS_PER_FRAME];
+		for(int i=0; i<EVENTS_PER_FRAME; i++) {
+			frame[i].type = EVENT_TYPE_POINTER_DRAGGED;
+			frame[i].point.x = i;
+			frame[i].point.y = i;
+			frame[i].touchId = 0;
+		}
+		mMoves = 0;
+		int start = maGetMilliSecondCount();
+		for(int f=0; f<FRAMES; f++) {
+			for(int i=0; i<EVENTS_PER_FRAME; i++) {
+				dispatchEvent(frame[i]);
+			}
+		}
+		int time = maGetMilliSecondCount() - start;
+		MAASSERT(mMoves == FRAMES * EVENTS_PER_FRAME);
+		printf("Dispatch, %i frames of %i drags:\n", FRAMES, EVENTS_PER_FRAME);
+		printf(" %i ms, %i us/frame\n", time, time * 1000 / FRAMES);
+	}
+
+	void benchLive(const char* name, bool batch) {
+		int calls = 0, events = 0, frames = 0;
+		int end = maGetMilliSecondCount() + LIVE_MS;
+		while(maGetMilliSecondCount() < end) {
+			int n;
+			do {
+				calls++;
+				if(batch)
+					n = maGetEvents(mEvents, MOBLET_EVENT_BATCH);
+				else
+					n = maGetEvent(mEvents);
+				for(int i=0; i<n; i++) {
+					if(mEvents[i].type == EVENT_TYPE_CLOSE)
+						maExit(0);
+					dispatchEvent(mEvents[i]);
+				}
+				events += n;
+			} while(n > 0);
+			frames++;
+			maWait(FRAME_MS);
+		}
+		printf("%s, %i frames: %i events, %i calls\n", name, frames, events, calls);
+	}
+};
+
+extern "C" int MAMain() {
+	InitConsole();
+	gConsoleLogging = 1;
+
+	BenchMoblet moblet;
+	moblet.runBenchmarks();
+
+	printf("Done.\n");
+	FREEZE;
+}
@@ -0,0 +1,197 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Measures frame hitches caused by image decoding.
+
+ Animates a bar across the screen while a new "thumbnail" arrives every few
+ frames, first decoding it with maCreateImageFromData(), then with
+ maCreateImageFromDataAsync(). Reports the longest frame and the number of
+ frames that took longer than HITCH_MS.
+
+ Also checks that maCancelImageDecode() leaves the placeholder empty.
+*/
+
+#include <ma.h>
+#include <mastring.h>
+#include <conprint.h>
+#include <maassert.h>
+#include "MAHeaders.h"
+
+#define FRAMES 300
+#define DECODE_INTERVAL 5
+#define HITCH_MS 34
+#define MAX_IMAGES 8
+
+struct Stats {
+	int total;
+	int worst;
+	int hitches;
+	int decoded;
+};
+
+//an image is drawn once it is ready. A slot that is still decoding
+//when its next image arrives gets a new placeholder.
+static MAHandle sImages[MAX_IMAGES];
+static bool sReady[MAX_IMAGES];
+static int sPending;
+
+static void checkExit(const MAEvent& event) {
+	if(event.type == EVENT_TYPE_CLOSE ||
+		(event.type == EVENT_TYPE_KEY_PRESSED && event.key == MAK_0))
+	{
+		maExit(0);
+	}
+}
+
+static MAHandle source(int i) {
+	return (i & 1) ? R_JPEG : R_PNG;
+}
+
+static void drawFrame(int frame) {
+	MAExtent scr = maGetScrSize();
+	int w = EXTENT_X(scr), h = EXTENT_Y(scr);
+	maSetColor(0);
+	maFillRect(0, 0, w, h);
+	maSetColor(0xff8000);
+	maFillRect((frame * 4) % w, h / 2 - 8, 32, 16);
+	for(int i=0; i<MAX_IMAGES; i++) {
+		if(sReady[i])
+			maDrawImage(sImages[i], (i % 4) * (w / 4), (i / 4) * (h / 4));
+	}
+	maUpdateScreen();
+}
+
+static void run(bool async, Stats& s) {
+	memset(&s, 0, sizeof(s));
+	sPending = 0;
+	for(int i=0; i<MAX_IMAGES; i++) {
+		sImages[i] = 0;
+		sReady[i] = false;
+	}
+
+	int start = maGetMilliSecondCount();
+	int last = start;
+	int next = 0;
+	for(int frame=0; frame<FRAMES || sPending > 0; frame++) {
+		MAEvent event;
+		while(maGetEvent(&event)) {
+			checkExit(event);
+			if(event.type == EVENT_TYPE_IMAGE_DECODED) {
+				MAASSERT(event.imageDecodeResult == RES_OK);
+				sPending--;
+				s.decoded++;
+				int i = 0;
+				while(i < MAX_IMAGES && sImages[i] != event.imagePlaceholder)
+					i++;
+				if(i < MAX_IMAGES)
+					sReady[i] = true;
+				else	//replaced while the event was on its way.
+					maDestroyPlaceholder(event.imagePlaceholder);
+			}
+		}
+
+		if(frame < FRAMES && frame % DECODE_INTERVAL == 0) {
+			int slot = next % MAX_IMAGES;
+			MAHandle data = source(next);
+			MAHandle old = sImages[slot];
+			if(old) {
+				if(sReady[slot]) {
+					maDestroyPlaceholder(old);
+				} else if(maCancelImageDecode(old)) {
+					//like a thumbnail that was scrolled away before it was shown.
+					sPending--;
+					maDestroyPlaceholder(old);
+				}
+			}
+			sImages[slot] = maCreatePlaceholder();
+			sReady[slot] = false;
+			if(async) {
+				int res = maCreateImageFromDataAsync(sImages[slot], data, 0, maGetDataSize(data));
+				MAASSERT(res == RES_OK);
+				sPending++;
+			} else {
+				int res = maCreateImageFromData(sImages[slot], data, 0, maGetDataSize(data));
+				MAASSERT(res == RES_OK);
+				sReady[slot] = true;
+				s.decoded++;
+			}
+			next++;
+		}
+
+		drawFrame(frame);
+
+		int now = maGetMilliSecondCount();
+		int t = now - last;
+		last = now;
+		if(t > s.worst)
+			s.worst = t;
+		if(t > HITCH_MS)
+			s.hitches++;
+	}
+	s.total = maGetMilliSecondCount() - start;
+
+	for(int i=0; i<MAX_IMAGES; i++) {
+		if(sImages[i])
+			maDestroyPlaceholder(sImages[i]);
+		sImages[i] = 0;
+		sReady[i] = false;
+	}
+}
+
+static void testCancel() {
+	MAHandle p = maCreatePlaceholder();
+	int res = maCreateImageFromDataAsync(p, R_PNG, 0, maGetDataSize(R_PNG));
+	if(res == IOCTL_UNAVAILABLE) {
+		printf("maCreateImageFromDataAsync is not available.\n");
+		FREEZE;
+	}
+	MAASSERT(res == RES_OK);
+	MAASSERT(maCancelImageDecode(p) == 1);
+	MAASSERT(maCancelImageDecode(p) == 0);
+	//the placeholder is empty again, so it can be used right away.
+	MAASSERT(maCreateImageFromData(p, R_JPEG, 0, maGetDataSize(R_JPEG)) == RES_OK);
+	maDestroyPlaceholder(p);
+	printf("Cancel OK.\n");
+}
+
+static void print(const char* name, const Stats& s) {
+	printf("%s: %i decodes, %i ms\n", name, s.decoded, s.total);
+	printf("  worst frame %i ms, %i frames > %i ms\n", s.worst, s.hitches, HITCH_MS);
+}
+
+extern "C" int MAMain() {
+	InitConsole();
+	gConsoleLogging = 1;
+
+	testCancel();
+
+	Stats sync, async;
+	run(false, sync);
+	run(true, async);
+
+	maSetImageDecodeConcurrency(1);
+	Stats single;
+	run(true, single);
+	maSetImageDecodeConcurrency(2);
+
+	print("sync", sync);
+	print("async", async);
+	print("async, 1 thread", single);
+	printf("Done.\n");
+	FREEZE;
+}
@@ -0,0 +1,172 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Measures image scaling and gradient generation.
+
+ A 512x512 image is scaled to a few sizes, the way MAUI::Scaler builds its
+ levels, first pixel by pixel in MoSync code and then with
+ maCreateScaledImage() and each of its filters. Then a 512x512 drawable
+ image is filled with linear and radial gradients, first in MoSync code
+ and then with maFillLinearGradient() and maFillRadialGradient().
+ Reports the time of each, in milliseconds.
+*/
+
+#include <ma.h>
+#include <mastring.h>
+#include <conprint.h>
+#include <maassert.h>
+#include <madmath.h>
+
+#define SIZE 512
+#define LEVELS 4
+
+static const int sLevels[LEVELS] = { 64, 128, 256, 384 };
+
+static void checkExit() {
+	MAEvent event;
+	while(maGetEvent(&event)) {
+		if(event.type == EVENT_TYPE_CLOSE ||
+			(event.type == EVENT_TYPE_KEY_PRESSED && event.key == MAK_0))
+		{
+			maExit(0);
+		}
+	}
+}
+
+// Nearest neighbour, like MAUI::Scaler does without maCreateScaledImage().
+static void guestScale(MAHandle dst, const int* src, int size) {
+	int* pixels = new int[size * size];
+	int delta = (SIZE << 16) / size;
+	for(int y=0; y<size; y++) {
+		const int* row = src + ((y * delta) >> 16) * SIZE;
+		int u = 0;
+		for(int x=0; x<size; x++) {
+			pixels[y * size + x] = row[u >> 16];
+			u += delta;
+		}
+	}
+	maCreateImageRaw(dst, pixels, EXTENT(size, size), 1);
+	delete[] pixels;
+}
+
+static int timeGuestScale(const int* src) {
+	int start = maGetMilliSecondCount();
+	for(int i=0; i<LEVELS; i++) {
+		MAHandle h = maCreatePlaceholder();
+		guestScale(h, src, sLevels[i]);
+		maDestroyPlaceholder(h);
+		checkExit();
+	}
+	return maGetMilliSecondCount() - start;
+}
+
+static int timeNativeScale(MAHandle image, int filter) {
+	MARect rect = { 0, 0, SIZE, SIZE };
+	int start = maGetMilliSecondCount();
+	for(int i=0; i<LEVELS; i++) {
+		MAHandle h = maCreatePlaceholder();
+		int res = maCreateScaledImage(h, image, &rect, sLevels[i], sLevels[i], filter);
+		MAASSERT(res == RES_OK);
+		maDestroyPlaceholder(h);
+		checkExit();
+	}
+	return maGetMilliSecondCount() - start;
+}
+
+static int lerpColor(int a, int b, double t) {
+	int c = 0;
+	for(int shift=0; shift<32; shift+=8) {
+		int ca = (a >> shift) & 0xff;
+		int cb = (b >> shift) & 0xff;
+		c |= ((int)(ca + (cb - ca) * t) & 0xff) << shift;
+	}
+	return c;
+}
+
+// A radial gradient in MoSync code, drawn with maDrawRGB().
+static int timeGuestRadial(MAHandle image) {
+	int start = maGetMilliSecondCount();
+	int* pixels = new int[SIZE * SIZE];
+	for(int y=0; y<SIZE; y++) {
+		for(int x=0; x<SIZE; x++) {
+			double len = sqrt((double)((x - SIZE/2) * (x - SIZE/2) + (y - SIZE/2) * (y - SIZE/2)));
+			double t = len < SIZE/2 ? len / (SIZE/2) : 1.0;
+			pixels[y * SIZE + x] = lerpColor(0xffffffff, 0xff0040a0, t);
+		}
+	}
+	MAHandle old = maSetDrawTarget(image);
+	MAPoint2d dst = { 0, 0 };
+	MARect rect = { 0, 0, SIZE, SIZE };
+	maDrawRGB(&dst, pixels, &rect, SIZE);
+	maSetDrawTarget(old);
+	delete[] pixels;
+	return maGetMilliSecondCount() - start;
+}
+
+static int timeNativeGradients(MAHandle image, bool radial) {
+	MARect rect = { 0, 0, SIZE, SIZE };
+	MAPoint2d a = { SIZE/2, SIZE/2 };
+	MAPoint2d b = { SIZE, SIZE };
+	int start = maGetMilliSecondCount();
+	MAHandle old = maSetDrawTarget(image);
+	int res;
+	if(radial)
+		res = maFillRadialGradient(&rect, &a, SIZE/2, 0xffffffff, 0xff0040a0);
+	else
+		res = maFillLinearGradient(&rect, &a, &b, 0xffffffff, 0xff0040a0);
+	MAASSERT(res == 0);
+	maSetDrawTarget(old);
+	return maGetMilliSecondCount() - start;
+}
+
+extern "C" int MAMain() {
+	int* src = new int[SIZE * SIZE];
+	for(int y=0; y<SIZE; y++) {
+		for(int x=0; x<SIZE; x++) {
+			src[y * SIZE + x] = 0xff000000 | ((x & 0xff) << 16) | ((y & 0xff) << 8) | ((x ^ y) & 0xff);
+		}
+	}
+	MAHandle image = maCreatePlaceholder();
+	MAASSERT(maCreateImageRaw(image, src, EXTENT(SIZE, SIZE), 1) == RES_OK);
+
+	int guest = timeGuestScale(src);
+	int nearest = timeNativeScale(image, IMAGE_SCALE_NEAREST);
+	int bilinear = timeNativeScale(image, IMAGE_SCALE_BILINEAR);
+	int box = timeNativeScale(image, IMAGE_SCALE_BOX);
+	delete[] src;
+
+	MAHandle target = maCreatePlaceholder();
+	MAASSERT(maCreateDrawableImage(target, SIZE, SIZE) == RES_OK);
+	int guestRadial = timeGuestRadial(target);
+	int linear = timeNativeGradients(target, false);
+	int radial = timeNativeGradients(target, true);
+
+	InitConsole();
+	gConsoleLogging = 1;
+	printf("Scaling %ix%i to %i sizes:\n", SIZE, SIZE, LEVELS);
+	printf("MoSync code, nearest: %i ms\n", guest);
+	printf("nearest: %i ms\n", nearest);
+	printf("bilinear: %i ms\n", bilinear);
+	printf("box: %i ms\n", box);
+	printf("Gradients, %ix%i:\n", SIZE, SIZE);
+	printf("MoSync code, radial: %i ms\n", guestRadial);
+	printf("linear: %i ms\n", linear);
+	printf("radial: %i ms\n", radial);
+	printf("Done.\n");
+	FREEZE;
+}
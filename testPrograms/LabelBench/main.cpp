@@ -0,0 +1,136 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Measures the cost of label lookups with many labels.
+
+ Builds a resource file with NLABELS labels in memory and loads it with
+ maLoadResources(). Then looks up every label, plus one missing label,
+ with maFindLabel() and with a single maFindLabels() call.
+*/
+
+#include <ma.h>
+#include <mastring.h>
+#include <mavsprintf.h>
+#include <conprint.h>
+#include <maassert.h>
+#include <IX_RESOURCE_TYPES.h>
+
+#define NLABELS 5000
+#define ROUNDS 10
+#define NAME_SIZE 16
+
+static char sNames[NLABELS][NAME_SIZE];
+static const char* sNamePtrs[NLABELS];
+static int sIndices[NLABELS];
+
+static void checkExit() {
+	MAEvent event;
+	while(maGetEvent(&event)) {
+		if(event.type == EVENT_TYPE_CLOSE ||
+			(event.type == EVENT_TYPE_KEY_PRESSED && event.key == MAK_0))
+		{
+			maExit(0);
+		}
+	}
+}
+
+// Same encoding as Stream::readUnsignedVarInt().
+static int writeUVarInt(byte* dst, int value) {
+	int n = 0;
+	while(value > 0x7f) {
+		dst[n++] = value & 0x7f;
+		value >>= 7;
+	}
+	dst[n++] = value | 0x80;
+	return n;
+}
+
+// Returns a data object with a resource file containing the labels.
+static MAHandle createLabelResources() {
+	int size = 4 + 8 + NLABELS * (1 + 4 + NAME_SIZE) + 1;
+	byte* buf = new byte[size];
+	int pos = 0;
+	memcpy(buf, "MARS", 4);
+	pos += 4;
+	pos += writeUVarInt(buf + pos, NLABELS);
+	pos += writeUVarInt(buf + pos, 0);	// total size; unused by the runtime.
+	for(int i=0; i<NLABELS; i++) {
+		int len = strlen(sNames[i]) + 1;
+		buf[pos++] = RT_LABEL;
+		pos += writeUVarInt(buf + pos, len);
+		memcpy(buf + pos, sNames[i], len);
+		pos += len;
+	}
+	buf[pos++] = 0;
+
+	MAHandle data = maCreatePlaceholder();
+	MAASSERT(maCreateData(data, pos) == RES_OK);
+	maWriteData(data, buf, 0, pos);
+	delete[] buf;
+	return data;
+}
+
+extern "C" int MAMain() {
+	InitConsole();
+	gConsoleLogging = 1;
+
+	for(int i=0; i<NLABELS; i++) {
+		sprintf(sNames[i], "label%i", i);
+		sNamePtrs[i] = sNames[i];
+	}
+	MAHandle data = createLabelResources();
+	MAASSERT(maLoadResources(data) > 0);
+	maDestroyObject(data);
+
+	// the labels replace the static resources, starting at index 1.
+	MAASSERT(maFindLabel(sNames[0]) == 1);
+	MAASSERT(maFindLabel(sNames[NLABELS - 1]) == NLABELS);
+	MAASSERT(maFindLabel("nolabel") == -1);
+
+	int start = maGetMilliSecondCount();
+	for(int r=0; r<ROUNDS; r++) {
+		for(int i=0; i<NLABELS; i++) {
+			maFindLabel(sNames[i]);
+		}
+		maFindLabel("nolabel");
+	}
+	int single = maGetMilliSecondCount() - start;
+	printf("maFindLabel: %i lookups in %i ms\n", ROUNDS * (NLABELS + 1), single);
+	checkExit();
+
+	start = maGetMilliSecondCount();
+	int found = 0;
+	for(int r=0; r<ROUNDS; r++) {
+		found = maFindLabels(sNamePtrs, sIndices, NLABELS);
+		if(found == IOCTL_UNAVAILABLE) {
+			printf("maFindLabels unavailable.\n");
+			break;
+		}
+	}
+	if(found != IOCTL_UNAVAILABLE) {
+		int batch = maGetMilliSecondCount() - start;
+		MAASSERT(found == NLABELS);
+		for(int i=0; i<NLABELS; i++) {
+			MAASSERT(sIndices[i] == i + 1);
+		}
+		printf("maFindLabels: %i lookups in %i ms\n", ROUNDS * NLABELS, batch);
+	}
+
+	printf("Done.\n");
+	FREEZE;
+}
@@ -0,0 +1,103 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Tests lazy loading of static resources.
+
+ Reports the time from runtime start to MAMain(), then the cost of
+ maLoadResource(), and of the first and second use of each kind of
+ resource. The first use of a binary, image or sprite loads it from the
+ mapped resource file; the second should be free.
+
+ tests/lazyResourceBench measures the time and memory of reading binaries
+ against mapping them, on the host.
+*/
+
+#include <ma.h>
+#include <conprint.h>
+#include <maassert.h>
+#include "MAHeaders.h"
+
+static int timeDataSize(MAHandle h, int& size) {
+	int start = maGetMilliSecondCount();
+	size = maGetDataSize(h);
+	return maGetMilliSecondCount() - start;
+}
+
+static int timeImageSize(MAHandle h, MAExtent& extent) {
+	int start = maGetMilliSecondCount();
+	extent = maGetImageSize(h);
+	return maGetMilliSecondCount() - start;
+}
+
+static int timeLoad(MAHandle h) {
+	int start = maGetMilliSecondCount();
+	MAASSERT(maLoadResource(h, h, MA_RESOURCE_OPEN | MA_RESOURCE_CLOSE) > 0);
+	return maGetMilliSecondCount() - start;
+}
+
+static void testBinary(const char* name, MAHandle h) {
+	int load = timeLoad(h);
+	int size, size2;
+	int first = timeDataSize(h, size);
+	int second = timeDataSize(h, size2);
+	MAASSERT(size == size2);
+	printf("%s: %i bytes, load %i ms, first %i ms, second %i ms\n",
+		name, size, load, first, second);
+}
+
+static void testImage(const char* name, MAHandle h) {
+	int load = timeLoad(h);
+	MAExtent e, e2;
+	int first = timeImageSize(h, e);
+	int second = timeImageSize(h, e2);
+	MAASSERT(e == e2);
+	printf("%s: %ix%i, load %i ms, first %i ms, second %i ms\n", name,
+		EXTENT_X(e), EXTENT_Y(e), load, first, second);
+}
+
+extern "C" int MAMain() {
+	int startup = maGetMilliSecondCount();
+	InitConsole();
+	gConsoleLogging = 1;
+
+	printf("Startup: %i ms\n", startup);
+
+	testBinary("Binary", R_BIG);
+	//ubins are always loaded.
+	int size;
+	printf("Ubin: %i bytes, %i ms\n", maGetDataSize(R_UBIN), timeDataSize(R_UBIN, size));
+	testImage("Image", R_IMAGE);
+	testImage("Sprite", R_SPRITE);
+
+	// binaries are writable, even when they share the mapped file,
+	// and the write doesn't reach the next load.
+	char text[4];
+	timeLoad(R_TEXT);
+	maReadData(R_TEXT, text, 0, 4);
+	MAASSERT(text[0] == 'L');
+	maWriteData(R_TEXT, "M", 0, 1);
+	maReadData(R_TEXT, text, 0, 4);
+	MAASSERT(text[0] == 'M');
+	maDestroyObject(R_TEXT);
+	timeLoad(R_TEXT);
+	maReadData(R_TEXT, text, 0, 4);
+	MAASSERT(text[0] == 'L');
+
+	printf("Done.\n");
+	FREEZE;
+}
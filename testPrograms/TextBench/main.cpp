@@ -0,0 +1,117 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Measures drawing a full screen of bitmap-font text.
+
+ Each frame fills the screen with lines of text, first with one
+ maDrawImageRegion() call per glyph, like MAUI::Font used to do, then with
+ MAUI::Font::drawString(), which draws the glyphs of a string with
+ maDrawImageRegions(). Reports the average time per frame.
+*/
+
+#include <ma.h>
+#include <mastring.h>
+#include <conprint.h>
+#include <maassert.h>
+#include <MAUI/Font.h>
+#include "MAHeaders.h"
+
+using namespace MAUI;
+
+#define FRAMES 50
+
+static const char sText[] =
+	"The quick brown fox jumps over the lazy dog. 0123456789 !?#%&/()=+-*";
+
+static void checkExit() {
+	MAEvent event;
+	while(maGetEvent(&event)) {
+		if(event.type == EVENT_TYPE_CLOSE ||
+			(event.type == EVENT_TYPE_KEY_PRESSED && event.key == MAK_0))
+		{
+			maExit(0);
+		}
+	}
+}
+
+// Draws a string one glyph at a time.
+static void drawSingly(Font& font, const char* text, int x, int y) {
+	const Charset& cs = font.getCharset();
+	const unsigned char* str = (const unsigned char*)text;
+	MAHandle image = font.getHandle();
+	int cx = x;
+	while(*str) {
+		const CharDescriptor& c = cs.chars[*str];
+		MARect src = { c.x, c.y, c.width, c.height };
+		MAPoint2d dst = { cx + c.xOffset, y + c.yOffset };
+		maDrawImageRegion(image, &src, &dst, TRANS_NONE);
+		cx += c.xAdvance;
+		str++;
+	}
+}
+
+// Returns the average time per frame, in milliseconds.
+static int run(Font& font, bool batched, int& glyphs) {
+	MAExtent scr = maGetScrSize();
+	int w = EXTENT_X(scr), h = EXTENT_Y(scr);
+	int lineHeight = font.getCharset().lineHeight;
+	int len = strlen(sText);
+	int start = maGetMilliSecondCount();
+	for(int frame=0; frame<FRAMES; frame++) {
+		checkExit();
+		maSetColor(0);
+		maFillRect(0, 0, w, h);
+		glyphs = 0;
+		for(int y=0; y<h; y+=lineHeight) {
+			//shift each line, so that it doesn't look like a benchmark of the same string.
+			int x = -((y / lineHeight) * 7 % 40);
+			if(batched)
+				font.drawString(sText, x, y);
+			else
+				drawSingly(font, sText, x, y);
+			glyphs += len;
+		}
+		maUpdateScreen();
+	}
+	return (maGetMilliSecondCount() - start) / FRAMES;
+}
+
+extern "C" int MAMain() {
+	Font font(R_FONT);
+
+	//one pixel, off-screen.
+	MARect src = { 0, 0, 1, 1 };
+	MAPoint2d dst = { -1, -1 };
+	if(maDrawImageRegions(font.getHandle(), &src, &dst, 1, TRANS_NONE) == IOCTL_UNAVAILABLE) {
+		InitConsole();
+		printf("maDrawImageRegions is not available.\n");
+		FREEZE;
+	}
+
+	int glyphs;
+	int single = run(font, false, glyphs);
+	int batched = run(font, true, glyphs);
+
+	InitConsole();
+	gConsoleLogging = 1;
+	printf("%i glyphs per frame\n", glyphs);
+	printf("maDrawImageRegion: %i ms/frame\n", single);
+	printf("maDrawImageRegions: %i ms/frame\n", batched);
+	printf("Done.\n");
+	FREEZE;
+}
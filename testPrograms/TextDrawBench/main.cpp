@@ -0,0 +1,120 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Measures a text-heavy redraw with the built-in font.
+
+ Each frame clears the screen and fills it with lines of text in a few
+ colours, measuring every line with maGetTextSize() first, like a list
+ that right-aligns its labels. The same lines are drawn every frame, as
+ they are on a screen that is redrawn without changes. The first frame is
+ reported separately, since it is the one that rasterises the glyphs.
+ Then the same is done with maDrawTextW(), whose glyphs are cached by then.
+*/
+
+#include <ma.h>
+#include <mastring.h>
+#include <conprint.h>
+#include <maassert.h>
+
+#define FRAMES 100
+#define LINE_LENGTH 64
+
+static const char sText[] =
+	"The quick brown fox jumps over the lazy dog. 0123456789 !?#%&/()=+-*";
+
+static const int sColors[] = { 0xffffff, 0xff8000, 0x00c0ff, 0x80ff80 };
+
+static void checkExit() {
+	MAEvent event;
+	while(maGetEvent(&event)) {
+		if(event.type == EVENT_TYPE_CLOSE ||
+			(event.type == EVENT_TYPE_KEY_PRESSED && event.key == MAK_0))
+		{
+			maExit(0);
+		}
+	}
+}
+
+struct Frame {
+	int first;	//ms
+	int average;	//ms, without the first frame
+	int lines;
+};
+
+static void drawLine(const char* str, int x, int y) { maDrawText(x, y, str); }
+static void drawLine(const wchar* str, int x, int y) { maDrawTextW(x, y, str); }
+static MAExtent lineSize(const char* str) { return maGetTextSize(str); }
+static MAExtent lineSize(const wchar* str) { return maGetTextSizeW(str); }
+
+template<class Tchar> static void drawFrame(Tchar (*lines)[LINE_LENGTH + 1], int count,
+	int w, int h, int lineHeight)
+{
+	maSetColor(0);
+	maFillRect(0, 0, w, h);
+	for(int i=0; i<count; i++) {
+		const Tchar* str = lines[i];
+		int width = EXTENT_X(lineSize(str));
+		maSetColor(sColors[i % (sizeof(sColors) / sizeof(*sColors))]);
+		drawLine(str, w - width, i * lineHeight);
+	}
+	maUpdateScreen();
+}
+
+template<class Tchar> static Frame run() {
+	MAExtent scr = maGetScrSize();
+	int w = EXTENT_X(scr), h = EXTENT_Y(scr);
+	int lineHeight = EXTENT_Y(maGetTextSize("Ag"));
+	Frame f;
+	f.lines = (h + lineHeight - 1) / lineHeight;
+
+	//each line starts at a different position in the text.
+	Tchar (*lines)[LINE_LENGTH + 1] = new Tchar[f.lines][LINE_LENGTH + 1];
+	int len = sizeof(sText) - 1;
+	for(int i=0; i<f.lines; i++) {
+		for(int j=0; j<LINE_LENGTH; j++) {
+			lines[i][j] = (unsigned char)sText[(i * 7 + j) % len];
+		}
+		lines[i][LINE_LENGTH] = 0;
+	}
+
+	int start = maGetMilliSecondCount();
+	drawFrame(lines, f.lines, w, h, lineHeight);
+	f.first = maGetMilliSecondCount() - start;
+
+	start = maGetMilliSecondCount();
+	for(int frame=0; frame<FRAMES; frame++) {
+		checkExit();
+		drawFrame(lines, f.lines, w, h, lineHeight);
+	}
+	f.average = (maGetMilliSecondCount() - start) / FRAMES;
+	delete[] lines;
+	return f;
+}
+
+extern "C" int MAMain() {
+	Frame latin1 = run<char>();
+	Frame wide = run<wchar>();
+
+	InitConsole();
+	gConsoleLogging = 1;
+	printf("%i lines of %i characters per frame\n", latin1.lines, LINE_LENGTH);
+	printf("maDrawText: first %i ms, then %i ms/frame\n", latin1.first, latin1.average);
+	printf("maDrawTextW: first %i ms, then %i ms/frame\n", wide.first, wide.average);
+	printf("Done.\n");
+	FREEZE;
+}
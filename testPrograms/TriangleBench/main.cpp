@@ -0,0 +1,151 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Measures filling of 10000 small triangles.
+
+ The triangles cover the screen as a grid of 8x8 pixel cells. They are
+ filled one call per triangle, then as strips of one call per grid row,
+ and then as a single strip and as fans of 5000 triangles each, which the
+ runtime may split into tiles and fill in parallel.
+ Reports the time of each, in milliseconds, for FRAMES frames.
+*/
+
+#include <ma.h>
+#include <mastring.h>
+#include <conprint.h>
+#include <maassert.h>
+
+#define TRIANGLES 10000
+#define CELL 8
+#define FRAMES 20
+
+static MAPoint2d sStrip[TRIANGLES + 2];
+static MAPoint2d sFan[TRIANGLES + 2];
+static int sColumns;
+
+static void checkExit() {
+	MAEvent event;
+	while(maGetEvent(&event)) {
+		if(event.type == EVENT_TYPE_CLOSE ||
+			(event.type == EVENT_TYPE_KEY_PRESSED && event.key == MAK_0))
+		{
+			maExit(0);
+		}
+	}
+}
+
+// A strip that zigzags along the rows of the grid, wrapping at the bottom.
+static void makeStrip(int width, int height) {
+	sColumns = width / CELL + 1;
+	int rows = height / CELL;
+	for(int i=0; i<TRIANGLES + 2; i++) {
+		int cell = i / 2;
+		int row = (cell / sColumns) % rows;
+		sStrip[i].x = (cell % sColumns) * CELL;
+		sStrip[i].y = row * CELL + (i & 1) * CELL;
+	}
+}
+
+// Two fans of thin triangles around the center of the screen.
+static void makeFan(int width, int height) {
+	int half = TRIANGLES / 2;
+	for(int f=0; f<2; f++) {
+		MAPoint2d* fan = sFan + f * (half + 1);
+		fan[0].x = width / 2;
+		fan[0].y = height / 2;
+		for(int i=1; i<=half; i++) {
+			//points along the top and bottom edges.
+			fan[i].x = (i - 1) * width / (half - 1);
+			fan[i].y = f == 0 ? 0 : height - 1;
+		}
+	}
+}
+
+static int timeSingle() {
+	int start = maGetMilliSecondCount();
+	for(int f=0; f<FRAMES; f++) {
+		maSetColor(0xff000000 | (f * 0x102030));
+		for(int i=0; i<TRIANGLES; i++) {
+			maFillTriangleStrip(sStrip + i, 3);
+		}
+		maUpdateScreen();
+		checkExit();
+	}
+	return maGetMilliSecondCount() - start;
+}
+
+static int timeRows() {
+	int perRow = sColumns * 2 - 2;
+	int start = maGetMilliSecondCount();
+	for(int f=0; f<FRAMES; f++) {
+		maSetColor(0xff000000 | (f * 0x302010));
+		for(int i=0; i<TRIANGLES; i+=perRow) {
+			int count = TRIANGLES - i < perRow ? TRIANGLES - i : perRow;
+			maFillTriangleStrip(sStrip + i, count + 2);
+		}
+		maUpdateScreen();
+		checkExit();
+	}
+	return maGetMilliSecondCount() - start;
+}
+
+static int timeStrip() {
+	int start = maGetMilliSecondCount();
+	for(int f=0; f<FRAMES; f++) {
+		maSetColor(0xff000000 | (f * 0x201030));
+		maFillTriangleStrip(sStrip, TRIANGLES + 2);
+		maUpdateScreen();
+		checkExit();
+	}
+	return maGetMilliSecondCount() - start;
+}
+
+static int timeFans() {
+	int half = TRIANGLES / 2;
+	int start = maGetMilliSecondCount();
+	for(int f=0; f<FRAMES; f++) {
+		maSetColor(0xff000000 | (f * 0x103020));
+		maFillTriangleFan(sFan, half + 1);
+		maFillTriangleFan(sFan + half + 1, half + 1);
+		maUpdateScreen();
+		checkExit();
+	}
+	return maGetMilliSecondCount() - start;
+}
+
+extern "C" int MAMain() {
+	MAExtent screen = maGetScrSize();
+	int width = EXTENT_X(screen), height = EXTENT_Y(screen);
+	makeStrip(width, height);
+	makeFan(width, height);
+
+	int single = timeSingle();
+	int rows = timeRows();
+	int strip = timeStrip();
+	int fans = timeFans();
+
+	InitConsole();
+	gConsoleLogging = 1;
+	printf("%i triangles, %i frames:\n", TRIANGLES, FRAMES);
+	printf("one call each: %i ms\n", single);
+	printf("one strip per row: %i ms\n", rows);
+	printf("one strip: %i ms\n", strip);
+	printf("two fans: %i ms\n", fans);
+	printf("Done.\n");
+	FREEZE;
+}
@@ -0,0 +1,83 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Measures how late maWait() returns when its timeout expires.
+
+ For each period from 1 to 100 ms, calls maWait() repeatedly and prints
+ the average and worst delay past the requested timeout, and how many
+ waits returned early. Don't touch the input devices while it runs;
+ a wait that is cut short by an event is counted as early and not measured.
+*/
+
+#include <ma.h>
+#include <conprint.h>
+#include <maassert.h>
+
+#define SAMPLES 50
+
+static const int sPeriods[] = { 1, 2, 5, 10, 16, 20, 33, 50, 100 };
+
+static void drainEvents() {
+	MAEvent event;
+	while(maGetEvent(&event)) {
+		if(event.type == EVENT_TYPE_CLOSE ||
+			(event.type == EVENT_TYPE_KEY_PRESSED && event.key == MAK_0))
+		{
+			maExit(0);
+		}
+	}
+}
+
+static void measure(int period) {
+	int total = 0, worst = 0, early = 0, samples = 0;
+	while(samples < SAMPLES) {
+		drainEvents();
+		int start = maGetMilliSecondCount();
+		maWait(period);
+		int delay = maGetMilliSecondCount() - start - period;
+		if(delay < 0) {
+			early++;
+			if(early > SAMPLES)
+				break;
+			continue;
+		}
+		total += delay;
+		if(delay > worst)
+			worst = delay;
+		samples++;
+	}
+	if(samples == 0) {
+		printf("%3i ms: no samples, %i early\n", period, early);
+		return;
+	}
+	printf("%3i ms: avg +%i.%02i, max +%i, %i early\n", period,
+		total / samples, (total * 100 / samples) % 100, worst, early);
+}
+
+extern "C" int MAMain() {
+	InitConsole();
+	gConsoleLogging = 1;
+
+	printf("maWait() wake-up delay, %i samples\n", SAMPLES);
+	for(unsigned i=0; i<sizeof(sPeriods) / sizeof(sPeriods[0]); i++) {
+		measure(sPeriods[i]);
+	}
+
+	printf("Done.\n");
+	FREEZE;
+}
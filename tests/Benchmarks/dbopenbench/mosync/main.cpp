@@ -0,0 +1,150 @@
+/*
+ * DBOpenBench measures how the options of maDBOpenEx affect the
+ * write throughput and read latency of a database.
+ *
+ * For each set of options, it opens a database of its own and reports:
+ * - commits per second, inserting one row per transaction,
+ * - rows per second, inserting many rows in one transaction,
+ * - microseconds per lookup of a random row by its primary key.
+ * It also prints the journal mode that is in use, since SQLite keeps
+ * its default mode where it doesn't support the one asked for.
+ */
+
+#include <ma.h>
+#include <mastring.h>
+#include <mastdlib.h>
+#include <conprint.h>
+#include <maassert.h>
+
+#define COMMITS 500
+#define ROWS 20000
+#define LOOKUPS 5000
+
+struct Config {
+	const char* name;
+	int flags;
+	MADBOpenOptions options;
+};
+
+static const Config sConfigs[] = {
+	{ "maDBOpen", -1, { 0, 0, 0, 0 } },
+	{ "defaults", 0, { MA_DB_JOURNAL_DEFAULT, MA_DB_SYNCHRONOUS_DEFAULT, 0, 0 } },
+	{ "truncate, normal", 0, { MA_DB_JOURNAL_TRUNCATE, MA_DB_SYNCHRONOUS_NORMAL, 0, 0 } },
+	{ "wal", 0, { MA_DB_JOURNAL_WAL, MA_DB_SYNCHRONOUS_DEFAULT, 0, 0 } },
+	{ "wal, normal", 0, { MA_DB_JOURNAL_WAL, MA_DB_SYNCHRONOUS_NORMAL, 0, 0 } },
+	{ "wal, normal, 8M cache", 0, { MA_DB_JOURNAL_WAL, MA_DB_SYNCHRONOUS_NORMAL, 8192, 0 } },
+	{ "wal, normal, 64M mmap", 0, { MA_DB_JOURNAL_WAL, MA_DB_SYNCHRONOUS_NORMAL, 0, 64 * 1024 * 1024 } },
+	{ "synchronous off", 0, { MA_DB_JOURNAL_DEFAULT, MA_DB_SYNCHRONOUS_OFF, 0, 0 } },
+	{ "shared cache", MA_DB_OPEN_SHARED_CACHE, { 0, 0, 0, 0 } },
+};
+
+static void checkExit() {
+	MAEvent event;
+	while(maGetEvent(&event)) {
+		if(event.type == EVENT_TYPE_CLOSE ||
+			(event.type == EVENT_TYPE_KEY_PRESSED && event.key == MAK_0))
+		{
+			maExit(0);
+		}
+	}
+}
+
+// Returns the handle, or the error from maDBOpenEx.
+static MAHandle openDatabase(int index) {
+	char path[1024];
+	int size = maGetSystemProperty("mosync.path.local", path, sizeof(path) - 32);
+	if(size < 0 || size > (int)sizeof(path) - 32)
+		strcpy(path, "/");
+	sprintf(path + strlen(path), "DBOpenBench%i.db", index);
+
+	const Config& c = sConfigs[index];
+	MAHandle db;
+	if(c.flags < 0)
+		db = maDBOpen(path);
+	else
+		db = maDBOpenEx(path, c.flags, &c.options);
+	if(db <= 0)
+		return db;
+	MAASSERT(maDBExecSQL(db, "DROP TABLE IF EXISTS bench") == MA_DB_OK);
+	MAASSERT(maDBExecSQL(db, "CREATE TABLE bench (k INTEGER PRIMARY KEY, v TEXT)") == MA_DB_OK);
+	return db;
+}
+
+static void journalMode(MAHandle db, char* mode, int size) {
+	MAHandle cursor = maDBExecSQL(db, "PRAGMA journal_mode");
+	MAASSERT(cursor > 0);
+	MAASSERT(maDBCursorNext(cursor) == MA_DB_OK);
+	int length = maDBCursorGetColumnText(cursor, 0, mode, size - 1);
+	MAASSERT(length >= 0 && length < size);
+	mode[length] = 0;
+	maDBCursorDestroy(cursor);
+}
+
+static int insert(MAHandle db, int first, int count) {
+	static char text[64];
+	MADBValue values[2];
+	values[0].type = MA_DB_TYPE_INT;
+	values[1].type = MA_DB_TYPE_TEXT;
+	values[1].text.addr = text;
+	values[1].text.length = -1;
+	int start = maGetMilliSecondCount();
+	for(int i=first; i<first + count; i++) {
+		values[0].i = i;
+		sprintf(text, "value %i, padded out to a typical length", i);
+		MAASSERT(maDBExecSQLParams(db, "INSERT INTO bench VALUES (?, ?)", values, 2) == MA_DB_OK);
+		if(i % 100 == 0)
+			checkExit();
+	}
+	return maGetMilliSecondCount() - start;
+}
+
+static int lookup(MAHandle db, int rows) {
+	MADBValue key;
+	key.type = MA_DB_TYPE_INT;
+	int start = maGetMilliSecondCount();
+	for(int i=0; i<LOOKUPS; i++) {
+		key.i = rand() % rows;
+		MAHandle cursor = maDBExecSQLParams(db, "SELECT v FROM bench WHERE k = ?", &key, 1);
+		MAASSERT(cursor > 0);
+		maDBCursorDestroy(cursor);
+		if(i % 100 == 0)
+			checkExit();
+	}
+	return maGetMilliSecondCount() - start;
+}
+
+static int perSecond(int count, int ms) {
+	return (int)(count * 1000LL / (ms > 0 ? ms : 1));
+}
+
+extern "C" int MAMain() {
+	InitConsole();
+	gConsoleLogging = 1;
+	printf("DBOpenBench: %i commits, %i rows in a transaction, %i lookups\n",
+		COMMITS, ROWS, LOOKUPS);
+
+	for(int i=0; i<(int)(sizeof(sConfigs) / sizeof(Config)); i++) {
+		MAHandle db = openDatabase(i);
+		if(db == IOCTL_UNAVAILABLE) {
+			printf("%s: maDBOpenEx is not available.\n", sConfigs[i].name);
+			continue;
+		}
+		MAASSERT(db > 0);
+		char mode[32];
+		journalMode(db, mode, sizeof(mode));
+
+		int commits = insert(db, 0, COMMITS);
+		MAASSERT(maDBExecSQL(db, "BEGIN") == MA_DB_OK);
+		int rows = insert(db, COMMITS, ROWS);
+		MAASSERT(maDBExecSQL(db, "COMMIT") == MA_DB_OK);
+		int lookups = lookup(db, COMMITS + ROWS);
+		maDBClose(db);
+
+		printf("%s (journal %s): %i commits/s, %i rows/s, %i us/lookup\n",
+			sConfigs[i].name, mode,
+			perSecond(COMMITS, commits), perSecond(ROWS, rows),
+			lookups * 1000 / LOOKUPS);
+	}
+	printf("Done.\n");
+	FREEZE;
+}
@@ -0,0 +1,224 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Host-side microbenchmark for AudioChannel::mix().
+
+ Mixes 1 to 32 channels of a tone into a 10 ms stereo buffer at 44100 Hz,
+ for each source format and resampler, at the output rate and at 22050 and
+ 48000 Hz, and prints the time per buffer. First checks that a source at the
+ output rate is mixed unchanged, that the polyphase filter keeps
+ a constant signal constant, and that a new source that is allocated where
+ a deleted one was is mixed from its start.
+
+ Build from this directory, with the headers that the idl generates in place:
+ g++ -O2 -I../../runtimes/cpp/base -I../../runtimes/cpp/platforms/sdl -I../../intlibs
+  audioMixBench.cpp ../../runtimes/cpp/base/AudioChannel.cpp ../../runtimes/cpp/base/AudioMix.cpp
+  ../../runtimes/cpp/base/AudioSource.cpp ../../runtimes/cpp/platforms/sdl/mutexImpl.cpp
+  -lSDL -o audioMixBench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <new>
+
+#include <config_platform.h>
+#include <helpers/helpers.h>
+
+#include "AudioChannel.h"
+#include "AudioSource.h"
+
+#define OUTPUT_RATE 44100
+#define BUFFER_FRAMES (OUTPUT_RATE / 100)
+#define SOURCE_FRAMES 4096
+#define MAX_CHANNELS 32
+#define MIN_FRAMES (16*1024*1024)
+
+// The runtimes provide these.
+void MoSyncErrorExit(int errorCode) {
+	printf("MoSyncErrorExit(%i)\n", errorCode);
+	exit(1);
+}
+
+void LogV(const char* fmt, VA_LIST vaList) {
+	vprintf(fmt, vaList);
+}
+
+// A looping tone, or a constant, in any format.
+class ToneSource : public AudioSource {
+public:
+	ToneSource(Format fmt, int channels, int rate, bool constant) {
+		info.fmt = fmt;
+		info.numChannels = channels;
+		info.sampleRate = rate;
+		info.bytesPerSample = (fmt == FMT_S16 || fmt == FMT_U16) ? 2 : 1;
+		info.bitDepth = info.bytesPerSample * 8;
+		info.bufferSize = SOURCE_FRAMES * channels * info.bytesPerSample;
+		info.canSeek = false;
+		mBuffer = new char[info.bufferSize];
+		for(int i=0; i<SOURCE_FRAMES * channels; i++) {
+			double v = constant ? 0.5 : sin(i / channels * 2 * 3.14159265 * 440 / rate) * 0.8;
+			int s16 = (int)(v * 32767);
+			switch(fmt) {
+			case FMT_S8: ((signed char*)mBuffer)[i] = (signed char)(s16 >> 8); break;
+			case FMT_U8: ((unsigned char*)mBuffer)[i] = (unsigned char)((s16 >> 8) + 128); break;
+			case FMT_S16: ((short*)mBuffer)[i] = (short)s16; break;
+			case FMT_U16: ((unsigned short*)mBuffer)[i] = (unsigned short)(s16 + 32768); break;
+			}
+		}
+	}
+	~ToneSource() { delete[] mBuffer; }
+
+	int init() { return 0; }
+	int fillBuffer() { return SOURCE_FRAMES; }
+	const void* getBuffer() const { return mBuffer; }
+	void setPosition(int) {}
+	int getPosition() const { return 0; }
+	int getLength() const { return 0; }
+	void setNumLoops(int) {}
+	int getNumLoops() { return 0; }
+private:
+	char* mBuffer;
+};
+
+static const char* sFormatNames[] = { "s8", "u8", "s16", "u16" };
+static const char* sResamplerNames[] = { "nearest", "linear", "polyphase" };
+static const int sRates[] = { OUTPUT_RATE, 22050, 48000 };
+static const int sChannelCounts[] = { 1, 8, 32 };
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof(*a))
+
+static int sMix[BUFFER_FRAMES * 2];
+
+static bool check() {
+	bool ok = true;
+	// a 16-bit stereo source at the output rate, at full volume, is unchanged
+	// but for the volume, which is 0xffff/0x10000.
+	ToneSource tone(AudioSource::FMT_S16, 2, OUTPUT_RATE, false);
+	for(int r=0; r<3; r++) {
+		AudioChannel c(OUTPUT_RATE, &tone);
+		c.setResampler((AudioMix::Resampler)r);
+		c.setActive(true);
+		for(int pass=0; pass<3; pass++) {
+			memset(sMix, 0, sizeof(sMix));
+			c.mix(sMix, BUFFER_FRAMES);
+			const short* src = (const short*)tone.getBuffer();
+			for(int i=0; i<BUFFER_FRAMES * 2; i++) {
+				int expected = src[(pass * BUFFER_FRAMES * 2 + i) % (SOURCE_FRAMES * 2)];
+				if(abs(sMix[i] - expected) > 1) {
+					printf("%s: sample %i of pass %i is %i, expected %i\n", sResamplerNames[r], i, pass, sMix[i], expected);
+					ok = false;
+					break;
+				}
+			}
+		}
+	}
+	// the polyphase filter keeps a constant constant, at any rate.
+	for(size_t i=1; i<ARRAY_SIZE(sRates); i++) {
+		ToneSource dc(AudioSource::FMT_S16, 1, sRates[i], true);
+		AudioChannel c(OUTPUT_RATE, &dc);
+		c.setResampler(AudioMix::POLYPHASE);
+		c.setActive(true);
+		memset(sMix, 0, sizeof(sMix));
+		c.mix(sMix, BUFFER_FRAMES);
+		int expected = (16383 * 0x7fff) >> 15;
+		// the first frames are filtered with the silence before the source.
+		for(int j=32; j<BUFFER_FRAMES * 2; j++) {
+			if(abs(sMix[j] - expected) > 1) {
+				printf("polyphase at %i Hz: sample %i is %i, expected %i\n", sRates[i], j, sMix[j], expected);
+				ok = false;
+				break;
+			}
+		}
+	}
+	// a new source at the address of a deleted one doesn't inherit its frames.
+	{
+		char storage[sizeof(ToneSource)];
+		ToneSource* src = new (storage) ToneSource(AudioSource::FMT_S16, 2, OUTPUT_RATE, false);
+		AudioChannel c(OUTPUT_RATE, src);
+		c.setActive(true);
+		c.mix(sMix, BUFFER_FRAMES);
+		c.setAudioSource(NULL);
+		c.waitForMix();
+		src->~ToneSource();
+		src = new (storage) ToneSource(AudioSource::FMT_S16, 2, OUTPUT_RATE, true);
+		c.setAudioSource(src);
+		memset(sMix, 0, sizeof(sMix));
+		c.mix(sMix, BUFFER_FRAMES);
+		int expected = (16383 * 0x7fff) >> 15;
+		for(int i=0; i<BUFFER_FRAMES * 2; i++) {
+			if(abs(sMix[i] - expected) > 1) {
+				printf("reused address: sample %i is %i, expected %i\n", i, sMix[i], expected);
+				ok = false;
+				break;
+			}
+		}
+		src->~ToneSource();
+	}
+	return ok;
+}
+
+static void bench(int fmt, int channels, int rate, int resampler, int numChannels) {
+	ToneSource* sources[MAX_CHANNELS];
+	AudioChannel* mixers[MAX_CHANNELS];
+	for(int i=0; i<numChannels; i++) {
+		sources[i] = new ToneSource((AudioSource::Format)fmt, channels, rate, false);
+		mixers[i] = new AudioChannel(OUTPUT_RATE, sources[i]);
+		mixers[i]->setResampler((AudioMix::Resampler)resampler);
+		mixers[i]->setVolume(0xffff / numChannels);
+		mixers[i]->setActive(true);
+	}
+	int buffers = MIN_FRAMES / (BUFFER_FRAMES * numChannels);
+	clock_t start = clock();
+	for(int b=0; b<buffers; b++) {
+		memset(sMix, 0, sizeof(sMix));
+		for(int i=0; i<numChannels; i++) {
+			mixers[i]->mix(sMix, BUFFER_FRAMES);
+		}
+	}
+	double us = (double)(clock() - start) / CLOCKS_PER_SEC * 1000000 / buffers;
+	printf("%-3s %-6s %5i Hz %-9s %2i channels %8.2f us/buffer\n", sFormatNames[fmt],
+		channels == 1 ? "mono" : "stereo", rate, sResamplerNames[resampler], numChannels, us);
+	for(int i=0; i<numChannels; i++) {
+		delete mixers[i];
+		delete sources[i];
+	}
+}
+
+int main() {
+	if(!check()) {
+		printf("FAILED\n");
+		return 1;
+	}
+	for(int fmt=0; fmt<4; fmt++) {
+		for(int channels=1; channels<=2; channels++) {
+			for(size_t r=0; r<ARRAY_SIZE(sRates); r++) {
+				for(int resampler=0; resampler<3; resampler++) {
+					if(sRates[r] == OUTPUT_RATE && resampler > 0)
+						continue;
+					for(size_t n=0; n<ARRAY_SIZE(sChannelCounts); n++) {
+						bench(fmt, channels, sRates[r], resampler, sChannelCounts[n]);
+					}
+				}
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,189 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Host-side test for the DNS cache in intlibs/net/resolver.cpp.
+
+ Installs a stub backend with Resolver::setBackend(), which counts its
+ lookups, and checks that:
+ - a second lookup of a host is a cache hit,
+ - a failed lookup is cached, and returns the same error,
+ - an entry with a time-to-live of 0 is looked up again,
+ - maDnsFlush()'s Resolver::flush() empties the cache,
+ - numeric addresses never reach the backend,
+ - threads that ask for a host that is being looked up share that lookup.
+ Then resolves "localhost" with the default backend.
+
+ Build from this directory, with the headers that the idl generates in place:
+ g++ -O2 -DLINUX -I../../runtimes/cpp/base -I../../runtimes/cpp/platforms/sdl -I../../intlibs
+  -I../../runtimes/cpp dnsCacheTest.cpp ../../intlibs/net/resolver.cpp
+  ../../intlibs/helpers/platforms/linux/log.cpp -lpthread -o dnsCacheTest
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "net/net.h"
+#include "net/resolver.h"
+
+#define THREADS 8
+#define SLOW_MS 200
+
+// The runtimes provide this.
+void MoSyncErrorExit(int errorCode) {
+	printf("MoSyncErrorExit(%i)\n", errorCode);
+	exit(1);
+}
+
+static void check(bool ok, const char* what) {
+	if(!ok) {
+		printf("FAILED: %s\n", what);
+		exit(1);
+	}
+}
+
+// "bad.test" fails, "zero.test" has a time-to-live of 0, "slow.test" takes
+// SLOW_MS. Every other host resolves to 10.0.0.1.
+class StubBackend : public ResolverBackend {
+public:
+	StubBackend() : lookups(0) {
+		pthread_mutex_init(&mMutex, NULL);
+	}
+
+	int lookup(const char* hostname, uint& inetAddr, int& ttl) {
+		pthread_mutex_lock(&mMutex);
+		lookups++;
+		pthread_mutex_unlock(&mMutex);
+		if(strcmp(hostname, "bad.test") == 0)
+			return CONNERR_DNS;
+		if(strcmp(hostname, "zero.test") == 0)
+			ttl = 0;
+		if(strcmp(hostname, "slow.test") == 0)
+			usleep(SLOW_MS * 1000);
+		inetAddr = inet_addr("10.0.0.1");
+		return 1;
+	}
+
+	int count() {
+		pthread_mutex_lock(&mMutex);
+		int n = lookups;
+		pthread_mutex_unlock(&mMutex);
+		return n;
+	}
+
+private:
+	int lookups;
+	pthread_mutex_t mMutex;
+};
+
+static StubBackend sBackend;
+
+static int resolve(const char* host) {
+	uint addr = 0;
+	int res = Resolver::resolve(host, addr);
+	if(res > 0)
+		check(addr == inet_addr("10.0.0.1") || addr == inet_addr(host), "address");
+	return res;
+}
+
+static Resolver::Stats stats() {
+	Resolver::Stats s;
+	Resolver::getStats(s);
+	return s;
+}
+
+static void testHits() {
+	int before = sBackend.count();
+	Resolver::Stats s = stats();
+	check(resolve("a.test") > 0, "first lookup");
+	check(resolve("a.test") > 0, "second lookup");
+	check(sBackend.count() == before + 1, "one backend lookup");
+	check(stats().hits == s.hits + 1, "cache hit");
+	printf("hits: ok\n");
+}
+
+static void testNegative() {
+	int before = sBackend.count();
+	Resolver::Stats s = stats();
+	check(resolve("bad.test") == CONNERR_DNS, "failed lookup");
+	check(resolve("bad.test") == CONNERR_DNS, "cached failure");
+	check(sBackend.count() == before + 1, "failure looked up once");
+	check(stats().negativeHits == s.negativeHits + 1, "negative hit");
+	printf("negative: ok\n");
+}
+
+static void testExpiryAndFlush() {
+	int before = sBackend.count();
+	check(resolve("zero.test") > 0 && resolve("zero.test") > 0, "zero ttl");
+	check(sBackend.count() == before + 2, "zero ttl is not cached");
+
+	before = sBackend.count();
+	check(resolve("b.test") > 0, "before flush");
+	Resolver::flush();
+	check(resolve("b.test") > 0, "after flush");
+	check(sBackend.count() == before + 2, "flush empties the cache");
+
+	before = sBackend.count();
+	check(resolve("127.0.0.1") > 0, "numeric");
+	check(sBackend.count() == before, "numeric address skips the backend");
+	printf("expiry and flush: ok\n");
+}
+
+static pthread_barrier_t sBarrier;
+
+static void* resolveSlow(void*) {
+	pthread_barrier_wait(&sBarrier);
+	return (void*)(size_t)(resolve("slow.test") > 0);
+}
+
+static void testJoined() {
+	int before = sBackend.count();
+	Resolver::Stats s = stats();
+	pthread_barrier_init(&sBarrier, NULL, THREADS);
+	pthread_t threads[THREADS];
+	for(int i=0; i<THREADS; i++) {
+		pthread_create(&threads[i], NULL, resolveSlow, NULL);
+	}
+	for(int i=0; i<THREADS; i++) {
+		void* ok;
+		pthread_join(threads[i], &ok);
+		check(ok != NULL, "joined lookup result");
+	}
+	pthread_barrier_destroy(&sBarrier);
+	check(sBackend.count() == before + 1, "one lookup for all threads");
+	check(stats().joinedLookups == s.joinedLookups + THREADS - 1, "joined lookups");
+	printf("in-flight lookups shared: ok\n");
+}
+
+int main() {
+	Resolver::setBackend(&sBackend);
+	testHits();
+	testNegative();
+	testExpiryAndFlush();
+	testJoined();
+	Resolver::setBackend(NULL);
+
+	//the default backend, through the hosts file.
+	uint addr;
+	check(Resolver::resolve("localhost", addr) > 0 && addr == inet_addr("127.0.0.1"),
+		"default backend");
+	printf("Done.\n");
+	return 0;
+}
@@ -0,0 +1,258 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Host-side benchmark for FileBuffer, which buffers maFileRead() and
+ maFileWrite().
+
+ Reads and writes an 8 MB file 1 byte, 64 bytes and 64 KB at a time,
+ straight through a FileStream, as the maFile functions did, and through
+ a FileBuffer, and prints the throughput of each. Then reads the file into
+ a memory stream 64 KB, 1 MB and 4 MB at a time, through a read() and
+ through a MappedFile. maFileReadToData() maps the file from 1 MB up.
+
+ First checks that random reads, writes, seeks and tells through a
+ FileBuffer leave the same file as the same operations on a vector.
+
+ Build from this directory, with the headers that the idl generates in place:
+ g++ -O2 -DLINUX -I../../runtimes/cpp/base -I../../runtimes/cpp/platforms/sdl -I../../intlibs
+  -I../../runtimes/cpp fileBufferBench.cpp ../../runtimes/cpp/base/FileBuffer.cpp
+  ../../runtimes/cpp/base/FileStream.cpp ../../runtimes/cpp/platforms/sdl/FileImpl.cpp
+  ../../runtimes/cpp/base/Stream.cpp ../../runtimes/cpp/base/MemStream.cpp
+  ../../runtimes/cpp/base/MappedFile.cpp -o fileBufferBench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <vector>
+
+#include <config_platform.h>
+#include <helpers/helpers.h>
+
+#include "FileBuffer.h"
+#include "MemStream.h"
+#include "MappedFile.h"
+
+#define PATH "fileBufferBench.bin"
+#define FILE_SIZE (8 * 1024 * 1024)
+#define ONE_BYTE_SIZE (1024 * 1024)
+#define MODEL_OPS 200000
+#define MODEL_SIZE (256 * 1024)
+
+using namespace Base;
+
+// The runtimes provide these.
+void MoSyncErrorExit(int errorCode) {
+	printf("MoSyncErrorExit(%i)\n", errorCode);
+	exit(1);
+}
+
+void LogV(const char* fmt, VA_LIST vaList) {
+	vprintf(fmt, vaList);
+}
+
+static long long now() {
+	timeval tv;
+	gettimeofday(&tv, NULL);
+	return (long long)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static void check(bool ok, const char* what) {
+	if(!ok) {
+		printf("FAILED: %s\n", what);
+		exit(1);
+	}
+}
+
+static void createFile(int size) {
+	WriteFileStream file(PATH);
+	check(file.isOpen(), "create");
+	std::vector<char> data(size);
+	for(int i=0; i<size; i++) {
+		data[i] = (char)(i * 7);
+	}
+	check(file.write(&data[0], size), "write");
+}
+
+static void readAll(WriteFileStream& fs, std::vector<char>& data) {
+	int length;
+	check(fs.length(length) && fs.seek(Seek::Start, 0), "length");
+	data.resize(length);
+	if(length > 0)
+		check(fs.read(&data[0], length), "read back");
+}
+
+static void testModel() {
+	createFile(MODEL_SIZE);
+	std::vector<char> model(MODEL_SIZE);
+	for(int i=0; i<MODEL_SIZE; i++) {
+		model[i] = (char)(i * 7);
+	}
+	WriteFileStream fs(PATH, false, true);
+	check(fs.isOpen(), "open");
+	FileBuffer buffer;
+	int pos = 0;
+	char data[FILE_BUFFER_SIZE * 2];
+	srand(1);
+	for(int i=0; i<MODEL_OPS; i++) {
+		//mostly small, sometimes larger than the buffer.
+		int size = rand() % 8 == 0 ? rand() % sizeof(data) : rand() % 100;
+		switch(rand() % 5) {
+		case 0:
+		case 1:
+			if(pos + size <= (int)model.size()) {
+				check(buffer.read(fs, data, size), "read");
+				check(memcmp(data, &model[pos], size) == 0, "read data");
+				pos += size;
+			} else {
+				//fails, and leaves the position undefined, like the maFile functions.
+				check(!buffer.read(fs, data, size), "read past the end");
+				check(buffer.flush(fs) && fs.seek(Seek::Start, pos), "seek after failed read");
+			}
+			break;
+		case 2:
+			for(int j=0; j<size; j++) {
+				data[j] = (char)rand();
+			}
+			check(buffer.write(fs, data, size), "write");
+			if(pos + size > (int)model.size())
+				model.resize(pos + size);
+			memcpy(&model[pos], data, size);
+			pos += size;
+			break;
+		case 3: {
+			int p;
+			check(buffer.tell(fs, p) && p == pos, "tell");
+			break;
+		}
+		case 4:
+			pos = rand() % (model.size() + 1);
+			check(buffer.flush(fs) && fs.seek(Seek::Start, pos), "seek");
+			break;
+		}
+	}
+	check(buffer.flush(fs), "flush");
+	std::vector<char> file;
+	readAll(fs, file);
+	check(file == model, "file contents");
+	printf("model: ok, %i KB\n", (int)file.size() / 1024);
+}
+
+static double mbPerSecond(long long bytes, long long us) {
+	return bytes / (double)MAX(us, 1LL);
+}
+
+static void benchRead(int size) {
+	int total = size == 1 ? ONE_BYTE_SIZE : FILE_SIZE;
+	std::vector<char> dst(size);
+	long long direct, buffered;
+	{
+		FileStream fs(PATH);
+		long long start = now();
+		for(int pos=0; pos<total; pos+=size) {
+			check(fs.read(&dst[0], size), "read");
+		}
+		direct = now() - start;
+	}
+	{
+		FileStream fs(PATH);
+		FileBuffer buffer;
+		long long start = now();
+		for(int pos=0; pos<total; pos+=size) {
+			check(buffer.read(fs, &dst[0], size), "buffered read");
+		}
+		buffered = now() - start;
+	}
+	printf("read %6i bytes at a time: %8.1f MB/s straight, %8.1f MB/s buffered\n",
+		size, mbPerSecond(total, direct), mbPerSecond(total, buffered));
+}
+
+static void benchWrite(int size) {
+	int total = size == 1 ? ONE_BYTE_SIZE : FILE_SIZE;
+	std::vector<char> src(size, 'x');
+	long long direct, buffered;
+	{
+		WriteFileStream fs(PATH);
+		long long start = now();
+		for(int pos=0; pos<total; pos+=size) {
+			check(fs.write(&src[0], size), "write");
+		}
+		direct = now() - start;
+	}
+	{
+		WriteFileStream fs(PATH);
+		FileBuffer buffer;
+		long long start = now();
+		for(int pos=0; pos<total; pos+=size) {
+			check(buffer.write(fs, &src[0], size), "buffered write");
+		}
+		check(buffer.flush(fs), "flush");
+		buffered = now() - start;
+		int length;
+		check(fs.length(length) && length == total, "written length");
+	}
+	printf("write %6i bytes at a time: %8.1f MB/s straight, %8.1f MB/s buffered\n",
+		size, mbPerSecond(total, direct), mbPerSecond(total, buffered));
+}
+
+// Into a data object, as maFileReadToData() does, at an offset of 16.
+static void benchReadToData(int size) {
+	MemStream data(size + 16);
+	long long read, mapped;
+	{
+		FileStream fs(PATH);
+		long long start = now();
+		for(int pos=0; pos<FILE_SIZE; pos+=size) {
+			check(data.seek(Seek::Start, 16) && data.writeStream(fs, size), "writeStream");
+		}
+		read = now() - start;
+	}
+	{
+		FileStream fs(PATH);
+		long long start = now();
+		for(int pos=0; pos<FILE_SIZE; pos+=size) {
+			int p;
+			check(fs.tell(p), "tell");
+			MappedFile map(PATH);
+			check(map.isOpen() && p <= map.size() - size, "map");
+			check(data.seek(Seek::Start, 16) && data.write(map.data() + p, size), "copy");
+			check(fs.seek(Seek::Current, size), "seek");
+		}
+		mapped = now() - start;
+	}
+	check(memcmp((char*)data.ptr() + 16, "xxxxxxxx", 8) == 0, "data");
+	printf("read to data %7i bytes at a time: %8.1f MB/s read, %8.1f MB/s mapped\n",
+		size, mbPerSecond(FILE_SIZE, read), mbPerSecond(FILE_SIZE, mapped));
+}
+
+int main() {
+	testModel();
+	int sizes[] = { 1, 64, 64 * 1024 };
+	for(int i=0; i<3; i++) {
+		benchWrite(sizes[i]);
+	}
+	for(int i=0; i<3; i++) {
+		benchRead(sizes[i]);
+	}
+	benchReadToData(64 * 1024);
+	benchReadToData(1024 * 1024);
+	benchReadToData(4 * 1024 * 1024);
+	remove(PATH);
+	return 0;
+}
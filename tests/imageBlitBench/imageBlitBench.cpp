@@ -0,0 +1,204 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Host-side microbenchmark for Image::drawImageRegion().
+
+ Blits sprites of common sizes in the formats and alpha modes that the
+ runtimes use, unrotated, mirrored and rotated, and prints the time per pixel.
+ Unrotated blends are first checked against a plain implementation of the
+ blend formula.
+
+ Build from this directory, with the headers that the idl generates in place:
+ g++ -O2 -I../../runtimes/cpp/base -I../../runtimes/cpp/platforms/sdl -I../../intlibs
+  imageBlitBench.cpp ../../runtimes/cpp/base/Image.cpp -o imageBlitBench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <config_platform.h>
+#include <helpers/helpers.h>
+#include <helpers/cpp_defs.h>
+#include <helpers/log.h>
+
+#include "Image.h"
+
+#define DST_SIZE 512
+#define MIN_PIXELS (64*1024*1024)
+
+// The runtimes provide these.
+void MoSyncErrorExit(int errorCode) {
+	printf("MoSyncErrorExit(%i)\n", errorCode);
+	exit(1);
+}
+
+void LogV(const char* fmt, VA_LIST vaList) {
+	vprintf(fmt, vaList);
+}
+
+enum Mode {
+	COPY, PLANE, CHANNEL
+};
+
+static const char* sModeNames[] = { "copy", "alpha plane", "alpha channel" };
+
+struct Transform {
+	int mode;
+	const char* name;
+};
+
+static const Transform sTransforms[] = {
+	{ TRANS_NONE, "none" },
+	{ TRANS_MIRROR, "mirror" },
+	{ TRANS_ROT90, "rot90" },
+};
+
+static const int sSizes[] = { 16, 32, 64, 128 };
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof(*a))
+
+static void fill(unsigned char* p, int size) {
+	for(int i=0; i<size; i++)
+		p[i] = rand();
+}
+
+// Sprite alpha: mostly transparent or opaque, with some edges in between.
+static void fillAlpha(unsigned char* p, int size, int stride) {
+	for(int i=0; i<size; i+=stride) {
+		int r = rand() % 4;
+		p[i] = r == 0 ? 0 : r == 1 ? 255 : rand();
+	}
+}
+
+static Image* createSprite(int size, Image::PixelFormat format, Mode mode) {
+	int bpp = (format == Image::PIXELFORMAT_RGB565) ? 2 : 4;
+	unsigned char* data = new unsigned char[size * size * bpp];
+	unsigned char* alpha = NULL;
+	fill(data, size * size * bpp);
+	if(mode == PLANE) {
+		alpha = new unsigned char[size * size];
+		fillAlpha(alpha, size * size, 1);
+	} else if(mode == CHANNEL) {
+		fillAlpha(data + 3, size * size * 4, 4);
+	}
+	return new Image(data, alpha, size, size, size * bpp, format);
+}
+
+static Image* createScreen(Image::PixelFormat format) {
+	int bpp = (format == Image::PIXELFORMAT_RGB565) ? 2 : 4;
+	Image* img = new Image(DST_SIZE, DST_SIZE, DST_SIZE * bpp, format);
+	fill(img->data, DST_SIZE * DST_SIZE * bpp);
+	return img;
+}
+
+static int blendChannel(int s, int d, int a) {
+	if(a == 255)
+		return s;
+	if(a == 0)
+		return d;
+	return d + (((s - d) * a) >> 8);
+}
+
+// Checks one unrotated blit against the formula, pixel by pixel.
+static bool check(Image* screen, Image* sprite, Mode mode) {
+	int size = sprite->width;
+	int bpp = screen->bytesPerPixel;
+	unsigned char* before = new unsigned char[DST_SIZE * DST_SIZE * bpp];
+	memcpy(before, screen->data, DST_SIZE * DST_SIZE * bpp);
+	screen->drawImage(3, 5, sprite);
+
+	bool ok = true;
+	for(int y=0; y<size && ok; y++) {
+		for(int x=0; x<size && ok; x++) {
+			int di = (y + 5) * DST_SIZE + x + 3;
+			int si = y * size + x;
+			unsigned expected, actual;
+			if(bpp == 2) {
+				unsigned s = ((unsigned short*)sprite->data)[si];
+				unsigned d = ((unsigned short*)before)[di];
+				actual = ((unsigned short*)screen->data)[di];
+				if(mode == COPY) {
+					expected = s;
+				} else {
+					int a = sprite->alpha[si];
+					expected = (blendChannel(s >> 11, d >> 11, a) << 11) |
+						(blendChannel((s >> 5) & 0x3f, (d >> 5) & 0x3f, a) << 5) |
+						blendChannel(s & 0x1f, d & 0x1f, a);
+				}
+			} else {
+				unsigned s = ((unsigned*)sprite->data)[si];
+				unsigned d = ((unsigned*)before)[di];
+				actual = ((unsigned*)screen->data)[di];
+				if(mode == COPY) {
+					expected = s;
+				} else {
+					int a = (mode == PLANE) ? sprite->alpha[si] : s >> 24;
+					expected = (blendChannel((s >> 16) & 0xff, (d >> 16) & 0xff, a) << 16) |
+						(blendChannel((s >> 8) & 0xff, (d >> 8) & 0xff, a) << 8) |
+						blendChannel(s & 0xff, d & 0xff, a);
+				}
+			}
+			if(actual != expected) {
+				printf("Mismatch at %i,%i: 0x%x, expected 0x%x\n", x, y, actual, expected);
+				ok = false;
+			}
+		}
+	}
+	delete[] before;
+	return ok;
+}
+
+static void bench(const char* formatName, Image::PixelFormat format, Mode mode) {
+	Image* screen = createScreen(format);
+	for(size_t s=0; s<ARRAY_SIZE(sSizes); s++) {
+		int size = sSizes[s];
+		Image* sprite = createSprite(size, format, mode);
+		if(!check(screen, sprite, mode)) {
+			printf("%s, %s, %i: FAILED\n", formatName, sModeNames[mode], size);
+			exit(1);
+		}
+		ClipRect rect = { 0, 0, size, size };
+		int count = MIN_PIXELS / (size * size);
+		for(size_t t=0; t<ARRAY_SIZE(sTransforms); t++) {
+			clock_t start = clock();
+			for(int i=0; i<count; i++) {
+				int x = (i * 37) % (DST_SIZE - size);
+				int y = (i * 91) % (DST_SIZE - size);
+				screen->drawImageRegion(x, y, &rect, sprite, sTransforms[t].mode);
+			}
+			double seconds = double(clock() - start) / CLOCKS_PER_SEC;
+			double ns = seconds * 1e9 / (double(count) * size * size);
+			printf("%-8s %-13s %3ix%-3i %-6s %6.2f ns/pixel\n", formatName, sModeNames[mode],
+				size, size, sTransforms[t].name, ns);
+		}
+		delete sprite;
+	}
+	delete screen;
+}
+
+int main() {
+	srand(1);
+	bench("RGB565", Image::PIXELFORMAT_RGB565, COPY);
+	bench("RGB565", Image::PIXELFORMAT_RGB565, PLANE);
+	bench("RGB888", Image::PIXELFORMAT_RGB888, COPY);
+	bench("ARGB8888", Image::PIXELFORMAT_ARGB8888, PLANE);
+	bench("ARGB8888", Image::PIXELFORMAT_ARGB8888, CHANNEL);
+	return 0;
+}
@@ -0,0 +1,209 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Host-side benchmark for the mapped resource file, which backs
+ maLoadResource() when LAZY_RESOURCES is defined.
+
+ Writes a 64 MB file of 64 binaries, then loads them all, as maLoadResource()
+ does, and prints the time and the growth of the resident set size (VmRSS):
+ - read into a MemStream each, as before,
+ - as a CopyOnWriteMemStream each, over a mapping of the file.
+ Then reads every binary once, and writes to one.
+
+ First checks that:
+ - writing to a CopyOnWriteMemStream doesn't change the mapping, or the
+   other streams over it,
+ - the mapping stays valid until the last stream over it is deleted.
+
+ Build from this directory, with the headers that the idl generates in place:
+ g++ -O2 -DLINUX -I../../runtimes/cpp/base -I../../runtimes/cpp/platforms/sdl -I../../intlibs
+  -I../../runtimes/cpp lazyResourceBench.cpp ../../runtimes/cpp/base/MemStream.cpp
+  ../../runtimes/cpp/base/MappedFile.cpp ../../runtimes/cpp/base/FileStream.cpp
+  ../../runtimes/cpp/base/Stream.cpp ../../runtimes/cpp/platforms/sdl/FileImpl.cpp
+  -o lazyResourceBench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <vector>
+
+#include <config_platform.h>
+#include <helpers/helpers.h>
+
+#include "MemStream.h"
+#include "MappedFile.h"
+#include "FileStream.h"
+
+#define PATH "lazyResourceBench.res"
+#define BINARIES 64
+#define BINARY_SIZE (1024 * 1024)
+
+using namespace Base;
+
+// The runtimes provide these.
+void MoSyncErrorExit(int errorCode) {
+	printf("MoSyncErrorExit(%i)\n", errorCode);
+	exit(1);
+}
+
+void LogV(const char* fmt, VA_LIST vaList) {
+	vprintf(fmt, vaList);
+}
+
+static long long now() {
+	timeval tv;
+	gettimeofday(&tv, NULL);
+	return (long long)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static void check(bool ok, const char* what) {
+	if(!ok) {
+		printf("FAILED: %s\n", what);
+		exit(1);
+	}
+}
+
+// In KB.
+static int rss() {
+	FILE* file = fopen("/proc/self/status", "r");
+	check(file != NULL, "/proc/self/status");
+	char line[256];
+	int kb = -1;
+	while(fgets(line, sizeof(line), file)) {
+		if(sscanf(line, "VmRSS: %i kB", &kb) == 1)
+			break;
+	}
+	fclose(file);
+	return kb;
+}
+
+// As in Syscall.cpp.
+class ResourceMap : public MappedFile, public RefCounted {
+public:
+	ResourceMap(const char* filename) : MappedFile(filename) {}
+};
+
+static void createFile() {
+	WriteFileStream file(PATH);
+	check(file.isOpen(), "create");
+	std::vector<char> data(BINARY_SIZE);
+	for(int b=0; b<BINARIES; b++) {
+		for(int i=0; i<BINARY_SIZE; i++) {
+			data[i] = (char)(b + i);
+		}
+		check(file.write(&data[0], BINARY_SIZE), "write");
+	}
+}
+
+static void testCopyOnWrite() {
+	ResourceMap* map = new ResourceMap(PATH);
+	check(map->isOpen(), "map");
+	CopyOnWriteMemStream* a = new CopyOnWriteMemStream(map->data(), BINARY_SIZE, map);
+	CopyOnWriteMemStream* b = new CopyOnWriteMemStream(map->data(), BINARY_SIZE, map);
+	check(a->ptrc() == map->data(), "shares the mapping");
+	check(a->seek(Seek::Start, 10) && a->write("xyz", 3), "write");
+	check(a->ptrc() != map->data(), "copied on write");
+	check(memcmp((char*)a->ptr() + 10, "xyz", 3) == 0, "written data");
+	check(((char*)a->ptr())[9] == 9 && ((char*)a->ptr())[13] == 13, "copied data");
+	check(map->data()[10] == 10, "mapping unchanged");
+	char c;
+	check(b->seek(Seek::Start, 10) && b->read(&c, 1) && c == 10, "other stream unchanged");
+
+	//the streams keep the mapping.
+	map->release();
+	check(b->seek(Seek::Start, BINARY_SIZE - 1) && b->read(&c, 1) &&
+		c == (char)(BINARY_SIZE - 1), "read after release");
+	delete a;
+	delete b;
+	printf("copy on write: ok\n");
+}
+
+static void benchRead() {
+	int startRss = rss();
+	long long start = now();
+	std::vector<MemStream*> binaries;
+	FileStream file(PATH);
+	for(int b=0; b<BINARIES; b++) {
+		MemStream* ms = new MemStream(BINARY_SIZE);
+		check(file.seek(Seek::Start, b * BINARY_SIZE) && file.readFully(*ms), "read");
+		binaries.push_back(ms);
+	}
+	long long load = now() - start;
+	int loadRss = rss() - startRss;
+
+	start = now();
+	int sum = 0;
+	for(int b=0; b<BINARIES; b++) {
+		const char* p = (const char*)binaries[b]->ptrc();
+		for(int i=0; i<BINARY_SIZE; i+=4096) {
+			sum += p[i];
+		}
+	}
+	long long touch = now() - start;
+	printf("read:   load %lli us, %i KB; first use %lli us, %i KB (%i)\n",
+		load, loadRss, touch, rss() - startRss, sum & 1);
+	for(int b=0; b<BINARIES; b++) {
+		delete binaries[b];
+	}
+}
+
+static void benchMapped() {
+	int startRss = rss();
+	long long start = now();
+	ResourceMap* map = new ResourceMap(PATH);
+	check(map->isOpen(), "map");
+	std::vector<CopyOnWriteMemStream*> binaries;
+	for(int b=0; b<BINARIES; b++) {
+		binaries.push_back(new CopyOnWriteMemStream(map->data() + b * BINARY_SIZE,
+			BINARY_SIZE, map));
+	}
+	map->release();
+	long long load = now() - start;
+	int loadRss = rss() - startRss;
+
+	start = now();
+	int sum = 0;
+	for(int b=0; b<BINARIES; b++) {
+		const char* p = (const char*)binaries[b]->ptrc();
+		for(int i=0; i<BINARY_SIZE; i+=4096) {
+			sum += p[i];
+		}
+	}
+	long long touch = now() - start;
+	int touchRss = rss() - startRss;
+
+	start = now();
+	check(binaries[0]->write("x", 1), "write");
+	long long write = now() - start;
+	printf("mapped: load %lli us, %i KB; first use %lli us, %i KB (%i); first write %lli us\n",
+		load, loadRss, touch, touchRss, sum & 1, write);
+	for(int b=0; b<BINARIES; b++) {
+		delete binaries[b];
+	}
+}
+
+int main() {
+	createFile();
+	testCopyOnWrite();
+	benchRead();
+	benchMapped();
+	remove(PATH);
+	return 0;
+}
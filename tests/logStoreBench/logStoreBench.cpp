@@ -0,0 +1,295 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Host-side benchmark for LogStore, which backs maOpenLogStore().
+
+ Fills a store with 10240 records of 1 KB, then updates random records,
+ and prints the time and the bytes written per update, next to rewriting
+ the whole 10 MB with a WriteFileStream, as maWriteStore() does.
+
+ First checks that:
+ - a torn record at the end of the file is dropped, and the rest kept,
+ - a damaged record is dropped, with the records after it,
+ - random appends and removals, across compactions and reopening,
+   read back as a std::map of the same operations does.
+
+ Build from this directory, with the headers that the idl generates in place:
+ g++ -O2 -DLINUX -I../../runtimes/cpp/base -I../../runtimes/cpp/platforms/sdl -I../../intlibs
+  -I../../runtimes/cpp logStoreBench.cpp ../../runtimes/cpp/base/LogStore.cpp
+  ../../runtimes/cpp/base/FileStream.cpp ../../runtimes/cpp/base/Stream.cpp
+  ../../runtimes/cpp/base/MemStream.cpp ../../runtimes/cpp/platforms/sdl/mutexImpl.cpp
+  ../../runtimes/cpp/platforms/sdl/ThreadPoolImpl.cpp -lSDL -o logStoreBench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <map>
+#include <vector>
+
+#include <config_platform.h>
+#include <helpers/helpers.h>
+#include <helpers/cpp_defs.h>
+
+#include "LogStore.h"
+#include "FileStream.h"
+#include "MemStream.h"
+
+#define PATH "logStoreBench.log"
+#define REWRITE_PATH "logStoreBench.store"
+#define RECORDS 10240
+#define RECORD_SIZE 1024
+#define UPDATES 20000
+#define REWRITES 20
+#define MODEL_OPS 50000
+
+using namespace Base;
+
+// The runtimes provide these.
+void MoSyncErrorExit(int errorCode) {
+	printf("MoSyncErrorExit(%i)\n", errorCode);
+	exit(1);
+}
+
+void LogV(const char* fmt, VA_LIST vaList) {
+	vprintf(fmt, vaList);
+}
+
+static long long now() {
+	timeval tv;
+	gettimeofday(&tv, NULL);
+	return (long long)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static void check(bool ok, const char* what) {
+	if(!ok) {
+		printf("FAILED: %s\n", what);
+		exit(1);
+	}
+}
+
+static LogStore* openStore(bool create) {
+	int error;
+	LogStore* store = LogStore::open(PATH, create, &error);
+	check(store != NULL, "open");
+	return store;
+}
+
+// The record of \a key, version \a version.
+static void fill(char* data, int size, int key, int version) {
+	for(int i=0; i<size; i++) {
+		data[i] = (char)(key * 31 + version * 7 + i);
+	}
+}
+
+static bool matches(LogStore* store, int key, int size, int version) {
+	std::vector<char> expected(size + 1), actual(size + 1);
+	fill(&expected[0], size, key, version);
+	if(store->read(key, &actual[0], size) != size)
+		return false;
+	return memcmp(&expected[0], &actual[0], size) == 0;
+}
+
+static long fileSize(const char* path) {
+	FILE* file = fopen(path, "rb");
+	check(file != NULL, "fopen");
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fclose(file);
+	return size;
+}
+
+// Writes records 0 to 9, version 0, of 100 bytes each.
+static void writeTen() {
+	remove(PATH);
+	LogStore* store = openStore(true);
+	char data[100];
+	for(int key=0; key<10; key++) {
+		fill(data, sizeof(data), key, 0);
+		check(store->append(key, data, sizeof(data)) == 0, "append");
+	}
+	delete store;
+}
+
+static void testTornTail() {
+	writeTen();
+	long size = fileSize(PATH);
+	FILE* file = fopen(PATH, "r+b");
+	check(file != NULL, "fopen");
+	check(ftruncate(fileno(file), size - 30) == 0, "ftruncate");
+	fclose(file);
+
+	LogStore* store = openStore(false);
+	for(int key=0; key<9; key++) {
+		check(matches(store, key, 100, 0), "record before a torn record");
+	}
+	check(store->read(9, NULL, 0) == STERR_NONEXISTENT, "torn record dropped");
+	//the next record follows the last good one.
+	char data[100];
+	fill(data, sizeof(data), 9, 1);
+	check(store->append(9, data, sizeof(data)) == 0, "append after torn record");
+	delete store;
+	store = openStore(false);
+	check(matches(store, 9, 100, 1), "record after a torn record");
+	delete store;
+	printf("torn tail: ok\n");
+}
+
+static void testCorruption() {
+	writeTen();
+	//a byte in the data of record 4.
+	FILE* file = fopen(PATH, "r+b");
+	check(file != NULL, "fopen");
+	long offset = 8 + 4 * (12 + 100) + 12 + 50;
+	fseek(file, offset, SEEK_SET);
+	int c = fgetc(file);
+	fseek(file, offset, SEEK_SET);
+	fputc(c ^ 0x10, file);
+	fclose(file);
+
+	LogStore* store = openStore(false);
+	for(int key=0; key<4; key++) {
+		check(matches(store, key, 100, 0), "record before a damaged record");
+	}
+	for(int key=4; key<10; key++) {
+		check(store->read(key, NULL, 0) == STERR_NONEXISTENT, "damaged record dropped");
+	}
+	check(fileSize(PATH) == 8 + 4 * (12 + 100), "damaged tail truncated");
+	delete store;
+	printf("corruption: ok\n");
+}
+
+struct ModelRecord {
+	int size;
+	int version;
+};
+typedef std::map<int, ModelRecord> Model;
+
+static void checkModel(LogStore* store, const Model& model) {
+	int key = -1;
+	for(Model::const_iterator itr = model.begin(); itr != model.end(); ++itr) {
+		key = store->next(key);
+		check(key == itr->first, "next");
+		check(matches(store, key, itr->second.size, itr->second.version), "model record");
+	}
+	check(store->next(key) == STERR_NONEXISTENT, "last record");
+}
+
+static void testModel() {
+	remove(PATH);
+	LogStore* store = openStore(true);
+	Model model;
+	std::vector<char> data(4096);
+	srand(1);
+	for(int i=0; i<MODEL_OPS; i++) {
+		int key = rand() % 500;
+		if(rand() % 4 == 0) {
+			int res = store->remove(key);
+			check(res == (model.count(key) ? 0 : STERR_NONEXISTENT), "remove");
+			model.erase(key);
+		} else {
+			ModelRecord r = { rand() % data.size(), i };
+			fill(&data[0], r.size, key, r.version);
+			check(store->append(key, &data[0], r.size) == 0, "append");
+			model[key] = r;
+		}
+		if(i % 5000 == 0) {
+			store->finishCompaction();
+			checkModel(store, model);
+			delete store;
+			store = openStore(false);
+			checkModel(store, model);
+		}
+	}
+	store->finishCompaction();
+	checkModel(store, model);
+	printf("model: ok, %i compactions, %i of %i bytes live\n",
+		store->getCompactions(), store->getLiveBytes(), store->getFileSize());
+	delete store;
+}
+
+static void benchLogStore() {
+	remove(PATH);
+	LogStore* store = openStore(true);
+	char data[RECORD_SIZE];
+	for(int key=0; key<RECORDS; key++) {
+		fill(data, sizeof(data), key, 0);
+		check(store->append(key, data, sizeof(data)) == 0, "append");
+	}
+	int startSize = store->getFileSize();
+
+	srand(2);
+	std::vector<int> versions(RECORDS, 0);
+	long long worst = 0, written = 0;
+	long long start = now();
+	for(int i=1; i<=UPDATES; i++) {
+		int key = rand() % RECORDS;
+		fill(data, sizeof(data), key, i);
+		long long t = now();
+		check(store->append(key, data, sizeof(data)) == 0, "append");
+		worst = MAX(worst, now() - t);
+		written += 12 + RECORD_SIZE;
+		versions[key] = i;
+	}
+	long long total = now() - start;
+	store->finishCompaction();
+	for(int key=0; key<RECORDS; key++) {
+		check(matches(store, key, RECORD_SIZE, versions[key]), "updated record");
+	}
+	printf("log store: %i updates of 1 KB in a %i KB store: %lli us per update, worst %lli us,"
+		" %lli bytes written per update, %i compactions, file %i KB\n",
+		UPDATES, startSize / 1024, total / UPDATES, worst, written / UPDATES,
+		store->getCompactions(), store->getFileSize() / 1024);
+	delete store;
+	remove(PATH);
+}
+
+static void benchRewrite() {
+	MemStream ms(RECORDS * RECORD_SIZE);
+	char data[RECORD_SIZE];
+	for(int key=0; key<RECORDS; key++) {
+		fill(data, sizeof(data), key, 0);
+		check(ms.write(data, sizeof(data)), "MemStream");
+	}
+	srand(2);
+	long long start = now();
+	for(int i=1; i<=REWRITES; i++) {
+		int key = rand() % RECORDS;
+		fill(data, sizeof(data), key, i);
+		check(ms.seek(Seek::Start, key * RECORD_SIZE) && ms.write(data, sizeof(data)), "update");
+		check(ms.seek(Seek::Start, 0), "seek");
+		WriteFileStream file(REWRITE_PATH);
+		check(file.isOpen() && file.writeFully(ms), "rewrite");
+	}
+	long long total = now() - start;
+	printf("rewrite: %i saves of %i KB: %lli us per update, %i bytes written per update\n",
+		REWRITES, RECORDS * RECORD_SIZE / 1024, total / REWRITES, RECORDS * RECORD_SIZE);
+	remove(REWRITE_PATH);
+}
+
+int main() {
+	testTornTail();
+	testCorruption();
+	testModel();
+	benchLogStore();
+	benchRewrite();
+	remove(PATH);
+	return 0;
+}
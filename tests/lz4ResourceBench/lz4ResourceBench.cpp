@@ -0,0 +1,181 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Host-side benchmark for LZ4-compressed resources.
+
+ Packs 16 MB of text (the file given on the command line, maapi.idl by
+ default, repeated) with the resource compiler's LZ4Pack(), and checks that
+ Lz4Stream gives back the same data, read in full and in random chunks.
+ Then writes the raw and the packed data to files and reads each one in
+ full, through a FileStream as an RT_BINARY resource is read and through an
+ Lz4Stream as an RT_LZ4_BINARY resource is read, with the file cache
+ dropped first and then warm. Prints the sizes and times.
+
+ Build from this directory, with the headers that the idl generates in place:
+ gcc -O2 -c ../../tools/pipe-tool/lz4pack.c
+ g++ -O2 -DLINUX -I../../runtimes/cpp/base -I../../runtimes/cpp/platforms/sdl -I../../intlibs
+  -I../../runtimes/cpp -I../../tools/pipe-tool lz4ResourceBench.cpp lz4pack.o
+  ../../runtimes/cpp/base/Lz4Stream.cpp ../../runtimes/cpp/base/FileStream.cpp
+  ../../runtimes/cpp/platforms/sdl/FileImpl.cpp ../../runtimes/cpp/base/Stream.cpp
+  ../../runtimes/cpp/base/MemStream.cpp -o lz4ResourceBench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <vector>
+
+#include <config_platform.h>
+#include <helpers/helpers.h>
+
+#include "FileStream.h"
+#include "MemStream.h"
+#include "Lz4Stream.h"
+#include "lz4pack.h"
+
+#define RAW_PATH "lz4ResourceBench.bin"
+#define PACKED_PATH "lz4ResourceBench.lz4"
+#define DATA_SIZE (16 * 1024 * 1024)
+#define CHUNK_READS 10000
+
+using namespace Base;
+
+// The runtimes provide these.
+void MoSyncErrorExit(int errorCode) {
+	printf("MoSyncErrorExit(%i)\n", errorCode);
+	exit(1);
+}
+
+void LogV(const char* fmt, VA_LIST vaList) {
+	vprintf(fmt, vaList);
+}
+
+static long long now() {
+	timeval tv;
+	gettimeofday(&tv, NULL);
+	return (long long)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static void check(bool ok, const char* what) {
+	if(!ok) {
+		printf("FAILED: %s\n", what);
+		exit(1);
+	}
+}
+
+static void loadText(const char* path, std::vector<char>& data) {
+	FileStream file(path);
+	int length;
+	check(file.isOpen() && file.length(length) && length > 0, "open text");
+	std::vector<char> text(length);
+	check(file.read(&text[0], length), "read text");
+	data.resize(DATA_SIZE);
+	for(int pos=0; pos<DATA_SIZE; pos+=length) {
+		memcpy(&data[pos], &text[0], MIN(length, DATA_SIZE - pos));
+	}
+}
+
+static void writeFile(const char* path, const void* data, int size) {
+	WriteFileStream file(path);
+	check(file.isOpen() && file.write(data, size), "write file");
+}
+
+static void dropCache(const char* path) {
+	int fd = open(path, O_RDONLY);
+	check(fd >= 0, "open for fadvise");
+	fdatasync(fd);
+	check(posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0, "fadvise");
+	close(fd);
+}
+
+static void testRoundTrip(const std::vector<char>& data,
+	const unsigned char* packed, int packedSize)
+{
+	Lz4Stream lz4(new MemStreamC(packed, packedSize));
+	int length;
+	check(lz4.isOpen() && lz4.length(length) && length == DATA_SIZE, "header");
+	std::vector<char> out(DATA_SIZE);
+	check(lz4.read(&out[0], DATA_SIZE), "read all");
+	check(out == data, "data");
+
+	srand(1);
+	char chunk[LZ4_BLOCK_SIZE * 2];
+	for(int i=0; i<CHUNK_READS; i++) {
+		int size = rand() % sizeof(chunk);
+		int pos = rand() % (DATA_SIZE - size);
+		check(lz4.seek(Seek::Start, pos) && lz4.read(chunk, size), "chunk read");
+		check(memcmp(chunk, &data[pos], size) == 0, "chunk data");
+	}
+	check(!lz4.read(chunk, DATA_SIZE), "read past the end");
+	printf("round trip: ok\n");
+}
+
+static long long timeRead(Stream& stream, std::vector<char>& out) {
+	long long start = now();
+	check(stream.read(&out[0], DATA_SIZE), "timed read");
+	return now() - start;
+}
+
+static void bench(const std::vector<char>& data, bool cold) {
+	std::vector<char> out(DATA_SIZE);
+	long long raw, packed;
+	if(cold)
+		dropCache(RAW_PATH);
+	{
+		FileStream file(RAW_PATH);
+		raw = timeRead(file, out);
+		check(out == data, "raw data");
+	}
+	if(cold)
+		dropCache(PACKED_PATH);
+	{
+		Lz4Stream lz4(new FileStream(PACKED_PATH));
+		check(lz4.isOpen(), "open packed");
+		packed = timeRead(lz4, out);
+		check(out == data, "packed data");
+	}
+	printf("%s cache: raw %6.1f ms, lz4 %6.1f ms\n", cold ? "cold" : "warm",
+		raw / 1000.0, packed / 1000.0);
+}
+
+int main(int argc, char** argv) {
+	std::vector<char> data;
+	loadText(argc > 1 ? argv[1] : "../../tools/idl2/maapi.idl", data);
+
+	int packedSize;
+	long long start = now();
+	unsigned char* packed = LZ4Pack((unsigned char*)&data[0], DATA_SIZE, &packedSize);
+	long long packTime = now() - start;
+	check(packed != NULL, "pack");
+	printf("%i KB packed to %i KB (%.1f%%) in %.1f ms\n", DATA_SIZE / 1024,
+		packedSize / 1024, packedSize * 100.0 / DATA_SIZE, packTime / 1000.0);
+
+	testRoundTrip(data, packed, packedSize);
+
+	writeFile(RAW_PATH, &data[0], DATA_SIZE);
+	writeFile(PACKED_PATH, packed, packedSize);
+	free(packed);
+	bench(data, true);
+	bench(data, false);
+	remove(RAW_PATH);
+	remove(PACKED_PATH);
+	return 0;
+}
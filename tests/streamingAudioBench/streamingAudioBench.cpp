@@ -0,0 +1,247 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+/*
+ Host-side benchmark for StreamingAudioSource.
+
+ Plays a decoder that takes a while for some buffers, like a compressed
+ track with expensive frames, through an AudioChannel whose callback runs
+ at ten times real time. It is played once with the decoder called from the
+ callback, as before, and once through a StreamingAudioSource, and prints
+ the slowest callback, the callbacks that missed their deadline, the
+ underruns, and the memory used, next to what decoding the whole track
+ would take. First checks that the streamed frames are the decoder's
+ frames, in order, across loops and after a seek.
+
+ Build from this directory, with the headers that the idl generates in place:
+ g++ -O2 -I../../runtimes/cpp/base -I../../runtimes/cpp/platforms/sdl -I../../intlibs
+  streamingAudioBench.cpp ../../runtimes/cpp/base/StreamingAudioSource.cpp
+  ../../runtimes/cpp/base/AudioChannel.cpp ../../runtimes/cpp/base/AudioMix.cpp
+  ../../runtimes/cpp/base/AudioSource.cpp ../../runtimes/cpp/platforms/sdl/mutexImpl.cpp
+  ../../runtimes/cpp/platforms/sdl/ThreadPoolImpl.cpp -lSDL -o streamingAudioBench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <config_platform.h>
+#include <helpers/helpers.h>
+
+#include "AudioChannel.h"
+#include "StreamingAudioSource.h"
+
+#define RATE 44100
+#define DECODE_FRAMES 2048
+#define CALLBACK_FRAMES 4096
+#define SPEEDUP 10
+#define TRACK_SECONDS 180
+#define PLAY_SECONDS 30
+
+// The runtimes provide these.
+void MoSyncErrorExit(int errorCode) {
+	printf("MoSyncErrorExit(%i)\n", errorCode);
+	exit(1);
+}
+
+void LogV(const char* fmt, VA_LIST vaList) {
+	vprintf(fmt, vaList);
+}
+
+static long long now() {
+	timeval tv;
+	gettimeofday(&tv, NULL);
+	return (long long)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static void burn(int us) {
+	long long end = now() + us;
+	while(now() < end) {}
+}
+
+// 16-bit stereo. The left sample of each frame is its index, the right is
+// its complement, so no frame is silent.
+class TestDecoder : public AudioSource {
+public:
+	TestDecoder(int frames, int costUs, int spikeEvery, int spikeUs)
+		: mFrames(frames), mPos(0), mNumLoops(1), mCalls(0),
+		mCostUs(costUs), mSpikeEvery(spikeEvery), mSpikeUs(spikeUs)
+	{
+		info.fmt = FMT_S16;
+		info.numChannels = 2;
+		info.sampleRate = RATE;
+		info.bytesPerSample = 2;
+		info.bitDepth = 16;
+		info.bufferSize = DECODE_FRAMES * 4;
+		info.canSeek = true;
+	}
+
+	int init() { return 0; }
+
+	int fillBuffer() {
+		if(mPos >= mFrames) {
+			if(mNumLoops == 1)
+				return 0;
+			if(mNumLoops > 1)
+				mNumLoops--;
+			mPos = 0;
+		}
+		int n = MIN(DECODE_FRAMES, mFrames - mPos);
+		for(int i=0; i<n; i++) {
+			mBuffer[i*2] = (short)(mPos + i);
+			mBuffer[i*2+1] = (short)~(mPos + i);
+		}
+		mPos += n;
+		mCalls++;
+		burn(mSpikeEvery && mCalls % mSpikeEvery == 0 ? mSpikeUs : mCostUs);
+		return n;
+	}
+
+	const void* getBuffer() const { return mBuffer; }
+	void setPosition(int ms) { mPos = MIN((int)((long long)ms * RATE / 1000), mFrames); }
+	int getPosition() const { return (int)((long long)mPos * 1000 / RATE); }
+	int getLength() const { return (int)((long long)mFrames * 1000 / RATE); }
+	void setNumLoops(int i) { mNumLoops = i; }
+	int getNumLoops() { return mNumLoops; }
+private:
+	short mBuffer[DECODE_FRAMES * 2];
+	int mFrames, mPos, mNumLoops, mCalls;
+	int mCostUs, mSpikeEvery, mSpikeUs;
+};
+
+// Reads \a s until it ends, or \a maxFrames frames, skipping silence.
+// Checks that each frame follows the one before. Returns the frames read,
+// or -1 on a mismatch.
+static int readFrames(StreamingAudioSource& s, int trackFrames, int& expected, int maxFrames) {
+	int total = 0;
+	while(total < maxFrames) {
+		int n = s.fillBuffer();
+		if(n == 0)
+			break;
+		const short* f = (const short*)s.getBuffer();
+		if(f[0] == 0 && f[1] == 0)
+			continue;
+		for(int i=0; i<n; i++) {
+			short l = (short)(expected % trackFrames);
+			if(f[i*2] != l || f[i*2+1] != (short)~l) {
+				printf("frame %i is %i, expected %i\n", expected, f[i*2], l);
+				return -1;
+			}
+			expected++;
+		}
+		total += n;
+	}
+	return total;
+}
+
+static bool check() {
+	const int frames = 5 * RATE + 123;
+	bool ok = true;
+
+	// three plays; the ring is smaller than the track.
+	{
+		StreamingAudioSource s(new TestDecoder(frames, 0, 0, 0), 100);
+		if(s.init() != 0)
+			return false;
+		s.setNumLoops(3);
+		int expected = 0;
+		int n = readFrames(s, frames, expected, 1 << 30);
+		if(n != 3 * frames) {
+			printf("looping: read %i frames, expected %i\n", n, 3 * frames);
+			ok = false;
+		}
+	}
+
+	// seek forwards, backwards and past the end.
+	{
+		StreamingAudioSource s(new TestDecoder(frames, 0, 0, 0), 100);
+		if(s.init() != 0)
+			return false;
+		int expected = 0;
+		readFrames(s, frames, expected, RATE / 2);
+		static const int seeks[] = { 3000, 1000, 10000 };
+		for(int i=0; i<3 && ok; i++) {
+			s.setPosition(seeks[i]);
+			expected = MIN(seeks[i] * RATE / 1000, frames);
+			int start = expected;
+			int n = readFrames(s, frames, expected, 1 << 30);
+			if(n != frames - start) {
+				printf("seek to %i ms: read %i frames, expected %i\n", seeks[i], n, frames - start);
+				ok = false;
+			}
+		}
+	}
+	return ok;
+}
+
+static void play(bool streaming) {
+	// 0.5 ms per buffer, and 20 ms, about two callbacks, for every 64th.
+	TestDecoder* decoder = new TestDecoder(TRACK_SECONDS * RATE, 500, 64, 20000);
+	StreamingAudioSource* stream = NULL;
+	AudioSource* source = decoder;
+	if(streaming) {
+		stream = new StreamingAudioSource(decoder);
+		stream->init();
+		source = stream;
+	}
+	AudioChannel channel(RATE, source);
+	channel.setActive(true);
+
+	static int mix[CALLBACK_FRAMES * 2];
+	int period = (int)((long long)CALLBACK_FRAMES * 1000000 / RATE / SPEEDUP);
+	int callbacks = PLAY_SECONDS * RATE / CALLBACK_FRAMES;
+	int slowest = 0, missed = 0;
+	long long deadline = now();
+	for(int i=0; i<callbacks; i++) {
+		long long start = now();
+		memset(mix, 0, sizeof(mix));
+		channel.mix(mix, CALLBACK_FRAMES);
+		int us = (int)(now() - start);
+		slowest = MAX(slowest, us);
+		if(us > period)
+			missed++;
+		deadline += period;
+		long long wait = deadline - now();
+		if(wait > 1000)
+			MoSyncThread::sleep((unsigned int)(wait / 1000));
+	}
+
+	printf("%-9s slowest callback %6i us of %i, %3i of %i late", streaming ? "streaming" : "direct",
+		slowest, period, missed, callbacks);
+	if(stream) {
+		printf(", %i underruns, peak %i KiB of %i KiB allocated\n", stream->getUnderruns(),
+			stream->getPeakBufferedBytes() / 1024, stream->getAllocatedBytes() / 1024);
+		channel.setAudioSource(NULL);
+		delete stream;
+	} else {
+		printf("\n");
+		delete decoder;
+	}
+}
+
+int main() {
+	if(!check()) {
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("decoding the whole %i s track would take %i KiB\n", TRACK_SECONDS,
+		TRACK_SECONDS * RATE * 4 / 1024);
+	play(false);
+	play(true);
+	return 0;
+}
@@ -74,6 +74,8 @@ void packageAndroid(const SETTINGS& s, const RuntimeInfo& ri) {
 	testAndroidPackage(s);
 	testAndroidVersionCode(s);
 	testAndroidInstallLocation(s);
+	testUncompressedResources(s, "Android");
+	testNoImageAtlases(s, "Android");
 
 	// copy program and resource files to add/assets/*.mp3
 	// build AndroidManifest.xml, res/layout/main.xml, res/values/strings.xml
@@ -40,6 +40,7 @@ void packageIOS(const SETTINGS& s, const RuntimeInfo& ri) {
 	testVersion(s);
 	testIOSCert(s);
 	testCppOutputDir(s);
+	testNoImageAtlases(s, "iOS");
 
 	std::ostringstream generateCmd;
 	std::ostringstream buildCmd;
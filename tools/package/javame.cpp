@@ -77,6 +77,8 @@ void packageJavaME(const SETTINGS& s, const RuntimeInfo& ri) {
 	testName(s);
 	testVendor(s);
 	testJavaMESigning(s);
+	testUncompressedResources(s, "Java ME");
+	testNoImageAtlases(s, "Java ME");
 
 	//string dstPath = ri.isBlackberry ? "" : s.dst;
 	string dstPath = s.dst;
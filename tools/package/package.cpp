@@ -452,6 +452,72 @@ void testJavaMESigning(const SETTINGS& s) {
 	}
 }
 
+// Resource types from maapi.idl.
+#define RT_LZ4_BINARY 11
+#define RT_LZ4_UBIN 12
+#define RT_ATLAS 13
+
+static bool readResourceVarInt(FILE* file, int& res) {
+	res = 0;
+	for(int i=0; i<4; i++) {
+		int b = fgetc(file);
+		if(b == EOF)
+			return false;
+		res |= (b & 0x7f) << (i*7);
+		if(b > 0x7f)
+			return true;
+	}
+	return false;
+}
+
+// Returns true if the resource file has a resource of the type \a a or \a b.
+static bool hasResourceType(const SETTINGS& s, int a, int b) {
+	if(!s.resource)
+		return false;
+	FILE* file = fopen(s.resource, "rb");
+	if(!file) {
+		printf("Could not open resource file '%s'!\n", s.resource);
+		exit(1);
+	}
+	char magic[4];
+	int count, size;
+	bool ok = fread(magic, 1, 4, file) == 4 && memcmp(magic, "MARS", 4) == 0 &&
+		readResourceVarInt(file, count) && readResourceVarInt(file, size);
+	bool found = false;
+	while(ok && !found) {
+		int type = fgetc(file);
+		if(type == EOF) {
+			ok = false;
+		} else if(type == 0) {
+			break;
+		} else if(type == a || type == b) {
+			found = true;
+		} else {
+			ok = readResourceVarInt(file, size) && fseek(file, size, SEEK_CUR) == 0;
+		}
+	}
+	fclose(file);
+	if(!ok) {
+		printf("Invalid resource file '%s'!\n", s.resource);
+		exit(1);
+	}
+	return found;
+}
+
+void testUncompressedResources(const SETTINGS& s, const char* platform) {
+	if(hasResourceType(s, RT_LZ4_BINARY, RT_LZ4_UBIN)) {
+		printf("%s does not support .lz4bin or .lz4ubin resources. Use .bin or .ubin.\n", platform);
+		exit(1);
+	}
+}
+
+void testNoImageAtlases(const SETTINGS& s, const char* platform) {
+	if(hasResourceType(s, RT_ATLAS, RT_ATLAS)) {
+		printf("%s does not support .atlas resources. Use an .image for each image.\n", platform);
+		exit(1);
+	}
+}
+
 const char* mosyncdir() {
 	static const char* md = NULL;
 	if(!md) {
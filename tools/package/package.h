@@ -114,6 +114,14 @@ void testBlackberryJde(const SETTINGS&);
 
 void testJavaMESigning(const SETTINGS& s);
 
+// Exits if the resource file has compressed resources.
+// Only the runtimes written in C++, except Android's and Symbian's, load them.
+void testUncompressedResources(const SETTINGS& s, const char* platform);
+
+// Exits if the resource file has image atlases.
+// Only the desktop runtime, MoRE, loads them.
+void testNoImageAtlases(const SETTINGS& s, const char* platform);
+
 bool isJavaIdentifierStart(char ch);
 bool isJavaIdentifierPart(char ch);
 
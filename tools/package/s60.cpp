@@ -29,6 +29,8 @@ static void setupS60(const SETTINGS& s, string& dstPath, string& combName) {
 	testProgram(s);
 	testName(s);
 	testVendor(s);
+	testUncompressedResources(s, "Symbian");
+	testNoImageAtlases(s, "Symbian");
 
 	dstPath = s.dst;
 	toSlashes(dstPath);
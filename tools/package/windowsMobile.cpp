@@ -29,6 +29,7 @@ void packageWM(const SETTINGS& s, const RuntimeInfo& ri) {
 	testProgram(s);
 	testName(s);
 	testVendor(s);
+	testNoImageAtlases(s, "Windows Mobile");
 
 	string dstCabName = s.dst + string("/") + string(s.name) + ".cab";
 
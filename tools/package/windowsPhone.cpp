@@ -38,6 +38,8 @@ void packageWindowsPhone(const SETTINGS& s, const RuntimeInfo& ri) {
 	testVendor(s);
 	testVersion(s);
 	testVsBuildPath(s);
+	testUncompressedResources(s, "Windows Phone");
+	testNoImageAtlases(s, "Windows Phone");
 
 	std::ostringstream generateCmd;
 	std::ostringstream buildCmd;
@@ -342,6 +342,19 @@ int main(int argc,char *argv[])
 			continue;
 		}
 
+		if (Token("rescache="))
+		{
+			GetCmdString();
+			strcpy(ResCacheDir, Name);
+			continue;
+		}
+
+		if (Token("threads="))
+		{
+			ResThreads = GetNum();
+			continue;
+		}
+
 		if (Token("gcj="))
 		{
 			GetCmdString();
@@ -750,6 +763,8 @@ Build application (-B) options:\n\
 \n\
 Resource compiler (-R) options:\n\
   -depend=file         output dependencies in makefile syntax\n\
+  -rescache=dir        keep compressed resources in dir, to reuse them\n\
+  -threads=n           compress with n threads (default: one per core)\n\
 \n\
 Librarian (-L) options:\n\
   -quiet               don't display the component files\n\
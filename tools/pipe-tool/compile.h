@@ -680,8 +680,35 @@ enum
 	ResType_Label = 9,
 //	ResType_Media = 10,
 //	ResType_UMedia = 11
+	ResType_LZ4Binary = 11,
+	ResType_LZ4UBinary = 12,
+	ResType_Atlas = 13
 };
 
+// An image packed into an atlas
+
+typedef struct
+{
+	char	*Name;				// header symbol, or NULL
+	char	*File;
+	int		Width;
+	int		Height;
+	int		x;
+	int		y;
+} ATLASIMAGE;
+
+// A resource queued for compression
+
+typedef struct
+{
+	unsigned long long Hash;
+	unsigned char *Src;
+	int SrcLen;
+	unsigned char *Packed;
+	int PackedLen;
+	int Cached;				// read from the cache
+} PACKJOB;
+
 //****************************************
 //
 //****************************************
@@ -797,6 +824,8 @@ dec(char GcjFlags[1024])
 
 dec(char DependName[256])
 decset(int Do_Export_Dependencies, 0)
+dec(char ResCacheDir[1024])
+decset(int ResThreads, 0)
 decset(FILE *DependFile, NULL)
 
 dec(FILE *InFile)
@@ -866,6 +895,10 @@ decset(int ResDispose, 0)
 dec(int IndexTable[32768])
 dec(short IndexCount)
 dec(int IndexWidth)
+decset(int AtlasWidth, 0)
+decset(int AtlasPadding, 0)
+decset(int AtlasCount, 0)
+decset(ATLASIMAGE *AtlasImages, 0)
 
 // Eval
 
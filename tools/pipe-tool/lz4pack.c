@@ -0,0 +1,198 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+//*********************************************************************************************
+//				       LZ4 compression of resources
+//*********************************************************************************************
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "lz4pack.h"
+
+#define LZ4_HASH_BITS		12
+#define LZ4_MIN_MATCH		4
+#define LZ4_MF_LIMIT		12		// a match must start this far from the end
+#define LZ4_LAST_LITERALS	5		// and stop this far from it
+#define LZ4_MAX_OFFSET		0xffff
+
+//****************************************
+//
+//****************************************
+
+unsigned int LZ4Read32(const unsigned char *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+//****************************************
+//
+//****************************************
+
+void LZ4Write32(unsigned char *p, unsigned int v)
+{
+	p[0] = v & 0xff;
+	p[1] = (v >> 8) & 0xff;
+	p[2] = (v >> 16) & 0xff;
+	p[3] = (v >> 24) & 0xff;
+}
+
+//****************************************
+// Writes the part of a length that doesn't
+// fit in a token nibble
+//****************************************
+
+static int LZ4WriteLength(unsigned char *dst, int op, int len)
+{
+	len -= 15;
+
+	while (len >= 255)
+	{
+		dst[op++] = 255;
+		len -= 255;
+	}
+
+	dst[op++] = len;
+	return op;
+}
+
+//****************************************
+// Writes one sequence. A matchLen of 0
+// means that there is no match, which is
+// only allowed at the end of the block
+//****************************************
+
+static int LZ4WriteSequence(unsigned char *dst, int op, const unsigned char *lit, int litLen, int offset, int matchLen)
+{
+	int ml = matchLen ? matchLen - LZ4_MIN_MATCH : 0;
+	int token = ((litLen < 15 ? litLen : 15) << 4) | (ml < 15 ? ml : 15);
+
+	dst[op++] = token;
+
+	if (litLen >= 15)
+		op = LZ4WriteLength(dst, op, litLen);
+
+	memcpy(dst + op, lit, litLen);
+	op += litLen;
+
+	if (matchLen == 0)
+		return op;
+
+	dst[op++] = offset & 0xff;
+	dst[op++] = (offset >> 8) & 0xff;
+
+	if (ml >= 15)
+		op = LZ4WriteLength(dst, op, ml);
+
+	return op;
+}
+
+//****************************************
+// Compresses one block into dst, which
+// must hold LZ4_BOUND(srcLen) bytes.
+// Returns the compressed size
+//****************************************
+
+#define LZ4_BOUND(n)		((n) + (n) / 255 + 16)
+
+static int LZ4CompressBlock(const unsigned char *src, int srcLen, unsigned char *dst)
+{
+	int table[1 << LZ4_HASH_BITS];
+	int ip = 0;
+	int anchor = 0;
+	int op = 0;
+	int n;
+
+	for (n=0;n<(1 << LZ4_HASH_BITS);n++)
+		table[n] = -1;
+
+	while (ip <= srcLen - LZ4_MF_LIMIT)
+	{
+		unsigned int seq = LZ4Read32(src + ip);
+		unsigned int h = (seq * 2654435761u) >> (32 - LZ4_HASH_BITS);
+		int ref = table[h];
+		int len;
+
+		table[h] = ip;
+
+		if (ref < 0 || ip - ref > LZ4_MAX_OFFSET || LZ4Read32(src + ref) != seq)
+		{
+			ip++;
+			continue;
+		}
+
+		len = LZ4_MIN_MATCH;
+
+		while (ip + len < srcLen - LZ4_LAST_LITERALS && src[ref + len] == src[ip + len])
+			len++;
+
+		op = LZ4WriteSequence(dst, op, src + anchor, ip - anchor, ip - ref, len);
+
+		ip += len;
+		anchor = ip;
+	}
+
+	return LZ4WriteSequence(dst, op, src + anchor, srcLen - anchor, 0, 0);
+}
+
+//****************************************
+// Compresses srcLen bytes. Returns a malloc'd
+// buffer and sets *len to its size, or
+// returns 0 if out of memory. Doesn't touch
+// any globals, so it can run on any thread.
+//****************************************
+
+unsigned char * LZ4Pack(const unsigned char *src, int srcLen, int *len)
+{
+	int blockCount = (srcLen + LZ4_BLOCK_SIZE - 1) / LZ4_BLOCK_SIZE;
+	int headerLen = 8 + blockCount * 4;
+	unsigned char *dst;
+	int op = headerLen;
+	int n;
+
+	dst = (unsigned char *) malloc(headerLen + LZ4_BOUND(srcLen) + blockCount * 16);
+
+	if (!dst)
+		return 0;
+
+	LZ4Write32(dst, srcLen);
+	LZ4Write32(dst + 4, LZ4_BLOCK_SIZE);
+
+	for (n=0;n<blockCount;n++)
+	{
+		int start = n * LZ4_BLOCK_SIZE;
+		int blockLen = srcLen - start < LZ4_BLOCK_SIZE ? srcLen - start : LZ4_BLOCK_SIZE;
+		int packedLen = LZ4CompressBlock(src + start, blockLen, dst + op);
+
+		// Incompressible blocks are stored as they are
+
+		if (packedLen >= blockLen)
+		{
+			memcpy(dst + op, src + start, blockLen);
+			LZ4Write32(dst + 8 + n * 4, blockLen | LZ4_RAW_BLOCK);
+			op += blockLen;
+		}
+		else
+		{
+			LZ4Write32(dst + 8 + n * 4, packedLen);
+			op += packedLen;
+		}
+	}
+
+	*len = op;
+	return dst;
+}
@@ -0,0 +1,59 @@
+/* Copyright (C) 2013 MoSync AB
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License, version 2, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to the Free
+Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+02111-1307, USA.
+*/
+
+#ifndef LZ4PACK_H
+#define LZ4PACK_H
+
+//****************************************
+//	  LZ4 compression of resources
+//
+// The data is split into blocks of
+// LZ4_BLOCK_SIZE bytes, which are compressed
+// independently, so that the runtime can
+// decompress any part of a resource without
+// decompressing what comes before it.
+//
+// Format, all ints little-endian:
+// int size
+// int blockSize
+// int blocks[(size + blockSize - 1) / blockSize]
+// followed by the blocks. Each entry in blocks
+// is the stored size of a block, with
+// LZ4_RAW_BLOCK set if it isn't compressed.
+//
+// Must match runtimes/cpp/base/Lz4Stream.h
+//****************************************
+
+#define LZ4_BLOCK_SIZE		0x10000
+#define LZ4_RAW_BLOCK		0x80000000
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+unsigned int LZ4Read32(const unsigned char *p);
+void LZ4Write32(unsigned char *p, unsigned int v);
+
+// Compresses srcLen bytes. Returns a malloc'd buffer and sets *len to its
+// size, or returns 0 if out of memory. Thread-safe.
+unsigned char * LZ4Pack(const unsigned char *src, int srcLen, int *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// LZ4PACK_H
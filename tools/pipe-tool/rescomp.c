@@ -20,7 +20,17 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 // 						   Written by A.R.Hartley
 //*********************************************************************************************
 
+#ifdef WIN32
+#include <windows.h>
+#include <direct.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
 #include "compile.h"
+#include "lz4pack.h"
 
 #define infoprintf		if (INFO) printf
 
@@ -56,6 +66,8 @@ void ResourceMain()
 
 	printf("Pass 1 - Size %d\n", ResIP);
 
+	RunPackJobs();
+
 	//*** Pass 2 ***
 
 	Section = SECT_data;
@@ -83,6 +95,8 @@ void ResourceMain()
 
 	printf("Pass 2 - Size %d\n", ResIP);
 
+	FreePackJobs();
+
 	AsmDisposeMem();
 
 	printf("Done...\n");
@@ -455,6 +469,30 @@ short ResourceCommands()
 		return 1;
 	}
 
+//------------------------------------
+//
+//------------------------------------
+
+	if (QToken(".lz4bin"))
+	{
+		ResType = ResType_LZ4Binary;
+
+		infoprintf("%d: LZ4 Binary\n",CurrentResource);
+		return 1;
+	}
+
+//------------------------------------
+//
+//------------------------------------
+
+	if (QToken(".lz4ubin"))
+	{
+		ResType = ResType_LZ4UBinary;
+
+		infoprintf("%d: LZ4 UBinary\n",CurrentResource);
+		return 1;
+	}
+
 //------------------------------------
 //
 //------------------------------------
@@ -852,6 +890,74 @@ short ResourceCommands()
 		return 1;
 	}
 
+//------------------------------------
+//
+//------------------------------------
+
+	if (QToken(".atlasimage"))		// symbol, filename (checked before .atlas, its prefix)
+	{
+		char *symbol = 0;
+		ATLASIMAGE *img;
+
+		if (ResType != ResType_Atlas)
+		{
+			Error(Error_Fatal, ".atlasimage must follow .atlas");
+			return 1;
+		}
+
+		SkipWhiteSpace();
+
+		if (isalpha(*FilePtr))
+		{
+			GetName();
+			symbol = (char *) malloc(strlen(Name) + 1);
+			strcpy(symbol, Name);
+
+			SkipWhiteSpace();
+			NeedToken(",");
+			SkipWhiteSpace();
+		}
+
+		GetStringName(128);
+
+		if(Do_Export_Dependencies && Pass == 2) {
+			ExportFileDependency(Name);
+		}
+
+		img = AddAtlasImage(symbol, AddRelPrefix(Name));
+
+		infoprintf("%d: Atlas image %d '%s' wh %d,%d\n", CurrentResource, AtlasCount - 1, Name, img->Width, img->Height);
+		return 1;
+	}
+
+//------------------------------------
+//
+//------------------------------------
+
+	if (QToken(".atlas"))			// maxwidth [, padding]
+	{
+		ResType = ResType_Atlas;
+
+		SkipWhiteSpace();
+
+		AtlasWidth = GetExpression();
+		AtlasPadding = 0;
+
+		SkipWhiteSpace();
+
+		if (QToken(","))
+		{
+			SkipWhiteSpace();
+			AtlasPadding = GetExpression();
+		}
+
+		if (AtlasWidth <= 0 || AtlasWidth > 0xffff || AtlasPadding < 0)
+			Error(Error_Fatal, "Invalid atlas width %d, padding %d", AtlasWidth, AtlasPadding);
+
+		infoprintf("%d: Atlas width %d padding %d\n", CurrentResource, AtlasWidth, AtlasPadding);
+		return 1;
+	}
+
 //------------------------------------
 //
 //------------------------------------
@@ -1398,6 +1504,721 @@ int GetDataIndex()
 	return 	DataIP;
 }
 
+//****************************************
+//		Packing cache
+//
+// Pass 1 doesn't need the packed data, so it
+// only queues the resources to be packed.
+// Between the passes, RunPackJobs() looks
+// them up in the cache directory given by
+// -rescache=, and packs the rest in parallel.
+// Pass 2 takes the packed data from the queue
+// in the same order.
+//
+// A job only depends on its own data, so the
+// output is the same for any number of threads.
+//
+// Cache files are named by a hash of the data
+// and the packing options.
+//****************************************
+
+#define PACK_CACHE_VERSION	1
+
+PACKJOB *PackJobs = 0;
+int PackJobCount = 0;
+int PackJobNext = 0;		// next job to run, or to take in pass 2
+
+#ifdef WIN32
+CRITICAL_SECTION PackJobLock;
+#else
+pthread_mutex_t PackJobLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+//****************************************
+//	 64-bit FNV-1a of the packing options
+//			   and the data
+//****************************************
+
+unsigned long long PackHash(const unsigned char *p, int len)
+{
+	unsigned long long h = 0xcbf29ce484222325ULL;
+	unsigned char opts[8];
+	int n;
+
+	LZ4Write32(opts, PACK_CACHE_VERSION);
+	LZ4Write32(opts + 4, LZ4_BLOCK_SIZE);
+
+	for (n=0;n<8;n++)
+		h = (h ^ opts[n]) * 0x100000001b3ULL;
+
+	for (n=0;n<len;n++)
+		h = (h ^ p[n]) * 0x100000001b3ULL;
+
+	return h;
+}
+
+//****************************************
+//
+//****************************************
+
+void PackCacheName(char *name, PACKJOB *job)
+{
+	sprintf(name, "%s/%08x%08x-%x.lz4", ResCacheDir,
+		(unsigned int) (job->Hash >> 32), (unsigned int) job->Hash, job->SrcLen);
+}
+
+//****************************************
+//	  Read a job's result from the cache
+//****************************************
+
+int ReadPackCache(PACKJOB *job)
+{
+	char name[1200];
+	FILE *f;
+	int len;
+
+	PackCacheName(name, job);
+
+	f = fopen(name, "rb");
+
+	if (!f)
+		return 0;
+
+	fseek(f, 0, SEEK_END);
+	len = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	job->Packed = (unsigned char *) malloc(len > 0 ? len : 1);
+
+	// The size in the header must match, or the file is broken
+
+	if (len < 8 || !job->Packed || (int) fread(job->Packed, 1, len, f) != len
+		|| (int) LZ4Read32(job->Packed) != job->SrcLen)
+	{
+		free(job->Packed);
+		job->Packed = 0;
+		fclose(f);
+		return 0;
+	}
+
+	fclose(f);
+
+	job->PackedLen = len;
+	job->Cached = 1;
+	return 1;
+}
+
+//****************************************
+//	  Write a job's result to the cache
+//****************************************
+
+void WritePackCache(PACKJOB *job)
+{
+	char name[1200];
+	char temp[1300];
+	FILE *f;
+	int ok;
+
+	PackCacheName(name, job);
+
+	// Write to a temporary file first, so that other
+	// builds never see a partial file
+
+#ifdef WIN32
+	sprintf(temp, "%s.%d.tmp", name, (int) GetCurrentProcessId());
+#else
+	sprintf(temp, "%s.%d.tmp", name, (int) getpid());
+#endif
+
+	f = fopen(temp, "wb");
+
+	if (!f)
+		return;
+
+	ok = (int) fwrite(job->Packed, 1, job->PackedLen, f) == job->PackedLen;
+
+	if (fclose(f) != 0)
+		ok = 0;
+
+	if (!ok || rename(temp, name) != 0)
+		remove(temp);
+}
+
+//****************************************
+//	 Pack queued jobs until there are none
+//****************************************
+
+void PackWorker()
+{
+	while (1)
+	{
+		PACKJOB *job = 0;
+
+#ifdef WIN32
+		EnterCriticalSection(&PackJobLock);
+#else
+		pthread_mutex_lock(&PackJobLock);
+#endif
+
+		while (PackJobNext < PackJobCount)
+		{
+			job = &PackJobs[PackJobNext++];
+
+			if (!job->Packed)
+				break;
+
+			job = 0;
+		}
+
+#ifdef WIN32
+		LeaveCriticalSection(&PackJobLock);
+#else
+		pthread_mutex_unlock(&PackJobLock);
+#endif
+
+		if (!job)
+			break;
+
+		job->Packed = LZ4Pack(job->Src, job->SrcLen, &job->PackedLen);
+	}
+}
+
+//****************************************
+// Thread entry points. Their signatures
+// differ, so they get no prototypes.
+//****************************************
+
+#ifdef WIN32
+//#noproto
+DWORD WINAPI PackThread(LPVOID arg)
+{
+	PackWorker();
+	return 0;
+}
+#else
+//#noproto
+void * PackThread(void *arg)
+{
+	PackWorker();
+	return 0;
+}
+#endif
+
+//****************************************
+//
+//****************************************
+
+int PackThreadCount()
+{
+	int n = ResThreads;
+
+	if (n <= 0)
+	{
+#ifdef WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		n = info.dwNumberOfProcessors;
+#else
+		n = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	}
+
+	if (n < 1)
+		n = 1;
+
+	if (n > 64)
+		n = 64;
+
+	return n;
+}
+
+//****************************************
+//	Pack the jobs queued by pass 1, using
+//		the cache and all cores
+//****************************************
+
+void RunPackJobs()
+{
+	int n, threadCount, hits = 0;
+
+	if (PackJobCount == 0)
+		return;
+
+	if (ResCacheDir[0])
+	{
+		// Fails harmlessly if the directory exists
+
+#ifdef WIN32
+		_mkdir(ResCacheDir);
+#else
+		mkdir(ResCacheDir, 0755);
+#endif
+
+		for (n=0;n<PackJobCount;n++)
+			hits += ReadPackCache(&PackJobs[n]);
+	}
+
+	threadCount = PackThreadCount();
+
+	if (threadCount > PackJobCount - hits)
+		threadCount = PackJobCount - hits;
+
+	PackJobNext = 0;
+
+#ifdef WIN32
+	InitializeCriticalSection(&PackJobLock);
+#endif
+
+	if (threadCount > 1)
+	{
+#ifdef WIN32
+		HANDLE threads[64];
+
+		for (n=0;n<threadCount;n++)
+			threads[n] = CreateThread(NULL, 0, PackThread, NULL, 0, NULL);
+
+		for (n=0;n<threadCount;n++)
+		{
+			if (threads[n])
+			{
+				WaitForSingleObject(threads[n], INFINITE);
+				CloseHandle(threads[n]);
+			}
+		}
+#else
+		pthread_t threads[64];
+		int started[64];
+
+		for (n=0;n<threadCount;n++)
+			started[n] = pthread_create(&threads[n], NULL, PackThread, NULL) == 0;
+
+		for (n=0;n<threadCount;n++)
+		{
+			if (started[n])
+				pthread_join(threads[n], NULL);
+		}
+#endif
+	}
+
+	// Packs them all with one thread, and any that are
+	// left if no thread could be started
+
+	PackWorker();
+
+#ifdef WIN32
+	DeleteCriticalSection(&PackJobLock);
+#endif
+
+	for (n=0;n<PackJobCount;n++)
+	{
+		PACKJOB *job = &PackJobs[n];
+
+		if (!job->Packed)
+			Error(Error_Fatal, "Out of memory compressing resources");
+
+		free(job->Src);
+		job->Src = 0;
+	}
+
+	if (ResCacheDir[0])
+	{
+		for (n=0;n<PackJobCount;n++)
+		{
+			if (!PackJobs[n].Cached)
+				WritePackCache(&PackJobs[n]);
+		}
+	}
+
+	printf("Packed %d resources, %d from cache, %d threads\n", PackJobCount, hits, threadCount > 1 ? threadCount : 1);
+
+	PackJobNext = 0;
+}
+
+//****************************************
+//	Compresses the current resource data.
+//
+// In pass 1 the data is only queued, and 0
+// is returned. In pass 2 returns a malloc'd
+// buffer and sets *len to its size.
+//****************************************
+
+unsigned char * PackResource(int DataLen, int *len)
+{
+	unsigned char *src;
+	unsigned char *dst;
+	unsigned long long hash;
+	PACKJOB *job;
+	int n;
+
+	src = (unsigned char *) malloc(DataLen + 1);
+
+	if (!src)
+	{
+		Error(Error_Fatal, "Out of memory compressing resource %d", CurrentResource);
+		return 0;
+	}
+
+	for (n=0;n<DataLen;n++)
+		src[n] = ArrayGet(&DataMemArray, n);
+
+	hash = PackHash(src, DataLen);
+
+	if (Pass == 1)
+	{
+		PackJobs = (PACKJOB *) realloc(PackJobs, (PackJobCount + 1) * sizeof(PACKJOB));
+
+		if (!PackJobs)
+		{
+			Error(Error_Fatal, "Out of memory compressing resource %d", CurrentResource);
+			return 0;
+		}
+
+		job = &PackJobs[PackJobCount++];
+		job->Hash = hash;
+		job->Src = src;
+		job->SrcLen = DataLen;
+		job->Packed = 0;
+		job->PackedLen = 0;
+		job->Cached = 0;
+		return 0;
+	}
+
+	// Pass 2 packs the resources in the same order as pass 1
+
+	job = PackJobNext < PackJobCount ? &PackJobs[PackJobNext++] : 0;
+
+	if (job && job->Hash == hash && job->SrcLen == DataLen && job->Packed)
+	{
+		dst = job->Packed;
+		*len = job->PackedLen;
+		job->Packed = 0;
+	}
+	else
+	{
+		dst = LZ4Pack(src, DataLen, len);
+
+		if (!dst)
+			Error(Error_Fatal, "Out of memory compressing resource %d", CurrentResource);
+	}
+
+	free(src);
+
+	printf("Res %d LZ4 %d -> %d\n", CurrentResource, DataLen, *len);
+
+	return dst;
+}
+
+//****************************************
+//	   Release what pass 2 didn't use
+//****************************************
+
+void FreePackJobs()
+{
+	int n;
+
+	for (n=0;n<PackJobCount;n++)
+	{
+		free(PackJobs[n].Src);
+		free(PackJobs[n].Packed);
+	}
+
+	free(PackJobs);
+
+	PackJobs = 0;
+	PackJobCount = 0;
+	PackJobNext = 0;
+}
+
+//****************************************
+//		Texture atlases
+//
+// .atlas packs the images that follow it
+// into one sheet. The runtime decodes them
+// into a single image when the resource is
+// loaded, so only the size of each image is
+// needed here; it's read from the file header.
+//
+// Format:
+// ushort width
+// ushort height
+// ushort count
+// followed by count images, each with
+// ushort x
+// ushort y
+// varint size
+// byte data[size]
+//
+// The atlas is followed by a binary resource,
+// <name>_TABLE, that maps each image to its
+// place in the sheet. All ints little-endian:
+// int atlas (resource handle)
+// int count
+// MARect rects[count]
+//
+// Must match runtimes/cpp/base/Syscall.cpp
+// and libs/MAUtil/ImageAtlas.h
+//****************************************
+
+//****************************************
+// Read the size of a PNG, GIF or JPEG
+//****************************************
+
+int ReadImageSize(const unsigned char *p, int len, int *width, int *height)
+{
+	int pos;
+
+	// PNG, the IHDR chunk must come first
+
+	if (len >= 24 && !memcmp(p, "\x89PNG", 4) && !memcmp(p + 12, "IHDR", 4))
+	{
+		*width = (p[16] << 24) | (p[17] << 16) | (p[18] << 8) | p[19];
+		*height = (p[20] << 24) | (p[21] << 16) | (p[22] << 8) | p[23];
+		return 1;
+	}
+
+	// GIF
+
+	if (len >= 10 && !memcmp(p, "GIF8", 4))
+	{
+		*width = p[6] | (p[7] << 8);
+		*height = p[8] | (p[9] << 8);
+		return 1;
+	}
+
+	// JPEG, look for a start of frame marker
+
+	if (len < 4 || p[0] != 0xff || p[1] != 0xd8)
+		return 0;
+
+	pos = 2;
+
+	while (pos + 4 <= len)
+	{
+		int marker, seglen;
+
+		if (p[pos] != 0xff)
+			return 0;
+
+		marker = p[pos + 1];
+
+		if (marker == 0xff)				// fill byte
+		{
+			pos++;
+			continue;
+		}
+
+		seglen = (p[pos + 2] << 8) | p[pos + 3];
+
+		if (marker >= 0xc0 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 && marker != 0xcc)
+		{
+			if (pos + 9 > len)
+				return 0;
+
+			*height = (p[pos + 5] << 8) | p[pos + 6];
+			*width = (p[pos + 7] << 8) | p[pos + 8];
+			return 1;
+		}
+
+		pos += 2 + seglen;
+	}
+
+	return 0;
+}
+
+//****************************************
+//	  Add an image to the current atlas
+//****************************************
+
+ATLASIMAGE * AddAtlasImage(char *symbol, char *file)
+{
+	ATLASIMAGE *img;
+	char *filemem;
+
+	AtlasImages = (ATLASIMAGE *) realloc(AtlasImages, (AtlasCount + 1) * sizeof(ATLASIMAGE));
+
+	if (!AtlasImages)
+	{
+		Error(Error_Fatal, "Out of memory adding atlas image");
+		return 0;
+	}
+
+	img = &AtlasImages[AtlasCount++];
+
+	img->Name = symbol;
+	img->File = (char *) malloc(strlen(file) + 1);
+	strcpy(img->File, file);
+	img->x = img->y = 0;
+
+	filemem = Open_FileAlloc(file);
+
+	if (!filemem)
+	{
+		Error(Error_Fatal, "Error reading image file '%s'", file);
+		return img;
+	}
+
+	if (!ReadImageSize((unsigned char *) filemem, FileAlloc_Len(), &img->Width, &img->Height))
+		Error(Error_Fatal, "Unknown image format in '%s'", file);
+
+	Free_File(filemem);
+
+	if (img->Width <= 0 || img->Height <= 0 || img->Width > AtlasWidth)
+		Error(Error_Fatal, "Image '%s' (%dx%d) doesn't fit in the atlas", file, img->Width, img->Height);
+
+	return img;
+}
+
+//****************************************
+//	Place the images on shelves, tallest
+//		first, and write the atlas
+//****************************************
+
+void PackAtlas()
+{
+	int *order;
+	int n, m, v;
+	int x = 0, y = 0, shelf = 0;
+	int height;
+
+	if (AtlasCount == 0 || AtlasCount > 0xffff)
+		Error(Error_Fatal, "Resource %d: an atlas needs 1 to 65535 images", CurrentResource);
+
+	if (ResName[0] == 0)
+		Error(Error_Fatal, "Resource %d: an atlas must be named", CurrentResource);
+
+	order = (int *) malloc(AtlasCount * sizeof(int));
+
+	if (!order)
+	{
+		Error(Error_Fatal, "Out of memory packing atlas %d", CurrentResource);
+		return;
+	}
+
+	// Sort by height, then width. Stable, so the layout
+	// only depends on the resource list.
+
+	for (n=0;n<AtlasCount;n++)
+	{
+		v = n;
+
+		for (m=n;m>0;m--)
+		{
+			ATLASIMAGE *a = &AtlasImages[order[m - 1]];
+			ATLASIMAGE *b = &AtlasImages[v];
+
+			if (a->Height > b->Height || (a->Height == b->Height && a->Width >= b->Width))
+				break;
+
+			order[m] = order[m - 1];
+		}
+
+		order[m] = v;
+	}
+
+	for (n=0;n<AtlasCount;n++)
+	{
+		ATLASIMAGE *img = &AtlasImages[order[n]];
+
+		if (x + img->Width > AtlasWidth)
+		{
+			y += shelf + AtlasPadding;
+			x = 0;
+			shelf = 0;
+		}
+
+		img->x = x;
+		img->y = y;
+
+		x += img->Width + AtlasPadding;
+
+		if (img->Height > shelf)
+			shelf = img->Height;
+	}
+
+	free(order);
+
+	height = y + shelf;
+
+	if (height > 0xffff)
+		Error(Error_Fatal, "Resource %d: atlas is too tall (%d)", CurrentResource, height);
+
+	WriteWord(AtlasWidth);
+	WriteWord(height);
+	WriteWord(AtlasCount);
+
+	for (n=0;n<AtlasCount;n++)
+	{
+		ATLASIMAGE *img = &AtlasImages[n];
+		char *filemem;
+		int filelen;
+		int i;
+
+		WriteWord(img->x);
+		WriteWord(img->y);
+
+		filemem = Open_FileAlloc(img->File);
+
+		if (!filemem)
+		{
+			Error(Error_Fatal, "Error reading image file '%s'", img->File);
+			return;
+		}
+
+		filelen = FileAlloc_Len();
+
+		WriteEncodedInt(filelen);
+
+		for (i=0;i<filelen;i++)
+			WriteByte(filemem[i]);
+
+		Free_File(filemem);
+	}
+
+	if (Pass == 2)
+		printf("Res %d Atlas %d images, %dx%d\n", CurrentResource, AtlasCount, AtlasWidth, height);
+}
+
+//****************************************
+//	 Write the table resource of an atlas
+//			and release the images
+//****************************************
+
+void WriteAtlasTable(char *atlasName, int atlas)
+{
+	int n;
+
+	sprintf(ResName, "%s_TABLE", atlasName);
+	MakeNewResource(ResName);
+
+	ResType = ResType_Binary;
+
+	WriteLong(atlas);
+	WriteLong(AtlasCount);
+
+	for (n=0;n<AtlasCount;n++)
+	{
+		ATLASIMAGE *img = &AtlasImages[n];
+
+		WriteLong(img->x);
+		WriteLong(img->y);
+		WriteLong(img->Width);
+		WriteLong(img->Height);
+
+		if (Pass == 2 && img->Name)
+			fprintf(HeaderFile,"#define %s %d\n", img->Name, n);
+
+		free(img->Name);
+		free(img->File);
+	}
+
+	free(AtlasImages);
+
+	AtlasImages = 0;
+	AtlasCount = 0;
+
+	FinalizeResource();
+}
+
 //****************************************
 //
 //****************************************
@@ -1410,6 +2231,33 @@ void FinalizeResource()
 	int ResStart = ResIP;
 
 	int IndexSize;
+	unsigned char *PackedData = 0;
+	char AtlasName[512];
+
+	AtlasName[0] = 0;
+
+	// Lay out the images of an atlas
+
+	if (ResType == ResType_Atlas)
+	{
+		if (IndexCount)
+			Error(Error_Fatal, "Resource %d: atlases can't have indices", CurrentResource);
+
+		PackAtlas();
+		DataLen = DataIP;
+
+		strcpy(AtlasName, ResName);
+	}
+
+	// Compress the data if needed
+
+	if (ResType == ResType_LZ4Binary || ResType == ResType_LZ4UBinary)
+	{
+		if (IndexCount)
+			Error(Error_Fatal, "Resource %d: compressed resources can't have indices", CurrentResource);
+
+		PackedData = PackResource(DataLen, &DataLen);
+	}
 
 	// Save the resource header
 
@@ -1499,9 +2347,17 @@ void FinalizeResource()
 // 	  Copy Data to resource section
 //----------------------------------------
 
-	for (n=0;n<DataLen;n++)
+	if (PackedData)
 	{
-		WriteResByte(ArrayGet(&DataMemArray, n));
+		for (n=0;n<DataLen;n++)
+			WriteResByte(PackedData[n]);
+
+		free(PackedData);
+	}
+	else
+	{
+		for (n=0;n<DataLen;n++)
+			WriteResByte(ArrayGet(&DataMemArray, n));
 	}
 
 	if (Pass == 2)
@@ -1534,6 +2390,11 @@ void FinalizeResource()
 	CurrentResource++;
 
 	Section = SECT_data;
+
+	// The table follows its atlas
+
+	if (AtlasName[0])
+		WriteAtlasTable(AtlasName, CurrentResource - 1);
 }
 
 //****************************************
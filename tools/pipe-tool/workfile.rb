@@ -14,6 +14,7 @@ work.instance_eval do
 	@EXTRA_LINKFLAGS = " -m32"
 	# -Wno-unused-function
 	@LIBRARIES = ["z"]
+	@LIBRARIES << "pthread" if(HOST != :win32)
 	@NAME = "pipe-tool"
 	@INSTALLDIR = mosyncdir + '/bin'
 	
@@ -40,6 +40,9 @@ enum
 	ResType_Label = 9,
 //	ResType_Media = 10,
 //	ResType_UMedia = 11
+	ResType_LZ4Binary = 11,
+	ResType_LZ4UBinary = 12,
+	ResType_Atlas = 13
 };
 
 using namespace std;
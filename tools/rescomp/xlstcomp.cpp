@@ -384,7 +384,9 @@ string VariantResourceSet::parseLST(string lstFile, string outputDir) {
 	ostringstream pipetoolCmd;
 	string output = outputDir + "/resources";
 	string deps = outputDir + "/resources.deps";
-	pipetoolCmd << mosyncdir() << "/bin/pipe-tool -R -depend=\"" << deps << "\" \"" << output << "\" \"" << lstFile << "\"";
+	// compressed resources are kept here between builds.
+	string cache = outputDir + "/rescache";
+	pipetoolCmd << mosyncdir() << "/bin/pipe-tool -R -depend=\"" << deps << "\" -rescache=\"" << cache << "\" \"" << output << "\" \"" << lstFile << "\"";
 	printf("%s\n", pipetoolCmd.str().c_str());
 	int res = system(pipetoolCmd.str().c_str());
 	if (res) {